@@ -94,6 +94,10 @@ public class AwShellActivity extends Activity implements OnRequestPermissionsRes
     private static final String PREFERENCES_NAME = "AwShellPrefs";
     private static final String INITIAL_URL = "about:blank";
     private static final String LAST_USED_URL_PREFERENCE_NAME = "url";
+    // Intent extras to record the Tango session, e.g.:
+    // adb shell am start ... --es recordSession /sdcard/session.tgls --ei recordSessionFrameSubsample 2
+    private static final String EXTRA_RECORD_SESSION = "recordSession";
+    private static final String EXTRA_RECORD_SESSION_FRAME_SUBSAMPLE = "recordSessionFrameSubsample";
     private static final int ADF_PERMISSION_ID = 2;
     private static final int CAMERA_ID = 0;
     private static final int MULTIPLE_PERMISSIONS_REQUEST_CODE = 12345;
@@ -469,6 +473,16 @@ public class AwShellActivity extends Activity implements OnRequestPermissionsRes
         Camera.getCameraInfo(CAMERA_ID, info);
         TangoJniNative.onCreate(this, display.getRotation(), info.orientation);
 
+        String recordSessionPath = getIntent() != null ? getIntent().getStringExtra(EXTRA_RECORD_SESSION) : null;
+        if (!TextUtils.isEmpty(recordSessionPath))
+        {
+            int frameSubsample = getIntent().getIntExtra(EXTRA_RECORD_SESSION_FRAME_SUBSAMPLE, 0);
+            if (!TangoJniNative.startRecording(recordSessionPath, frameSubsample))
+            {
+                Log.e(TAG, "Could not record the session to " + recordSessionPath);
+            }
+        }
+
         CommandLine.init(new String[] { "chrome", "--ignore-gpu-blacklist", "--enable-webvr", "--enable-blink-features=ScriptedSpeech" });
 
         AwShellResourceProvider.registerResources(this);
@@ -548,6 +562,7 @@ public class AwShellActivity extends Activity implements OnRequestPermissionsRes
             return;
         }
 
+        TangoJniNative.stopRecording();
         TangoJniNative.onDestroy();
 
         if (mDevToolsServer != null) {
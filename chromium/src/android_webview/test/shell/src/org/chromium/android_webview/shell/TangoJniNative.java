@@ -66,4 +66,15 @@ public class TangoJniNative {
     public static native void onConfigurationChanged(int activityOrientation, int sensorOrientation);
 
     public static native void resetPose();
+
+    /**
+     * Record the Tango sensor data to a session log file.
+     *
+     * @param path The file to write.
+     * @param frameSubsample The color camera frames are downsampled by this
+     *     factor. 0 does not record frames.
+     */
+    public static native boolean startRecording(String path, int frameSubsample);
+
+    public static native void stopRecording();
 }
@@ -45,7 +45,18 @@ LOCAL_C_INCLUDES := \
 	../../../../../third_party/tango/libtango_client_api \
 	../../../../../third_party/tango/libtango_support_api
 LOCAL_SRC_FILES := TangoHandler.cpp \
-                   TangoHandlerJNIInterface.cpp
+                   TangoHandlerJNIInterface.cpp \
+                   CameraFrameRing.cpp \
+                   DepthDensifier.cpp \
+                   DepthImageProjector.cpp \
+                   MarkerDetector.cpp \
+                   SensorProcessing.cpp \
+                   SensorTiming.cpp \
+                   SessionRecorder.cpp \
+                   SyntheticSensorBackend.cpp \
+                   TangoSensorBackend.cpp \
+                   TangoTrace.cpp \
+                   ThreadPool.cpp
 LOCAL_CFLAGS := -std=gnu++11 -Werror -fexceptions
 LOCAL_SHARED_LIBRARIES := tango_client_api tango_support_api
 LOCAL_LDLIBS := -llog -landroid -lGLESv2 -lEGL
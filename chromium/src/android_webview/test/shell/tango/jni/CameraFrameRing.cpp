@@ -0,0 +1,120 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CameraFrameRing.h"
+
+namespace tango_chromium {
+
+CameraFrameRing::CameraFrameRing()
+{
+  for (unsigned i = 0; i < kSize; i++)
+  {
+    displayCounts[i] = 0;
+  }
+  clear();
+}
+
+int CameraFrameRing::getLatchSlot() const
+{
+  // The oldest slot (or an empty one) that is neither displayed nor the
+  // newest. With a single context there always is one, as there are at
+  // least 3 slots.
+  int latchSlot = -1;
+  for (unsigned i = 0; i < kSize; i++)
+  {
+    if (static_cast<int>(i) == newestSlot || displayCounts[i] > 0)
+    {
+      continue;
+    }
+    if (latchSlot < 0 || timestamps[i] < timestamps[latchSlot])
+    {
+      latchSlot = i;
+    }
+  }
+  return latchSlot;
+}
+
+void CameraFrameRing::onFrameLatched(unsigned slot, double timestamp)
+{
+  if (slot >= kSize)
+  {
+    return;
+  }
+  if (timestamp <= getNewestTimestamp())
+  {
+    // The texture of the slot was overwritten all the same, so it does not
+    // hold its previous frame anymore.
+    if (static_cast<int>(slot) != newestSlot)
+    {
+      timestamps[slot] = 0;
+    }
+    return;
+  }
+  timestamps[slot] = timestamp;
+  newestSlot = slot;
+}
+
+int CameraFrameRing::selectFrame(double timestamp, int previousSlot)
+{
+  releaseFrame(previousSlot);
+  if (newestSlot < 0)
+  {
+    return -1;
+  }
+  int displayedSlot = newestSlot;
+  if (timestamp > 0)
+  {
+    for (unsigned i = 0; i < kSize; i++)
+    {
+      if (timestamps[i] == timestamp)
+      {
+        displayedSlot = i;
+        break;
+      }
+    }
+  }
+  displayCounts[displayedSlot]++;
+  return displayedSlot;
+}
+
+void CameraFrameRing::releaseFrame(int slot)
+{
+  if (slot >= 0 && slot < static_cast<int>(kSize) && displayCounts[slot] > 0)
+  {
+    displayCounts[slot]--;
+  }
+}
+
+double CameraFrameRing::getNewestTimestamp() const
+{
+  return newestSlot < 0 ? 0 : timestamps[newestSlot];
+}
+
+double CameraFrameRing::getTimestamp(unsigned slot) const
+{
+  return slot < kSize ? timestamps[slot] : 0;
+}
+
+void CameraFrameRing::clear()
+{
+  for (unsigned i = 0; i < kSize; i++)
+  {
+    timestamps[i] = 0;
+  }
+  newestSlot = -1;
+}
+
+}  // namespace tango_chromium
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CameraFrameRing.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace tango_chromium {
+
+namespace {
+
+void latch(CameraFrameRing& ring, double timestamp)
+{
+  ring.onFrameLatched(ring.getLatchSlot(), timestamp);
+}
+
+}  // namespace
+
+TEST(CameraFrameRingTest, StartsEmpty)
+{
+  CameraFrameRing ring;
+  EXPECT_EQ(0.0, ring.getNewestTimestamp());
+  EXPECT_EQ(-1, ring.selectFrame(0, -1));
+  EXPECT_EQ(-1, ring.selectFrame(1.0, -1));
+}
+
+TEST(CameraFrameRingTest, DisplaysTheFrameOfThePose)
+{
+  CameraFrameRing ring;
+  latch(ring, 1.0);
+  // The pose is computed for the newest frame, then a newer one is latched
+  // before the frame is drawn.
+  double poseTimestamp = ring.getNewestTimestamp();
+  latch(ring, 1.033);
+  EXPECT_EQ(1.033, ring.getNewestTimestamp());
+
+  int slot = ring.selectFrame(poseTimestamp, -1);
+  ASSERT_GE(slot, 0);
+  EXPECT_EQ(1.0, ring.getTimestamp(slot));
+}
+
+TEST(CameraFrameRingTest, DisplaysTheNewestFrameWithoutMatchingPose)
+{
+  CameraFrameRing ring;
+  latch(ring, 1.0);
+  latch(ring, 1.033);
+  int slot = ring.selectFrame(0, -1);
+  EXPECT_EQ(1.033, ring.getTimestamp(slot));
+  slot = ring.selectFrame(0.5, slot);
+  EXPECT_EQ(1.033, ring.getTimestamp(slot));
+}
+
+TEST(CameraFrameRingTest, NeverLatchesIntoTheDisplayedOrTheNewestFrame)
+{
+  CameraFrameRing ring;
+  double timestamp = 1.0;
+  latch(ring, timestamp);
+  int displayed = -1;
+  for (int i = 0; i < 20; i++)
+  {
+    // The page keeps displaying the frame of an old pose while new frames
+    // keep coming.
+    displayed = ring.selectFrame(1.0, displayed);
+    double newest = ring.getNewestTimestamp();
+    int slot = ring.getLatchSlot();
+    ASSERT_GE(slot, 0) << i;
+    EXPECT_NE(displayed, slot) << i;
+    EXPECT_NE(newest, ring.getTimestamp(slot)) << i;
+    timestamp += 0.033;
+    ring.onFrameLatched(slot, timestamp);
+    EXPECT_EQ(1.0, ring.getTimestamp(displayed)) << i;
+  }
+}
+
+TEST(CameraFrameRingTest, IgnoresFramesThatAreNotNewer)
+{
+  CameraFrameRing ring;
+  latch(ring, 2.0);
+  int slot = ring.getLatchSlot();
+  ring.onFrameLatched(slot, 2.0);
+  ring.onFrameLatched(slot, 1.0);
+  EXPECT_EQ(0.0, ring.getTimestamp(slot));
+  EXPECT_EQ(slot, ring.getLatchSlot());
+  EXPECT_EQ(2.0, ring.getNewestTimestamp());
+}
+
+TEST(CameraFrameRingTest, EmptiesTheSlotOfAFrameThatIsNotNewer)
+{
+  CameraFrameRing ring;
+  latch(ring, 1.0);
+  latch(ring, 2.0);
+  latch(ring, 3.0);
+  int slot = ring.getLatchSlot();
+  ASSERT_EQ(1.0, ring.getTimestamp(slot));
+  ring.onFrameLatched(slot, 2.5);
+  EXPECT_EQ(0.0, ring.getTimestamp(slot));
+  EXPECT_EQ(3.0, ring.getNewestTimestamp());
+  // The pose of the overwritten frame falls back to the newest frame.
+  EXPECT_NE(slot, ring.selectFrame(1.0, -1));
+}
+
+TEST(CameraFrameRingTest, Clear)
+{
+  CameraFrameRing ring;
+  latch(ring, 1.0);
+  int displayed = ring.selectFrame(1.0, -1);
+  ring.clear();
+  EXPECT_EQ(0.0, ring.getNewestTimestamp());
+  // The slot stays displayed until it is released.
+  EXPECT_NE(displayed, ring.getLatchSlot());
+  EXPECT_EQ(-1, ring.selectFrame(1.0, displayed));
+  latch(ring, 2.0);
+  latch(ring, 3.0);
+  latch(ring, 4.0);
+  EXPECT_EQ(4.0, ring.getNewestTimestamp());
+}
+
+TEST(CameraFrameRingTest, NeverLatchesIntoAFrameDisplayedByAnyContext)
+{
+  CameraFrameRing ring;
+  latch(ring, 1.0);
+  latch(ring, 2.0);
+  // Two contexts display different frames, the third slot is the only one
+  // left.
+  int first = ring.selectFrame(1.0, -1);
+  int second = ring.selectFrame(2.0, -1);
+  EXPECT_NE(first, second);
+  int slot = ring.getLatchSlot();
+  ASSERT_GE(slot, 0);
+  EXPECT_NE(first, slot);
+  EXPECT_NE(second, slot);
+  ring.onFrameLatched(slot, 3.0);
+
+  // Both displayed frames are older than the newest one: no slot is left
+  // until one of the contexts moves on.
+  EXPECT_EQ(-1, ring.getLatchSlot());
+  second = ring.selectFrame(3.0, second);
+  slot = ring.getLatchSlot();
+  ASSERT_GE(slot, 0);
+  EXPECT_NE(first, slot);
+  EXPECT_NE(second, slot);
+  ring.onFrameLatched(slot, 4.0);
+  EXPECT_EQ(-1, ring.getLatchSlot());
+
+  // Same when a context releases its frame.
+  ring.releaseFrame(first);
+  slot = ring.getLatchSlot();
+  EXPECT_EQ(first, slot);
+  ring.onFrameLatched(slot, 5.0);
+  EXPECT_EQ(3.0, ring.getTimestamp(second));
+}
+
+}  // namespace tango_chromium
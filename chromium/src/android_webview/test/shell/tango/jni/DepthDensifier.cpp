@@ -0,0 +1,303 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DepthDensifier.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DEPTH_DENSIFIER_USE_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define DEPTH_DENSIFIER_USE_SSE2
+#endif
+
+namespace {
+
+// The filter covers (2 * kRadius + 1)^2 pixels of the depth image, so holes
+// up to 2 * kRadius pixels wide are filled.
+constexpr int kRadius = 4;
+constexpr int kDiameter = 2 * kRadius + 1;
+// The spatial weights are gaussian, in pixels of the depth image.
+constexpr float kSpatialSigma = 2.5f;
+// The luma weights are 1 / (1 + (difference / kLumaSigma)^2), which is cheaper
+// than a gaussian in SIMD and does not vanish as fast for noisy luma.
+constexpr float kLumaSigma = 10.0f;
+// Pixels whose neighbours with depth weigh less than this stay without depth.
+constexpr float kMinWeight = 1e-4f;
+constexpr float kMaxDepthMillimeters = 65535.0f;
+constexpr uint32_t kRowsPerTask = 8;
+
+// The size of the depth image and the layout of its padded copies.
+struct PaddedLayout
+{
+	uint32_t width;
+	uint32_t height;
+	// The width rounded up to the next multiple of 4 plus the borders, so
+	// the SIMD loops can read 4 pixels past the last column.
+	uint32_t stride;
+};
+
+inline uint32_t paddedIndex(const PaddedLayout& layout, uint32_t x, uint32_t y)
+{
+  return (y + kRadius) * layout.stride + x + kRadius;
+}
+
+// Averages the factorX x factorY blocks of luma into the rows [begin, end) of
+// the padded luma.
+void downsampleLuma(const tango_chromium::LumaImage& luma, uint32_t factorX, uint32_t factorY, const PaddedLayout& layout, uint32_t begin, uint32_t end, float* paddedLuma)
+{
+  const float scale = 1.0f / (factorX * factorY);
+  for (uint32_t y = begin; y < end; y++)
+  {
+    const uint8_t* rows = luma.data + y * factorY * luma.stride;
+    float* out = paddedLuma + paddedIndex(layout, 0, y);
+    uint32_t x = 0;
+#if defined(DEPTH_DENSIFIER_USE_NEON)
+    // The camera images are 8 times the size of the depth images: the pairwise
+    // additions sum 2 blocks of 8 luma values at a time.
+    if (factorX == 8)
+    {
+      for (; x + 2 <= layout.width; x += 2)
+      {
+        uint16x8_t sums = vdupq_n_u16(0);
+        for (uint32_t row = 0; row < factorY; row++)
+        {
+          sums = vpadalq_u8(sums, vld1q_u8(rows + row * luma.stride + x * 8));
+        }
+        uint64x2_t blocks = vpaddlq_u32(vpaddlq_u16(sums));
+        out[x] = vgetq_lane_u64(blocks, 0) * scale;
+        out[x + 1] = vgetq_lane_u64(blocks, 1) * scale;
+      }
+    }
+#elif defined(DEPTH_DENSIFIER_USE_SSE2)
+    // The camera images are 8 times the size of the depth images: the sums of
+    // absolute differences with 0 sum 2 blocks of 8 luma values at a time.
+    if (factorX == 8)
+    {
+      const __m128i zero = _mm_setzero_si128();
+      for (; x + 2 <= layout.width; x += 2)
+      {
+        __m128i sums = zero;
+        for (uint32_t row = 0; row < factorY; row++)
+        {
+          __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows + row * luma.stride + x * 8));
+          sums = _mm_add_epi64(sums, _mm_sad_epu8(pixels, zero));
+        }
+        out[x] = _mm_cvtsi128_si32(sums) * scale;
+        out[x + 1] = _mm_cvtsi128_si32(_mm_srli_si128(sums, 8)) * scale;
+      }
+    }
+#endif
+    for (; x < layout.width; x++)
+    {
+      uint32_t sum = 0;
+      for (uint32_t row = 0; row < factorY; row++)
+      {
+        const uint8_t* block = rows + row * luma.stride + x * factorX;
+        for (uint32_t column = 0; column < factorX; column++)
+        {
+          sum += block[column];
+        }
+      }
+      out[x] = sum * scale;
+    }
+  }
+}
+
+inline uint16_t averageDepth(float weightedDepth, float weight)
+{
+  if (!(weight > kMinWeight))
+  {
+    return 0;
+  }
+  return static_cast<uint16_t>(std::min(weightedDepth / weight + 0.5f, kMaxDepthMillimeters));
+}
+
+// Filters the rows [begin, end) of the depth image into dense.
+void filterRows(const PaddedLayout& layout, const float* paddedDepth, const float* paddedLuma, const float* spatialWeights, const uint16_t* sparse, uint32_t begin, uint32_t end, uint16_t* dense)
+{
+  const float inverseLumaSigma2 = 1.0f / (kLumaSigma * kLumaSigma);
+  for (uint32_t y = begin; y < end; y++)
+  {
+    const uint16_t* sparseRow = sparse + y * layout.width;
+    uint16_t* denseRow = dense + y * layout.width;
+    uint32_t x = 0;
+#if defined(DEPTH_DENSIFIER_USE_NEON) || defined(DEPTH_DENSIFIER_USE_SSE2)
+    float laneWeightedDepth[4];
+    float laneWeight[4];
+#if defined(DEPTH_DENSIFIER_USE_NEON)
+    const float32x4_t zero = vdupq_n_f32(0);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    for (; x < layout.width; x += 4)
+    {
+      const uint32_t center = paddedIndex(layout, x, y);
+      const float32x4_t centerLuma = vld1q_f32(paddedLuma + center);
+      float32x4_t weightedDepth = zero;
+      float32x4_t weight = zero;
+      for (int dy = -kRadius; dy <= kRadius; dy++)
+      {
+        const float* rowSpatialWeights = spatialWeights + (dy + kRadius) * kDiameter;
+        const uint32_t row = center + dy * static_cast<int>(layout.stride);
+        for (int dx = -kRadius; dx <= kRadius; dx++)
+        {
+          float32x4_t depth = vld1q_f32(paddedDepth + row + dx);
+          float32x4_t difference = vsubq_f32(vld1q_f32(paddedLuma + row + dx), centerLuma);
+          float32x4_t denominator = vmlaq_n_f32(one, vmulq_f32(difference, difference), inverseLumaSigma2);
+          // One Newton-Raphson step is plenty for a weight.
+          float32x4_t lumaWeight = vrecpeq_f32(denominator);
+          lumaWeight = vmulq_f32(vrecpsq_f32(denominator, lumaWeight), lumaWeight);
+          float32x4_t w = vmulq_n_f32(lumaWeight, rowSpatialWeights[dx + kRadius]);
+          w = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(w), vcgtq_f32(depth, zero)));
+          weight = vaddq_f32(weight, w);
+          weightedDepth = vmlaq_f32(weightedDepth, w, depth);
+        }
+      }
+      vst1q_f32(laneWeightedDepth, weightedDepth);
+      vst1q_f32(laneWeight, weight);
+#else
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 lumaScale = _mm_set1_ps(inverseLumaSigma2);
+    for (; x < layout.width; x += 4)
+    {
+      const uint32_t center = paddedIndex(layout, x, y);
+      const __m128 centerLuma = _mm_loadu_ps(paddedLuma + center);
+      __m128 weightedDepth = zero;
+      __m128 weight = zero;
+      for (int dy = -kRadius; dy <= kRadius; dy++)
+      {
+        const float* rowSpatialWeights = spatialWeights + (dy + kRadius) * kDiameter;
+        const uint32_t row = center + dy * static_cast<int>(layout.stride);
+        for (int dx = -kRadius; dx <= kRadius; dx++)
+        {
+          __m128 depth = _mm_loadu_ps(paddedDepth + row + dx);
+          __m128 difference = _mm_sub_ps(_mm_loadu_ps(paddedLuma + row + dx), centerLuma);
+          __m128 denominator = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(difference, difference), lumaScale));
+          __m128 w = _mm_div_ps(_mm_set1_ps(rowSpatialWeights[dx + kRadius]), denominator);
+          w = _mm_and_ps(w, _mm_cmpgt_ps(depth, zero));
+          weight = _mm_add_ps(weight, w);
+          weightedDepth = _mm_add_ps(weightedDepth, _mm_mul_ps(w, depth));
+        }
+      }
+      _mm_storeu_ps(laneWeightedDepth, weightedDepth);
+      _mm_storeu_ps(laneWeight, weight);
+#endif
+      // The last lanes of the row fall in the padding.
+      const uint32_t lanes = std::min(4u, layout.width - x);
+      for (uint32_t lane = 0; lane < lanes; lane++)
+      {
+        denseRow[x + lane] = sparseRow[x + lane] != 0 ? sparseRow[x + lane] : averageDepth(laneWeightedDepth[lane], laneWeight[lane]);
+      }
+    }
+#endif
+    for (; x < layout.width; x++)
+    {
+      if (sparseRow[x] != 0)
+      {
+        denseRow[x] = sparseRow[x];
+        continue;
+      }
+      const uint32_t center = paddedIndex(layout, x, y);
+      float weightedDepth = 0;
+      float weight = 0;
+      for (int dy = -kRadius; dy <= kRadius; dy++)
+      {
+        const uint32_t row = center + dy * static_cast<int>(layout.stride);
+        for (int dx = -kRadius; dx <= kRadius; dx++)
+        {
+          float depth = paddedDepth[row + dx];
+          if (depth > 0)
+          {
+            float difference = paddedLuma[row + dx] - paddedLuma[center];
+            float w = spatialWeights[(dy + kRadius) * kDiameter + dx + kRadius] / (1.0f + difference * difference * inverseLumaSigma2);
+            weight += w;
+            weightedDepth += w * depth;
+          }
+        }
+      }
+      denseRow[x] = averageDepth(weightedDepth, weight);
+    }
+  }
+}
+
+} // End anonymous namespace
+
+namespace tango_chromium {
+
+DepthDensifier::DepthDensifier(unsigned numberOfThreads): threadPool(numberOfThreads)
+  , spatialWeights(kDiameter * kDiameter)
+{
+  for (int dy = -kRadius; dy <= kRadius; dy++)
+  {
+    for (int dx = -kRadius; dx <= kRadius; dx++)
+    {
+      spatialWeights[(dy + kRadius) * kDiameter + dx + kRadius] = std::exp(-(dx * dx + dy * dy) / (2.0f * kSpatialSigma * kSpatialSigma));
+    }
+  }
+}
+
+bool DepthDensifier::densify(const DepthImage& sparse, const LumaImage& luma, DepthImage& dense)
+{
+  if (sparse.width == 0 || sparse.height == 0 || luma.data == nullptr ||
+      luma.width < sparse.width || luma.height < sparse.height ||
+      luma.width % sparse.width != 0 || luma.height % sparse.height != 0)
+  {
+    return false;
+  }
+
+  PaddedLayout layout;
+  layout.width = sparse.width;
+  layout.height = sparse.height;
+  layout.stride = ((sparse.width + 3) & ~3u) + 2 * kRadius;
+  const uint32_t paddedSize = layout.stride * (layout.height + 2 * kRadius);
+  // The borders stay at 0: no depth, so their luma does not matter.
+  paddedDepth.assign(paddedSize, 0.0f);
+  paddedLuma.assign(paddedSize, 0.0f);
+
+  dense.width = sparse.width;
+  dense.height = sparse.height;
+  dense.timestamp = sparse.timestamp;
+  dense.depth.resize(sparse.depth.size());
+
+  const uint32_t factorX = luma.width / sparse.width;
+  const uint32_t factorY = luma.height / sparse.height;
+  const unsigned tasks = (layout.height + kRowsPerTask - 1) / kRowsPerTask;
+  threadPool.parallelFor(tasks, [&](unsigned task)
+  {
+    uint32_t begin = task * kRowsPerTask;
+    uint32_t end = std::min(layout.height, begin + kRowsPerTask);
+    downsampleLuma(luma, factorX, factorY, layout, begin, end, paddedLuma.data());
+    for (uint32_t y = begin; y < end; y++)
+    {
+      const uint16_t* row = sparse.depth.data() + y * layout.width;
+      std::copy(row, row + layout.width, paddedDepth.begin() + paddedIndex(layout, 0, y));
+    }
+  });
+  // Every tile reads the rows of its neighbours, so the filter only starts
+  // once all of them have been padded.
+  threadPool.parallelFor(tasks, [&](unsigned task)
+  {
+    uint32_t begin = task * kRowsPerTask;
+    uint32_t end = std::min(layout.height, begin + kRowsPerTask);
+    filterRows(layout, paddedDepth.data(), paddedLuma.data(), spatialWeights.data(), sparse.depth.data(), begin, end, dense.depth.data());
+  });
+  return true;
+}
+
+}  // namespace tango_chromium
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _DEPTH_DENSIFIER_H_
+#define _DEPTH_DENSIFIER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "DepthImageProjector.h"
+#include "ThreadPool.h"
+
+namespace tango_chromium {
+
+// The luma plane of a color camera frame (the Y plane of NV21), without
+// display rotation.
+struct LumaImage
+{
+	const uint8_t* data;
+	uint32_t width;
+	uint32_t height;
+	uint32_t stride;
+};
+
+// Fills the holes of the sparse DepthImages of DepthImageProjector with a
+// joint bilateral filter guided by the luma of the color camera: the depth of
+// a pixel without one is the average of the depths around it, weighted by
+// their distance and by how similar their luma is, so depth does not bleed
+// across the edges of the image.
+//
+// The luma is first box filtered down to the size of the depth image. The
+// rows of the image are then split in tiles between the threads of the pool,
+// each one filtering 4 pixels at a time (SIMD).
+class DepthDensifier
+{
+public:
+	explicit DepthDensifier(unsigned numberOfThreads = 0);
+
+	DepthDensifier(const DepthDensifier& other) = delete;
+	DepthDensifier& operator=(const DepthDensifier& other) = delete;
+
+	// Writes sparse with its holes filled to dense, which gets the size and
+	// the timestamp of sparse. The pixels that have a depth in sparse keep it,
+	// the ones too far from any depth stay at 0. The size of luma must be a
+	// multiple of the size of sparse, otherwise false is returned and dense
+	// is left untouched.
+	bool densify(const DepthImage& sparse, const LumaImage& luma, DepthImage& dense);
+
+private:
+	ThreadPool threadPool;
+	// The depth and the downsampled luma, as floats, with a border of
+	// kRadius pixels (see the .cpp) so the filter does not need bounds checks.
+	std::vector<float> paddedDepth;
+	std::vector<float> paddedLuma;
+	std::vector<float> spatialWeights;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _DEPTH_DENSIFIER_H_
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DepthDensifier.h"
+
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace tango_chromium {
+
+namespace {
+
+// A 61 x 35 depth image, so the rows are not a multiple of the SIMD width nor
+// of the tiles, with a depth every 3 pixels.
+DepthImage createSparseImage(uint16_t leftDepth, uint16_t rightDepth)
+{
+  DepthImage image;
+  image.width = 61;
+  image.height = 35;
+  image.timestamp = 2.0;
+  image.depth.assign(image.width * image.height, 0);
+  for (uint32_t y = 0; y < image.height; y += 3)
+  {
+    for (uint32_t x = 0; x < image.width; x += 3)
+    {
+      image.depth[y * image.width + x] = x < image.width / 2 ? leftDepth : rightDepth;
+    }
+  }
+  return image;
+}
+
+// A luma plane factor times the size of the image, darker on the left half
+// of the image than on the right half.
+std::vector<uint8_t> createLuma(const DepthImage& image, uint32_t factor, uint8_t left, uint8_t right, LumaImage& luma)
+{
+  luma.width = image.width * factor;
+  luma.height = image.height * factor;
+  // Some padding at the end of the rows, like in the camera frames.
+  luma.stride = luma.width + 16;
+  std::vector<uint8_t> data(luma.stride * luma.height, 255);
+  for (uint32_t y = 0; y < luma.height; y++)
+  {
+    for (uint32_t x = 0; x < luma.width; x++)
+    {
+      data[y * luma.stride + x] = x / factor < image.width / 2 ? left : right;
+    }
+  }
+  luma.data = data.data();
+  return data;
+}
+
+}  // namespace
+
+TEST(DepthDensifierTest, FillsHolesAndKeepsMeasuredDepths)
+{
+  DepthImage sparse = createSparseImage(1500, 1500);
+  sparse.depth[3 * sparse.width + 3] = 1400;
+  LumaImage luma;
+  std::vector<uint8_t> lumaData = createLuma(sparse, 8, 100, 100, luma);
+
+  DepthDensifier densifier(1);
+  DepthImage dense;
+  ASSERT_TRUE(densifier.densify(sparse, luma, dense));
+  ASSERT_EQ(sparse.width, dense.width);
+  ASSERT_EQ(sparse.height, dense.height);
+  EXPECT_EQ(2.0, dense.timestamp);
+  EXPECT_EQ(1400, dense.depth[3 * dense.width + 3]);
+  for (uint32_t i = 0; i < dense.depth.size(); i++)
+  {
+    EXPECT_NEAR(1500, dense.depth[i], 100) << i;
+  }
+}
+
+TEST(DepthDensifierTest, DoesNotBleedAcrossLumaEdges)
+{
+  DepthImage sparse = createSparseImage(1000, 3000);
+  LumaImage luma;
+  std::vector<uint8_t> uniformData = createLuma(sparse, 1, 128, 128, luma);
+  DepthDensifier densifier(1);
+  DepthImage blurred;
+  ASSERT_TRUE(densifier.densify(sparse, luma, blurred));
+
+  std::vector<uint8_t> edgeData = createLuma(sparse, 1, 40, 200, luma);
+  DepthImage dense;
+  ASSERT_TRUE(densifier.densify(sparse, luma, dense));
+
+  // The last column of the left half has no depth and depths of the right
+  // half 2 pixels away.
+  for (uint32_t y = 0; y < dense.height; y++)
+  {
+    uint32_t i = y * dense.width + dense.width / 2 - 1;
+    EXPECT_NEAR(1000, dense.depth[i], 20) << y;
+    EXPECT_GT(blurred.depth[i], 1200) << y;
+  }
+}
+
+TEST(DepthDensifierTest, LeavesHolesFarFromAnyDepthEmpty)
+{
+  DepthImage sparse = createSparseImage(0, 0);
+  sparse.depth[17 * sparse.width + 30] = 2000;
+  LumaImage luma;
+  std::vector<uint8_t> lumaData = createLuma(sparse, 8, 90, 90, luma);
+
+  DepthDensifier densifier;
+  DepthImage dense;
+  ASSERT_TRUE(densifier.densify(sparse, luma, dense));
+  EXPECT_EQ(2000, dense.depth[17 * sparse.width + 34]);
+  EXPECT_EQ(2000, dense.depth[13 * sparse.width + 26]);
+  EXPECT_EQ(0, dense.depth[17 * sparse.width + 35]);
+  EXPECT_EQ(0, dense.depth[0]);
+}
+
+TEST(DepthDensifierTest, MatchesWithSeveralThreads)
+{
+  DepthImage sparse = createSparseImage(800, 4000);
+  LumaImage luma;
+  std::vector<uint8_t> lumaData = createLuma(sparse, 8, 30, 220, luma);
+  for (uint32_t i = 0; i < lumaData.size(); i += 7)
+  {
+    lumaData[i] = static_cast<uint8_t>(i * 31);
+  }
+
+  DepthDensifier singleThreaded(1);
+  DepthDensifier multiThreaded(4);
+  DepthImage expected;
+  DepthImage dense;
+  ASSERT_TRUE(singleThreaded.densify(sparse, luma, expected));
+  ASSERT_TRUE(multiThreaded.densify(sparse, luma, dense));
+  EXPECT_EQ(expected.depth, dense.depth);
+}
+
+TEST(DepthDensifierTest, RejectsLumaOfAnotherSize)
+{
+  DepthImage sparse = createSparseImage(1000, 1000);
+  LumaImage luma;
+  std::vector<uint8_t> lumaData = createLuma(sparse, 8, 100, 100, luma);
+  luma.width -= 1;
+
+  DepthDensifier densifier(1);
+  DepthImage dense;
+  EXPECT_FALSE(densifier.densify(sparse, luma, dense));
+  EXPECT_EQ(0u, dense.width);
+  EXPECT_TRUE(dense.depth.empty());
+}
+
+}  // namespace tango_chromium
@@ -0,0 +1,290 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DepthImageProjector.h"
+
+#include <algorithm>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DEPTH_IMAGE_PROJECTOR_USE_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#define DEPTH_IMAGE_PROJECTOR_USE_SSE2
+#endif
+
+namespace {
+
+// Points nearer to the color camera than this, in meters, are dropped.
+constexpr float kMinDepth = 0.05f;
+// 0xFFFF marks the pixels without depth in the z-buffers, so farther points
+// are dropped.
+constexpr uint16_t kNoDepth = 0xFFFF;
+constexpr float kMaxDepthMillimeters = 65534.0f;
+// Smaller point clouds are not worth waking up more threads for.
+constexpr uint32_t kMinPointsPerTask = 4096;
+constexpr uint32_t kRowsPerMergeTask = 16;
+
+struct Projection
+{
+	float m[16];
+	float fx;
+	float fy;
+	float cx;
+	float cy;
+	float width;
+	float height;
+	uint32_t stride;
+};
+
+inline void writeDepth(uint16_t* zBuffer, uint32_t index, uint16_t depth)
+{
+  if (depth < zBuffer[index])
+  {
+    zBuffer[index] = depth;
+  }
+}
+
+inline void projectPoint(const Projection& p, const float* point, uint16_t* zBuffer)
+{
+  const float* m = p.m;
+  float x = m[0] * point[0] + m[4] * point[1] + m[ 8] * point[2] + m[12];
+  float y = m[1] * point[0] + m[5] * point[1] + m[ 9] * point[2] + m[13];
+  float z = m[2] * point[0] + m[6] * point[1] + m[10] * point[2] + m[14];
+  // Also drops NaNs.
+  if (!(z > kMinDepth))
+  {
+    return;
+  }
+  float inverseZ = 1.0f / z;
+  float u = p.fx * x * inverseZ + p.cx;
+  float v = p.fy * y * inverseZ + p.cy;
+  float millimeters = z * 1000.0f + 0.5f;
+  if (!(u >= 0 && u < p.width && v >= 0 && v < p.height) || millimeters > kMaxDepthMillimeters)
+  {
+    return;
+  }
+  writeDepth(zBuffer, static_cast<uint32_t>(v) * p.stride + static_cast<uint32_t>(u), static_cast<uint16_t>(millimeters));
+}
+
+void projectPoints(const Projection& p, const float (*points)[4], uint32_t begin, uint32_t end, uint16_t* zBuffer)
+{
+  uint32_t i = begin;
+#if defined(DEPTH_IMAGE_PROJECTOR_USE_NEON) || defined(DEPTH_IMAGE_PROJECTOR_USE_SSE2)
+  uint32_t laneValid[4];
+  uint32_t laneU[4];
+  uint32_t laneV[4];
+  uint32_t laneDepth[4];
+#if defined(DEPTH_IMAGE_PROJECTOR_USE_NEON)
+  const float* m = p.m;
+  const float32x4_t minDepth = vdupq_n_f32(kMinDepth);
+  const float32x4_t zero = vdupq_n_f32(0);
+  const float32x4_t width = vdupq_n_f32(p.width);
+  const float32x4_t height = vdupq_n_f32(p.height);
+  const float32x4_t cx = vdupq_n_f32(p.cx);
+  const float32x4_t cy = vdupq_n_f32(p.cy);
+  const float32x4_t half = vdupq_n_f32(0.5f);
+  const float32x4_t maxDepth = vdupq_n_f32(kMaxDepthMillimeters);
+  for (; i + 4 <= end; i += 4)
+  {
+    // x, y, z and confidence of 4 points, deinterleaved.
+    float32x4x4_t q = vld4q_f32(points[i]);
+    float32x4_t x = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m[12]), q.val[0], m[0]), q.val[1], m[4]), q.val[2], m[ 8]);
+    float32x4_t y = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m[13]), q.val[0], m[1]), q.val[1], m[5]), q.val[2], m[ 9]);
+    float32x4_t z = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m[14]), q.val[0], m[2]), q.val[1], m[6]), q.val[2], m[10]);
+    // Two Newton-Raphson steps make the estimate of 1 / z exact to a
+    // fraction of a pixel.
+    float32x4_t inverseZ = vrecpeq_f32(z);
+    inverseZ = vmulq_f32(vrecpsq_f32(z, inverseZ), inverseZ);
+    inverseZ = vmulq_f32(vrecpsq_f32(z, inverseZ), inverseZ);
+    float32x4_t u = vmlaq_f32(cx, vmulq_n_f32(x, p.fx), inverseZ);
+    float32x4_t v = vmlaq_f32(cy, vmulq_n_f32(y, p.fy), inverseZ);
+    float32x4_t millimeters = vmlaq_n_f32(half, z, 1000.0f);
+    uint32x4_t valid = vcgtq_f32(z, minDepth);
+    valid = vandq_u32(valid, vandq_u32(vcgeq_f32(u, zero), vcltq_f32(u, width)));
+    valid = vandq_u32(valid, vandq_u32(vcgeq_f32(v, zero), vcltq_f32(v, height)));
+    valid = vandq_u32(valid, vcleq_f32(millimeters, maxDepth));
+    uint32x2_t anyValid = vorr_u32(vget_low_u32(valid), vget_high_u32(valid));
+    if ((vget_lane_u32(anyValid, 0) | vget_lane_u32(anyValid, 1)) == 0)
+    {
+      continue;
+    }
+    vst1q_u32(laneValid, valid);
+    vst1q_u32(laneU, vcvtq_u32_f32(u));
+    vst1q_u32(laneV, vcvtq_u32_f32(v));
+    vst1q_u32(laneDepth, vcvtq_u32_f32(millimeters));
+#else
+  const __m128 m0 = _mm_set1_ps(p.m[0]), m1 = _mm_set1_ps(p.m[1]), m2 = _mm_set1_ps(p.m[2]);
+  const __m128 m4 = _mm_set1_ps(p.m[4]), m5 = _mm_set1_ps(p.m[5]), m6 = _mm_set1_ps(p.m[6]);
+  const __m128 m8 = _mm_set1_ps(p.m[8]), m9 = _mm_set1_ps(p.m[9]), m10 = _mm_set1_ps(p.m[10]);
+  const __m128 m12 = _mm_set1_ps(p.m[12]), m13 = _mm_set1_ps(p.m[13]), m14 = _mm_set1_ps(p.m[14]);
+  const __m128 fx = _mm_set1_ps(p.fx);
+  const __m128 fy = _mm_set1_ps(p.fy);
+  const __m128 cx = _mm_set1_ps(p.cx);
+  const __m128 cy = _mm_set1_ps(p.cy);
+  const __m128 minDepth = _mm_set1_ps(kMinDepth);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 width = _mm_set1_ps(p.width);
+  const __m128 height = _mm_set1_ps(p.height);
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 thousand = _mm_set1_ps(1000.0f);
+  const __m128 maxDepth = _mm_set1_ps(kMaxDepthMillimeters);
+  for (; i + 4 <= end; i += 4)
+  {
+    // x, y, z and confidence of 4 points, deinterleaved.
+    __m128 px = _mm_loadu_ps(points[i]);
+    __m128 py = _mm_loadu_ps(points[i + 1]);
+    __m128 pz = _mm_loadu_ps(points[i + 2]);
+    __m128 pc = _mm_loadu_ps(points[i + 3]);
+    _MM_TRANSPOSE4_PS(px, py, pz, pc);
+    __m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, m0), _mm_mul_ps(py, m4)), _mm_add_ps(_mm_mul_ps(pz, m8), m12));
+    __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, m1), _mm_mul_ps(py, m5)), _mm_add_ps(_mm_mul_ps(pz, m9), m13));
+    __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, m2), _mm_mul_ps(py, m6)), _mm_add_ps(_mm_mul_ps(pz, m10), m14));
+    __m128 inverseZ = _mm_div_ps(one, z);
+    __m128 u = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(x, fx), inverseZ), cx);
+    __m128 v = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(y, fy), inverseZ), cy);
+    __m128 millimeters = _mm_add_ps(_mm_mul_ps(z, thousand), half);
+    __m128 valid = _mm_cmpgt_ps(z, minDepth);
+    valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmplt_ps(u, width)));
+    valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmplt_ps(v, height)));
+    valid = _mm_and_ps(valid, _mm_cmple_ps(millimeters, maxDepth));
+    if (_mm_movemask_ps(valid) == 0)
+    {
+      continue;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(laneValid), _mm_castps_si128(valid));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(laneU), _mm_cvttps_epi32(u));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(laneV), _mm_cvttps_epi32(v));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(laneDepth), _mm_cvttps_epi32(millimeters));
+#endif
+    // The z-buffer test is scattered, so it stays scalar.
+    for (unsigned lane = 0; lane < 4; lane++)
+    {
+      if (laneValid[lane] != 0)
+      {
+        writeDepth(zBuffer, laneV[lane] * p.stride + laneU[lane], static_cast<uint16_t>(laneDepth[lane]));
+      }
+    }
+  }
+#endif
+  for (; i < end; i++)
+  {
+    projectPoint(p, points[i], zBuffer);
+  }
+}
+
+// Writes the nearest depth of the z-buffers to depth for the pixels in
+// [begin, end), with 0 where none of them has one.
+void mergeZBuffers(const std::vector<std::vector<uint16_t>>& zBuffers, unsigned count, uint32_t begin, uint32_t end, uint16_t* depth)
+{
+  uint32_t i = begin;
+#if defined(DEPTH_IMAGE_PROJECTOR_USE_NEON)
+  const uint16x8_t noDepth = vdupq_n_u16(kNoDepth);
+  for (; i + 8 <= end; i += 8)
+  {
+    uint16x8_t nearest = vld1q_u16(&zBuffers[0][i]);
+    for (unsigned j = 1; j < count; j++)
+    {
+      nearest = vminq_u16(nearest, vld1q_u16(&zBuffers[j][i]));
+    }
+    vst1q_u16(depth + i, vbicq_u16(nearest, vceqq_u16(nearest, noDepth)));
+  }
+#elif defined(DEPTH_IMAGE_PROJECTOR_USE_SSE2)
+  // SSE2 only has a signed 16 bit minimum: flipping the sign bit maps the
+  // unsigned order onto the signed one.
+  const __m128i signBit = _mm_set1_epi16(static_cast<short>(0x8000));
+  const __m128i noDepth = _mm_set1_epi16(static_cast<short>(kNoDepth));
+  for (; i + 8 <= end; i += 8)
+  {
+    __m128i nearest = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&zBuffers[0][i])), signBit);
+    for (unsigned j = 1; j < count; j++)
+    {
+      nearest = _mm_min_epi16(nearest, _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&zBuffers[j][i])), signBit));
+    }
+    nearest = _mm_xor_si128(nearest, signBit);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(depth + i), _mm_andnot_si128(_mm_cmpeq_epi16(nearest, noDepth), nearest));
+  }
+#endif
+  for (; i < end; i++)
+  {
+    uint16_t nearest = zBuffers[0][i];
+    for (unsigned j = 1; j < count; j++)
+    {
+      nearest = std::min(nearest, zBuffers[j][i]);
+    }
+    depth[i] = nearest == kNoDepth ? 0 : nearest;
+  }
+}
+
+} // End anonymous namespace
+
+namespace tango_chromium {
+
+DepthImageProjector::DepthImageProjector(unsigned numberOfThreads): threadPool(numberOfThreads)
+{
+}
+
+void DepthImageProjector::project(const SensorPointCloud& pointCloud, const float* depthToColor, const SensorCameraIntrinsics& intrinsics, uint32_t width, uint32_t height, DepthImage& image)
+{
+  const uint32_t size = width * height;
+  image.width = width;
+  image.height = height;
+  image.timestamp = pointCloud.timestamp;
+  image.depth.resize(size);
+  if (size == 0)
+  {
+    return;
+  }
+
+  Projection projection;
+  std::copy(depthToColor, depthToColor + 16, projection.m);
+  float scaleX = intrinsics.width > 0 ? static_cast<float>(width) / intrinsics.width : 1.0f;
+  float scaleY = intrinsics.height > 0 ? static_cast<float>(height) / intrinsics.height : 1.0f;
+  projection.fx = static_cast<float>(intrinsics.fx) * scaleX;
+  projection.fy = static_cast<float>(intrinsics.fy) * scaleY;
+  projection.cx = static_cast<float>(intrinsics.cx) * scaleX;
+  projection.cy = static_cast<float>(intrinsics.cy) * scaleY;
+  projection.width = static_cast<float>(width);
+  projection.height = static_cast<float>(height);
+  projection.stride = width;
+
+  const uint32_t numberOfPoints = pointCloud.numberOfPoints;
+  const unsigned tasks = std::max(1u, std::min(threadPool.getNumberOfThreads(), numberOfPoints / kMinPointsPerTask));
+  if (zBuffers.size() < tasks)
+  {
+    zBuffers.resize(tasks);
+  }
+  threadPool.parallelFor(tasks, [&](unsigned task)
+  {
+    std::vector<uint16_t>& zBuffer = zBuffers[task];
+    zBuffer.assign(size, kNoDepth);
+    uint32_t begin = static_cast<uint64_t>(numberOfPoints) * task / tasks;
+    uint32_t end = static_cast<uint64_t>(numberOfPoints) * (task + 1) / tasks;
+    projectPoints(projection, pointCloud.points, begin, end, zBuffer.data());
+  });
+
+  const unsigned mergeTasks = (height + kRowsPerMergeTask - 1) / kRowsPerMergeTask;
+  threadPool.parallelFor(mergeTasks, [&](unsigned task)
+  {
+    uint32_t begin = task * kRowsPerMergeTask * width;
+    uint32_t end = std::min(size, (task + 1) * kRowsPerMergeTask * width);
+    mergeZBuffers(zBuffers, tasks, begin, end, image.depth.data());
+  });
+}
+
+}  // namespace tango_chromium
@@ -0,0 +1,210 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DepthImageProjector.h"
+
+#include <cmath>
+#include <vector>
+
+#include "SyntheticSensorBackend.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace tango_chromium {
+
+namespace {
+
+const float kIdentity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+SensorCameraIntrinsics createIntrinsics()
+{
+  SensorCameraIntrinsics intrinsics;
+  memset(&intrinsics, 0, sizeof(intrinsics));
+  intrinsics.width = 640;
+  intrinsics.height = 480;
+  intrinsics.fx = intrinsics.fy = 520.0;
+  intrinsics.cx = 320.0;
+  intrinsics.cy = 240.0;
+  return intrinsics;
+}
+
+// A point that projects to the center of the pixel (x, y) of a 160 x 120
+// image of the intrinsics above, at the given depth.
+void addPoint(std::vector<float>& points, unsigned x, unsigned y, float depth)
+{
+  points.push_back((x + 0.5f - 80.0f) / 130.0f * depth);
+  points.push_back((y + 0.5f - 60.0f) / 130.0f * depth);
+  points.push_back(depth);
+  points.push_back(1.0f);
+}
+
+SensorPointCloud createPointCloud(const std::vector<float>& points)
+{
+  SensorPointCloud pointCloud;
+  pointCloud.timestamp = 1.0;
+  pointCloud.numberOfPoints = points.size() / 4;
+  pointCloud.points = reinterpret_cast<const float (*)[4]>(points.data());
+  return pointCloud;
+}
+
+unsigned countPixelsWithDepth(const DepthImage& image)
+{
+  unsigned count = 0;
+  for (uint16_t depth : image.depth)
+  {
+    count += depth != 0;
+  }
+  return count;
+}
+
+}  // namespace
+
+TEST(DepthImageProjectorTest, ProjectsPointsIntoTheColorCamera)
+{
+  // More points than fit in the SIMD loop, so the scalar tail runs too.
+  std::vector<float> points;
+  for (unsigned i = 0; i < 7; i++)
+  {
+    addPoint(points, 10 + i * 20, 5 + i * 15, 0.5f + i);
+  }
+  SensorPointCloud pointCloud = createPointCloud(points);
+
+  DepthImageProjector projector(1);
+  DepthImage image;
+  projector.project(pointCloud, kIdentity, createIntrinsics(), 160, 120, image);
+  ASSERT_EQ(160u, image.width);
+  ASSERT_EQ(120u, image.height);
+  ASSERT_EQ(160u * 120u, image.depth.size());
+  EXPECT_EQ(1.0, image.timestamp);
+  EXPECT_EQ(7u, countPixelsWithDepth(image));
+  for (unsigned i = 0; i < 7; i++)
+  {
+    EXPECT_EQ(500 + i * 1000, image.depth[(5 + i * 15) * 160 + 10 + i * 20]) << i;
+  }
+}
+
+TEST(DepthImageProjectorTest, AppliesTheDepthToColorTransform)
+{
+  std::vector<float> points;
+  addPoint(points, 80, 60, 2.0f);
+  SensorPointCloud pointCloud = createPointCloud(points);
+
+  // The color camera is 1 m behind the depth camera: the point is 3 m away
+  // and nearer to the center of the image.
+  float depthToColor[16];
+  memcpy(depthToColor, kIdentity, sizeof(depthToColor));
+  depthToColor[14] = 1.0f;
+
+  DepthImageProjector projector(1);
+  DepthImage image;
+  projector.project(pointCloud, depthToColor, createIntrinsics(), 160, 120, image);
+  EXPECT_EQ(1u, countPixelsWithDepth(image));
+  EXPECT_EQ(3000, image.depth[60 * 160 + 80]);
+}
+
+TEST(DepthImageProjectorTest, DropsPointsOutsideOfTheImage)
+{
+  std::vector<float> points;
+  // Behind the camera, too near, out of the image and too far.
+  addPoint(points, 80, 60, -1.0f);
+  addPoint(points, 80, 60, 0.01f);
+  points.insert(points.end(), {-2.0f, 0.0f, 1.0f, 1.0f});
+  points.insert(points.end(), {0.0f, 2.0f, 1.0f, 1.0f});
+  addPoint(points, 80, 60, 70.0f);
+  addPoint(points, 80, 60, NAN);
+  SensorPointCloud pointCloud = createPointCloud(points);
+
+  DepthImageProjector projector(1);
+  DepthImage image;
+  projector.project(pointCloud, kIdentity, createIntrinsics(), 160, 120, image);
+  EXPECT_EQ(0u, countPixelsWithDepth(image));
+}
+
+TEST(DepthImageProjectorTest, KeepsTheNearestPointOfEveryPixel)
+{
+  // Enough points for every thread to get some, with the nearest point of the
+  // pixel in the last task.
+  std::vector<float> points;
+  for (unsigned i = 0; i < 40000; i++)
+  {
+    addPoint(points, i % 160, (i / 160) % 120, 4.0f - (i % 7) * 0.25f);
+  }
+  addPoint(points, 33, 44, 0.75f);
+  SensorPointCloud pointCloud = createPointCloud(points);
+
+  DepthImageProjector singleThreaded(1);
+  DepthImageProjector multiThreaded(4);
+  DepthImage expected;
+  DepthImage image;
+  singleThreaded.project(pointCloud, kIdentity, createIntrinsics(), 160, 120, expected);
+  multiThreaded.project(pointCloud, kIdentity, createIntrinsics(), 160, 120, image);
+  EXPECT_EQ(750, image.depth[44 * 160 + 33]);
+  EXPECT_EQ(expected.depth, image.depth);
+  EXPECT_EQ(160u * 120u, countPixelsWithDepth(image));
+}
+
+TEST(DepthImageProjectorTest, MatchesTheSyntheticRoom)
+{
+  SyntheticSensorBackend backend;
+  backend.setTime(1.0);
+  SensorPointCloud pointCloud;
+  ASSERT_TRUE(backend.getLatestPointCloud(&pointCloud));
+  float depthToColor[16];
+  ASSERT_TRUE(backend.getDepthToColorTransform(pointCloud.timestamp, pointCloud.timestamp, depthToColor));
+  SensorCameraIntrinsics intrinsics;
+  ASSERT_TRUE(backend.getColorCameraIntrinsics(SENSOR_ROTATION_IGNORED, &intrinsics));
+
+  DepthImageProjector projector;
+  DepthImage image;
+  projector.project(pointCloud, depthToColor, intrinsics, 80, 60, image);
+  EXPECT_GT(countPixelsWithDepth(image), 80u * 60u / 4);
+
+  // The depth of every pixel is the one of a wall seen through it.
+  double colorCamera[16];
+  float matrix[16];
+  ASSERT_TRUE(backend.getMatrixTransform(pointCloud.timestamp, SENSOR_FRAME_START_OF_SERVICE, SENSOR_FRAME_CAMERA_COLOR, SENSOR_CONVENTION_TANGO, SENSOR_ROTATION_IGNORED, matrix));
+  for (int i = 0; i < 16; i++)
+  {
+    colorCamera[i] = matrix[i];
+  }
+  for (uint32_t y = 0; y < image.height; y++)
+  {
+    for (uint32_t x = 0; x < image.width; x++)
+    {
+      uint16_t depth = image.depth[y * image.width + x];
+      if (depth == 0)
+      {
+        continue;
+      }
+      double ray[3] = {
+        ((x + 0.5) * 8 - intrinsics.cx) / intrinsics.fx,
+        ((y + 0.5) * 8 - intrinsics.cy) / intrinsics.fy,
+        1.0
+      };
+      double direction[3];
+      for (int i = 0; i < 3; i++)
+      {
+        direction[i] = colorCamera[i] * ray[0] + colorCamera[4 + i] * ray[1] + colorCamera[8 + i] * ray[2];
+      }
+      double distance;
+      double normal[3];
+      ASSERT_TRUE(backend.castRay(&colorCamera[12], direction, &distance, normal));
+      // The points are not at the centers of the pixels.
+      EXPECT_NEAR(distance * 1000, depth, distance * 1000 * 0.05) << x << " " << y;
+    }
+  }
+}
+
+}  // namespace tango_chromium
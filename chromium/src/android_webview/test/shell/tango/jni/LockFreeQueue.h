@@ -0,0 +1,142 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LOCK_FREE_QUEUE_H_
+#define _LOCK_FREE_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace tango_chromium {
+
+// Bounded multi producer, multi consumer queue that never blocks nor
+// allocates after construction. Every slot carries a sequence number that
+// tells producers and consumers whether it is free for the current lap
+// (D. Vyukov's bounded MPMC queue). The capacity is rounded up to a power of
+// 2.
+template <typename T>
+class LockFreeQueue
+{
+public:
+	explicit LockFreeQueue(size_t capacity)
+		: slots(roundUpToPowerOf2(capacity))
+		, mask(slots.size() - 1)
+		, enqueuePosition(0)
+		, dequeuePosition(0)
+	{
+		for (size_t i = 0; i < slots.size(); i++)
+		{
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	LockFreeQueue(const LockFreeQueue& other) = delete;
+	LockFreeQueue& operator=(const LockFreeQueue& other) = delete;
+
+	size_t getCapacity() const
+	{
+		return slots.size();
+	}
+
+	// Returns false if the queue is full.
+	bool push(const T& value)
+	{
+		size_t position = enqueuePosition.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Slot& slot = slots[position & mask];
+			size_t sequence = slot.sequence.load(std::memory_order_acquire);
+			ptrdiff_t difference = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(position);
+			if (difference == 0)
+			{
+				if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					slot.value = value;
+					slot.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+			{
+				return false;
+			}
+			else
+			{
+				position = enqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// Returns false if the queue is empty.
+	bool pop(T& value)
+	{
+		size_t position = dequeuePosition.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Slot& slot = slots[position & mask];
+			size_t sequence = slot.sequence.load(std::memory_order_acquire);
+			ptrdiff_t difference = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(position + 1);
+			if (difference == 0)
+			{
+				if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					value = slot.value;
+					slot.sequence.store(position + mask + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+			{
+				return false;
+			}
+			else
+			{
+				position = dequeuePosition.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+private:
+	struct Slot
+	{
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	static size_t roundUpToPowerOf2(size_t value)
+	{
+		size_t result = 2;
+		while (result < value)
+		{
+			result *= 2;
+		}
+		return result;
+	}
+
+	std::vector<Slot> slots;
+	const size_t mask;
+	// Keeps the producer and consumer positions on different cache lines.
+	// alignas is not used as over aligned types cannot be allocated with new
+	// before C++17.
+	std::atomic<size_t> enqueuePosition;
+	char cacheLinePadding[64];
+	std::atomic<size_t> dequeuePosition;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _LOCK_FREE_QUEUE_H_
@@ -0,0 +1,1240 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MarkerDetector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MARKER_DETECTOR_USE_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define MARKER_DETECTOR_USE_SSE2
+#endif
+
+namespace {
+
+using tango_chromium::GrayImage;
+using tango_chromium::MarkerDetector;
+
+constexpr unsigned kMinCodeDistance = 3;
+constexpr unsigned kMinCodeBits = 3;
+constexpr unsigned kRowsPerDecimationTask = 16;
+constexpr double kPolygonEpsilonFactor = 0.035;
+constexpr double kEdgeTrimFactor = 0.1;
+constexpr int kPoseRefinementIterations = 10;
+
+inline unsigned popcount16(uint16_t v)
+{
+  unsigned count = 0;
+  while (v)
+  {
+    v &= v - 1;
+    count++;
+  }
+  return count;
+}
+
+// Rotates the 4x4 data bits the same way the grid rotates when the quad
+// corners are shifted by one position: new[r][c] = old[c][3 - r].
+inline uint16_t rotateCode(uint16_t code)
+{
+  const unsigned N = MarkerDetector::DATA_SIZE;
+  uint16_t rotated = 0;
+  for (unsigned r = 0; r < N; r++)
+  {
+    for (unsigned c = 0; c < N; c++)
+    {
+      unsigned from = c * N + (N - 1 - r);
+      if (code & (1 << (N * N - 1 - from)))
+      {
+        rotated |= 1 << (N * N - 1 - (r * N + c));
+      }
+    }
+  }
+  return rotated;
+}
+
+// The dictionary and a lookup table from any observed 16 bit pattern to the
+// (id, rotation) pair it decodes to with up to one bit error. Entries are
+// id * 4 + rotation + 1, 0 meaning no match.
+class Dictionary
+{
+public:
+  static const Dictionary& get()
+  {
+    static Dictionary dictionary;
+    return dictionary;
+  }
+
+  std::vector<uint16_t> codes;
+  std::vector<uint32_t> lookup;
+
+private:
+  Dictionary(): lookup(1 << 16, 0)
+  {
+    // Greedy selection, in increasing code order, of codes that are far enough
+    // from all their own rotations and from every rotation of the codes
+    // already selected. The result is deterministic so printed markers stay
+    // valid. Codes within kMinCodeDistance - 1 = 2 bits of a rotation of a
+    // selected code are marked as taken.
+    std::vector<char> taken(1 << 16, 0);
+    for (uint32_t candidate = 0; candidate < (1 << 16); candidate++)
+    {
+      uint16_t code = static_cast<uint16_t>(candidate);
+      unsigned bits = popcount16(code);
+      if (taken[code] || bits < kMinCodeBits || bits > 16 - kMinCodeBits)
+      {
+        continue;
+      }
+      uint16_t rotations[4];
+      rotations[0] = code;
+      for (int i = 1; i < 4; i++)
+      {
+        rotations[i] = rotateCode(rotations[i - 1]);
+      }
+      bool valid = true;
+      for (int i = 1; i < 4 && valid; i++)
+      {
+        valid = popcount16(code ^ rotations[i]) >= kMinCodeDistance;
+      }
+      if (!valid)
+      {
+        continue;
+      }
+      uint32_t id = codes.size();
+      codes.push_back(code);
+      for (uint32_t i = 0; i < 4; i++)
+      {
+        uint32_t entry = id * 4 + i + 1;
+        lookup[rotations[i]] = entry;
+        taken[rotations[i]] = 1;
+        for (int bit = 0; bit < 16; bit++)
+        {
+          uint16_t oneError = rotations[i] ^ (1 << bit);
+          lookup[oneError] = entry;
+          taken[oneError] = 1;
+          for (int other = bit + 1; other < 16; other++)
+          {
+            taken[oneError ^ (1 << other)] = 1;
+          }
+        }
+      }
+    }
+  }
+};
+
+// Solves the n x n system a * x = b in place with partial pivoting. a is row
+// major and is destroyed.
+bool solveLinearSystem(double* a, double* b, int n)
+{
+  for (int col = 0; col < n; col++)
+  {
+    int pivot = col;
+    for (int row = col + 1; row < n; row++)
+    {
+      if (std::fabs(a[row * n + col]) > std::fabs(a[pivot * n + col]))
+      {
+        pivot = row;
+      }
+    }
+    if (std::fabs(a[pivot * n + col]) < 1e-12)
+    {
+      return false;
+    }
+    if (pivot != col)
+    {
+      for (int k = 0; k < n; k++)
+      {
+        std::swap(a[col * n + k], a[pivot * n + k]);
+      }
+      std::swap(b[col], b[pivot]);
+    }
+    for (int row = col + 1; row < n; row++)
+    {
+      double factor = a[row * n + col] / a[col * n + col];
+      if (factor == 0)
+      {
+        continue;
+      }
+      for (int k = col; k < n; k++)
+      {
+        a[row * n + k] -= factor * a[col * n + k];
+      }
+      b[row] -= factor * b[col];
+    }
+  }
+  for (int row = n - 1; row >= 0; row--)
+  {
+    double sum = b[row];
+    for (int k = row + 1; k < n; k++)
+    {
+      sum -= a[row * n + k] * b[k];
+    }
+    b[row] = sum / a[row * n + row];
+  }
+  return true;
+}
+
+// Computes the homography (row major, h[8] = 1) that maps the 4 src points to
+// the 4 dst points.
+bool computeHomography(const double src[4][2], const double dst[4][2], double* h)
+{
+  double a[64];
+  double b[8];
+  for (int i = 0; i < 4; i++)
+  {
+    double X = src[i][0], Y = src[i][1], x = dst[i][0], y = dst[i][1];
+    double* r0 = a + (i * 2) * 8;
+    double* r1 = r0 + 8;
+    r0[0] = X; r0[1] = Y; r0[2] = 1; r0[3] = 0; r0[4] = 0; r0[5] = 0; r0[6] = -X * x; r0[7] = -Y * x;
+    r1[0] = 0; r1[1] = 0; r1[2] = 0; r1[3] = X; r1[4] = Y; r1[5] = 1; r1[6] = -X * y; r1[7] = -Y * y;
+    b[i * 2] = x;
+    b[i * 2 + 1] = y;
+  }
+  if (!solveLinearSystem(a, b, 8))
+  {
+    return false;
+  }
+  memcpy(h, b, sizeof(b));
+  h[8] = 1;
+  return true;
+}
+
+inline bool applyHomography(const double* h, double X, double Y, double* x, double* y)
+{
+  double w = h[6] * X + h[7] * Y + h[8];
+  if (std::fabs(w) < 1e-12)
+  {
+    return false;
+  }
+  *x = (h[0] * X + h[1] * Y + h[2]) / w;
+  *y = (h[3] * X + h[4] * Y + h[5]) / w;
+  return true;
+}
+
+// Bilinear sample with pixel centers at integer coordinates. Returns a
+// negative value outside of the image.
+inline float sampleBilinear(const GrayImage& image, double x, double y)
+{
+  if (x < 0 || y < 0)
+  {
+    return -1;
+  }
+  unsigned x0 = static_cast<unsigned>(x);
+  unsigned y0 = static_cast<unsigned>(y);
+  if (x0 + 1 >= image.width || y0 + 1 >= image.height)
+  {
+    return -1;
+  }
+  float fx = static_cast<float>(x - x0);
+  float fy = static_cast<float>(y - y0);
+  const uint8_t* p = image.data + y0 * image.stride + x0;
+  float top = p[0] + (p[1] - p[0]) * fx;
+  float bottom = p[image.stride] + (p[image.stride + 1] - p[image.stride]) * fx;
+  return top + (bottom - top) * fy;
+}
+
+inline void cross3(const double* a, const double* b, double* out)
+{
+  double r0 = a[1] * b[2] - a[2] * b[1];
+  double r1 = a[2] * b[0] - a[0] * b[2];
+  double r2 = a[0] * b[1] - a[1] * b[0];
+  out[0] = r0;
+  out[1] = r1;
+  out[2] = r2;
+}
+
+// Row major 3x3 helpers.
+inline void multiplyMatrix3(const double* a, const double* b, double* out)
+{
+  double r[9];
+  for (int i = 0; i < 3; i++)
+  {
+    for (int j = 0; j < 3; j++)
+    {
+      r[i * 3 + j] = a[i * 3] * b[j] + a[i * 3 + 1] * b[3 + j] + a[i * 3 + 2] * b[6 + j];
+    }
+  }
+  memcpy(out, r, sizeof(r));
+}
+
+inline void multiplyMatrix3Vector(const double* m, const double* v, double* out)
+{
+  double r0 = m[0] * v[0] + m[1] * v[1] + m[2] * v[2];
+  double r1 = m[3] * v[0] + m[4] * v[1] + m[5] * v[2];
+  double r2 = m[6] * v[0] + m[7] * v[1] + m[8] * v[2];
+  out[0] = r0;
+  out[1] = r1;
+  out[2] = r2;
+}
+
+// Replaces m by the closest rotation matrix (polar decomposition by Newton
+// iterations R = (R + R^-T) / 2).
+void orthonormalize(double* m)
+{
+  for (int iteration = 0; iteration < 10; iteration++)
+  {
+    double c0 = m[4] * m[8] - m[5] * m[7];
+    double c1 = m[5] * m[6] - m[3] * m[8];
+    double c2 = m[3] * m[7] - m[4] * m[6];
+    double det = m[0] * c0 + m[1] * c1 + m[2] * c2;
+    if (std::fabs(det) < 1e-12)
+    {
+      return;
+    }
+    // The inverse transpose is the cofactor matrix divided by the determinant.
+    double cofactor[9] = {
+      c0, c1, c2,
+      m[2] * m[7] - m[1] * m[8], m[0] * m[8] - m[2] * m[6], m[1] * m[6] - m[0] * m[7],
+      m[1] * m[5] - m[2] * m[4], m[2] * m[3] - m[0] * m[5], m[0] * m[4] - m[1] * m[3]
+    };
+    for (int i = 0; i < 9; i++)
+    {
+      m[i] = 0.5 * (m[i] + cofactor[i] / det);
+    }
+  }
+}
+
+void rodrigues(const double* w, double* r)
+{
+  double theta = std::sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+  if (theta < 1e-15)
+  {
+    double identity[9] = { 1, -w[2], w[1], w[2], 1, -w[0], -w[1], w[0], 1 };
+    memcpy(r, identity, sizeof(identity));
+    return;
+  }
+  double k[3] = { w[0] / theta, w[1] / theta, w[2] / theta };
+  double c = std::cos(theta), s = std::sin(theta), v = 1 - c;
+  r[0] = c + k[0] * k[0] * v;        r[1] = k[0] * k[1] * v - k[2] * s; r[2] = k[0] * k[2] * v + k[1] * s;
+  r[3] = k[1] * k[0] * v + k[2] * s; r[4] = c + k[1] * k[1] * v;        r[5] = k[1] * k[2] * v - k[0] * s;
+  r[6] = k[2] * k[0] * v - k[1] * s; r[7] = k[2] * k[1] * v + k[0] * s; r[8] = c + k[2] * k[2] * v;
+}
+
+// Hamilton quaternion (x, y, z, w) from a row major rotation matrix.
+void matrixToQuaternion(const double* m, double* q)
+{
+  double trace = m[0] + m[4] + m[8];
+  if (trace > 0)
+  {
+    double s = std::sqrt(trace + 1.0) * 2;
+    q[3] = 0.25 * s;
+    q[0] = (m[7] - m[5]) / s;
+    q[1] = (m[2] - m[6]) / s;
+    q[2] = (m[3] - m[1]) / s;
+  }
+  else if (m[0] > m[4] && m[0] > m[8])
+  {
+    double s = std::sqrt(1.0 + m[0] - m[4] - m[8]) * 2;
+    q[3] = (m[7] - m[5]) / s;
+    q[0] = 0.25 * s;
+    q[1] = (m[1] + m[3]) / s;
+    q[2] = (m[2] + m[6]) / s;
+  }
+  else if (m[4] > m[8])
+  {
+    double s = std::sqrt(1.0 + m[4] - m[0] - m[8]) * 2;
+    q[3] = (m[2] - m[6]) / s;
+    q[0] = (m[1] + m[3]) / s;
+    q[1] = 0.25 * s;
+    q[2] = (m[5] + m[7]) / s;
+  }
+  else
+  {
+    double s = std::sqrt(1.0 + m[8] - m[0] - m[4]) * 2;
+    q[3] = (m[3] - m[1]) / s;
+    q[0] = (m[2] + m[6]) / s;
+    q[1] = (m[5] + m[7]) / s;
+    q[2] = 0.25 * s;
+  }
+}
+
+inline void multiplyQuaternions(const double* a, const double* b, double* out)
+{
+  double x = a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1];
+  double y = a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0];
+  double z = a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3];
+  double w = a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2];
+  out[0] = x;
+  out[1] = y;
+  out[2] = z;
+  out[3] = w;
+}
+
+inline void rotateVector(const double* q, const double* v, double* out)
+{
+  // v' = v + 2w(q x v) + 2q x (q x v)
+  double t[3];
+  cross3(q, v, t);
+  t[0] *= 2; t[1] *= 2; t[2] *= 2;
+  double u[3];
+  cross3(q, t, u);
+  out[0] = v[0] + q[3] * t[0] + u[0];
+  out[1] = v[1] + q[3] * t[1] + u[1];
+  out[2] = v[2] + q[3] * t[2] + u[2];
+}
+
+struct Line
+{
+  // normal . p = distance
+  double normal[2];
+  double distance;
+};
+
+bool fitLine(const int* points, int count, int first, int length, Line& line)
+{
+  if (length < 2)
+  {
+    return false;
+  }
+  double mx = 0, my = 0;
+  for (int i = 0; i < length; i++)
+  {
+    int index = ((first + i) % count) * 2;
+    mx += points[index];
+    my += points[index + 1];
+  }
+  mx /= length;
+  my /= length;
+  double sxx = 0, sxy = 0, syy = 0;
+  for (int i = 0; i < length; i++)
+  {
+    int index = ((first + i) % count) * 2;
+    double dx = points[index] - mx, dy = points[index + 1] - my;
+    sxx += dx * dx;
+    sxy += dx * dy;
+    syy += dy * dy;
+  }
+  double theta = 0.5 * std::atan2(2 * sxy, sxx - syy);
+  line.normal[0] = -std::sin(theta);
+  line.normal[1] = std::cos(theta);
+  line.distance = line.normal[0] * mx + line.normal[1] * my;
+  return true;
+}
+
+bool intersectLines(const Line& a, const Line& b, double* p)
+{
+  double det = a.normal[0] * b.normal[1] - a.normal[1] * b.normal[0];
+  if (std::fabs(det) < 1e-6)
+  {
+    return false;
+  }
+  p[0] = (a.distance * b.normal[1] - a.normal[1] * b.distance) / det;
+  p[1] = (a.normal[0] * b.distance - a.distance * b.normal[0]) / det;
+  return true;
+}
+
+double distanceToSegment(const int* p, const int* a, const int* b)
+{
+  double dx = b[0] - a[0], dy = b[1] - a[1];
+  double length = std::sqrt(dx * dx + dy * dy);
+  if (length < 1e-9)
+  {
+    double ex = p[0] - a[0], ey = p[1] - a[1];
+    return std::sqrt(ex * ex + ey * ey);
+  }
+  return std::fabs(dx * (a[1] - p[1]) - dy * (a[0] - p[0])) / length;
+}
+
+// Iterative Douglas-Peucker on the closed contour. Returns the indices of the
+// polygon vertices in contour order, or an empty vector as soon as more than
+// maxVertices are needed.
+void approximatePolygon(const int* points, int count, double epsilon, size_t maxVertices, std::vector<int>& vertices)
+{
+  vertices.clear();
+  // Split the closed contour at its first point and the point farthest from
+  // it.
+  int farthest = 0;
+  double farthestDistance = -1;
+  for (int i = 1; i < count; i++)
+  {
+    double dx = points[i * 2] - points[0], dy = points[i * 2 + 1] - points[1];
+    double d = dx * dx + dy * dy;
+    if (d > farthestDistance)
+    {
+      farthestDistance = d;
+      farthest = i;
+    }
+  }
+  std::vector<char> keep(count + 1, 0);
+  keep[0] = keep[farthest] = keep[count] = 1;
+  std::vector<std::pair<int, int>> stack;
+  stack.push_back(std::make_pair(0, farthest));
+  stack.push_back(std::make_pair(farthest, count));
+  size_t kept = 2;
+  while (!stack.empty())
+  {
+    std::pair<int, int> range = stack.back();
+    stack.pop_back();
+    const int* a = points + (range.first % count) * 2;
+    const int* b = points + (range.second % count) * 2;
+    int split = -1;
+    double splitDistance = epsilon;
+    for (int i = range.first + 1; i < range.second; i++)
+    {
+      double d = distanceToSegment(points + i * 2, a, b);
+      if (d > splitDistance)
+      {
+        splitDistance = d;
+        split = i;
+      }
+    }
+    if (split >= 0)
+    {
+      if (++kept > maxVertices + 1)
+      {
+        return;
+      }
+      keep[split] = 1;
+      stack.push_back(std::make_pair(range.first, split));
+      stack.push_back(std::make_pair(split, range.second));
+    }
+  }
+  for (int i = 0; i < count; i++)
+  {
+    if (keep[i])
+    {
+      vertices.push_back(i);
+    }
+  }
+  // The first contour point is an arbitrary split point, drop it if it lies
+  // on an edge.
+  if (vertices.size() > 3)
+  {
+    const int* previous = points + vertices.back() * 2;
+    const int* next = points + vertices[1] * 2;
+    if (distanceToSegment(points, previous, next) <= epsilon)
+    {
+      vertices.erase(vertices.begin());
+    }
+  }
+  if (vertices.size() > maxVertices)
+  {
+    vertices.clear();
+  }
+}
+
+const int kDirectionX[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+const int kDirectionY[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+// kDirectionFromOffset[dy + 1][dx + 1]
+const int kDirectionFromOffset[3][3] = { { 5, 6, 7 }, { 4, -1, 0 }, { 3, 2, 1 } };
+
+// Moore neighbour tracing of the border that starts at (x, y), whose west
+// neighbour is background. Points are appended as x, y pairs. The image must
+// have a one pixel background frame.
+void traceContour(const uint8_t* binary, uint8_t* traced, int width, int x, int y, size_t maxLength, std::vector<int>& contour)
+{
+  contour.clear();
+  int startX = x, startY = y;
+  int secondX = -1, secondY = -1;
+  // Direction, from the current pixel, of the last background pixel examined.
+  int backtrack = 4;
+  contour.push_back(x);
+  contour.push_back(y);
+  traced[y * width + x] = 1;
+  while (contour.size() < maxLength * 2)
+  {
+    int k;
+    int nextX = 0, nextY = 0;
+    for (k = 1; k <= 8; k++)
+    {
+      int d = (backtrack + k) & 7;
+      nextX = x + kDirectionX[d];
+      nextY = y + kDirectionY[d];
+      if (binary[nextY * width + nextX])
+      {
+        int previous = (backtrack + k - 1) & 7;
+        int backgroundX = x + kDirectionX[previous];
+        int backgroundY = y + kDirectionY[previous];
+        backtrack = kDirectionFromOffset[backgroundY - nextY + 1][backgroundX - nextX + 1];
+        break;
+      }
+    }
+    if (k > 8)
+    {
+      // Isolated pixel.
+      return;
+    }
+    if (x == startX && y == startY && secondX >= 0)
+    {
+      if (nextX == secondX && nextY == secondY)
+      {
+        // Back at the start, moving the same way as the first time.
+        contour.resize(contour.size() - 2);
+        return;
+      }
+    }
+    if (secondX < 0)
+    {
+      secondX = nextX;
+      secondY = nextY;
+    }
+    x = nextX;
+    y = nextY;
+    contour.push_back(x);
+    contour.push_back(y);
+    traced[y * width + x] = 1;
+  }
+}
+
+}  // End anonymous namespace
+
+namespace tango_chromium {
+
+MarkerDetectorParams::MarkerDetectorParams(): tileSize(8)
+  , minContrast(20)
+  , decimateWidth(1000)
+  , minPerimeter(40)
+  , maxBitErrors(1)
+{
+}
+
+MarkerDetector::MarkerDetector(const MarkerDetectorParams& params, unsigned numberOfThreads): params(params)
+  , threadPool(numberOfThreads)
+  , decimation(1)
+{
+  memset(&workingImage, 0, sizeof(workingImage));
+}
+
+unsigned MarkerDetector::getDictionarySize()
+{
+  return Dictionary::get().codes.size();
+}
+
+uint16_t MarkerDetector::getCode(unsigned id)
+{
+  const std::vector<uint16_t>& codes = Dictionary::get().codes;
+  return id < codes.size() ? codes[id] : 0;
+}
+
+void MarkerDetector::detect(const GrayImage& image, const CameraModel& camera, double markerSize, std::vector<DetectedMarker>& markers)
+{
+  markers.clear();
+  if (image.data == nullptr || image.width < 16 || image.height < 16)
+  {
+    return;
+  }
+
+  const GrayImage& working = prepareWorkingImage(image);
+  threshold(working);
+
+  std::vector<Candidate> candidates;
+  findCandidates(candidates);
+  if (candidates.empty())
+  {
+    return;
+  }
+
+  // Decoding and pose estimation are independent per candidate.
+  std::vector<DetectedMarker> results(candidates.size());
+  std::vector<char> valid(candidates.size(), 0);
+  threadPool.parallelFor(candidates.size(), [&](unsigned i)
+  {
+    if (decode(image, candidates[i], results[i]))
+    {
+      estimatePose(camera, markerSize, results[i]);
+      valid[i] = 1;
+    }
+  });
+  for (size_t i = 0; i < candidates.size(); i++)
+  {
+    if (valid[i])
+    {
+      markers.push_back(results[i]);
+    }
+  }
+}
+
+void MarkerDetector::transformMarkerPose(const DetectedMarker& marker, const double* cameraTranslation, const double* cameraOrientation, double* translation, double* orientation)
+{
+  double rotated[3];
+  rotateVector(cameraOrientation, marker.translation, rotated);
+  translation[0] = cameraTranslation[0] + rotated[0];
+  translation[1] = cameraTranslation[1] + rotated[1];
+  translation[2] = cameraTranslation[2] + rotated[2];
+  multiplyQuaternions(cameraOrientation, marker.orientation, orientation);
+}
+
+const GrayImage& MarkerDetector::prepareWorkingImage(const GrayImage& image)
+{
+  if (image.width <= params.decimateWidth)
+  {
+    decimation = 1;
+    workingImage = image;
+    return workingImage;
+  }
+
+  decimation = 2;
+  const unsigned width = image.width / 2;
+  const unsigned height = image.height / 2;
+  decimatedImage.resize(width * height);
+  uint8_t* output = decimatedImage.data();
+  unsigned tasks = (height + kRowsPerDecimationTask - 1) / kRowsPerDecimationTask;
+  threadPool.parallelFor(tasks, [&](unsigned task)
+  {
+    unsigned endY = std::min(height, (task + 1) * kRowsPerDecimationTask);
+    for (unsigned y = task * kRowsPerDecimationTask; y < endY; y++)
+    {
+      const uint8_t* row0 = image.data + (y * 2) * image.stride;
+      const uint8_t* row1 = row0 + image.stride;
+      uint8_t* out = output + y * width;
+      unsigned x = 0;
+#if defined(MARKER_DETECTOR_USE_NEON)
+      for (; x + 16 <= width; x += 16)
+      {
+        uint8x16x2_t top = vld2q_u8(row0 + x * 2);
+        uint8x16x2_t bottom = vld2q_u8(row1 + x * 2);
+        uint8x16_t topAverage = vrhaddq_u8(top.val[0], top.val[1]);
+        uint8x16_t bottomAverage = vrhaddq_u8(bottom.val[0], bottom.val[1]);
+        vst1q_u8(out + x, vrhaddq_u8(topAverage, bottomAverage));
+      }
+#elif defined(MARKER_DETECTOR_USE_SSE2)
+      const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+      for (; x + 16 <= width; x += 16)
+      {
+        __m128i v0 = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 2)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 2)));
+        __m128i v1 = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 2 + 16)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 2 + 16)));
+        __m128i h0 = _mm_avg_epu16(_mm_and_si128(v0, lowBytes), _mm_srli_epi16(v0, 8));
+        __m128i h1 = _mm_avg_epu16(_mm_and_si128(v1, lowBytes), _mm_srli_epi16(v1, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(h0, h1));
+      }
+#endif
+      for (; x < width; x++)
+      {
+        out[x] = (row0[x * 2] + row0[x * 2 + 1] + row1[x * 2] + row1[x * 2 + 1] + 2) >> 2;
+      }
+    }
+  });
+
+  workingImage.data = output;
+  workingImage.width = width;
+  workingImage.height = height;
+  workingImage.stride = width;
+  return workingImage;
+}
+
+void MarkerDetector::threshold(const GrayImage& image)
+{
+  const unsigned width = image.width;
+  const unsigned height = image.height;
+  const unsigned tileSize = params.tileSize;
+  const unsigned tilesX = width / tileSize;
+  const unsigned tilesY = height / tileSize;
+
+  binaryImage.assign(width * height, 0);
+  if (tilesX == 0 || tilesY == 0)
+  {
+    return;
+  }
+
+  tileMin.resize(tilesX * tilesY);
+  tileMax.resize(tilesX * tilesY);
+  tileThreshold.resize(tilesX * tilesY);
+
+  // Extrema of every tile.
+  threadPool.parallelFor(tilesY, [&](unsigned ty)
+  {
+    uint8_t* mins = &tileMin[ty * tilesX];
+    uint8_t* maxs = &tileMax[ty * tilesX];
+    const uint8_t* tileRow = image.data + ty * tileSize * image.stride;
+    unsigned tx = 0;
+#if defined(MARKER_DETECTOR_USE_NEON) || defined(MARKER_DETECTOR_USE_SSE2)
+    // 16 byte vectors cover two 8 pixel wide tiles.
+    if (tileSize == 8)
+    {
+      uint8_t lanesMin[16];
+      uint8_t lanesMax[16];
+      for (; tx + 2 <= tilesX; tx += 2)
+      {
+        const uint8_t* p = tileRow + tx * 8;
+#if defined(MARKER_DETECTOR_USE_NEON)
+        uint8x16_t vmin = vdupq_n_u8(255);
+        uint8x16_t vmax = vdupq_n_u8(0);
+        for (unsigned r = 0; r < 8; r++, p += image.stride)
+        {
+          uint8x16_t v = vld1q_u8(p);
+          vmin = vminq_u8(vmin, v);
+          vmax = vmaxq_u8(vmax, v);
+        }
+        vst1q_u8(lanesMin, vmin);
+        vst1q_u8(lanesMax, vmax);
+#else
+        __m128i vmin = _mm_set1_epi8(static_cast<char>(255));
+        __m128i vmax = _mm_setzero_si128();
+        for (unsigned r = 0; r < 8; r++, p += image.stride)
+        {
+          __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+          vmin = _mm_min_epu8(vmin, v);
+          vmax = _mm_max_epu8(vmax, v);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanesMin), vmin);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanesMax), vmax);
+#endif
+        for (unsigned half = 0; half < 2; half++)
+        {
+          uint8_t mn = 255, mx = 0;
+          for (unsigned i = half * 8; i < half * 8 + 8; i++)
+          {
+            mn = std::min(mn, lanesMin[i]);
+            mx = std::max(mx, lanesMax[i]);
+          }
+          mins[tx + half] = mn;
+          maxs[tx + half] = mx;
+        }
+      }
+    }
+#endif
+    for (; tx < tilesX; tx++)
+    {
+      uint8_t mn = 255, mx = 0;
+      const uint8_t* p = tileRow + tx * tileSize;
+      for (unsigned r = 0; r < tileSize; r++, p += image.stride)
+      {
+        for (unsigned c = 0; c < tileSize; c++)
+        {
+          mn = std::min(mn, p[c]);
+          mx = std::max(mx, p[c]);
+        }
+      }
+      mins[tx] = mn;
+      maxs[tx] = mx;
+    }
+  });
+
+  // The threshold of a tile is the middle of the range of its 3x3
+  // neighbourhood. Low contrast neighbourhoods are background: a threshold
+  // of 0 never classifies a pixel as dark.
+  for (unsigned ty = 0; ty < tilesY; ty++)
+  {
+    for (unsigned tx = 0; tx < tilesX; tx++)
+    {
+      uint8_t mn = 255, mx = 0;
+      for (unsigned ny = (ty > 0 ? ty - 1 : 0); ny <= std::min(ty + 1, tilesY - 1); ny++)
+      {
+        for (unsigned nx = (tx > 0 ? tx - 1 : 0); nx <= std::min(tx + 1, tilesX - 1); nx++)
+        {
+          mn = std::min(mn, tileMin[ny * tilesX + nx]);
+          mx = std::max(mx, tileMax[ny * tilesX + nx]);
+        }
+      }
+      tileThreshold[ty * tilesX + tx] = (mx - mn < static_cast<int>(params.minContrast)) ? 0 : (mn + mx + 1) / 2;
+    }
+  }
+
+  // Binarize: 1 for pixels darker than the threshold of their tile. Pixels
+  // past the last full tile use the threshold of the last tile.
+  threadPool.parallelFor(tilesY, [&](unsigned ty)
+  {
+    const uint8_t* thresholds = &tileThreshold[ty * tilesX];
+    unsigned endY = (ty + 1 == tilesY) ? height : (ty + 1) * tileSize;
+    for (unsigned y = ty * tileSize; y < endY; y++)
+    {
+      const uint8_t* in = image.data + y * image.stride;
+      uint8_t* out = &binaryImage[y * width];
+      unsigned x = 0;
+#if defined(MARKER_DETECTOR_USE_NEON) || defined(MARKER_DETECTOR_USE_SSE2)
+      if (tileSize == 8)
+      {
+        for (unsigned tx = 0; tx + 2 <= tilesX; tx += 2, x += 16)
+        {
+#if defined(MARKER_DETECTOR_USE_NEON)
+          uint8x16_t t = vcombine_u8(vdup_n_u8(thresholds[tx]), vdup_n_u8(thresholds[tx + 1]));
+          uint8x16_t dark = vandq_u8(vcltq_u8(vld1q_u8(in + x), t), vdupq_n_u8(1));
+          vst1q_u8(out + x, dark);
+#else
+          __m128i t = _mm_unpacklo_epi64(_mm_set1_epi8(static_cast<char>(thresholds[tx])), _mm_set1_epi8(static_cast<char>(thresholds[tx + 1])));
+          __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x));
+          // p < t exactly when the saturated t - p is not zero.
+          __m128i notDark = _mm_cmpeq_epi8(_mm_subs_epu8(t, v), _mm_setzero_si128());
+          __m128i dark = _mm_andnot_si128(notDark, _mm_set1_epi8(1));
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), dark);
+#endif
+        }
+      }
+#endif
+      for (; x < width; x++)
+      {
+        unsigned tx = std::min(x / tileSize, tilesX - 1);
+        out[x] = in[x] < thresholds[tx] ? 1 : 0;
+      }
+    }
+  });
+
+  // Force a background frame so contour tracing never leaves the image.
+  memset(&binaryImage[0], 0, width);
+  memset(&binaryImage[(height - 1) * width], 0, width);
+  for (unsigned y = 0; y < height; y++)
+  {
+    binaryImage[y * width] = 0;
+    binaryImage[y * width + width - 1] = 0;
+  }
+}
+
+void MarkerDetector::findCandidates(std::vector<Candidate>& candidates)
+{
+  const int width = workingImage.width;
+  const int height = workingImage.height;
+  if (binaryImage.size() != static_cast<size_t>(width * height))
+  {
+    return;
+  }
+  traced.assign(width * height, 0);
+  const size_t maxLength = 4 * (width + height);
+  const uint8_t* binary = binaryImage.data();
+  std::vector<int> vertices;
+
+  for (int y = 1; y < height - 1; y++)
+  {
+    const uint8_t* row = binary + y * width;
+    for (int x = 1; x < width - 1; x++)
+    {
+      if (!row[x] || row[x - 1] || traced[y * width + x])
+      {
+        continue;
+      }
+      traceContour(binary, traced.data(), width, x, y, maxLength, contour);
+      int count = contour.size() / 2;
+      if (count < static_cast<int>(params.minPerimeter) || contour.size() >= maxLength * 2)
+      {
+        continue;
+      }
+
+      // Outer borders are traced clockwise on the screen (positive area with y
+      // pointing down), hole borders the other way.
+      double area = 0;
+      for (int i = 0; i < count; i++)
+      {
+        int j = (i + 1) % count;
+        area += static_cast<double>(contour[i * 2]) * contour[j * 2 + 1] - static_cast<double>(contour[j * 2]) * contour[i * 2 + 1];
+      }
+      area *= 0.5;
+      double minSide = params.minPerimeter / 4.0;
+      if (area < minSide * minSide * 0.5)
+      {
+        continue;
+      }
+
+      double epsilon = std::max(2.0, count * kPolygonEpsilonFactor);
+      approximatePolygon(contour.data(), count, epsilon, 4, vertices);
+      if (vertices.size() != 4)
+      {
+        continue;
+      }
+
+      // Reject concave quads and quads with very short sides.
+      bool valid = true;
+      double crossSign = 0;
+      for (int i = 0; i < 4 && valid; i++)
+      {
+        const int* a = &contour[vertices[i] * 2];
+        const int* b = &contour[vertices[(i + 1) % 4] * 2];
+        const int* c = &contour[vertices[(i + 2) % 4] * 2];
+        double abx = b[0] - a[0], aby = b[1] - a[1];
+        double bcx = c[0] - b[0], bcy = c[1] - b[1];
+        double cross = abx * bcy - aby * bcx;
+        valid = (crossSign == 0 || cross * crossSign > 0) && (abx * abx + aby * aby) >= minSide * minSide * 0.25;
+        crossSign = cross;
+      }
+      if (!valid)
+      {
+        continue;
+      }
+
+      // Refine every corner as the intersection of the lines fitted to the
+      // two adjacent edges, moved half a pixel outwards to the actual edge
+      // between the dark and the light pixels.
+      double centroid[2] = { 0, 0 };
+      for (int i = 0; i < 4; i++)
+      {
+        centroid[0] += contour[vertices[i] * 2] * 0.25;
+        centroid[1] += contour[vertices[i] * 2 + 1] * 0.25;
+      }
+      Line lines[4];
+      bool linesValid = true;
+      for (int i = 0; i < 4 && linesValid; i++)
+      {
+        int first = vertices[i];
+        int length = (vertices[(i + 1) % 4] - first + count) % count;
+        int trim = static_cast<int>(length * kEdgeTrimFactor) + 1;
+        linesValid = fitLine(contour.data(), count, first + trim, length - 2 * trim, lines[i]);
+        if (linesValid)
+        {
+          double side = lines[i].normal[0] * centroid[0] + lines[i].normal[1] * centroid[1] - lines[i].distance;
+          lines[i].distance += side < 0 ? 0.5 : -0.5;
+        }
+      }
+
+      Candidate candidate;
+      const double scale = decimation;
+      const double offset = (decimation - 1) * 0.5;
+      for (int i = 0; i < 4; i++)
+      {
+        double corner[2];
+        if (!linesValid || !intersectLines(lines[(i + 3) % 4], lines[i], corner))
+        {
+          corner[0] = contour[vertices[i] * 2];
+          corner[1] = contour[vertices[i] * 2 + 1];
+        }
+        candidate.corners[i][0] = static_cast<float>(corner[0] * scale + offset);
+        candidate.corners[i][1] = static_cast<float>(corner[1] * scale + offset);
+      }
+      candidates.push_back(candidate);
+    }
+  }
+}
+
+bool MarkerDetector::decode(const GrayImage& image, const Candidate& candidate, DetectedMarker& marker) const
+{
+  const double G = GRID_SIZE;
+  const double grid[4][2] = { { 0, 0 }, { G, 0 }, { G, G }, { 0, G } };
+  double corners[4][2];
+  for (int i = 0; i < 4; i++)
+  {
+    corners[i][0] = candidate.corners[i][0];
+    corners[i][1] = candidate.corners[i][1];
+  }
+  double h[9];
+  if (!computeHomography(grid, corners, h))
+  {
+    return false;
+  }
+
+  // Average a few bilinear samples around every cell center.
+  static const double kOffsets[5][2] = { { 0, 0 }, { -0.2, 0 }, { 0.2, 0 }, { 0, -0.2 }, { 0, 0.2 } };
+  float cells[GRID_SIZE * GRID_SIZE];
+  float minValue = 255, maxValue = 0;
+  for (unsigned r = 0; r < GRID_SIZE; r++)
+  {
+    for (unsigned c = 0; c < GRID_SIZE; c++)
+    {
+      float sum = 0;
+      for (int s = 0; s < 5; s++)
+      {
+        double x, y;
+        if (!applyHomography(h, c + 0.5 + kOffsets[s][0], r + 0.5 + kOffsets[s][1], &x, &y))
+        {
+          return false;
+        }
+        float value = sampleBilinear(image, x, y);
+        if (value < 0)
+        {
+          return false;
+        }
+        sum += value;
+      }
+      float value = sum / 5;
+      cells[r * GRID_SIZE + c] = value;
+      minValue = std::min(minValue, value);
+      maxValue = std::max(maxValue, value);
+    }
+  }
+  if (maxValue - minValue < params.minContrast)
+  {
+    return false;
+  }
+  float threshold = (minValue + maxValue) * 0.5f;
+
+  unsigned borderErrors = 0;
+  uint16_t code = 0;
+  for (unsigned r = 0; r < GRID_SIZE; r++)
+  {
+    for (unsigned c = 0; c < GRID_SIZE; c++)
+    {
+      bool white = cells[r * GRID_SIZE + c] > threshold;
+      if (r == 0 || c == 0 || r == GRID_SIZE - 1 || c == GRID_SIZE - 1)
+      {
+        borderErrors += white ? 1 : 0;
+      }
+      else
+      {
+        code = (code << 1) | (white ? 1 : 0);
+      }
+    }
+  }
+  if (borderErrors > 1)
+  {
+    return false;
+  }
+
+  const Dictionary& dictionary = Dictionary::get();
+  uint32_t entry = dictionary.lookup[code];
+  if (entry == 0)
+  {
+    return false;
+  }
+  unsigned id = (entry - 1) / 4;
+  unsigned rotation = (entry - 1) % 4;
+  // The observed code is the dictionary code rotated `rotation` times, so the
+  // upper left corner of the marker is the one `4 - rotation` positions
+  // further.
+  unsigned shift = (4 - rotation) % 4;
+  uint16_t expected = dictionary.codes[id];
+  for (unsigned i = 0; i < shift; i++)
+  {
+    code = rotateCode(code);
+  }
+  if (popcount16(code ^ expected) > params.maxBitErrors)
+  {
+    return false;
+  }
+
+  marker.id = id;
+  // Upper left, upper right, lower right, lower left on the marker map to
+  // P3, P2, P1, P0.
+  for (int i = 0; i < 4; i++)
+  {
+    const float* corner = candidate.corners[(shift + i) % 4];
+    marker.corners[3 - i][0] = corner[0];
+    marker.corners[3 - i][1] = corner[1];
+  }
+  return true;
+}
+
+void MarkerDetector::estimatePose(const CameraModel& camera, double markerSize, DetectedMarker& marker) const
+{
+  const double s = markerSize * 0.5;
+  const double objectPoints[4][3] = { { -s, -s, 0 }, { s, -s, 0 }, { s, s, 0 }, { -s, s, 0 } };
+  double imagePoints[4][2];
+  double planePoints[4][2];
+  for (int i = 0; i < 4; i++)
+  {
+    imagePoints[i][0] = (marker.corners[i][0] - camera.cx) / camera.fx;
+    imagePoints[i][1] = (marker.corners[i][1] - camera.cy) / camera.fy;
+    planePoints[i][0] = objectPoints[i][0];
+    planePoints[i][1] = objectPoints[i][1];
+  }
+
+  // Initial pose from the plane to image homography: H ~ [r1 r2 t].
+  double h[9];
+  double rotation[9] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+  double t[3] = { 0, 0, 1 };
+  if (computeHomography(planePoints, imagePoints, h))
+  {
+    double h1[3] = { h[0], h[3], h[6] };
+    double h2[3] = { h[1], h[4], h[7] };
+    double h3[3] = { h[2], h[5], h[8] };
+    double norm1 = std::sqrt(h1[0] * h1[0] + h1[1] * h1[1] + h1[2] * h1[2]);
+    double norm2 = std::sqrt(h2[0] * h2[0] + h2[1] * h2[1] + h2[2] * h2[2]);
+    double lambda = 2.0 / (norm1 + norm2);
+    if (h3[2] * lambda < 0)
+    {
+      lambda = -lambda;
+    }
+    double r1[3] = { h1[0] * lambda, h1[1] * lambda, h1[2] * lambda };
+    double r2[3] = { h2[0] * lambda, h2[1] * lambda, h2[2] * lambda };
+    double r3[3];
+    cross3(r1, r2, r3);
+    double initial[9] = { r1[0], r2[0], r3[0], r1[1], r2[1], r3[1], r1[2], r2[2], r3[2] };
+    orthonormalize(initial);
+    memcpy(rotation, initial, sizeof(initial));
+    t[0] = h3[0] * lambda;
+    t[1] = h3[1] * lambda;
+    t[2] = h3[2] * lambda;
+  }
+
+  // Gauss-Newton refinement of the reprojection error. The rotation is
+  // updated as R = exp([w]x) * R.
+  for (int iteration = 0; iteration < kPoseRefinementIterations; iteration++)
+  {
+    double jtj[36] = { 0 };
+    double jte[6] = { 0 };
+    for (int i = 0; i < 4; i++)
+    {
+      double q[3];
+      multiplyMatrix3Vector(rotation, objectPoints[i], q);
+      double p[3] = { q[0] + t[0], q[1] + t[1], q[2] + t[2] };
+      if (p[2] <= 1e-9)
+      {
+        return;
+      }
+      double invZ = 1.0 / p[2];
+      double x = p[0] * invZ, y = p[1] * invZ;
+      double e[2] = { x - imagePoints[i][0], y - imagePoints[i][1] };
+      // d(x, y)/dp
+      double dp[2][3] = { { invZ, 0, -x * invZ }, { 0, invZ, -y * invZ } };
+      // dp/dw = -[q]x, dp/dt = I
+      double qx[3][3] = { { 0, q[2], -q[1] }, { -q[2], 0, q[0] }, { q[1], -q[0], 0 } };
+      double j[2][6];
+      for (int row = 0; row < 2; row++)
+      {
+        for (int col = 0; col < 3; col++)
+        {
+          j[row][col] = dp[row][0] * qx[0][col] + dp[row][1] * qx[1][col] + dp[row][2] * qx[2][col];
+          j[row][col + 3] = dp[row][col];
+        }
+      }
+      for (int row = 0; row < 2; row++)
+      {
+        for (int a = 0; a < 6; a++)
+        {
+          jte[a] += j[row][a] * e[row];
+          for (int b = 0; b < 6; b++)
+          {
+            jtj[a * 6 + b] += j[row][a] * j[row][b];
+          }
+        }
+      }
+    }
+    double delta[6];
+    for (int a = 0; a < 6; a++)
+    {
+      jtj[a * 6 + a] *= 1.0 + 1e-6;
+      delta[a] = -jte[a];
+    }
+    if (!solveLinearSystem(jtj, delta, 6))
+    {
+      break;
+    }
+    double update[9];
+    rodrigues(delta, update);
+    multiplyMatrix3(update, rotation, rotation);
+    orthonormalize(rotation);
+    t[0] += delta[3];
+    t[1] += delta[4];
+    t[2] += delta[5];
+    double step = 0;
+    for (int a = 0; a < 6; a++)
+    {
+      step += delta[a] * delta[a];
+    }
+    if (step < 1e-20)
+    {
+      break;
+    }
+  }
+
+  double squaredError = 0;
+  for (int i = 0; i < 4; i++)
+  {
+    double q[3];
+    multiplyMatrix3Vector(rotation, objectPoints[i], q);
+    double p[3] = { q[0] + t[0], q[1] + t[1], q[2] + t[2] };
+    double dx = (p[0] / p[2]) * camera.fx + camera.cx - marker.corners[i][0];
+    double dy = (p[1] / p[2]) * camera.fy + camera.cy - marker.corners[i][1];
+    squaredError += dx * dx + dy * dy;
+  }
+  marker.reprojectionError = std::sqrt(squaredError / 4);
+  memcpy(marker.translation, t, sizeof(t));
+  matrixToQuaternion(rotation, marker.orientation);
+}
+
+}  // namespace tango_chromium
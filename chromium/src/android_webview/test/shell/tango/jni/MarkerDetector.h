@@ -0,0 +1,151 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MARKER_DETECTOR_H_
+#define _MARKER_DETECTOR_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "ThreadPool.h"
+
+namespace tango_chromium {
+
+// An 8 bit grayscale image. The luma plane of an NV21 TangoImageBuffer can be
+// used directly (data, width, height and stride of the buffer).
+struct GrayImage
+{
+	const uint8_t* data;
+	uint32_t width;
+	uint32_t height;
+	uint32_t stride;
+};
+
+// Pinhole intrinsics of the camera that captured the image. Lens distortion is
+// not modelled.
+struct CameraModel
+{
+	double fx;
+	double fy;
+	double cx;
+	double cy;
+};
+
+// A marker found in an image. The pose is the transform from the marker frame
+// to the camera frame (x right, y down, z forward, like
+// TANGO_SUPPORT_ENGINE_TANGO). The marker frame has X to the right on the tag,
+// Y up on the tag and Z pointing out of the tag, like TangoSupportMarker.
+struct DetectedMarker
+{
+	int id;
+	// P3 -- P2
+	// |     |
+	// P0 -- P1
+	float corners[4][2];
+	double translation[3];
+	double orientation[4];
+	// RMS reprojection error of the corners, in pixels.
+	double reprojectionError;
+};
+
+struct MarkerDetectorParams
+{
+	MarkerDetectorParams();
+
+	// Side, in pixels, of the tiles used to compute the local threshold.
+	unsigned tileSize;
+	// Tiles whose neighbourhood has a lower max - min contrast are considered
+	// background.
+	unsigned minContrast;
+	// Images wider than this are downsampled by 2 before the threshold and
+	// contour stages. Bits and corners are always read at full resolution.
+	unsigned decimateWidth;
+	// Minimum perimeter, in pixels of the (possibly decimated) working image,
+	// for a contour to be considered as a marker candidate.
+	unsigned minPerimeter;
+	// Maximum number of interior bits that can be corrected when decoding.
+	unsigned maxBitErrors;
+};
+
+// Square fiducial detector. Markers are 6x6 cell grids: a one cell black
+// border around 4x4 data bits (white = 1), read row by row from the top left
+// cell. Ids index a dictionary of rotation-invariant codes with a minimum
+// Hamming distance of 3 between any two codes in any rotation.
+//
+// The pipeline is: tile based adaptive threshold (SIMD), outer contour
+// tracing, quad fitting with sub pixel edge refinement, bit decoding through
+// the quad homography and planar PnP (homography decomposition followed by
+// Gauss-Newton refinement of the reprojection error).
+class MarkerDetector
+{
+public:
+	static const unsigned GRID_SIZE = 6;
+	static const unsigned DATA_SIZE = 4;
+
+	explicit MarkerDetector(const MarkerDetectorParams& params = MarkerDetectorParams(), unsigned numberOfThreads = 0);
+
+	MarkerDetector(const MarkerDetector& other) = delete;
+	MarkerDetector& operator=(const MarkerDetector& other) = delete;
+
+	// Detects the markers in the image. markerSize is the side of the black
+	// square in meters.
+	void detect(const GrayImage& image, const CameraModel& camera, double markerSize, std::vector<DetectedMarker>& markers);
+
+	// Expresses the pose of a detected marker in another frame, given the pose
+	// of the camera in that frame (translation and x, y, z, w quaternion).
+	static void transformMarkerPose(const DetectedMarker& marker, const double* cameraTranslation, const double* cameraOrientation, double* translation, double* orientation);
+
+	static unsigned getDictionarySize();
+	// The 16 data bits of a marker id, most significant bit first.
+	static uint16_t getCode(unsigned id);
+
+	// Exposed for tests and benchmarks.
+	const std::vector<uint8_t>& getBinaryImage() const
+	{
+		return binaryImage;
+	}
+
+private:
+	struct Candidate
+	{
+		// Quad corners in full resolution pixel coordinates, clockwise on the
+		// screen starting from an arbitrary corner.
+		float corners[4][2];
+	};
+
+	const GrayImage& prepareWorkingImage(const GrayImage& image);
+	void threshold(const GrayImage& image);
+	void findCandidates(std::vector<Candidate>& candidates);
+	bool decode(const GrayImage& image, const Candidate& candidate, DetectedMarker& marker) const;
+	void estimatePose(const CameraModel& camera, double markerSize, DetectedMarker& marker) const;
+
+	MarkerDetectorParams params;
+	ThreadPool threadPool;
+
+	unsigned decimation;
+	GrayImage workingImage;
+	std::vector<uint8_t> decimatedImage;
+	std::vector<uint8_t> tileMin;
+	std::vector<uint8_t> tileMax;
+	std::vector<uint8_t> tileThreshold;
+	std::vector<uint8_t> binaryImage;
+	std::vector<uint8_t> traced;
+	std::vector<int> contour;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _MARKER_DETECTOR_H_
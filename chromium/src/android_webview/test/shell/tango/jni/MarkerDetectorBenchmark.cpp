@@ -0,0 +1,109 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Runs the marker detector over NV21 frames recorded from the Tango color
+// camera (raw TangoImageBuffer data, concatenated) and reports the time per
+// frame for different numbers of threads.
+//
+// Usage: marker_detector_benchmark frames.nv21 width height fx fy cx cy
+//        [markerSize] [iterations]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+
+#include "MarkerDetector.h"
+
+using tango_chromium::CameraModel;
+using tango_chromium::DetectedMarker;
+using tango_chromium::GrayImage;
+using tango_chromium::MarkerDetector;
+using tango_chromium::MarkerDetectorParams;
+
+int main(int argc, char** argv)
+{
+  if (argc < 8)
+  {
+    fprintf(stderr, "Usage: %s frames.nv21 width height fx fy cx cy [markerSize] [iterations]\n", argv[0]);
+    return 1;
+  }
+
+  const unsigned width = atoi(argv[2]);
+  const unsigned height = atoi(argv[3]);
+  CameraModel camera;
+  camera.fx = atof(argv[4]);
+  camera.fy = atof(argv[5]);
+  camera.cx = atof(argv[6]);
+  camera.cy = atof(argv[7]);
+  const double markerSize = argc > 8 ? atof(argv[8]) : 0.1;
+  const int iterations = argc > 9 ? atoi(argv[9]) : 10;
+
+  // Only the luma plane of every frame is kept.
+  const size_t frameSize = width * height * 3 / 2;
+  std::ifstream file(argv[1], std::ios::binary);
+  if (!file || width == 0 || height == 0)
+  {
+    fprintf(stderr, "Could not open %s\n", argv[1]);
+    return 1;
+  }
+  std::vector<std::vector<uint8_t>> frames;
+  std::vector<uint8_t> frame(frameSize);
+  while (file.read(reinterpret_cast<char*>(frame.data()), frameSize))
+  {
+    frames.push_back(std::vector<uint8_t>(frame.begin(), frame.begin() + width * height));
+  }
+  if (frames.empty())
+  {
+    fprintf(stderr, "No complete %ux%u frame in %s\n", width, height, argv[1]);
+    return 1;
+  }
+  printf("%zu frames of %ux%u\n", frames.size(), width, height);
+
+  unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  for (unsigned threads = 1; threads <= maxThreads; threads *= 2)
+  {
+    MarkerDetector detector(MarkerDetectorParams(), threads);
+    std::vector<DetectedMarker> markers;
+    size_t markerCount = 0;
+    double maxReprojectionError = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int iteration = 0; iteration < iterations; iteration++)
+    {
+      for (const std::vector<uint8_t>& luma : frames)
+      {
+        GrayImage image;
+        image.data = luma.data();
+        image.width = width;
+        image.height = height;
+        image.stride = width;
+        detector.detect(image, camera, markerSize, markers);
+        markerCount += markers.size();
+        for (const DetectedMarker& marker : markers)
+        {
+          maxReprojectionError = std::max(maxReprojectionError, marker.reprojectionError);
+        }
+      }
+    }
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    unsigned detections = iterations * frames.size();
+    printf("%u thread(s): %.3f ms/frame, %.2f markers/frame, max reprojection error %.3f px\n",
+        threads, elapsed / detections, static_cast<double>(markerCount) / detections, maxReprojectionError);
+  }
+  return 0;
+}
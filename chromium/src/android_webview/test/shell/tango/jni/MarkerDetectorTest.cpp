@@ -0,0 +1,363 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MarkerDetector.h"
+
+#include <cmath>
+#include <set>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace tango_chromium {
+
+namespace {
+
+const unsigned kWidth = 640;
+const unsigned kHeight = 480;
+const double kMarkerSize = 0.1;
+
+CameraModel makeCamera(unsigned width = kWidth, unsigned height = kHeight)
+{
+  CameraModel camera;
+  camera.fx = camera.fy = width * 500.0 / kWidth;
+  camera.cx = (width - 1) * 0.5;
+  camera.cy = (height - 1) * 0.5;
+  return camera;
+}
+
+// Marker to camera rotation (row major) from rotations around the camera axes
+// applied to a marker facing the camera.
+void makeRotation(double ax, double ay, double az, double* r)
+{
+  // Facing the camera: X right, Y up (camera -y), Z towards the camera (-z).
+  double facing[9] = { 1, 0, 0, 0, -1, 0, 0, 0, -1 };
+  double cx = std::cos(ax), sx = std::sin(ax);
+  double cy = std::cos(ay), sy = std::sin(ay);
+  double cz = std::cos(az), sz = std::sin(az);
+  double rx[9] = { 1, 0, 0, 0, cx, -sx, 0, sx, cx };
+  double ry[9] = { cy, 0, sy, 0, 1, 0, -sy, 0, cy };
+  double rz[9] = { cz, -sz, 0, sz, cz, 0, 0, 0, 1 };
+  double tmp[9], tmp2[9];
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 3; j++)
+    {
+      tmp[i * 3 + j] = 0;
+      for (int k = 0; k < 3; k++) tmp[i * 3 + j] += ry[i * 3 + k] * rx[k * 3 + j];
+    }
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 3; j++)
+    {
+      tmp2[i * 3 + j] = 0;
+      for (int k = 0; k < 3; k++) tmp2[i * 3 + j] += rz[i * 3 + k] * tmp[k * 3 + j];
+    }
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 3; j++)
+    {
+      r[i * 3 + j] = 0;
+      for (int k = 0; k < 3; k++) r[i * 3 + j] += tmp2[i * 3 + k] * facing[k * 3 + j];
+    }
+}
+
+// Ray casts a marker (with a one cell white quiet zone) on a gray background,
+// with 4x4 supersampling.
+class SyntheticImage
+{
+public:
+  SyntheticImage(unsigned width = kWidth, unsigned height = kHeight): width(width)
+    , height(height)
+    , pixels(width * height)
+  {
+  }
+
+  void render(unsigned id, const double* rotation, const double* translation, const CameraModel& camera)
+  {
+    const uint16_t code = MarkerDetector::getCode(id);
+    const double cell = kMarkerSize / MarkerDetector::GRID_SIZE;
+    // Columns of the rotation are the marker axes in the camera frame.
+    const double normal[3] = { rotation[2], rotation[5], rotation[8] };
+    const double d = normal[0] * translation[0] + normal[1] * translation[1] + normal[2] * translation[2];
+    for (unsigned y = 0; y < height; y++)
+    {
+      for (unsigned x = 0; x < width; x++)
+      {
+        int sum = 0;
+        for (int sy = 0; sy < 4; sy++)
+        {
+          for (int sx = 0; sx < 4; sx++)
+          {
+            double ray[3] = { (x - 0.375 + sx * 0.25 - camera.cx) / camera.fx, (y - 0.375 + sy * 0.25 - camera.cy) / camera.fy, 1 };
+            double denominator = normal[0] * ray[0] + normal[1] * ray[1] + normal[2] * ray[2];
+            int value = 120;
+            if (std::fabs(denominator) > 1e-9)
+            {
+              double s = d / denominator;
+              double p[3] = { ray[0] * s - translation[0], ray[1] * s - translation[1], ray[2] * s - translation[2] };
+              // Marker coordinates: X right, Y up, origin at the center.
+              double mx = rotation[0] * p[0] + rotation[3] * p[1] + rotation[6] * p[2];
+              double my = rotation[1] * p[0] + rotation[4] * p[1] + rotation[7] * p[2];
+              int column = static_cast<int>(std::floor(mx / cell + 3));
+              int row = static_cast<int>(std::floor(3 - my / cell));
+              if (s > 0 && column >= -1 && column <= 6 && row >= -1 && row <= 6)
+              {
+                value = 230;
+                if (column >= 0 && column < 6 && row >= 0 && row < 6)
+                {
+                  value = 30;
+                  if (column >= 1 && column <= 4 && row >= 1 && row <= 4)
+                  {
+                    int bit = (row - 1) * 4 + (column - 1);
+                    value = (code >> (15 - bit)) & 1 ? 230 : 30;
+                  }
+                }
+              }
+            }
+            sum += value;
+          }
+        }
+        pixels[y * width + x] = static_cast<uint8_t>(sum / 16);
+      }
+    }
+  }
+
+  GrayImage image() const
+  {
+    GrayImage image;
+    image.data = pixels.data();
+    image.width = width;
+    image.height = height;
+    image.stride = width;
+    return image;
+  }
+
+  unsigned width;
+  unsigned height;
+  std::vector<uint8_t> pixels;
+};
+
+double quaternionAngle(const double* a, const double* b)
+{
+  double dot = std::fabs(a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]);
+  return 2 * std::acos(std::min(1.0, dot));
+}
+
+void rotationToQuaternion(const double* m, double* q)
+{
+  // The test rotations are either far from 180 degrees or close to 180
+  // degrees around X (the facing pose).
+  double trace = m[0] + m[4] + m[8];
+  if (trace > -0.99)
+  {
+    double s = std::sqrt(trace + 1.0) * 2;
+    q[3] = 0.25 * s;
+    q[0] = (m[7] - m[5]) / s;
+    q[1] = (m[2] - m[6]) / s;
+    q[2] = (m[3] - m[1]) / s;
+    return;
+  }
+  double s = std::sqrt(1.0 + m[0] - m[4] - m[8]) * 2;
+  q[3] = (m[7] - m[5]) / s;
+  q[0] = 0.25 * s;
+  q[1] = (m[1] + m[3]) / s;
+  q[2] = (m[2] + m[6]) / s;
+}
+
+struct PoseCase
+{
+  double ax;
+  double ay;
+  double az;
+  double tx;
+  double ty;
+  double tz;
+};
+
+}  // namespace
+
+TEST(MarkerDetectorTest, DictionaryIsRotationInvariant)
+{
+  ASSERT_GT(MarkerDetector::getDictionarySize(), 50u);
+  std::vector<uint16_t> rotations;
+  for (unsigned id = 0; id < MarkerDetector::getDictionarySize(); id++)
+  {
+    // Same rotation as the detector: new[r][c] = old[c][3 - r].
+    uint16_t code = MarkerDetector::getCode(id);
+    for (int k = 0; k < 4; k++)
+    {
+      rotations.push_back(code);
+      uint16_t rotated = 0;
+      for (int r = 0; r < 4; r++)
+        for (int c = 0; c < 4; c++)
+          if (code & (1 << (15 - (c * 4 + 3 - r))))
+            rotated |= 1 << (15 - (r * 4 + c));
+      code = rotated;
+    }
+  }
+  for (size_t i = 0; i < rotations.size(); i++)
+  {
+    for (size_t j = i + 1; j < rotations.size(); j++)
+    {
+      int distance = 0;
+      for (uint16_t v = rotations[i] ^ rotations[j]; v; v &= v - 1)
+      {
+        distance++;
+      }
+      ASSERT_GE(distance, 3) << i / 4 << " " << j / 4;
+    }
+  }
+}
+
+TEST(MarkerDetectorTest, EmptyImageHasNoMarkers)
+{
+  SyntheticImage synthetic;
+  std::fill(synthetic.pixels.begin(), synthetic.pixels.end(), 128);
+  MarkerDetector detector;
+  std::vector<DetectedMarker> markers;
+  detector.detect(synthetic.image(), makeCamera(), kMarkerSize, markers);
+  EXPECT_TRUE(markers.empty());
+}
+
+TEST(MarkerDetectorTest, NoiseHasNoMarkers)
+{
+  SyntheticImage synthetic;
+  uint32_t state = 12345;
+  for (uint8_t& pixel : synthetic.pixels)
+  {
+    state = state * 1664525 + 1013904223;
+    pixel = state >> 24;
+  }
+  MarkerDetector detector;
+  std::vector<DetectedMarker> markers;
+  detector.detect(synthetic.image(), makeCamera(), kMarkerSize, markers);
+  EXPECT_TRUE(markers.empty());
+}
+
+TEST(MarkerDetectorTest, DetectsIdAndPose)
+{
+  const CameraModel camera = makeCamera();
+  const PoseCase cases[] = {
+    { 0, 0, 0, 0, 0, 0.5 },
+    { 0, 0, 0.5, 0.05, -0.03, 0.6 },
+    { 0.4, 0, 1.8, -0.05, 0.02, 0.5 },
+    { 0, -0.5, -2.5, 0.02, 0.05, 0.7 },
+    { 0.3, 0.3, 3.1, 0, 0, 0.4 },
+    { -0.6, 0.2, 0.9, 0.1, 0.05, 0.8 },
+  };
+  MarkerDetector detector;
+  SyntheticImage synthetic;
+  unsigned id = 0;
+  for (const PoseCase& pose : cases)
+  {
+    id = (id + 7) % MarkerDetector::getDictionarySize();
+    double rotation[9];
+    makeRotation(pose.ax, pose.ay, pose.az, rotation);
+    double translation[3] = { pose.tx, pose.ty, pose.tz };
+    synthetic.render(id, rotation, translation, camera);
+
+    std::vector<DetectedMarker> markers;
+    detector.detect(synthetic.image(), camera, kMarkerSize, markers);
+    ASSERT_EQ(1u, markers.size()) << "id " << id;
+    const DetectedMarker& marker = markers[0];
+    EXPECT_EQ(static_cast<int>(id), marker.id);
+    EXPECT_LT(marker.reprojectionError, 0.5);
+    for (int i = 0; i < 3; i++)
+    {
+      EXPECT_NEAR(translation[i], marker.translation[i], 0.01 * translation[2]);
+    }
+    double expected[4];
+    rotationToQuaternion(rotation, expected);
+    EXPECT_LT(quaternionAngle(expected, marker.orientation), 0.05);
+  }
+}
+
+TEST(MarkerDetectorTest, DetectsInDecimatedImage)
+{
+  const unsigned width = 1920, height = 1080;
+  const CameraModel camera = makeCamera(width, height);
+  SyntheticImage synthetic(width, height);
+  double rotation[9];
+  makeRotation(-0.3, 0.4, 0.7, rotation);
+  double translation[3] = { 0.03, -0.02, 0.5 };
+  synthetic.render(42, rotation, translation, camera);
+
+  MarkerDetector detector;
+  std::vector<DetectedMarker> markers;
+  detector.detect(synthetic.image(), camera, kMarkerSize, markers);
+  ASSERT_EQ(1u, markers.size());
+  EXPECT_EQ(42, markers[0].id);
+  EXPECT_LT(markers[0].reprojectionError, 0.5);
+  for (int i = 0; i < 3; i++)
+  {
+    EXPECT_NEAR(translation[i], markers[0].translation[i], 0.005);
+  }
+}
+
+TEST(MarkerDetectorTest, DetectsSeveralMarkers)
+{
+  const CameraModel camera = makeCamera();
+  SyntheticImage left, right;
+  double rotation[9];
+  makeRotation(0.2, 0, 0.3, rotation);
+  double leftTranslation[3] = { -0.1, 0, 0.6 };
+  double rightTranslation[3] = { 0.1, 0.02, 0.6 };
+  left.render(3, rotation, leftTranslation, camera);
+  right.render(11, rotation, rightTranslation, camera);
+  for (unsigned y = 0; y < kHeight; y++)
+  {
+    for (unsigned x = kWidth / 2; x < kWidth; x++)
+    {
+      left.pixels[y * kWidth + x] = right.pixels[y * kWidth + x];
+    }
+  }
+
+  MarkerDetector detector(MarkerDetectorParams(), 3);
+  std::vector<DetectedMarker> markers;
+  detector.detect(left.image(), camera, kMarkerSize, markers);
+  ASSERT_EQ(2u, markers.size());
+  std::set<int> ids;
+  for (const DetectedMarker& marker : markers)
+  {
+    ids.insert(marker.id);
+  }
+  EXPECT_EQ(1u, ids.count(3));
+  EXPECT_EQ(1u, ids.count(11));
+}
+
+TEST(MarkerDetectorTest, TransformMarkerPose)
+{
+  DetectedMarker marker;
+  marker.translation[0] = 1;
+  marker.translation[1] = 0;
+  marker.translation[2] = 0;
+  marker.orientation[0] = 0;
+  marker.orientation[1] = 0;
+  marker.orientation[2] = 0;
+  marker.orientation[3] = 1;
+  // Camera at (0, 0, 2) rotated 90 degrees around Z.
+  const double cameraTranslation[3] = { 0, 0, 2 };
+  const double cameraOrientation[4] = { 0, 0, std::sqrt(0.5), std::sqrt(0.5) };
+  double translation[3];
+  double orientation[4];
+  MarkerDetector::transformMarkerPose(marker, cameraTranslation, cameraOrientation, translation, orientation);
+  EXPECT_NEAR(0, translation[0], 1e-9);
+  EXPECT_NEAR(1, translation[1], 1e-9);
+  EXPECT_NEAR(2, translation[2], 1e-9);
+  for (int i = 0; i < 4; i++)
+  {
+    EXPECT_NEAR(cameraOrientation[i], orientation[i], 1e-9);
+  }
+}
+
+}  // namespace tango_chromium
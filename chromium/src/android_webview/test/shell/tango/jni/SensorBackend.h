@@ -0,0 +1,114 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SENSOR_BACKEND_H_
+#define _SENSOR_BACKEND_H_
+
+#include <cstdint>
+
+namespace tango_chromium {
+
+enum SensorFrame
+{
+	SENSOR_FRAME_START_OF_SERVICE,
+	SENSOR_FRAME_AREA_DESCRIPTION,
+	SENSOR_FRAME_CAMERA_COLOR,
+	SENSOR_FRAME_CAMERA_DEPTH
+};
+
+// Axes convention of the target frame of a pose. The base frame always uses
+// the OpenGL world convention (Y up).
+enum SensorConvention
+{
+	// X right, Y up, Z backwards.
+	SENSOR_CONVENTION_OPENGL,
+	// X right, Y down, Z forward.
+	SENSOR_CONVENTION_TANGO
+};
+
+// Display rotations use the TangoSupportRotation values: 0 to 3 quarter turns,
+// or SENSOR_ROTATION_IGNORED.
+const int SENSOR_ROTATION_IGNORED = -1;
+
+struct SensorPose
+{
+	double timestamp;
+	double translation[3];
+	// x, y, z, w.
+	double orientation[4];
+	// Whether the pose could be estimated (TANGO_POSE_VALID).
+	bool valid;
+};
+
+struct SensorPointCloud
+{
+	double timestamp;
+	uint32_t numberOfPoints;
+	// x, y, z, confidence in the depth camera frame (Tango convention). Owned by
+	// the backend, valid until the next getLatestPointCloud call.
+	const float (*points)[4];
+};
+
+struct SensorCameraIntrinsics
+{
+	uint32_t width;
+	uint32_t height;
+	double fx;
+	double fy;
+	double cx;
+	double cy;
+	double distortion[5];
+	int calibrationType;
+};
+
+// The source of the sensor data. TangoHandler works with TangoSensorBackend,
+// which gets it from the Tango Service. SyntheticSensorBackend generates it so
+// the algorithms TangoHandler uses (see SensorProcessing.h) can run on the
+// host.
+class SensorBackend
+{
+public:
+	virtual ~SensorBackend() {}
+
+	// The pose of target relative to base at timestamp, 0 for the latest one.
+	// displayRotation only applies to the color camera. Returns false if the
+	// query failed, a pose that could not be estimated is returned with valid
+	// set to false.
+	virtual bool getPose(double timestamp, SensorFrame base, SensorFrame target, SensorConvention targetConvention, int displayRotation, SensorPose* pose) = 0;
+	// Same as getPose, as a column major matrix that transforms from target to
+	// base. Returns false if the pose is not valid.
+	virtual bool getMatrixTransform(double timestamp, SensorFrame base, SensorFrame target, SensorConvention targetConvention, int displayRotation, float* matrix) = 0;
+	// Column major matrix that transforms from the depth camera frame at
+	// depthTimestamp to the color camera frame at colorTimestamp, both in the
+	// Tango convention and without display rotation.
+	virtual bool getDepthToColorTransform(double depthTimestamp, double colorTimestamp, float* matrix) = 0;
+
+	virtual bool getColorCameraIntrinsics(int displayRotation, SensorCameraIntrinsics* intrinsics) = 0;
+
+	virtual uint32_t getMaxNumberOfPointsInPointCloud() const = 0;
+	virtual bool getLatestPointCloud(SensorPointCloud* pointCloud) = 0;
+	// Fits a plane to the points of pointCloud around the normalized position
+	// (u, v) of the color camera image at colorTimestamp. point and plane (a, b,
+	// c, d with ax + by + cz + d = 0) are in the depth camera frame of the
+	// point cloud.
+	virtual bool fitPlaneNearPoint(const SensorPointCloud& pointCloud, double colorTimestamp, float u, float v, int displayRotation, double* point, double* plane) = 0;
+
+	virtual void resetPose() = 0;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _SENSOR_BACKEND_H_
@@ -0,0 +1,249 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SyntheticSensorBackend.h"
+
+#include <cmath>
+#include <vector>
+
+#include "SensorMath.h"
+#include "SensorProcessing.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace tango_chromium {
+
+namespace {
+
+constexpr double kEpsilon = 1e-4;
+
+// Distance from point to the nearest wall of the room.
+double distanceToRoom(const SyntheticSceneParameters& parameters, const float* point)
+{
+  double distances[] = {
+    std::fabs(std::fabs(point[0]) - parameters.roomWidth / 2.0),
+    std::fabs(point[1]),
+    std::fabs(point[1] - parameters.roomHeight),
+    std::fabs(std::fabs(point[2]) - parameters.roomDepth / 2.0)
+  };
+  double distance = distances[0];
+  for (double d : distances)
+  {
+    distance = std::min(distance, d);
+  }
+  return distance;
+}
+
+// The texture coordinates the camera image UV transform maps (u, v) to.
+void transformUV(const float* matrix, float u, float v, float* uv)
+{
+  uv[0] = matrix[0] * u + matrix[4] * v + matrix[12];
+  uv[1] = matrix[1] * u + matrix[5] * v + matrix[13];
+}
+
+}  // namespace
+
+TEST(SyntheticSensorBackendTest, PosesFollowTheTrajectory)
+{
+  SyntheticSceneParameters parameters;
+  SyntheticSensorBackend backend(parameters);
+  backend.setTime(2.0);
+
+  SensorPose pose;
+  ASSERT_TRUE(backend.getPose(0, SENSOR_FRAME_START_OF_SERVICE, SENSOR_FRAME_CAMERA_COLOR, SENSOR_CONVENTION_OPENGL, 0, &pose));
+  EXPECT_TRUE(pose.valid);
+  EXPECT_DOUBLE_EQ(2.0, pose.timestamp);
+  double angle = parameters.angularSpeed * 2.0;
+  EXPECT_NEAR(parameters.trajectoryRadius * std::cos(angle), pose.translation[0], kEpsilon);
+  EXPECT_NEAR(parameters.eyeHeight, pose.translation[1], kEpsilon);
+  EXPECT_NEAR(parameters.trajectoryRadius * std::sin(angle), pose.translation[2], kEpsilon);
+  double length = std::sqrt(pose.orientation[0] * pose.orientation[0] + pose.orientation[1] * pose.orientation[1] +
+      pose.orientation[2] * pose.orientation[2] + pose.orientation[3] * pose.orientation[3]);
+  EXPECT_NEAR(1.0, length, kEpsilon);
+}
+
+TEST(SyntheticSensorBackendTest, AreaDescriptionCorrection)
+{
+  SyntheticSensorBackend backend;
+  backend.setTime(1.0);
+
+  float correction[16];
+  float startOfService[16];
+  float areaDescription[16];
+  ASSERT_TRUE(backend.getMatrixTransform(0, SENSOR_FRAME_AREA_DESCRIPTION, SENSOR_FRAME_START_OF_SERVICE, SENSOR_CONVENTION_OPENGL, SENSOR_ROTATION_IGNORED, correction));
+  ASSERT_TRUE(backend.getMatrixTransform(0, SENSOR_FRAME_START_OF_SERVICE, SENSOR_FRAME_CAMERA_COLOR, SENSOR_CONVENTION_OPENGL, 0, startOfService));
+  ASSERT_TRUE(backend.getMatrixTransform(0, SENSOR_FRAME_AREA_DESCRIPTION, SENSOR_FRAME_CAMERA_COLOR, SENSOR_CONVENTION_OPENGL, 0, areaDescription));
+
+  float corrected[16];
+  matrixMultiply(correction, startOfService, corrected);
+  EXPECT_TRUE(matricesAreEqual(areaDescription, corrected, kEpsilon));
+}
+
+TEST(SyntheticSensorBackendTest, PointCloudsLieOnTheWalls)
+{
+  SyntheticSceneParameters parameters;
+  SyntheticSensorBackend backend(parameters);
+  backend.setTime(3.3);
+
+  SensorPointCloud pointCloud;
+  ASSERT_TRUE(backend.getLatestPointCloud(&pointCloud));
+  EXPECT_EQ(backend.getMaxNumberOfPointsInPointCloud(), pointCloud.numberOfPoints);
+  // The depth camera runs at depthRate.
+  EXPECT_DOUBLE_EQ(3.2, pointCloud.timestamp);
+
+  float depthTransform[16];
+  ASSERT_TRUE(backend.getMatrixTransform(pointCloud.timestamp, SENSOR_FRAME_START_OF_SERVICE, SENSOR_FRAME_CAMERA_DEPTH, SENSOR_CONVENTION_TANGO, SENSOR_ROTATION_IGNORED, depthTransform));
+  std::vector<float> points(pointCloud.numberOfPoints * 3);
+  ASSERT_EQ(pointCloud.numberOfPoints, copyPointCloud(pointCloud, 0, depthTransform, points.data()));
+  for (uint32_t i = 0; i < pointCloud.numberOfPoints; i++)
+  {
+    ASSERT_LT(distanceToRoom(parameters, &points[i * 3]), 1e-3) << "point " << i;
+  }
+}
+
+TEST(SyntheticSensorBackendTest, DepthToColorTransform)
+{
+  SyntheticSensorBackend backend;
+
+  // The cameras share the same origin and orientation.
+  float matrix[16];
+  ASSERT_TRUE(backend.getDepthToColorTransform(1.0, 1.0, matrix));
+  for (int i = 0; i < 16; i++)
+  {
+    EXPECT_NEAR(i % 5 == 0 ? 1 : 0, matrix[i], kEpsilon) << i;
+  }
+
+  // Across timestamps, the motion of the camera is included.
+  float depthCamera[16];
+  float colorCamera[16];
+  float expected[16];
+  ASSERT_TRUE(backend.getDepthToColorTransform(1.0, 1.5, matrix));
+  ASSERT_TRUE(backend.getMatrixTransform(1.0, SENSOR_FRAME_START_OF_SERVICE, SENSOR_FRAME_CAMERA_DEPTH, SENSOR_CONVENTION_TANGO, SENSOR_ROTATION_IGNORED, depthCamera));
+  ASSERT_TRUE(backend.getMatrixTransform(1.5, SENSOR_FRAME_START_OF_SERVICE, SENSOR_FRAME_CAMERA_COLOR, SENSOR_CONVENTION_TANGO, SENSOR_ROTATION_IGNORED, colorCamera));
+  matrixInverse(colorCamera, colorCamera);
+  matrixMultiply(colorCamera, depthCamera, expected);
+  EXPECT_TRUE(matricesAreEqual(expected, matrix, kEpsilon));
+}
+
+TEST(SyntheticSensorBackendTest, CopyPointCloudSkipsPoints)
+{
+  const float xyzc[5][4] = {{0, 0, 1, 1}, {1, 0, 1, 1}, {2, 0, 1, 1}, {3, 0, 1, 1}, {4, 0, 1, 1}};
+  SensorPointCloud pointCloud;
+  pointCloud.timestamp = 0;
+  pointCloud.numberOfPoints = 5;
+  pointCloud.points = xyzc;
+
+  float points[15];
+  ASSERT_EQ(3u, copyPointCloud(pointCloud, 1, nullptr, points));
+  EXPECT_EQ(0, points[0]);
+  EXPECT_EQ(2, points[3]);
+  EXPECT_EQ(4, points[6]);
+
+  const float translation[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 10, 20, 30, 1};
+  ASSERT_EQ(2u, copyPointCloud(pointCloud, 2, translation, points));
+  EXPECT_EQ(10, points[0]);
+  EXPECT_EQ(20, points[1]);
+  EXPECT_EQ(31, points[2]);
+  EXPECT_EQ(13, points[3]);
+}
+
+TEST(SyntheticSensorBackendTest, HitTestFindsTheWall)
+{
+  SyntheticSensorBackend backend;
+  // The point cloud is from 0.4, the color camera has moved since.
+  backend.setTime(0.5);
+
+  SensorPointCloud pointCloud;
+  ASSERT_TRUE(backend.getLatestPointCloud(&pointCloud));
+  float depthTransform[16];
+  ASSERT_TRUE(backend.getMatrixTransform(pointCloud.timestamp, SENSOR_FRAME_START_OF_SERVICE, SENSOR_FRAME_CAMERA_DEPTH, SENSOR_CONVENTION_TANGO, SENSOR_ROTATION_IGNORED, depthTransform));
+
+  // The hit at the center of the screen is along the viewing direction of the
+  // color camera.
+  float modelMatrix[16];
+  ASSERT_TRUE(hitTestPointCloud(backend, pointCloud, depthTransform, 0, 0.5f, 0.5f, 0, modelMatrix));
+
+  float camera[16];
+  ASSERT_TRUE(backend.getMatrixTransform(0, SENSOR_FRAME_START_OF_SERVICE, SENSOR_FRAME_CAMERA_COLOR, SENSOR_CONVENTION_OPENGL, 0, camera));
+  double origin[3] = {camera[12], camera[13], camera[14]};
+  double direction[3] = {-camera[8], -camera[9], -camera[10]};
+  double distance;
+  double normal[3];
+  ASSERT_TRUE(backend.castRay(origin, direction, &distance, normal));
+  for (int i = 0; i < 3; i++)
+  {
+    EXPECT_NEAR(origin[i] + direction[i] * distance, modelMatrix[12 + i], 1e-3);
+    // The Y axis of the hit is the normal of the wall.
+    EXPECT_NEAR(normal[i], modelMatrix[4 + i], 1e-3);
+  }
+}
+
+TEST(SyntheticSensorBackendTest, ProjectionMatrixMatchesIntrinsics)
+{
+  SyntheticSensorBackend backend;
+  SensorCameraIntrinsics intrinsics;
+  ASSERT_TRUE(backend.getColorCameraIntrinsics(1, &intrinsics));
+  EXPECT_LT(intrinsics.width, intrinsics.height);
+
+  float projection[16];
+  projectionMatrixFromIntrinsics(intrinsics, 0.1f, 100.0f, projection);
+  // A point on the right edge of the image projects to x = 1.
+  double z = -2.0;
+  double x = (intrinsics.width - intrinsics.cx) / intrinsics.fx * -z;
+  double clipX = projection[0] * x + projection[8] * z;
+  double clipW = projection[11] * z;
+  EXPECT_NEAR(1.0, clipX / clipW, kEpsilon);
+}
+
+TEST(SyntheticSensorBackendTest, CameraImageUVTransformFollowsTheRotation)
+{
+  float matrix[16];
+  float uv[2];
+  // A camera sensor mounted in landscape shown on a display rotated the same
+  // way is not rotated.
+  cameraImageUVTransform(1, 90, 1.0f, matrix);
+  transformUV(matrix, 0.25f, 0.75f, uv);
+  EXPECT_NEAR(0.25f, uv[0], kEpsilon);
+  EXPECT_NEAR(0.75f, uv[1], kEpsilon);
+
+  // Every quarter turn maps the corners of the display to different corners
+  // of the image.
+  for (int displayRotation = 0; displayRotation < 4; displayRotation++)
+  {
+    cameraImageUVTransform(displayRotation, 90, 1.0f, matrix);
+    transformUV(matrix, 0, 0, uv);
+    float expected[4][2] = {{1, 0}, {0, 0}, {0, 1}, {1, 1}};
+    EXPECT_NEAR(expected[displayRotation][0], uv[0], kEpsilon) << displayRotation;
+    EXPECT_NEAR(expected[displayRotation][1], uv[1], kEpsilon) << displayRotation;
+    transformUV(matrix, 0.5f, 0.5f, uv);
+    EXPECT_NEAR(0.5f, uv[0], kEpsilon) << displayRotation;
+    EXPECT_NEAR(0.5f, uv[1], kEpsilon) << displayRotation;
+  }
+}
+
+TEST(SyntheticSensorBackendTest, CameraImageUVTransformCropsTheBottom)
+{
+  float matrix[16];
+  float uv[2];
+  cameraImageUVTransform(0, 0, 0.8f, matrix);
+  transformUV(matrix, 1, 1, uv);
+  EXPECT_NEAR(1, uv[0], kEpsilon);
+  EXPECT_NEAR(1, uv[1], kEpsilon);
+  transformUV(matrix, 0, 0, uv);
+  EXPECT_NEAR(0, uv[0], kEpsilon);
+  EXPECT_NEAR(0.2f, uv[1], kEpsilon);
+}
+
+}  // namespace tango_chromium
@@ -0,0 +1,350 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the native hot paths of libtango_chromium (point cloud copies,
+// hit tests, depth image projection and the matrix helpers) on data generated by the
+// SyntheticSensorBackend, so the inputs are the same on every run and every
+// architecture. Reports ns/op and the bytes processed per op, as a table and,
+// with --json, as a JSON document that can be tracked per commit.
+//
+// Usage: tango_sensor_benchmark [--json=results.json|-] [--min-time=seconds]
+//        [--filter=substring]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "DepthDensifier.h"
+#include "DepthImageProjector.h"
+#include "SensorMath.h"
+#include "SensorProcessing.h"
+#include "SyntheticSensorBackend.h"
+
+using tango_chromium::DepthDensifier;
+using tango_chromium::DepthImage;
+using tango_chromium::DepthImageProjector;
+using tango_chromium::LumaImage;
+using tango_chromium::SENSOR_CONVENTION_OPENGL;
+using tango_chromium::SENSOR_CONVENTION_TANGO;
+using tango_chromium::SENSOR_FRAME_CAMERA_COLOR;
+using tango_chromium::SENSOR_FRAME_CAMERA_DEPTH;
+using tango_chromium::SENSOR_FRAME_START_OF_SERVICE;
+using tango_chromium::SENSOR_ROTATION_IGNORED;
+using tango_chromium::SensorCameraIntrinsics;
+using tango_chromium::SensorPointCloud;
+using tango_chromium::SyntheticSceneParameters;
+using tango_chromium::SyntheticSensorBackend;
+
+namespace {
+
+// The resolution of the Tango depth camera, so the point clouds have the size
+// of the ones returned on a device.
+const uint32_t kDepthColumns = 224;
+const uint32_t kDepthRows = 172;
+const double kTime = 0.5;
+
+struct BenchmarkResult
+{
+  std::string name;
+  uint64_t iterations;
+  double nanosecondsPerOperation;
+  double bytesPerOperation;
+};
+
+// Keeps the compiler from removing the benchmarked computations.
+volatile float benchmarkSink;
+
+class BenchmarkRunner
+{
+public:
+  BenchmarkRunner(double minimumTime, const std::string& filter, FILE* table): minimumTime(minimumTime), filter(filter), table(table)
+  {
+  }
+
+  // Runs operation in batches of growing size until they take at least
+  // minimumTime. bytesPerOperation is the size of the data operation reads or
+  // writes.
+  void run(const std::string& name, size_t bytesPerOperation, const std::function<void()>& operation)
+  {
+    if (!filter.empty() && name.find(filter) == std::string::npos)
+    {
+      return;
+    }
+
+    // Warm up the caches.
+    operation();
+
+    uint64_t iterations = 1;
+    double elapsed = 0;
+    while (true)
+    {
+      auto start = std::chrono::steady_clock::now();
+      for (uint64_t i = 0; i < iterations; i++)
+      {
+        operation();
+      }
+      elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+      if (elapsed >= minimumTime * 1e9 || iterations >= (1ull << 40))
+      {
+        break;
+      }
+      iterations *= elapsed > 0 && elapsed < minimumTime * 1e8 ? 10 : 2;
+    }
+
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.nanosecondsPerOperation = elapsed / iterations;
+    result.bytesPerOperation = bytesPerOperation;
+    results.push_back(result);
+    fprintf(table, "%-40s %12.1f ns/op %12.0f bytes/op %10.1f MB/s\n", name.c_str(),
+        result.nanosecondsPerOperation, result.bytesPerOperation,
+        result.bytesPerOperation * 1e3 / result.nanosecondsPerOperation);
+  }
+
+  bool writeJSON(FILE* file) const
+  {
+    fprintf(file, "{\n  \"benchmark\": \"tango_sensor_benchmark\",\n");
+    fprintf(file, "  \"architecture\": \"%s\",\n", architecture());
+    fprintf(file, "  \"compiler\": \"%s\",\n", __VERSION__);
+    fprintf(file, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+      const BenchmarkResult& result = results[i];
+      fprintf(file, "    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"bytes_per_op\": %.0f}%s\n",
+          result.name.c_str(), static_cast<unsigned long long>(result.iterations),
+          result.nanosecondsPerOperation, result.bytesPerOperation, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return !ferror(file);
+  }
+
+private:
+  static const char* architecture()
+  {
+#if defined(__aarch64__)
+    return "arm64";
+#elif defined(__arm__)
+    return "arm";
+#elif defined(__x86_64__)
+    return "x86_64";
+#elif defined(__i386__)
+    return "x86";
+#else
+    return "unknown";
+#endif
+  }
+
+  double minimumTime;
+  std::string filter;
+  FILE* table;
+  std::vector<BenchmarkResult> results;
+};
+
+void runPointCloudBenchmarks(BenchmarkRunner& runner, SyntheticSensorBackend& backend, const SensorPointCloud& pointCloud, const float* depthTransform)
+{
+  std::vector<float> points(backend.getMaxNumberOfPointsInPointCloud() * 3);
+  const size_t pointCloudSize = pointCloud.numberOfPoints * 4 * sizeof(float);
+
+  runner.run("copyPointCloud", pointCloudSize, [&]()
+  {
+    benchmarkSink = points[3 * copyPointCloud(pointCloud, 0, nullptr, points.data()) - 1];
+  });
+  runner.run("copyPointCloud/transform", pointCloudSize, [&]()
+  {
+    benchmarkSink = points[3 * copyPointCloud(pointCloud, 0, depthTransform, points.data()) - 1];
+  });
+  runner.run("copyPointCloud/skip3", pointCloudSize / 4, [&]()
+  {
+    benchmarkSink = points[3 * copyPointCloud(pointCloud, 3, nullptr, points.data()) - 1];
+  });
+  runner.run("copyPointCloud/skip3/transform", pointCloudSize / 4, [&]()
+  {
+    benchmarkSink = points[3 * copyPointCloud(pointCloud, 3, depthTransform, points.data()) - 1];
+  });
+
+  float modelMatrix[16];
+  runner.run("hitTestPointCloud", sizeof(modelMatrix), [&]()
+  {
+    hitTestPointCloud(backend, pointCloud, depthTransform, kTime, 0.5f, 0.5f, 0, modelMatrix);
+    benchmarkSink = modelMatrix[14];
+  });
+}
+
+void runDepthImageBenchmarks(BenchmarkRunner& runner, SyntheticSensorBackend& backend, const SensorPointCloud& pointCloud)
+{
+  float depthToColor[16];
+  SensorCameraIntrinsics intrinsics;
+  if (!backend.getDepthToColorTransform(pointCloud.timestamp, pointCloud.timestamp, depthToColor) ||
+      !backend.getColorCameraIntrinsics(SENSOR_ROTATION_IGNORED, &intrinsics))
+  {
+    return;
+  }
+  // The size of the depth images of TangoHandler.
+  const uint32_t width = intrinsics.width / 8;
+  const uint32_t height = intrinsics.height / 8;
+  const size_t pointCloudSize = pointCloud.numberOfPoints * 4 * sizeof(float);
+
+  DepthImageProjector singleThreaded(1);
+  DepthImageProjector multiThreaded;
+  DepthImage image;
+  runner.run("DepthImageProjector/1thread", pointCloudSize, [&]()
+  {
+    singleThreaded.project(pointCloud, depthToColor, intrinsics, width, height, image);
+    benchmarkSink = image.depth[image.depth.size() / 2];
+  });
+  runner.run("DepthImageProjector", pointCloudSize, [&]()
+  {
+    multiThreaded.project(pointCloud, depthToColor, intrinsics, width, height, image);
+    benchmarkSink = image.depth[image.depth.size() / 2];
+  });
+
+  // A luma plane with some texture, of the size of the color camera frames.
+  std::vector<uint8_t> lumaData(intrinsics.width * intrinsics.height);
+  for (size_t i = 0; i < lumaData.size(); i++)
+  {
+    lumaData[i] = static_cast<uint8_t>((i / intrinsics.width / 64 + i / 96) * 37);
+  }
+  LumaImage luma;
+  luma.data = lumaData.data();
+  luma.width = intrinsics.width;
+  luma.height = intrinsics.height;
+  luma.stride = intrinsics.width;
+  multiThreaded.project(pointCloud, depthToColor, intrinsics, width, height, image);
+  DepthDensifier singleThreadedDensifier(1);
+  DepthDensifier multiThreadedDensifier;
+  DepthImage dense;
+  runner.run("DepthDensifier/1thread", lumaData.size(), [&]()
+  {
+    singleThreadedDensifier.densify(image, luma, dense);
+    benchmarkSink = dense.depth[dense.depth.size() / 2];
+  });
+  runner.run("DepthDensifier", lumaData.size(), [&]()
+  {
+    multiThreadedDensifier.densify(image, luma, dense);
+    benchmarkSink = dense.depth[dense.depth.size() / 2];
+  });
+}
+
+void runMatrixBenchmarks(BenchmarkRunner& runner, SyntheticSensorBackend& backend, const float* depthTransform)
+{
+  float matrix[16];
+  runner.run("matrixInverse", 2 * sizeof(matrix), [&]()
+  {
+    tango_chromium::matrixInverse(depthTransform, matrix);
+    benchmarkSink = matrix[0];
+  });
+
+  double plane[4] = {0, 0, -1, 2.5};
+  double transformedPlane[4];
+  runner.run("transformPlane", sizeof(matrix) + sizeof(plane) + sizeof(transformedPlane), [&]()
+  {
+    tango_chromium::transformPlane(plane, depthTransform, transformedPlane);
+    benchmarkSink = transformedPlane[3];
+  });
+
+  SensorCameraIntrinsics intrinsics;
+  backend.getColorCameraIntrinsics(0, &intrinsics);
+  runner.run("matrixProjection", sizeof(matrix), [&]()
+  {
+    projectionMatrixFromIntrinsics(intrinsics, 0.1f, 100.0f, matrix);
+    benchmarkSink = matrix[0];
+  });
+
+  float colorTransform[16];
+  backend.getMatrixTransform(kTime, SENSOR_FRAME_START_OF_SERVICE, SENSOR_FRAME_CAMERA_COLOR, SENSOR_CONVENTION_OPENGL, 0, colorTransform);
+  runner.run("matrixMultiply", 3 * sizeof(matrix), [&]()
+  {
+    tango_chromium::matrixMultiply(colorTransform, depthTransform, matrix);
+    benchmarkSink = matrix[15];
+  });
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  std::string jsonPath;
+  std::string filter;
+  double minimumTime = 0.5;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strncmp(argv[i], "--json=", 7) == 0)
+    {
+      jsonPath = argv[i] + 7;
+    }
+    else if (strncmp(argv[i], "--min-time=", 11) == 0)
+    {
+      minimumTime = atof(argv[i] + 11);
+    }
+    else if (strncmp(argv[i], "--filter=", 9) == 0)
+    {
+      filter = argv[i] + 9;
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [--json=results.json|-] [--min-time=seconds] [--filter=substring]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  SyntheticSceneParameters parameters;
+  parameters.depthColumns = kDepthColumns;
+  parameters.depthRows = kDepthRows;
+  SyntheticSensorBackend backend(parameters);
+  backend.setTime(kTime);
+
+  SensorPointCloud pointCloud;
+  float depthTransform[16];
+  if (!backend.getLatestPointCloud(&pointCloud) || pointCloud.numberOfPoints == 0 ||
+      !backend.getMatrixTransform(pointCloud.timestamp, SENSOR_FRAME_START_OF_SERVICE, SENSOR_FRAME_CAMERA_DEPTH, SENSOR_CONVENTION_TANGO, 0, depthTransform))
+  {
+    fprintf(stderr, "Could not generate the synthetic point cloud\n");
+    return 1;
+  }
+
+  // The table goes to stderr when stdout is used for the JSON document.
+  FILE* jsonFile = jsonPath == "-" ? stdout : nullptr;
+  FILE* table = jsonFile == stdout ? stderr : stdout;
+  fprintf(table, "%u points per point cloud\n", pointCloud.numberOfPoints);
+
+  BenchmarkRunner runner(minimumTime, filter, table);
+  runPointCloudBenchmarks(runner, backend, pointCloud, depthTransform);
+  runDepthImageBenchmarks(runner, backend, pointCloud);
+  runMatrixBenchmarks(runner, backend, depthTransform);
+
+  if (!jsonPath.empty())
+  {
+    if (jsonFile == nullptr)
+    {
+      jsonFile = fopen(jsonPath.c_str(), "w");
+    }
+    if (jsonFile == nullptr || !runner.writeJSON(jsonFile))
+    {
+      fprintf(stderr, "Could not write %s\n", jsonPath.c_str());
+      return 1;
+    }
+    if (jsonFile != stdout)
+    {
+      fclose(jsonFile);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,298 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SENSOR_MATH_H_
+#define _SENSOR_MATH_H_
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+// Column major matrix and vector helpers shared by TangoHandler and the
+// sensor backends.
+
+namespace tango_chromium {
+
+inline void multiplyMatrixWithVector(const float* m, const double* v, double* vr, bool addTranslation = true) {
+  double v0 = v[0];
+  double v1 = v[1];
+  double v2 = v[2];
+    vr[0] = m[ 0] * v0 + m[ 4] * v1 + m[ 8] * v2 + (addTranslation ? m[12] : 0);
+    vr[1] = m[ 1] * v0 + m[ 5] * v1 + m[ 9] * v2 + (addTranslation ? m[13] : 0);
+    vr[2] = m[ 2] * v0 + m[ 6] * v1 + m[10] * v2 + (addTranslation ? m[14] : 0);
+}
+
+inline void matrixInverse(const float* m, float* o)
+{
+    // based on http://www.euclideanspace.com/maths/algebra/matrix/functions/inverse/fourD/index.htm
+    float* te = o;
+    const float* me = m;
+
+    float n11 = me[ 0 ], n21 = me[ 1 ], n31 = me[ 2 ], n41 = me[ 3 ],
+      n12 = me[ 4 ], n22 = me[ 5 ], n32 = me[ 6 ], n42 = me[ 7 ],
+      n13 = me[ 8 ], n23 = me[ 9 ], n33 = me[ 10 ], n43 = me[ 11 ],
+      n14 = me[ 12 ], n24 = me[ 13 ], n34 = me[ 14 ], n44 = me[ 15 ],
+
+      t11 = n23 * n34 * n42 - n24 * n33 * n42 + n24 * n32 * n43 - n22 * n34 * n43 - n23 * n32 * n44 + n22 * n33 * n44,
+      t12 = n14 * n33 * n42 - n13 * n34 * n42 - n14 * n32 * n43 + n12 * n34 * n43 + n13 * n32 * n44 - n12 * n33 * n44,
+      t13 = n13 * n24 * n42 - n14 * n23 * n42 + n14 * n22 * n43 - n12 * n24 * n43 - n13 * n22 * n44 + n12 * n23 * n44,
+      t14 = n14 * n23 * n32 - n13 * n24 * n32 - n14 * n22 * n33 + n12 * n24 * n33 + n13 * n22 * n34 - n12 * n23 * n34;
+
+    float det = n11 * t11 + n21 * t12 + n31 * t13 + n41 * t14;
+
+    assert(det != 0);
+
+    float detInv = 1.0 / det;
+
+    te[ 0 ] = t11 * detInv;
+    te[ 1 ] = ( n24 * n33 * n41 - n23 * n34 * n41 - n24 * n31 * n43 + n21 * n34 * n43 + n23 * n31 * n44 - n21 * n33 * n44 ) * detInv;
+    te[ 2 ] = ( n22 * n34 * n41 - n24 * n32 * n41 + n24 * n31 * n42 - n21 * n34 * n42 - n22 * n31 * n44 + n21 * n32 * n44 ) * detInv;
+    te[ 3 ] = ( n23 * n32 * n41 - n22 * n33 * n41 - n23 * n31 * n42 + n21 * n33 * n42 + n22 * n31 * n43 - n21 * n32 * n43 ) * detInv;
+
+    te[ 4 ] = t12 * detInv;
+    te[ 5 ] = ( n13 * n34 * n41 - n14 * n33 * n41 + n14 * n31 * n43 - n11 * n34 * n43 - n13 * n31 * n44 + n11 * n33 * n44 ) * detInv;
+    te[ 6 ] = ( n14 * n32 * n41 - n12 * n34 * n41 - n14 * n31 * n42 + n11 * n34 * n42 + n12 * n31 * n44 - n11 * n32 * n44 ) * detInv;
+    te[ 7 ] = ( n12 * n33 * n41 - n13 * n32 * n41 + n13 * n31 * n42 - n11 * n33 * n42 - n12 * n31 * n43 + n11 * n32 * n43 ) * detInv;
+
+    te[ 8 ] = t13 * detInv;
+    te[ 9 ] = ( n14 * n23 * n41 - n13 * n24 * n41 - n14 * n21 * n43 + n11 * n24 * n43 + n13 * n21 * n44 - n11 * n23 * n44 ) * detInv;
+    te[ 10 ] = ( n12 * n24 * n41 - n14 * n22 * n41 + n14 * n21 * n42 - n11 * n24 * n42 - n12 * n21 * n44 + n11 * n22 * n44 ) * detInv;
+    te[ 11 ] = ( n13 * n22 * n41 - n12 * n23 * n41 - n13 * n21 * n42 + n11 * n23 * n42 + n12 * n21 * n43 - n11 * n22 * n43 ) * detInv;
+
+    te[ 12 ] = t14 * detInv;
+    te[ 13 ] = ( n13 * n24 * n31 - n14 * n23 * n31 + n14 * n21 * n33 - n11 * n24 * n33 - n13 * n21 * n34 + n11 * n23 * n34 ) * detInv;
+    te[ 14 ] = ( n14 * n22 * n31 - n12 * n24 * n31 - n14 * n21 * n32 + n11 * n24 * n32 + n12 * n21 * n34 - n11 * n22 * n34 ) * detInv;
+    te[ 15 ] = ( n12 * n23 * n31 - n13 * n22 * n31 + n13 * n21 * n32 - n11 * n23 * n32 - n12 * n21 * n33 + n11 * n22 * n33 ) * detInv;
+}
+
+inline void matrixTranspose(const float* m, float* o)
+{
+    if (o == m)
+    {
+        float t;
+        t = m[1];
+        o[1] = m[4];
+        o[4] = t;
+        t = m[2];
+        o[2] = m[8];
+        o[8] = t;
+        t = m[3];
+        o[3] = m[12];
+        o[12] = t;
+        t = m[6];
+        o[6] = m[9];
+        o[9] = t;
+        t = m[7];
+        o[7] = m[13];
+        o[13] = t;
+        t = m[11];
+        o[11] = m[14];
+        o[14] = t;
+    }
+    else
+    {
+        o[1] = m[4];
+        o[4] = m[1];
+        o[2] = m[8];
+        o[8] = m[2];
+        o[3] = m[12];
+        o[12] = m[3];
+        o[6] = m[9];
+        o[9] = m[6];
+        o[7] = m[13];
+        o[13] = m[7];
+        o[11] = m[14];
+        o[14] = m[11];
+    }
+    o[0] = m[0];
+    o[5] = m[5];
+    o[10] = m[10];
+    o[15] = m[15];
+}
+
+inline void matrixFrustum(float const & left,
+             float const & right,
+             float const & bottom,
+             float const & top,
+             float const & near,
+             float const & far,
+             float* matrix)
+{
+
+  float x = 2 * near / ( right - left );
+  float y = 2 * near / ( top - bottom );
+
+  float a = ( right + left ) / ( right - left );
+  float b = ( top + bottom ) / ( top - bottom );
+  float c = - ( far + near ) / ( far - near );
+  float d = - 2 * far * near / ( far - near );
+
+  matrix[ 0 ] = x;  matrix[ 4 ] = 0;  matrix[ 8 ] = a;  matrix[ 12 ] = 0;
+  matrix[ 1 ] = 0;  matrix[ 5 ] = y;  matrix[ 9 ] = b;  matrix[ 13 ] = 0;
+  matrix[ 2 ] = 0;  matrix[ 6 ] = 0;  matrix[ 10 ] = c; matrix[ 14 ] = d;
+  matrix[ 3 ] = 0;  matrix[ 7 ] = 0;  matrix[ 11 ] = - 1; matrix[ 15 ] = 0;
+
+
+    // matrix[0] = (float(2) * near) / (right - left);
+    // matrix[5] = (float(2) * near) / (top - bottom);
+    // matrix[2][0] = (right + left) / (right - left);
+    // matrix[2][1] = (top + bottom) / (top - bottom);
+    // matrix[10] = -(farVal + nearVal) / (farVal - nearVal);
+    // matrix[2][3] = float(-1);
+    // matrix[3][2] = -(float(2) * farVal * nearVal) / (farVal - nearVal);
+}
+
+inline void matrixProjection(float width, float height,
+                      float fx, float fy,
+                      float cx, float cy,
+                      float near, float far,
+                      float* matrix)
+{
+  const float xscale = near / fx;
+  const float yscale = near / fy;
+
+  const float xoffset = (cx - (width / 2.0)) * xscale;
+  // Color camera's coordinates has y pointing downwards so we negate this term.
+  const float yoffset = -(cy - (height / 2.0)) * yscale;
+
+  matrixFrustum(xscale * -width / 2.0f - xoffset,
+          xscale * width / 2.0f - xoffset,
+          yscale * -height / 2.0f - yoffset,
+          yscale * height / 2.0f - yoffset, near, far,
+          matrix);
+}
+
+// Column major matrix of the rigid transform with the given translation and
+// x, y, z, w orientation.
+inline void matrixFromPose(const double* translation, const double* orientation, float* m)
+{
+  double x = orientation[0];
+  double y = orientation[1];
+  double z = orientation[2];
+  double w = orientation[3];
+  m[ 0] = 1 - 2 * (y * y + z * z);
+  m[ 1] = 2 * (x * y + z * w);
+  m[ 2] = 2 * (x * z - y * w);
+  m[ 3] = 0;
+  m[ 4] = 2 * (x * y - z * w);
+  m[ 5] = 1 - 2 * (x * x + z * z);
+  m[ 6] = 2 * (y * z + x * w);
+  m[ 7] = 0;
+  m[ 8] = 2 * (x * z + y * w);
+  m[ 9] = 2 * (y * z - x * w);
+  m[10] = 1 - 2 * (x * x + y * y);
+  m[11] = 0;
+  m[12] = translation[0];
+  m[13] = translation[1];
+  m[14] = translation[2];
+  m[15] = 1;
+}
+
+// o = a * b, all column major. o can be a or b.
+inline void matrixMultiply(const float* a, const float* b, float* o)
+{
+  float r[16];
+  for (int column = 0; column < 4; column++)
+  {
+    for (int row = 0; row < 4; row++)
+    {
+      r[column * 4 + row] =
+        a[row] * b[column * 4] +
+        a[4 + row] * b[column * 4 + 1] +
+        a[8 + row] * b[column * 4 + 2] +
+        a[12 + row] * b[column * 4 + 3];
+    }
+  }
+  memcpy(o, r, sizeof(r));
+}
+
+inline bool matricesAreEqual(const float* a, const float* b, float epsilon)
+{
+  for (int i = 0; i < 16; i++)
+  {
+    if (std::fabs(a[i] - b[i]) > epsilon)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+inline double dot(const double* v1, const double* v2)
+{
+  return v1[0] * v2[0] + v1[1] * v2[1] + v1[2] * v2[2];
+}
+
+inline void cross(const double* v1, const double* v2, double* out)
+{
+  // TODO: Check if v1 or v2 as equal to out.
+  out[0] = v1[1] * v2[2] - v1[2] * v2[1];
+  out[1] = v1[2] * v2[0] - v1[0] * v2[2];
+  out[2] = v1[0] * v2[1] - v1[1] * v2[0];
+}
+
+inline void transformPlane(const double* p, const float* m, double* pr)
+{
+  double pCopy[3] = { p[0], p[1], p[2] };
+
+  pr[0] = p[0] * -p[3];
+  pr[1] = p[1] * -p[3];
+  pr[2] = p[2] * -p[3];
+
+  multiplyMatrixWithVector(m, pr, pr);
+  float mCopy[16];
+  double normal[3];
+  matrixInverse(m, mCopy);
+  matrixTranspose(mCopy, mCopy);
+  multiplyMatrixWithVector(mCopy, pCopy, normal, false);
+
+  pr[3] = -dot(pr, normal);
+  pr[0] = normal[0];
+  pr[1] = normal[1];
+  pr[2] = normal[2];
+}
+
+inline void matrixFromPointAndPlane(const double* point, const double* plane, float* m)
+{
+  const static double WORLD_UP[3] = {0, 1, 0}; 
+  const static double THRESHOLD = 0.5;
+
+  double normalY[3] = { 0, 1, 0 };
+  if (fabs(dot(WORLD_UP, plane)) > THRESHOLD) {
+    normalY[1] = 0; normalY[2] = 1;
+  }
+  double normalZ[3];
+  cross(plane, normalY, normalZ);
+  cross(normalZ, plane, normalY);
+  memset(m, 0, sizeof(float) * 16);
+  m[0] = m[5] = m[10] = m[15] = 1;
+  m[ 0] = normalY[0];
+  m[ 1] = normalY[1];
+  m[ 2] = normalY[2];
+  m[ 4] = plane[0];
+  m[ 5] = plane[1];
+  m[ 6] = plane[2];
+  m[ 8] = normalZ[0];
+  m[ 9] = normalZ[1];
+  m[10] = normalZ[2];
+  m[12] = point[0];
+  m[13] = point[1];
+  m[14] = point[2];
+}
+
+}  // namespace tango_chromium
+
+#endif  // _SENSOR_MATH_H_
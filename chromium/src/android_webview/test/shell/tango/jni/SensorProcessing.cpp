@@ -0,0 +1,109 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SensorProcessing.h"
+
+#include "SensorMath.h"
+
+namespace tango_chromium {
+
+uint32_t copyPointCloud(const SensorPointCloud& pointCloud, unsigned pointsToSkip, const float* transform, float* points)
+{
+  const unsigned step = pointsToSkip + 1;
+  uint32_t j = 0;
+  if (transform == nullptr)
+  {
+    for (uint32_t i = 0; i < pointCloud.numberOfPoints; i += step, j += 3)
+    {
+      const float* point = pointCloud.points[i];
+      points[j    ] = point[0];
+      points[j + 1] = point[1];
+      points[j + 2] = point[2];
+    }
+  }
+  else
+  {
+    // Transforming while copying avoids a temporary copy of the whole point
+    // cloud.
+    const float* m = transform;
+    for (uint32_t i = 0; i < pointCloud.numberOfPoints; i += step, j += 3)
+    {
+      const float* point = pointCloud.points[i];
+      float x = point[0];
+      float y = point[1];
+      float z = point[2];
+      points[j    ] = m[0] * x + m[4] * y + m[ 8] * z + m[12];
+      points[j + 1] = m[1] * x + m[5] * y + m[ 9] * z + m[13];
+      points[j + 2] = m[2] * x + m[6] * y + m[10] * z + m[14];
+    }
+  }
+  return j / 3;
+}
+
+bool hitTestPointCloud(SensorBackend& backend, const SensorPointCloud& pointCloud, const float* depthTransform, double colorTimestamp, float x, float y, int displayRotation, float* modelMatrix)
+{
+  double point[3];
+  double plane[4];
+  if (!backend.fitPlaneNearPoint(pointCloud, colorTimestamp, x, y, displayRotation, point, plane))
+  {
+    return false;
+  }
+
+  multiplyMatrixWithVector(depthTransform, point, point);
+  transformPlane(plane, depthTransform, plane);
+  matrixFromPointAndPlane(point, plane, modelMatrix);
+  return true;
+}
+
+void projectionMatrixFromIntrinsics(const SensorCameraIntrinsics& intrinsics, float near, float far, float* matrix)
+{
+  matrixProjection(
+    static_cast<float>(intrinsics.width), static_cast<float>(intrinsics.height),
+    static_cast<float>(intrinsics.fx), static_cast<float>(intrinsics.fy),
+    static_cast<float>(intrinsics.cx), static_cast<float>(intrinsics.cy),
+    near, far, matrix);
+}
+
+void cameraImageUVTransform(int displayRotation, int sensorOrientation, float visibleHeight, float* matrix)
+{
+  // The rotations of the texture coordinates around the center of the image,
+  // as (u, v) -> (r[0] * u + r[1] * v + r[2], r[3] * u + r[4] * v + r[5]).
+  static const float kRotations[4][6] = {
+    { 1,  0, 0,   0,  1, 0},
+    { 0, -1, 1,   1,  0, 0},
+    {-1,  0, 1,   0, -1, 1},
+    { 0,  1, 0,  -1,  0, 1}
+  };
+  int quarterTurns = ((sensorOrientation / 90 - displayRotation) % 4 + 4) % 4;
+  const float* r = kRotations[quarterTurns];
+
+  // The crop keeps the top of the image: v -> visibleHeight * v + offset.
+  float offset = 1 - visibleHeight;
+  for (int i = 0; i < 16; i++)
+  {
+    matrix[i] = 0;
+  }
+  matrix[ 0] = r[0];
+  matrix[ 1] = r[3];
+  matrix[ 4] = r[1] * visibleHeight;
+  matrix[ 5] = r[4] * visibleHeight;
+  matrix[10] = 1;
+  matrix[12] = r[1] * offset + r[2];
+  matrix[13] = r[4] * offset + r[5];
+  matrix[15] = 1;
+}
+
+}  // namespace tango_chromium
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SENSOR_PROCESSING_H_
+#define _SENSOR_PROCESSING_H_
+
+#include <cstdint>
+
+#include "SensorBackend.h"
+
+namespace tango_chromium {
+
+// Copies every (pointsToSkip + 1)th point of pointCloud to points as x, y, z
+// triplets, transformed by transform if it is not null. Returns the number of
+// points copied.
+uint32_t copyPointCloud(const SensorPointCloud& pointCloud, unsigned pointsToSkip, const float* transform, float* points);
+
+// Hit tests the normalized position (x, y) of the color camera image seen at
+// colorTimestamp against pointCloud. depthTransform transforms from the depth
+// camera frame of the point cloud to the frame of the hit. The model matrix
+// has the plane normal as its Y axis and the hit point as its translation.
+bool hitTestPointCloud(SensorBackend& backend, const SensorPointCloud& pointCloud, const float* depthTransform, double colorTimestamp, float x, float y, int displayRotation, float* modelMatrix);
+
+// OpenGL projection matrix of a camera with the given intrinsics.
+void projectionMatrixFromIntrinsics(const SensorCameraIntrinsics& intrinsics, float near, float far, float* matrix);
+
+// Column major texture coordinate transform from a quad covering the display
+// (origin at the bottom left) to the color camera texture. The image is
+// rotated by the quarter turns between the display rotation (0 to 3) and the
+// sensor orientation (in degrees), then only the top visibleHeight fraction of
+// it, in display orientation, is kept.
+void cameraImageUVTransform(int displayRotation, int sensorOrientation, float visibleHeight, float* matrix);
+
+}  // namespace tango_chromium
+
+#endif  // _SENSOR_PROCESSING_H_
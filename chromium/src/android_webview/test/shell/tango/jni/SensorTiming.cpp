@@ -0,0 +1,208 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SensorTiming.h"
+
+#include "TangoTrace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+
+namespace tango_chromium {
+
+namespace {
+
+const double kSmallestBucket = 0.1;
+const int kBucketsPerOctave = 8;
+// Samples are delivered well within this time, in seconds.
+const double kMaxDeliveryLatency = 0.5;
+
+double clockTime(clockid_t clock)
+{
+  timespec time;
+  clock_gettime(clock, &time);
+  return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+}  // namespace
+
+LatencyHistogram::LatencyHistogram()
+{
+  reset();
+}
+
+void LatencyHistogram::record(double milliseconds)
+{
+  int bucket = 0;
+  if (milliseconds > kSmallestBucket)
+  {
+    bucket = std::min(NUMBER_OF_BUCKETS - 1, static_cast<int>(kBucketsPerOctave * std::log2(milliseconds / kSmallestBucket)));
+  }
+  buckets[bucket]++;
+  if (count == 0)
+  {
+    min = max = milliseconds;
+  }
+  else
+  {
+    min = std::min(min, milliseconds);
+    max = std::max(max, milliseconds);
+  }
+  count++;
+  sum += milliseconds;
+}
+
+void LatencyHistogram::reset()
+{
+  memset(buckets, 0, sizeof(buckets));
+  count = 0;
+  sum = min = max = 0;
+}
+
+void LatencyHistogram::getStatistics(LatencyStatistics* statistics) const
+{
+  statistics->count = count;
+  statistics->mean = count > 0 ? sum / count : 0;
+  statistics->min = min;
+  statistics->max = max;
+
+  const double percentiles[3] = {0.5, 0.9, 0.99};
+  double* values[3] = {&statistics->p50, &statistics->p90, &statistics->p99};
+  for (int i = 0; i < 3; i++)
+  {
+    *values[i] = 0;
+    if (count == 0)
+    {
+      continue;
+    }
+    uint32_t rank = std::max(1u, static_cast<uint32_t>(std::ceil(percentiles[i] * count)));
+    uint32_t cumulative = 0;
+    for (int bucket = 0; bucket < NUMBER_OF_BUCKETS; bucket++)
+    {
+      cumulative += buckets[bucket];
+      if (cumulative >= rank)
+      {
+        // The geometric center of the bucket, which cannot be outside of the
+        // recorded values. The first and the last buckets are open ended.
+        double center = kSmallestBucket * std::exp2((bucket + 0.5) / kBucketsPerOctave);
+        if (bucket == 0)
+        {
+          center = min;
+        }
+        else if (bucket == NUMBER_OF_BUCKETS - 1)
+        {
+          center = max;
+        }
+        *values[i] = std::max(min, std::min(max, center));
+        break;
+      }
+    }
+  }
+}
+
+SensorClock::SensorClock(): source(SOURCE_UNKNOWN), offset(0)
+{
+}
+
+double SensorClock::now()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SensorClock::onSampleDelivered(double sensorTimestamp)
+{
+#ifdef CLOCK_BOOTTIME
+  double bootTime = clockTime(CLOCK_BOOTTIME);
+#else
+  double bootTime = -1;
+#endif
+  onSampleDelivered(sensorTimestamp, clockTime(CLOCK_MONOTONIC), bootTime);
+}
+
+void SensorClock::onSampleDelivered(double sensorTimestamp, double monotonicTime, double bootTime)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  // The clocks are checked on every delivery, as the boot time clock drifts
+  // away from the monotonic one every time the device sleeps.
+  double monotonicLatency = monotonicTime - sensorTimestamp;
+  double bootTimeLatency = bootTime - sensorTimestamp;
+  if (monotonicLatency >= 0 && monotonicLatency < kMaxDeliveryLatency)
+  {
+    source = SOURCE_MONOTONIC;
+    offset = 0;
+  }
+  else if (bootTimeLatency >= 0 && bootTimeLatency < kMaxDeliveryLatency)
+  {
+    source = SOURCE_BOOT_TIME;
+    offset = monotonicTime - bootTime;
+  }
+  else if (source != SOURCE_ESTIMATED || monotonicLatency < offset)
+  {
+    source = SOURCE_ESTIMATED;
+    offset = monotonicLatency;
+  }
+}
+
+double SensorClock::toSteadyTime(double sensorTimestamp) const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return source == SOURCE_UNKNOWN ? 0 : sensorTimestamp + offset;
+}
+
+SensorClock::Source SensorClock::getSource() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return source;
+}
+
+RateCounter::RateCounter(const char* name, double period): name(name), period(period), periodStart(0), count(0), rate(0)
+{
+}
+
+void RateCounter::tick()
+{
+  tick(SensorClock::now());
+}
+
+void RateCounter::tick(double now)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (periodStart == 0)
+  {
+    periodStart = now;
+  }
+  count++;
+  double elapsed = now - periodStart;
+  if (elapsed >= period)
+  {
+    // The event that ends a period starts the next one.
+    rate = (count - 1) / elapsed;
+    count = 1;
+    periodStart = now;
+    TangoTrace::setCounter(name, static_cast<int64_t>(rate + 0.5));
+  }
+}
+
+double RateCounter::getRate() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return rate;
+}
+
+}  // namespace tango_chromium
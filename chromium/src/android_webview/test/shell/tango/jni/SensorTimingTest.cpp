@@ -0,0 +1,98 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SensorTiming.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace tango_chromium {
+
+TEST(LatencyHistogramTest, Percentiles)
+{
+  LatencyHistogram histogram;
+  LatencyStatistics statistics;
+  histogram.getStatistics(&statistics);
+  EXPECT_EQ(0u, statistics.count);
+  EXPECT_EQ(0, statistics.p50);
+
+  // 1 to 100 ms.
+  for (int i = 1; i <= 100; i++)
+    histogram.record(i);
+  histogram.getStatistics(&statistics);
+  EXPECT_EQ(100u, statistics.count);
+  EXPECT_DOUBLE_EQ(50.5, statistics.mean);
+  EXPECT_EQ(1, statistics.min);
+  EXPECT_EQ(100, statistics.max);
+  EXPECT_NEAR(50, statistics.p50, 50 * 0.05);
+  EXPECT_NEAR(90, statistics.p90, 90 * 0.05);
+  EXPECT_NEAR(99, statistics.p99, 99 * 0.05);
+
+  // The values out of the range of the buckets are kept.
+  histogram.reset();
+  histogram.record(0.01);
+  histogram.record(100000);
+  histogram.getStatistics(&statistics);
+  EXPECT_EQ(0.01, statistics.p50);
+  EXPECT_EQ(100000, statistics.p99);
+}
+
+TEST(SensorClockTest, FindsTheClockOfTheSensor)
+{
+  SensorClock clock;
+  EXPECT_EQ(0, clock.toSteadyTime(10));
+
+  // Samples delivered 5 ms after their timestamp on the monotonic clock.
+  clock.onSampleDelivered(100.0, 100.005, 250.005);
+  EXPECT_EQ(SensorClock::SOURCE_MONOTONIC, clock.getSource());
+  EXPECT_DOUBLE_EQ(99.0, clock.toSteadyTime(99.0));
+
+  // After the device slept, the timestamps follow the boot time clock.
+  clock.onSampleDelivered(300.0, 150.01, 300.01);
+  EXPECT_EQ(SensorClock::SOURCE_BOOT_TIME, clock.getSource());
+  EXPECT_DOUBLE_EQ(149.0, clock.toSteadyTime(299.0));
+}
+
+TEST(SensorClockTest, EstimatesUnknownClocks)
+{
+  SensorClock clock;
+  clock.onSampleDelivered(10.0, 1000.02, 2000.0);
+  EXPECT_EQ(SensorClock::SOURCE_ESTIMATED, clock.getSource());
+  EXPECT_NEAR(1000.02, clock.toSteadyTime(10.0), 1e-9);
+  // The fastest delivery is kept.
+  clock.onSampleDelivered(11.0, 1001.01, 2001.0);
+  clock.onSampleDelivered(12.0, 1002.05, 2002.0);
+  EXPECT_NEAR(1000.01, clock.toSteadyTime(10.0), 1e-9);
+}
+
+TEST(RateCounterTest, ComputesTheRatePerPeriod)
+{
+  RateCounter counter("Test");
+  EXPECT_EQ(0, counter.getRate());
+
+  // 30 events per second.
+  for (int i = 0; i <= 30; i++)
+    counter.tick(10.0 + i / 30.0);
+  EXPECT_NEAR(30, counter.getRate(), 1e-6);
+
+  // The rate is only updated once a period is complete.
+  for (int i = 1; i < 5; i++)
+    counter.tick(11.0 + i / 5.0);
+  EXPECT_NEAR(30, counter.getRate(), 1e-6);
+  counter.tick(12.0);
+  EXPECT_NEAR(5, counter.getRate(), 1e-6);
+}
+
+}  // namespace tango_chromium
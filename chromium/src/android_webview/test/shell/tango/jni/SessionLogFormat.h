@@ -0,0 +1,191 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SESSION_LOG_FORMAT_H_
+#define _SESSION_LOG_FORMAT_H_
+
+#include <cstdint>
+
+// The binary format written by SessionRecorder. It does not depend on the
+// Tango headers so it can be read on any platform.
+//
+// File layout (little endian, every structure and payload 8 byte aligned):
+//
+//   SessionLogFileHeader
+//   Chunks: SessionLogChunkHeader followed by chunk.recordCount records.
+//     Each record is a SessionLogRecordHeader followed by record.size bytes
+//     of payload, padded to a multiple of 8.
+//   SessionLogIndexEntry[footer.indexEntryCount] (one per chunk)
+//   SessionLogFileFooter
+//
+// The index and the footer are only written when the recording is stopped
+// cleanly. Without them, the chunks can still be found by walking the chunk
+// headers from the start of the file.
+
+namespace tango_chromium {
+
+const uint32_t SESSION_LOG_FILE_MAGIC = 0x534c4754;  // "TGLS"
+const uint32_t SESSION_LOG_CHUNK_MAGIC = 0x4b4e4843;  // "CHNK"
+const uint32_t SESSION_LOG_FOOTER_MAGIC = 0x58444e49;  // "INDX"
+const uint32_t SESSION_LOG_VERSION = 1;
+
+enum SessionLogRecordType
+{
+	// SessionLogPose.
+	SESSION_LOG_RECORD_POSE = 1,
+	// SessionLogPointCloud followed by numberOfPoints x, y, z, confidence
+	// floats.
+	SESSION_LOG_RECORD_POINT_CLOUD = 2,
+	// SessionLogCameraIntrinsics.
+	SESSION_LOG_RECORD_CAMERA_INTRINSICS = 3,
+	// SessionLogFrame followed by the NV21 pixels: width * height bytes of
+	// luma and width * height / 2 bytes of interleaved V and U.
+	SESSION_LOG_RECORD_FRAME = 4,
+	// SessionLogMarkers followed by numberOfMarkers SessionLogMarker, each one
+	// followed by its content padded to a multiple of 8.
+	SESSION_LOG_RECORD_MARKERS = 5
+};
+
+struct SessionLogFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+};
+
+struct SessionLogChunkHeader
+{
+	uint32_t magic;
+	uint32_t recordCount;
+	// Bytes of records after this header.
+	uint64_t size;
+	double firstTimestamp;
+	double lastTimestamp;
+};
+
+struct SessionLogRecordHeader
+{
+	uint32_t type;
+	// Payload bytes, without the padding.
+	uint32_t size;
+	// Tango timestamp (seconds since boot) of the data.
+	double timestamp;
+};
+
+struct SessionLogIndexEntry
+{
+	// Offset of the SessionLogChunkHeader from the start of the file.
+	uint64_t offset;
+	double firstTimestamp;
+	double lastTimestamp;
+	uint32_t recordCount;
+	// Bit (1 << type) is set for every record type in the chunk.
+	uint32_t recordTypes;
+};
+
+struct SessionLogFileFooter
+{
+	uint64_t indexOffset;
+	uint32_t indexEntryCount;
+	uint32_t magic;
+};
+
+// The pose of the color camera as returned by TangoHandler::getPose (OpenGL
+// convention, rotated to the display).
+struct SessionLogPose
+{
+	double translation[3];
+	double orientation[4];
+	int32_t statusCode;
+	// Whether the pose is relative to an ADF instead of the start of service.
+	uint32_t localized;
+};
+
+struct SessionLogPointCloud
+{
+	uint32_t numberOfPoints;
+	uint32_t reserved;
+	// Depth camera to START_OF_SERVICE transform at the point cloud timestamp
+	// (column major, OpenGL world, Tango depth camera), if valid.
+	float depthTransform[16];
+	uint32_t depthTransformIsValid;
+	uint32_t reserved2;
+};
+
+// The color camera intrinsics as exposed by TangoHandler, that is, rotated to
+// the display.
+struct SessionLogCameraIntrinsics
+{
+	uint32_t width;
+	uint32_t height;
+	double fx;
+	double fy;
+	double cx;
+	double cy;
+	double distortion[5];
+	int32_t calibrationType;
+	int32_t displayRotation;
+	// Orientation of the camera sensor, as reported to VRPassThroughCamera.
+	int32_t sensorOrientation;
+	int32_t reserved;
+};
+
+struct SessionLogFrame
+{
+	// Size of the stored frame. It is the size of the camera image divided
+	// by subsample (rounded down to even numbers). The stride is width.
+	uint32_t width;
+	uint32_t height;
+	uint32_t subsample;
+	uint32_t reserved;
+	int64_t frameNumber;
+};
+
+struct SessionLogMarkers
+{
+	uint32_t numberOfMarkers;
+	uint32_t reserved;
+};
+
+struct SessionLogMarker
+{
+	int32_t type;
+	int32_t id;
+	double translation[3];
+	double orientation[4];
+	uint32_t contentSize;
+	uint32_t reserved;
+};
+
+static_assert(sizeof(SessionLogFileHeader) == 8, "Unexpected SessionLogFileHeader size");
+static_assert(sizeof(SessionLogChunkHeader) == 32, "Unexpected SessionLogChunkHeader size");
+static_assert(sizeof(SessionLogRecordHeader) == 16, "Unexpected SessionLogRecordHeader size");
+static_assert(sizeof(SessionLogIndexEntry) == 32, "Unexpected SessionLogIndexEntry size");
+static_assert(sizeof(SessionLogFileFooter) == 16, "Unexpected SessionLogFileFooter size");
+static_assert(sizeof(SessionLogPose) == 64, "Unexpected SessionLogPose size");
+static_assert(sizeof(SessionLogPointCloud) == 80, "Unexpected SessionLogPointCloud size");
+static_assert(sizeof(SessionLogCameraIntrinsics) == 96, "Unexpected SessionLogCameraIntrinsics size");
+static_assert(sizeof(SessionLogFrame) == 24, "Unexpected SessionLogFrame size");
+static_assert(sizeof(SessionLogMarkers) == 8, "Unexpected SessionLogMarkers size");
+static_assert(sizeof(SessionLogMarker) == 72, "Unexpected SessionLogMarker size");
+
+inline uint64_t sessionLogPaddedSize(uint64_t size)
+{
+	return (size + 7) & ~static_cast<uint64_t>(7);
+}
+
+}  // namespace tango_chromium
+
+#endif  // _SESSION_LOG_FORMAT_H_
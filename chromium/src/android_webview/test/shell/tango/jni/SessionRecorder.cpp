@@ -0,0 +1,475 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SessionRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace tango_chromium {
+
+namespace {
+
+// Poses, intrinsics and markers fit in a small record. Point clouds and
+// frames use one of the few large records, whose buffers grow to the size
+// of the biggest payload seen and are then reused.
+constexpr size_t kSmallRecordSize = 4096;
+constexpr size_t kNumberOfSmallRecords = 512;
+constexpr size_t kNumberOfLargeRecords = 16;
+// Chunks are closed once they hold this many bytes of records.
+constexpr uint64_t kChunkSize = 1 << 20;
+constexpr size_t kFileBufferSize = 1 << 20;
+constexpr std::chrono::milliseconds kWriterIdleSleep(2);
+
+const uint8_t kPadding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+
+}  // namespace
+
+SessionRecorder::SessionRecorder(): recording(false)
+  , frameSubsample(0)
+  , activeProducers(0)
+  , droppedRecords(0)
+  , records(kNumberOfSmallRecords + kNumberOfLargeRecords)
+  , freeSmallRecords(kNumberOfSmallRecords)
+  , freeLargeRecords(kNumberOfLargeRecords)
+  , pendingRecords(kNumberOfSmallRecords + kNumberOfLargeRecords)
+  , stopWriter(false)
+  , writeFailed(false)
+  , file(nullptr)
+  , filePosition(0)
+  , chunkIsOpen(false)
+{
+  for (size_t i = 0; i < records.size(); i++)
+  {
+    Record* record = &records[i];
+    record->large = i >= kNumberOfSmallRecords;
+    if (record->large)
+    {
+      freeLargeRecords.push(record);
+    }
+    else
+    {
+      record->payload.reserve(kSmallRecordSize);
+      freeSmallRecords.push(record);
+    }
+  }
+}
+
+SessionRecorder::~SessionRecorder()
+{
+  stop();
+}
+
+bool SessionRecorder::start(const std::string& path, unsigned frameSubsample)
+{
+  stop();
+
+  file = fopen(path.c_str(), "wb");
+  if (file == nullptr)
+  {
+    return false;
+  }
+  fileBuffer.resize(kFileBufferSize);
+  setvbuf(file, fileBuffer.data(), _IOFBF, fileBuffer.size());
+
+  filePosition = 0;
+  chunkIsOpen = false;
+  index.clear();
+  writeFailed = false;
+  droppedRecords = 0;
+
+  SessionLogFileHeader header;
+  header.magic = SESSION_LOG_FILE_MAGIC;
+  header.version = SESSION_LOG_VERSION;
+  if (!write(&header, sizeof(header)))
+  {
+    fclose(file);
+    file = nullptr;
+    return false;
+  }
+
+  this->frameSubsample = frameSubsample;
+  stopWriter = false;
+  writerThread = std::thread(&SessionRecorder::writerLoop, this);
+  recording = true;
+  return true;
+}
+
+void SessionRecorder::stop()
+{
+  if (!writerThread.joinable())
+  {
+    return;
+  }
+
+  // Once no producer is filling a record, everything left is in the queue.
+  recording = false;
+  while (activeProducers != 0)
+  {
+    std::this_thread::yield();
+  }
+  stopWriter = true;
+  writerThread.join();
+}
+
+bool SessionRecorder::beginRecord()
+{
+  activeProducers++;
+  if (!recording)
+  {
+    activeProducers--;
+    return false;
+  }
+  return true;
+}
+
+void SessionRecorder::endRecord()
+{
+  activeProducers--;
+}
+
+SessionRecorder::Record* SessionRecorder::acquireRecord(uint32_t type, double timestamp, size_t size)
+{
+  Record* record = nullptr;
+  LockFreeQueue<Record*>& freeRecords = size > kSmallRecordSize ? freeLargeRecords : freeSmallRecords;
+  if (!freeRecords.pop(record))
+  {
+    droppedRecords++;
+    return nullptr;
+  }
+  record->header.type = type;
+  record->header.size = static_cast<uint32_t>(size);
+  record->header.timestamp = timestamp;
+  record->payload.resize(size);
+  return record;
+}
+
+void SessionRecorder::submitRecord(Record* record)
+{
+  // There are as many queue slots as records, so this cannot fail.
+  pendingRecords.push(record);
+}
+
+void SessionRecorder::releaseRecord(Record* record)
+{
+  if (record->large)
+  {
+    freeLargeRecords.push(record);
+  }
+  else
+  {
+    freeSmallRecords.push(record);
+  }
+}
+
+void SessionRecorder::recordPose(double timestamp, const double* translation, const double* orientation, int32_t statusCode, bool localized)
+{
+  if (!beginRecord())
+  {
+    return;
+  }
+  Record* record = acquireRecord(SESSION_LOG_RECORD_POSE, timestamp, sizeof(SessionLogPose));
+  if (record != nullptr)
+  {
+    SessionLogPose* pose = reinterpret_cast<SessionLogPose*>(record->payload.data());
+    memcpy(pose->translation, translation, sizeof(pose->translation));
+    memcpy(pose->orientation, orientation, sizeof(pose->orientation));
+    pose->statusCode = statusCode;
+    pose->localized = localized ? 1 : 0;
+    submitRecord(record);
+  }
+  endRecord();
+}
+
+void SessionRecorder::recordPointCloud(double timestamp, const float* points, uint32_t numberOfPoints, const float* depthTransform)
+{
+  if (!beginRecord())
+  {
+    return;
+  }
+  size_t pointsSize = numberOfPoints * 4 * sizeof(float);
+  Record* record = acquireRecord(SESSION_LOG_RECORD_POINT_CLOUD, timestamp, sizeof(SessionLogPointCloud) + pointsSize);
+  if (record != nullptr)
+  {
+    SessionLogPointCloud* pointCloud = reinterpret_cast<SessionLogPointCloud*>(record->payload.data());
+    memset(pointCloud, 0, sizeof(SessionLogPointCloud));
+    pointCloud->numberOfPoints = numberOfPoints;
+    if (depthTransform != nullptr)
+    {
+      memcpy(pointCloud->depthTransform, depthTransform, sizeof(pointCloud->depthTransform));
+      pointCloud->depthTransformIsValid = 1;
+    }
+    if (pointsSize > 0)
+    {
+      memcpy(record->payload.data() + sizeof(SessionLogPointCloud), points, pointsSize);
+    }
+    submitRecord(record);
+  }
+  endRecord();
+}
+
+void SessionRecorder::recordCameraIntrinsics(double timestamp, const SessionLogCameraIntrinsics& intrinsics)
+{
+  if (!beginRecord())
+  {
+    return;
+  }
+  Record* record = acquireRecord(SESSION_LOG_RECORD_CAMERA_INTRINSICS, timestamp, sizeof(SessionLogCameraIntrinsics));
+  if (record != nullptr)
+  {
+    memcpy(record->payload.data(), &intrinsics, sizeof(SessionLogCameraIntrinsics));
+    submitRecord(record);
+  }
+  endRecord();
+}
+
+void SessionRecorder::recordFrame(double timestamp, int64_t frameNumber, const uint8_t* data, uint32_t width, uint32_t height, uint32_t stride)
+{
+  if (!beginRecord())
+  {
+    return;
+  }
+  unsigned subsample = frameSubsample;
+  // The stored size is kept even so the VU plane has whole samples.
+  uint32_t frameWidth = subsample > 0 ? (width / subsample) & ~1u : 0;
+  uint32_t frameHeight = subsample > 0 ? (height / subsample) & ~1u : 0;
+  if (frameWidth == 0 || frameHeight == 0)
+  {
+    endRecord();
+    return;
+  }
+
+  size_t lumaSize = frameWidth * frameHeight;
+  Record* record = acquireRecord(SESSION_LOG_RECORD_FRAME, timestamp, sizeof(SessionLogFrame) + lumaSize * 3 / 2);
+  if (record != nullptr)
+  {
+    SessionLogFrame* frame = reinterpret_cast<SessionLogFrame*>(record->payload.data());
+    frame->width = frameWidth;
+    frame->height = frameHeight;
+    frame->subsample = subsample;
+    frame->reserved = 0;
+    frame->frameNumber = frameNumber;
+
+    uint8_t* luma = record->payload.data() + sizeof(SessionLogFrame);
+    uint8_t* chroma = luma + lumaSize;
+    const uint8_t* sourceChroma = data + stride * height;
+    if (subsample == 1)
+    {
+      for (uint32_t y = 0; y < frameHeight; y++)
+      {
+        memcpy(luma + y * frameWidth, data + y * stride, frameWidth);
+      }
+      for (uint32_t y = 0; y < frameHeight / 2; y++)
+      {
+        memcpy(chroma + y * frameWidth, sourceChroma + y * stride, frameWidth);
+      }
+    }
+    else
+    {
+      for (uint32_t y = 0; y < frameHeight; y++)
+      {
+        const uint8_t* source = data + y * subsample * stride;
+        uint8_t* destination = luma + y * frameWidth;
+        for (uint32_t x = 0; x < frameWidth; x++)
+        {
+          destination[x] = source[x * subsample];
+        }
+      }
+      // Every VU pair covers 2x2 luma pixels, so pairs are picked with the
+      // same step.
+      for (uint32_t y = 0; y < frameHeight / 2; y++)
+      {
+        const uint8_t* source = sourceChroma + y * subsample * stride;
+        uint8_t* destination = chroma + y * frameWidth;
+        for (uint32_t x = 0; x < frameWidth / 2; x++)
+        {
+          destination[2 * x] = source[2 * x * subsample];
+          destination[2 * x + 1] = source[2 * x * subsample + 1];
+        }
+      }
+    }
+    submitRecord(record);
+  }
+  endRecord();
+}
+
+void SessionRecorder::recordMarkers(double timestamp, const std::vector<SessionLogMarker>& markers, const std::vector<std::string>& contents)
+{
+  if (!beginRecord())
+  {
+    return;
+  }
+  size_t size = sizeof(SessionLogMarkers);
+  for (size_t i = 0; i < markers.size(); i++)
+  {
+    size += sizeof(SessionLogMarker) + sessionLogPaddedSize(i < contents.size() ? contents[i].size() : 0);
+  }
+  Record* record = acquireRecord(SESSION_LOG_RECORD_MARKERS, timestamp, size);
+  if (record != nullptr)
+  {
+    uint8_t* data = record->payload.data();
+    memset(data, 0, size);
+    SessionLogMarkers* header = reinterpret_cast<SessionLogMarkers*>(data);
+    header->numberOfMarkers = markers.size();
+    data += sizeof(SessionLogMarkers);
+    for (size_t i = 0; i < markers.size(); i++)
+    {
+      SessionLogMarker* marker = reinterpret_cast<SessionLogMarker*>(data);
+      *marker = markers[i];
+      marker->contentSize = i < contents.size() ? contents[i].size() : 0;
+      marker->reserved = 0;
+      data += sizeof(SessionLogMarker);
+      if (marker->contentSize > 0)
+      {
+        memcpy(data, contents[i].data(), marker->contentSize);
+      }
+      data += sessionLogPaddedSize(marker->contentSize);
+    }
+    submitRecord(record);
+  }
+  endRecord();
+}
+
+void SessionRecorder::writerLoop()
+{
+  Record* record = nullptr;
+  for (;;)
+  {
+    if (pendingRecords.pop(record))
+    {
+      writeRecord(*record);
+      releaseRecord(record);
+      continue;
+    }
+    if (stopWriter)
+    {
+      // No producer is left, drain what was pushed since the last pop.
+      while (pendingRecords.pop(record))
+      {
+        writeRecord(*record);
+        releaseRecord(record);
+      }
+      break;
+    }
+    std::this_thread::sleep_for(kWriterIdleSleep);
+  }
+
+  finishChunk();
+  writeIndex();
+  if (fclose(file) != 0)
+  {
+    writeFailed = true;
+  }
+  file = nullptr;
+}
+
+bool SessionRecorder::write(const void* data, size_t size)
+{
+  if (writeFailed)
+  {
+    return false;
+  }
+  if (size > 0 && fwrite(data, size, 1, file) != 1)
+  {
+    writeFailed = true;
+    return false;
+  }
+  filePosition += size;
+  return true;
+}
+
+void SessionRecorder::writeRecord(const Record& record)
+{
+  if (!chunkIsOpen)
+  {
+    chunk.magic = SESSION_LOG_CHUNK_MAGIC;
+    chunk.recordCount = 0;
+    chunk.size = 0;
+    chunk.firstTimestamp = record.header.timestamp;
+    chunk.lastTimestamp = record.header.timestamp;
+    chunkIndexEntry.offset = filePosition;
+    chunkIndexEntry.recordTypes = 0;
+    // The header is rewritten with the final values when the chunk is full.
+    if (!write(&chunk, sizeof(chunk)))
+    {
+      return;
+    }
+    chunkIsOpen = true;
+  }
+
+  uint64_t paddedSize = sessionLogPaddedSize(record.header.size);
+  if (!write(&record.header, sizeof(record.header)) ||
+      !write(record.payload.data(), record.header.size) ||
+      !write(kPadding, paddedSize - record.header.size))
+  {
+    return;
+  }
+
+  // Records from different threads are not strictly ordered by timestamp.
+  chunk.recordCount++;
+  chunk.size += sizeof(record.header) + paddedSize;
+  chunk.firstTimestamp = std::min(chunk.firstTimestamp, record.header.timestamp);
+  chunk.lastTimestamp = std::max(chunk.lastTimestamp, record.header.timestamp);
+  chunkIndexEntry.recordTypes |= 1u << record.header.type;
+
+  if (chunk.size >= kChunkSize)
+  {
+    finishChunk();
+  }
+}
+
+void SessionRecorder::finishChunk()
+{
+  if (!chunkIsOpen)
+  {
+    return;
+  }
+  chunkIsOpen = false;
+  if (writeFailed)
+  {
+    return;
+  }
+
+  uint64_t endPosition = filePosition;
+  if (fseeko(file, chunkIndexEntry.offset, SEEK_SET) != 0 ||
+      fwrite(&chunk, sizeof(chunk), 1, file) != 1 ||
+      fseeko(file, endPosition, SEEK_SET) != 0)
+  {
+    writeFailed = true;
+    return;
+  }
+
+  chunkIndexEntry.firstTimestamp = chunk.firstTimestamp;
+  chunkIndexEntry.lastTimestamp = chunk.lastTimestamp;
+  chunkIndexEntry.recordCount = chunk.recordCount;
+  index.push_back(chunkIndexEntry);
+}
+
+void SessionRecorder::writeIndex()
+{
+  SessionLogFileFooter footer;
+  footer.indexOffset = filePosition;
+  footer.indexEntryCount = index.size();
+  footer.magic = SESSION_LOG_FOOTER_MAGIC;
+  if (!index.empty())
+  {
+    write(index.data(), index.size() * sizeof(SessionLogIndexEntry));
+  }
+  write(&footer, sizeof(footer));
+}
+
+}  // namespace tango_chromium
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SESSION_RECORDER_H_
+#define _SESSION_RECORDER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LockFreeQueue.h"
+#include "SessionLogFormat.h"
+
+namespace tango_chromium {
+
+// Records the sensor data seen by TangoHandler to a file (see
+// SessionLogFormat.h). The record* functions can be called from any thread:
+// they copy the data to a preallocated record and push it to a lock-free
+// queue, a writer thread does the file IO. If the writer falls behind, new
+// records are dropped instead of blocking the caller.
+class SessionRecorder
+{
+public:
+	SessionRecorder();
+	~SessionRecorder();
+
+	SessionRecorder(const SessionRecorder& other) = delete;
+	SessionRecorder& operator=(const SessionRecorder& other) = delete;
+
+	// Camera frames are stored downsampled by frameSubsample in both
+	// dimensions. A frameSubsample of 0 does not record frames.
+	bool start(const std::string& path, unsigned frameSubsample);
+	// Waits for the queued records to be written and writes the index.
+	void stop();
+
+	bool isRecording() const
+	{
+		return recording;
+	}
+
+	bool isRecordingFrames() const
+	{
+		return recording && frameSubsample > 0;
+	}
+
+	void recordPose(double timestamp, const double* translation, const double* orientation, int32_t statusCode, bool localized);
+	// points are x, y, z, confidence. depthTransform can be null.
+	void recordPointCloud(double timestamp, const float* points, uint32_t numberOfPoints, const float* depthTransform);
+	void recordCameraIntrinsics(double timestamp, const SessionLogCameraIntrinsics& intrinsics);
+	// data is an NV21 image whose VU plane starts right after height rows.
+	void recordFrame(double timestamp, int64_t frameNumber, const uint8_t* data, uint32_t width, uint32_t height, uint32_t stride);
+	// contents holds the content of every marker (empty for ARTags).
+	void recordMarkers(double timestamp, const std::vector<SessionLogMarker>& markers, const std::vector<std::string>& contents);
+
+	// Records dropped because no preallocated record was free.
+	uint64_t getDroppedRecords() const
+	{
+		return droppedRecords;
+	}
+
+	// Whether writing to the file failed during the last recording.
+	bool hasFailed() const
+	{
+		return writeFailed;
+	}
+
+private:
+	struct Record
+	{
+		SessionLogRecordHeader header;
+		std::vector<uint8_t> payload;
+		bool large;
+	};
+
+	// Producers keep the recording alive between beginRecord and the matching
+	// endRecord, so stop does not close the file under them.
+	bool beginRecord();
+	void endRecord();
+	Record* acquireRecord(uint32_t type, double timestamp, size_t size);
+	void submitRecord(Record* record);
+	void releaseRecord(Record* record);
+
+	void writerLoop();
+	bool write(const void* data, size_t size);
+	void writeRecord(const Record& record);
+	void finishChunk();
+	void writeIndex();
+
+	std::atomic<bool> recording;
+	std::atomic<unsigned> frameSubsample;
+	std::atomic<unsigned> activeProducers;
+	std::atomic<uint64_t> droppedRecords;
+
+	std::vector<Record> records;
+	LockFreeQueue<Record*> freeSmallRecords;
+	LockFreeQueue<Record*> freeLargeRecords;
+	LockFreeQueue<Record*> pendingRecords;
+
+	// Only used by the writer thread while recording.
+	std::thread writerThread;
+	std::atomic<bool> stopWriter;
+	std::atomic<bool> writeFailed;
+	FILE* file;
+	std::vector<char> fileBuffer;
+	uint64_t filePosition;
+	bool chunkIsOpen;
+	SessionLogChunkHeader chunk;
+	SessionLogIndexEntry chunkIndexEntry;
+	std::vector<SessionLogIndexEntry> index;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _SESSION_RECORDER_H_
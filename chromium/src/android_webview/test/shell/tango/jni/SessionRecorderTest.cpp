@@ -0,0 +1,302 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SessionRecorder.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <thread>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace tango_chromium {
+
+namespace {
+
+struct ParsedRecord
+{
+  SessionLogRecordHeader header;
+  std::vector<uint8_t> payload;
+};
+
+std::string makeTemporaryPath(const char* name)
+{
+  return std::string(P_tmpdir) + "/" + name + ".tgls";
+}
+
+std::vector<uint8_t> readFile(const std::string& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Reads the records through the index, checking that it matches the chunks.
+bool parseSessionLog(const std::vector<uint8_t>& data, std::vector<ParsedRecord>& records, std::vector<SessionLogIndexEntry>& index)
+{
+  if (data.size() < sizeof(SessionLogFileHeader) + sizeof(SessionLogFileFooter))
+    return false;
+  SessionLogFileHeader header;
+  memcpy(&header, data.data(), sizeof(header));
+  SessionLogFileFooter footer;
+  memcpy(&footer, data.data() + data.size() - sizeof(footer), sizeof(footer));
+  if (header.magic != SESSION_LOG_FILE_MAGIC || header.version != SESSION_LOG_VERSION || footer.magic != SESSION_LOG_FOOTER_MAGIC)
+    return false;
+  if (footer.indexOffset + footer.indexEntryCount * sizeof(SessionLogIndexEntry) + sizeof(footer) != data.size())
+    return false;
+
+  index.resize(footer.indexEntryCount);
+  if (!index.empty())
+    memcpy(index.data(), data.data() + footer.indexOffset, index.size() * sizeof(SessionLogIndexEntry));
+
+  uint64_t expectedOffset = sizeof(SessionLogFileHeader);
+  for (const SessionLogIndexEntry& entry : index)
+  {
+    if (entry.offset != expectedOffset)
+      return false;
+    SessionLogChunkHeader chunk;
+    memcpy(&chunk, data.data() + entry.offset, sizeof(chunk));
+    if (chunk.magic != SESSION_LOG_CHUNK_MAGIC || chunk.recordCount != entry.recordCount)
+      return false;
+    uint64_t offset = entry.offset + sizeof(chunk);
+    for (uint32_t i = 0; i < chunk.recordCount; i++)
+    {
+      ParsedRecord record;
+      memcpy(&record.header, data.data() + offset, sizeof(record.header));
+      offset += sizeof(record.header);
+      record.payload.assign(data.begin() + offset, data.begin() + offset + record.header.size);
+      offset += sessionLogPaddedSize(record.header.size);
+      if (record.header.timestamp < entry.firstTimestamp || record.header.timestamp > entry.lastTimestamp)
+        return false;
+      if (!(entry.recordTypes & (1u << record.header.type)))
+        return false;
+      records.push_back(record);
+    }
+    if (offset != entry.offset + sizeof(chunk) + chunk.size)
+      return false;
+    expectedOffset = offset;
+  }
+  return expectedOffset == footer.indexOffset;
+}
+
+}  // namespace
+
+TEST(LockFreeQueueTest, KeepsOrderAndBounds)
+{
+  LockFreeQueue<int> queue(3);
+  EXPECT_EQ(4u, queue.getCapacity());
+  for (int i = 0; i < 4; i++)
+    EXPECT_TRUE(queue.push(i));
+  EXPECT_FALSE(queue.push(4));
+  int value = -1;
+  for (int i = 0; i < 4; i++)
+  {
+    EXPECT_TRUE(queue.pop(value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_FALSE(queue.pop(value));
+}
+
+TEST(LockFreeQueueTest, ConcurrentProducers)
+{
+  const int kValuesPerThread = 10000;
+  const int kThreads = 4;
+  LockFreeQueue<int> queue(64);
+  std::vector<std::thread> producers;
+  for (int t = 0; t < kThreads; t++)
+  {
+    producers.push_back(std::thread([&queue, t]()
+    {
+      for (int i = 0; i < kValuesPerThread; i++)
+      {
+        while (!queue.push(t * kValuesPerThread + i))
+          std::this_thread::yield();
+      }
+    }));
+  }
+  std::vector<int> lastValue(kThreads, -1);
+  int value;
+  for (int received = 0; received < kThreads * kValuesPerThread;)
+  {
+    if (!queue.pop(value))
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    // Values from the same producer come out in order.
+    int t = value / kValuesPerThread;
+    EXPECT_GT(value, lastValue[t]);
+    lastValue[t] = value;
+    received++;
+  }
+  for (std::thread& producer : producers)
+    producer.join();
+  EXPECT_FALSE(queue.pop(value));
+}
+
+TEST(SessionRecorderTest, RecordsAndIndexesEveryStream)
+{
+  const std::string path = makeTemporaryPath("session_recorder_test");
+  SessionRecorder recorder;
+  ASSERT_TRUE(recorder.start(path, 2));
+  EXPECT_TRUE(recorder.isRecordingFrames());
+
+  const uint32_t kWidth = 64, kHeight = 48, kStride = 80;
+  std::vector<uint8_t> nv21(kStride * kHeight * 3 / 2);
+  for (uint32_t y = 0; y < kHeight * 3 / 2; y++)
+    for (uint32_t x = 0; x < kStride; x++)
+      nv21[y * kStride + x] = static_cast<uint8_t>(x + 3 * y);
+
+  const int kPoses = 300;
+  const int kPointClouds = 20;
+  const uint32_t kPoints = 20000;
+  std::thread poseThread([&recorder]()
+  {
+    for (int i = 0; i < kPoses; i++)
+    {
+      double translation[3] = {static_cast<double>(i), 0, 0};
+      double orientation[4] = {0, 0, 0, 1};
+      recorder.recordPose(i * 0.01, translation, orientation, 1, i % 2 == 0);
+      // Small records are plentiful, but give the writer some time.
+      if (i % 100 == 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+  });
+  std::thread pointCloudThread([&recorder]()
+  {
+    std::vector<float> points(kPoints * 4, 0.5f);
+    float transform[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    for (int i = 0; i < kPointClouds; i++)
+    {
+      recorder.recordPointCloud(i * 0.2, points.data(), kPoints, i % 2 ? transform : nullptr);
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+  });
+
+  SessionLogCameraIntrinsics intrinsics;
+  memset(&intrinsics, 0, sizeof(intrinsics));
+  intrinsics.width = kWidth;
+  intrinsics.height = kHeight;
+  intrinsics.fx = 50;
+  recorder.recordCameraIntrinsics(0.0, intrinsics);
+  recorder.recordFrame(0.5, 7, nv21.data(), kWidth, kHeight, kStride);
+
+  SessionLogMarker marker;
+  memset(&marker, 0, sizeof(marker));
+  marker.type = 2;
+  marker.id = 0;
+  recorder.recordMarkers(0.6, std::vector<SessionLogMarker>(2, marker), {"hello", "https://example.com/webar"});
+
+  poseThread.join();
+  pointCloudThread.join();
+  recorder.stop();
+  EXPECT_FALSE(recorder.isRecording());
+  EXPECT_FALSE(recorder.hasFailed());
+  EXPECT_EQ(0u, recorder.getDroppedRecords());
+
+  std::vector<ParsedRecord> records;
+  std::vector<SessionLogIndexEntry> index;
+  ASSERT_TRUE(parseSessionLog(readFile(path), records, index));
+  // 20 point clouds of 320KB do not fit in a single chunk.
+  EXPECT_GT(index.size(), 1u);
+
+  std::map<uint32_t, int> counts;
+  double lastPoseTimestamp = -1;
+  for (const ParsedRecord& record : records)
+  {
+    counts[record.header.type]++;
+    switch (record.header.type)
+    {
+      case SESSION_LOG_RECORD_POSE:
+      {
+        // Records from the same thread keep their order.
+        EXPECT_GT(record.header.timestamp, lastPoseTimestamp);
+        lastPoseTimestamp = record.header.timestamp;
+        break;
+      }
+      case SESSION_LOG_RECORD_POINT_CLOUD:
+      {
+        SessionLogPointCloud pointCloud;
+        memcpy(&pointCloud, record.payload.data(), sizeof(pointCloud));
+        EXPECT_EQ(kPoints, pointCloud.numberOfPoints);
+        EXPECT_EQ(sizeof(pointCloud) + kPoints * 4 * sizeof(float), record.payload.size());
+        break;
+      }
+      case SESSION_LOG_RECORD_FRAME:
+      {
+        SessionLogFrame frame;
+        memcpy(&frame, record.payload.data(), sizeof(frame));
+        EXPECT_EQ(kWidth / 2, frame.width);
+        EXPECT_EQ(kHeight / 2, frame.height);
+        EXPECT_EQ(7, frame.frameNumber);
+        const uint8_t* luma = record.payload.data() + sizeof(frame);
+        const uint8_t* chroma = luma + frame.width * frame.height;
+        EXPECT_EQ(nv21[10 * kStride + 14], luma[5 * frame.width + 7]);
+        // VU pair (3, 4) of the subsampled frame is pair (6, 8) of the source.
+        const uint8_t* sourceChroma = nv21.data() + kStride * kHeight;
+        EXPECT_EQ(sourceChroma[8 * kStride + 12], chroma[4 * frame.width + 6]);
+        EXPECT_EQ(sourceChroma[8 * kStride + 13], chroma[4 * frame.width + 7]);
+        break;
+      }
+      case SESSION_LOG_RECORD_MARKERS:
+      {
+        SessionLogMarkers markers;
+        memcpy(&markers, record.payload.data(), sizeof(markers));
+        ASSERT_EQ(2u, markers.numberOfMarkers);
+        SessionLogMarker second;
+        size_t offset = sizeof(markers) + sizeof(SessionLogMarker) + sessionLogPaddedSize(5);
+        memcpy(&second, record.payload.data() + offset, sizeof(second));
+        ASSERT_EQ(25u, second.contentSize);
+        EXPECT_EQ("https://example.com/webar", std::string(reinterpret_cast<const char*>(record.payload.data() + offset + sizeof(second)), second.contentSize));
+        break;
+      }
+    }
+  }
+  EXPECT_EQ(kPoses, counts[SESSION_LOG_RECORD_POSE]);
+  EXPECT_EQ(kPointClouds, counts[SESSION_LOG_RECORD_POINT_CLOUD]);
+  EXPECT_EQ(1, counts[SESSION_LOG_RECORD_CAMERA_INTRINSICS]);
+  EXPECT_EQ(1, counts[SESSION_LOG_RECORD_FRAME]);
+  EXPECT_EQ(1, counts[SESSION_LOG_RECORD_MARKERS]);
+
+  remove(path.c_str());
+}
+
+TEST(SessionRecorderTest, IgnoresRecordsWhenStopped)
+{
+  const std::string path = makeTemporaryPath("session_recorder_stopped_test");
+  SessionRecorder recorder;
+  double translation[3] = {0, 0, 0};
+  double orientation[4] = {0, 0, 0, 1};
+  recorder.recordPose(1.0, translation, orientation, 1, false);
+
+  ASSERT_TRUE(recorder.start(path, 0));
+  EXPECT_FALSE(recorder.isRecordingFrames());
+  uint8_t pixels[16] = {0};
+  recorder.recordFrame(1.0, 0, pixels, 4, 2, 4);
+  recorder.stop();
+  recorder.recordPose(2.0, translation, orientation, 1, false);
+
+  std::vector<ParsedRecord> records;
+  std::vector<SessionLogIndexEntry> index;
+  ASSERT_TRUE(parseSessionLog(readFile(path), records, index));
+  EXPECT_TRUE(records.empty());
+  EXPECT_TRUE(index.empty());
+
+  remove(path.c_str());
+}
+
+}  // namespace tango_chromium
@@ -0,0 +1,419 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SyntheticSensorBackend.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// The color camera intrinsics, without display rotation.
+constexpr uint32_t kColorCameraWidth = 640;
+constexpr uint32_t kColorCameraHeight = 480;
+constexpr double kColorCameraFocalLength = 520.0;
+// Horizontal field of view of the depth camera.
+constexpr double kDepthFieldOfView = M_PI / 3.0;
+// The AREA_DESCRIPTION frame relative to the START_OF_SERVICE frame.
+constexpr double kAreaDescriptionYaw = M_PI / 6.0;
+const double kAreaDescriptionTranslation[3] = {0.5, 0.0, -0.25};
+
+void identity(double* m)
+{
+  memset(m, 0, sizeof(double) * 16);
+  m[0] = m[5] = m[10] = m[15] = 1;
+}
+
+// o = a * b, column major. o can be a or b.
+void multiply(const double* a, const double* b, double* o)
+{
+  double r[16];
+  for (int column = 0; column < 4; column++)
+  {
+    for (int row = 0; row < 4; row++)
+    {
+      r[column * 4 + row] =
+        a[row] * b[column * 4] +
+        a[4 + row] * b[column * 4 + 1] +
+        a[8 + row] * b[column * 4 + 2] +
+        a[12 + row] * b[column * 4 + 3];
+    }
+  }
+  memcpy(o, r, sizeof(r));
+}
+
+// Inverse of a rigid transform.
+void rigidInverse(const double* m, double* o)
+{
+  double r[16];
+  identity(r);
+  for (int i = 0; i < 3; i++)
+  {
+    for (int j = 0; j < 3; j++)
+    {
+      r[j * 4 + i] = m[i * 4 + j];
+    }
+  }
+  for (int i = 0; i < 3; i++)
+  {
+    r[12 + i] = -(r[i] * m[12] + r[4 + i] * m[13] + r[8 + i] * m[14]);
+  }
+  memcpy(o, r, sizeof(r));
+}
+
+void rotationX(double angle, double* m)
+{
+  identity(m);
+  m[5] = m[10] = std::cos(angle);
+  m[6] = std::sin(angle);
+  m[9] = -m[6];
+}
+
+void rotationY(double angle, double* m)
+{
+  identity(m);
+  m[0] = m[10] = std::cos(angle);
+  m[8] = std::sin(angle);
+  m[2] = -m[8];
+}
+
+void rotationZ(double angle, double* m)
+{
+  identity(m);
+  m[0] = m[5] = std::cos(angle);
+  m[1] = std::sin(angle);
+  m[4] = -m[1];
+}
+
+void transformPoint(const double* m, const double* p, double* o)
+{
+  double r[3];
+  for (int i = 0; i < 3; i++)
+  {
+    r[i] = m[i] * p[0] + m[4 + i] * p[1] + m[8 + i] * p[2] + m[12 + i];
+  }
+  memcpy(o, r, sizeof(r));
+}
+
+void transformDirection(const double* m, const double* d, double* o)
+{
+  double r[3];
+  for (int i = 0; i < 3; i++)
+  {
+    r[i] = m[i] * d[0] + m[4 + i] * d[1] + m[8 + i] * d[2];
+  }
+  memcpy(o, r, sizeof(r));
+}
+
+void quaternionFromMatrix(const double* m, double* q)
+{
+  double trace = m[0] + m[5] + m[10];
+  if (trace > 0)
+  {
+    double s = 0.5 / std::sqrt(trace + 1.0);
+    q[3] = 0.25 / s;
+    q[0] = (m[6] - m[9]) * s;
+    q[1] = (m[8] - m[2]) * s;
+    q[2] = (m[1] - m[4]) * s;
+  }
+  else if (m[0] > m[5] && m[0] > m[10])
+  {
+    double s = 2.0 * std::sqrt(1.0 + m[0] - m[5] - m[10]);
+    q[3] = (m[6] - m[9]) / s;
+    q[0] = 0.25 * s;
+    q[1] = (m[4] + m[1]) / s;
+    q[2] = (m[8] + m[2]) / s;
+  }
+  else if (m[5] > m[10])
+  {
+    double s = 2.0 * std::sqrt(1.0 + m[5] - m[0] - m[10]);
+    q[3] = (m[8] - m[2]) / s;
+    q[0] = (m[4] + m[1]) / s;
+    q[1] = 0.25 * s;
+    q[2] = (m[9] + m[6]) / s;
+  }
+  else
+  {
+    double s = 2.0 * std::sqrt(1.0 + m[10] - m[0] - m[5]);
+    q[3] = (m[1] - m[4]) / s;
+    q[0] = (m[8] + m[2]) / s;
+    q[1] = (m[9] + m[6]) / s;
+    q[2] = 0.25 * s;
+  }
+}
+
+bool isRotatedByQuarterTurn(int displayRotation)
+{
+  return displayRotation == 1 || displayRotation == 3;
+}
+
+} // End anonymous namespace
+
+namespace tango_chromium {
+
+SyntheticSceneParameters::SyntheticSceneParameters(): roomWidth(6.0)
+  , roomHeight(3.0)
+  , roomDepth(5.0)
+  , trajectoryRadius(1.0)
+  , eyeHeight(1.5)
+  , angularSpeed(0.5)
+  , pitch(-0.3)
+  , depthColumns(64)
+  , depthRows(48)
+  , depthRate(5.0)
+{
+}
+
+SyntheticSensorBackend::SyntheticSensorBackend(const SyntheticSceneParameters& parameters): parameters(parameters)
+  , time(0)
+  , depthFocalLength(0.5 * parameters.depthColumns / std::tan(kDepthFieldOfView / 2.0))
+  , pointCloudTimestamp(-1)
+  , points(parameters.depthColumns * parameters.depthRows * 4)
+  , numberOfPoints(0)
+{
+}
+
+SyntheticSensorBackend::~SyntheticSensorBackend()
+{
+}
+
+void SyntheticSensorBackend::setTime(double time)
+{
+  this->time = time;
+}
+
+bool SyntheticSensorBackend::castRay(const double* origin, const double* direction, double* distance, double* normal) const
+{
+  const double minimum[3] = {-parameters.roomWidth / 2.0, 0.0, -parameters.roomDepth / 2.0};
+  const double maximum[3] = {parameters.roomWidth / 2.0, parameters.roomHeight, parameters.roomDepth / 2.0};
+  double nearest = std::numeric_limits<double>::infinity();
+  int axis = -1;
+  for (int i = 0; i < 3; i++)
+  {
+    if (direction[i] == 0)
+    {
+      continue;
+    }
+    double t = ((direction[i] > 0 ? maximum[i] : minimum[i]) - origin[i]) / direction[i];
+    if (t > 0 && t < nearest)
+    {
+      nearest = t;
+      axis = i;
+    }
+  }
+  if (axis < 0)
+  {
+    return false;
+  }
+  *distance = nearest;
+  normal[0] = normal[1] = normal[2] = 0;
+  normal[axis] = direction[axis] > 0 ? -1 : 1;
+  return true;
+}
+
+void SyntheticSensorBackend::getFrameTransform(double timestamp, SensorFrame frame, SensorConvention convention, int displayRotation, double* matrix) const
+{
+  switch (frame)
+  {
+    case SENSOR_FRAME_START_OF_SERVICE:
+      identity(matrix);
+      return;
+    case SENSOR_FRAME_AREA_DESCRIPTION:
+      rotationY(kAreaDescriptionYaw, matrix);
+      memcpy(&matrix[12], kAreaDescriptionTranslation, sizeof(kAreaDescriptionTranslation));
+      return;
+    default:
+      break;
+  }
+
+  // Both cameras, in the OpenGL convention.
+  double angle = parameters.angularSpeed * timestamp;
+  double pitch[16];
+  rotationY(-angle, matrix);
+  rotationX(parameters.pitch, pitch);
+  multiply(matrix, pitch, matrix);
+  matrix[12] = parameters.trajectoryRadius * std::cos(angle);
+  matrix[13] = parameters.eyeHeight;
+  matrix[14] = parameters.trajectoryRadius * std::sin(angle);
+
+  if (frame == SENSOR_FRAME_CAMERA_COLOR && displayRotation > 0)
+  {
+    double rotation[16];
+    rotationZ(displayRotation * M_PI / 2.0, rotation);
+    multiply(matrix, rotation, matrix);
+  }
+  if (convention == SENSOR_CONVENTION_TANGO)
+  {
+    double flip[16];
+    rotationX(M_PI, flip);
+    multiply(matrix, flip, matrix);
+  }
+}
+
+void SyntheticSensorBackend::getRelativeTransform(double timestamp, SensorFrame base, SensorFrame target, SensorConvention targetConvention, int displayRotation, double* matrix) const
+{
+  if (timestamp == 0)
+  {
+    timestamp = time;
+  }
+  double baseTransform[16];
+  getFrameTransform(timestamp, base, SENSOR_CONVENTION_OPENGL, SENSOR_ROTATION_IGNORED, baseTransform);
+  rigidInverse(baseTransform, baseTransform);
+  getFrameTransform(timestamp, target, targetConvention, displayRotation, matrix);
+  multiply(baseTransform, matrix, matrix);
+}
+
+bool SyntheticSensorBackend::getPose(double timestamp, SensorFrame base, SensorFrame target, SensorConvention targetConvention, int displayRotation, SensorPose* pose)
+{
+  double matrix[16];
+  getRelativeTransform(timestamp, base, target, targetConvention, displayRotation, matrix);
+  pose->timestamp = timestamp == 0 ? time : timestamp;
+  memcpy(pose->translation, &matrix[12], sizeof(pose->translation));
+  quaternionFromMatrix(matrix, pose->orientation);
+  pose->valid = true;
+  return true;
+}
+
+bool SyntheticSensorBackend::getMatrixTransform(double timestamp, SensorFrame base, SensorFrame target, SensorConvention targetConvention, int displayRotation, float* matrix)
+{
+  double m[16];
+  getRelativeTransform(timestamp, base, target, targetConvention, displayRotation, m);
+  for (int i = 0; i < 16; i++)
+  {
+    matrix[i] = static_cast<float>(m[i]);
+  }
+  return true;
+}
+
+bool SyntheticSensorBackend::getDepthToColorTransform(double depthTimestamp, double colorTimestamp, float* matrix)
+{
+  double depthCamera[16];
+  double colorCamera[16];
+  getFrameTransform(depthTimestamp, SENSOR_FRAME_CAMERA_DEPTH, SENSOR_CONVENTION_TANGO, SENSOR_ROTATION_IGNORED, depthCamera);
+  getFrameTransform(colorTimestamp, SENSOR_FRAME_CAMERA_COLOR, SENSOR_CONVENTION_TANGO, SENSOR_ROTATION_IGNORED, colorCamera);
+  rigidInverse(colorCamera, colorCamera);
+  multiply(colorCamera, depthCamera, colorCamera);
+  for (int i = 0; i < 16; i++)
+  {
+    matrix[i] = static_cast<float>(colorCamera[i]);
+  }
+  return true;
+}
+
+bool SyntheticSensorBackend::getColorCameraIntrinsics(int displayRotation, SensorCameraIntrinsics* intrinsics)
+{
+  memset(intrinsics, 0, sizeof(*intrinsics));
+  bool rotated = isRotatedByQuarterTurn(displayRotation);
+  intrinsics->width = rotated ? kColorCameraHeight : kColorCameraWidth;
+  intrinsics->height = rotated ? kColorCameraWidth : kColorCameraHeight;
+  intrinsics->fx = intrinsics->fy = kColorCameraFocalLength;
+  intrinsics->cx = intrinsics->width / 2.0;
+  intrinsics->cy = intrinsics->height / 2.0;
+  return true;
+}
+
+uint32_t SyntheticSensorBackend::getMaxNumberOfPointsInPointCloud() const
+{
+  return parameters.depthColumns * parameters.depthRows;
+}
+
+bool SyntheticSensorBackend::getLatestPointCloud(SensorPointCloud* pointCloud)
+{
+  // The depth camera runs at a lower rate than the poses are queried.
+  double timestamp = std::floor(time * parameters.depthRate) / parameters.depthRate;
+  if (timestamp != pointCloudTimestamp)
+  {
+    pointCloudTimestamp = timestamp;
+    double depthCamera[16];
+    getFrameTransform(timestamp, SENSOR_FRAME_CAMERA_DEPTH, SENSOR_CONVENTION_TANGO, SENSOR_ROTATION_IGNORED, depthCamera);
+    const double* origin = &depthCamera[12];
+    double cx = parameters.depthColumns / 2.0;
+    double cy = parameters.depthRows / 2.0;
+    numberOfPoints = 0;
+    for (uint32_t row = 0; row < parameters.depthRows; row++)
+    {
+      for (uint32_t column = 0; column < parameters.depthColumns; column++)
+      {
+        // Z is 1, so the distance along the ray is the depth of the point.
+        double ray[3] = {(column + 0.5 - cx) / depthFocalLength, (row + 0.5 - cy) / depthFocalLength, 1.0};
+        double direction[3];
+        double depth;
+        double normal[3];
+        transformDirection(depthCamera, ray, direction);
+        if (!castRay(origin, direction, &depth, normal))
+        {
+          continue;
+        }
+        float* point = &points[numberOfPoints * 4];
+        point[0] = static_cast<float>(ray[0] * depth);
+        point[1] = static_cast<float>(ray[1] * depth);
+        point[2] = static_cast<float>(depth);
+        point[3] = 1.0f;
+        numberOfPoints++;
+      }
+    }
+  }
+
+  pointCloud->timestamp = pointCloudTimestamp;
+  pointCloud->numberOfPoints = numberOfPoints;
+  pointCloud->points = reinterpret_cast<const float (*)[4]>(points.data());
+  return true;
+}
+
+bool SyntheticSensorBackend::fitPlaneNearPoint(const SensorPointCloud& pointCloud, double colorTimestamp, float u, float v, int displayRotation, double* point, double* plane)
+{
+  // The walls are known, so the plane is the exact one instead of a fit of the
+  // points.
+  SensorCameraIntrinsics intrinsics;
+  getColorCameraIntrinsics(displayRotation, &intrinsics);
+  double colorCamera[16];
+  getRelativeTransform(colorTimestamp, SENSOR_FRAME_START_OF_SERVICE, SENSOR_FRAME_CAMERA_COLOR, SENSOR_CONVENTION_OPENGL, displayRotation, colorCamera);
+
+  double ray[3] = {
+    (u * intrinsics.width - intrinsics.cx) / intrinsics.fx,
+    -(v * intrinsics.height - intrinsics.cy) / intrinsics.fy,
+    -1.0
+  };
+  double direction[3];
+  double distance;
+  double normal[3];
+  transformDirection(colorCamera, ray, direction);
+  if (!castRay(&colorCamera[12], direction, &distance, normal))
+  {
+    return false;
+  }
+  double worldPoint[3];
+  for (int i = 0; i < 3; i++)
+  {
+    worldPoint[i] = colorCamera[12 + i] + direction[i] * distance;
+  }
+
+  double depthCamera[16];
+  getFrameTransform(pointCloud.timestamp, SENSOR_FRAME_CAMERA_DEPTH, SENSOR_CONVENTION_TANGO, SENSOR_ROTATION_IGNORED, depthCamera);
+  rigidInverse(depthCamera, depthCamera);
+  transformPoint(depthCamera, worldPoint, point);
+  transformDirection(depthCamera, normal, plane);
+  plane[3] = -(plane[0] * point[0] + plane[1] * point[1] + plane[2] * point[2]);
+  return true;
+}
+
+void SyntheticSensorBackend::resetPose()
+{
+  // Tracking is never lost in the synthetic scene.
+}
+
+}  // namespace tango_chromium
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SYNTHETIC_SENSOR_BACKEND_H_
+#define _SYNTHETIC_SENSOR_BACKEND_H_
+
+#include <vector>
+
+#include "SensorBackend.h"
+
+namespace tango_chromium {
+
+struct SyntheticSceneParameters
+{
+	SyntheticSceneParameters();
+
+	// The room is a box centered on the origin with its floor at y = 0.
+	double roomWidth;
+	double roomHeight;
+	double roomDepth;
+	// The camera moves on a horizontal circle around the origin, looking along
+	// the circle and slightly down.
+	double trajectoryRadius;
+	double eyeHeight;
+	double angularSpeed;
+	double pitch;
+	// The depth camera casts one ray per cell of this grid.
+	uint32_t depthColumns;
+	uint32_t depthRows;
+	double depthRate;
+};
+
+// Generates the sensor data of a camera moving in a procedural room: analytic
+// poses and point clouds ray cast against the walls, so the results of the
+// algorithms built on top of them can be checked exactly. The time only
+// advances with setTime. The color and depth cameras share the same origin
+// and the AREA_DESCRIPTION frame is a fixed rigid transform of the
+// START_OF_SERVICE frame.
+class SyntheticSensorBackend: public SensorBackend
+{
+public:
+	explicit SyntheticSensorBackend(const SyntheticSceneParameters& parameters = SyntheticSceneParameters());
+	~SyntheticSensorBackend() override;
+
+	SyntheticSensorBackend(const SyntheticSensorBackend& other) = delete;
+	SyntheticSensorBackend& operator=(const SyntheticSensorBackend& other) = delete;
+
+	void setTime(double time);
+	double getTime() const
+	{
+		return time;
+	}
+
+	// Casts a ray in the START_OF_SERVICE frame from inside the room. Returns
+	// the distance along direction (in multiples of its length) and the normal
+	// of the wall that is hit, facing the inside of the room.
+	bool castRay(const double* origin, const double* direction, double* distance, double* normal) const;
+
+	bool getPose(double timestamp, SensorFrame base, SensorFrame target, SensorConvention targetConvention, int displayRotation, SensorPose* pose) override;
+	bool getMatrixTransform(double timestamp, SensorFrame base, SensorFrame target, SensorConvention targetConvention, int displayRotation, float* matrix) override;
+	bool getDepthToColorTransform(double depthTimestamp, double colorTimestamp, float* matrix) override;
+	bool getColorCameraIntrinsics(int displayRotation, SensorCameraIntrinsics* intrinsics) override;
+	uint32_t getMaxNumberOfPointsInPointCloud() const override;
+	bool getLatestPointCloud(SensorPointCloud* pointCloud) override;
+	bool fitPlaneNearPoint(const SensorPointCloud& pointCloud, double colorTimestamp, float u, float v, int displayRotation, double* point, double* plane) override;
+	void resetPose() override;
+
+private:
+	// Column major transform from frame to START_OF_SERVICE at timestamp.
+	void getFrameTransform(double timestamp, SensorFrame frame, SensorConvention convention, int displayRotation, double* matrix) const;
+	void getRelativeTransform(double timestamp, SensorFrame base, SensorFrame target, SensorConvention targetConvention, int displayRotation, double* matrix) const;
+
+	SyntheticSceneParameters parameters;
+	double time;
+	double depthFocalLength;
+	double pointCloudTimestamp;
+	std::vector<float> points;
+	uint32_t numberOfPoints;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _SYNTHETIC_SENSOR_BACKEND_H_
@@ -26,7 +26,13 @@
 
 #include "TangoHandler.h"
 
-#include <sstream>
+#include "DepthDensifier.h"
+#include "MarkerDetector.h"
+#include "SensorMath.h"
+#include "SensorProcessing.h"
+#include "SessionRecorder.h"
+#include "TangoSensorBackend.h"
+#include "TangoTrace.h"
 
 #include <thread>
 
@@ -34,6 +40,16 @@ namespace {
 
 constexpr int kTangoCoreMinimumVersion = 9377;
 constexpr int kMarkerDetectionFPS = 30;
+// Depth and color camera frames are disabled after this long without use.
+constexpr std::chrono::seconds kSubsystemIdleTimeout(5);
+constexpr std::chrono::milliseconds kSubsystemIdleCheckInterval(500);
+// The maximum rate of the Tango depth camera.
+constexpr int kDepthFramerate = 5;
+// The depth images have 1/8 of the resolution of the color camera image.
+constexpr uint32_t kDepthImageDownsampling = 8;
+// The color camera timestamp is used for the poses while it changed within
+// this time.
+constexpr std::chrono::seconds kImageBufferTimestampTimeout(1);
 
 const float ANDROID_WEBVIEW_ADDRESS_BAR_HEIGHT = 125;
 
@@ -49,279 +65,79 @@ void onFrameAvailable(void* context, TangoCameraId tangoCameraId, const TangoIma
 
 void onTextureAvailable(void* context, TangoCameraId tangoCameraId)
 {
-  // Do nothing for now.
+  static_cast<tango_chromium::TangoHandler*>(context)->onTextureAvailable();
 }
 
-inline void multiplyMatrixWithVector(const float* m, const double* v, double* vr, bool addTranslation = true) {
-  double v0 = v[0];
-  double v1 = v[1];
-  double v2 = v[2];
-    vr[0] = m[ 0] * v0 + m[ 4] * v1 + m[ 8] * v2 + (addTranslation ? m[12] : 0);
-    vr[1] = m[ 1] * v0 + m[ 5] * v1 + m[ 9] * v2 + (addTranslation ? m[13] : 0);
-    vr[2] = m[ 2] * v0 + m[ 6] * v1 + m[10] * v2 + (addTranslation ? m[14] : 0);
-}
-
-inline void matrixInverse(const float* m, float* o)
-{
-    // based on http://www.euclideanspace.com/maths/algebra/matrix/functions/inverse/fourD/index.htm
-    float* te = o;
-    const float* me = m;
-
-    float n11 = me[ 0 ], n21 = me[ 1 ], n31 = me[ 2 ], n41 = me[ 3 ],
-      n12 = me[ 4 ], n22 = me[ 5 ], n32 = me[ 6 ], n42 = me[ 7 ],
-      n13 = me[ 8 ], n23 = me[ 9 ], n33 = me[ 10 ], n43 = me[ 11 ],
-      n14 = me[ 12 ], n24 = me[ 13 ], n34 = me[ 14 ], n44 = me[ 15 ],
-
-      t11 = n23 * n34 * n42 - n24 * n33 * n42 + n24 * n32 * n43 - n22 * n34 * n43 - n23 * n32 * n44 + n22 * n33 * n44,
-      t12 = n14 * n33 * n42 - n13 * n34 * n42 - n14 * n32 * n43 + n12 * n34 * n43 + n13 * n32 * n44 - n12 * n33 * n44,
-      t13 = n13 * n24 * n42 - n14 * n23 * n42 + n14 * n22 * n43 - n12 * n24 * n43 - n13 * n22 * n44 + n12 * n23 * n44,
-      t14 = n14 * n23 * n32 - n13 * n24 * n32 - n14 * n22 * n33 + n12 * n24 * n33 + n13 * n22 * n34 - n12 * n23 * n34;
-
-    float det = n11 * t11 + n21 * t12 + n31 * t13 + n41 * t14;
-
-    assert(det != 0);
-
-    float detInv = 1.0 / det;
-
-    te[ 0 ] = t11 * detInv;
-    te[ 1 ] = ( n24 * n33 * n41 - n23 * n34 * n41 - n24 * n31 * n43 + n21 * n34 * n43 + n23 * n31 * n44 - n21 * n33 * n44 ) * detInv;
-    te[ 2 ] = ( n22 * n34 * n41 - n24 * n32 * n41 + n24 * n31 * n42 - n21 * n34 * n42 - n22 * n31 * n44 + n21 * n32 * n44 ) * detInv;
-    te[ 3 ] = ( n23 * n32 * n41 - n22 * n33 * n41 - n23 * n31 * n42 + n21 * n33 * n42 + n22 * n31 * n43 - n21 * n32 * n43 ) * detInv;
-
-    te[ 4 ] = t12 * detInv;
-    te[ 5 ] = ( n13 * n34 * n41 - n14 * n33 * n41 + n14 * n31 * n43 - n11 * n34 * n43 - n13 * n31 * n44 + n11 * n33 * n44 ) * detInv;
-    te[ 6 ] = ( n14 * n32 * n41 - n12 * n34 * n41 - n14 * n31 * n42 + n11 * n34 * n42 + n12 * n31 * n44 - n11 * n32 * n44 ) * detInv;
-    te[ 7 ] = ( n12 * n33 * n41 - n13 * n32 * n41 + n13 * n31 * n42 - n11 * n33 * n42 - n12 * n31 * n43 + n11 * n32 * n43 ) * detInv;
-
-    te[ 8 ] = t13 * detInv;
-    te[ 9 ] = ( n14 * n23 * n41 - n13 * n24 * n41 - n14 * n21 * n43 + n11 * n24 * n43 + n13 * n21 * n44 - n11 * n23 * n44 ) * detInv;
-    te[ 10 ] = ( n12 * n24 * n41 - n14 * n22 * n41 + n14 * n21 * n42 - n11 * n24 * n42 - n12 * n21 * n44 + n11 * n22 * n44 ) * detInv;
-    te[ 11 ] = ( n13 * n22 * n41 - n12 * n23 * n41 - n13 * n21 * n42 + n11 * n23 * n42 + n12 * n21 * n43 - n11 * n22 * n43 ) * detInv;
-
-    te[ 12 ] = t14 * detInv;
-    te[ 13 ] = ( n13 * n24 * n31 - n14 * n23 * n31 + n14 * n21 * n33 - n11 * n24 * n33 - n13 * n21 * n34 + n11 * n23 * n34 ) * detInv;
-    te[ 14 ] = ( n14 * n22 * n31 - n12 * n24 * n31 - n14 * n21 * n32 + n11 * n24 * n32 + n12 * n21 * n34 - n11 * n22 * n34 ) * detInv;
-    te[ 15 ] = ( n12 * n23 * n31 - n13 * n22 * n31 + n13 * n21 * n32 - n11 * n23 * n32 - n12 * n21 * n33 + n11 * n22 * n33 ) * detInv;
-}
-
-inline void matrixTranspose(const GLfloat* m, GLfloat* o)
-{
-    if (o == m)
-    {
-        GLfloat t;
-        t = m[1];
-        o[1] = m[4];
-        o[4] = t;
-        t = m[2];
-        o[2] = m[8];
-        o[8] = t;
-        t = m[3];
-        o[3] = m[12];
-        o[12] = t;
-        t = m[6];
-        o[6] = m[9];
-        o[9] = t;
-        t = m[7];
-        o[7] = m[13];
-        o[13] = t;
-        t = m[11];
-        o[11] = m[14];
-        o[14] = t;
-    }
-    else
-    {
-        o[1] = m[4];
-        o[4] = m[1];
-        o[2] = m[8];
-        o[8] = m[2];
-        o[3] = m[12];
-        o[12] = m[3];
-        o[6] = m[9];
-        o[9] = m[6];
-        o[7] = m[13];
-        o[13] = m[7];
-        o[11] = m[14];
-        o[14] = m[11];
-    }
-    o[0] = m[0];
-    o[5] = m[5];
-    o[10] = m[10];
-    o[15] = m[15];
-}
-
-inline void matrixFrustum(float const & left,
-             float const & right,
-             float const & bottom,
-             float const & top,
-             float const & near,
-             float const & far,
-             float* matrix)
-{
-
-  float x = 2 * near / ( right - left );
-  float y = 2 * near / ( top - bottom );
-
-  float a = ( right + left ) / ( right - left );
-  float b = ( top + bottom ) / ( top - bottom );
-  float c = - ( far + near ) / ( far - near );
-  float d = - 2 * far * near / ( far - near );
-
-  matrix[ 0 ] = x;  matrix[ 4 ] = 0;  matrix[ 8 ] = a;  matrix[ 12 ] = 0;
-  matrix[ 1 ] = 0;  matrix[ 5 ] = y;  matrix[ 9 ] = b;  matrix[ 13 ] = 0;
-  matrix[ 2 ] = 0;  matrix[ 6 ] = 0;  matrix[ 10 ] = c; matrix[ 14 ] = d;
-  matrix[ 3 ] = 0;  matrix[ 7 ] = 0;  matrix[ 11 ] = - 1; matrix[ 15 ] = 0;
-
-
-    // matrix[0] = (float(2) * near) / (right - left);
-    // matrix[5] = (float(2) * near) / (top - bottom);
-    // matrix[2][0] = (right + left) / (right - left);
-    // matrix[2][1] = (top + bottom) / (top - bottom);
-    // matrix[10] = -(farVal + nearVal) / (farVal - nearVal);
-    // matrix[2][3] = float(-1);
-    // matrix[3][2] = -(float(2) * farVal * nearVal) / (farVal - nearVal);
-}
-
-inline void matrixProjection(float width, float height,
-                      float fx, float fy,
-                      float cx, float cy,
-                      float near, float far,
-                      float* matrix)
-{
-  const float xscale = near / fx;
-  const float yscale = near / fy;
-
-  const float xoffset = (cx - (width / 2.0)) * xscale;
-  // Color camera's coordinates has y pointing downwards so we negate this term.
-  const float yoffset = -(cy - (height / 2.0)) * yscale;
-
-  matrixFrustum(xscale * -width / 2.0f - xoffset,
-          xscale * width / 2.0f - xoffset,
-          yscale * -height / 2.0f - yoffset,
-          yscale * height / 2.0f - yoffset, near, far,
-          matrix);
-}
-
-inline double dot(const double* v1, const double* v2)
-{
-  return v1[0] * v2[0] + v1[1] * v2[1] + v1[2] * v2[2];
-}
-
-inline void cross(const double* v1, const double* v2, double* out)
-{
-  // TODO: Check if v1 or v2 as equal to out.
-  out[0] = v1[1] * v2[2] - v1[2] * v2[1];
-  out[1] = v1[2] * v2[0] - v1[0] * v2[2];
-  out[2] = v1[0] * v2[1] - v1[1] * v2[0];
-}
-
-inline void transformPlane(const double* p, const float* m, double* pr)
-{
-  double pCopy[3] = { p[0], p[1], p[2] };
-
-  pr[0] = p[0] * -p[3];
-  pr[1] = p[1] * -p[3];
-  pr[2] = p[2] * -p[3];
-
-  multiplyMatrixWithVector(m, pr, pr);
-  float mCopy[16];
-  double normal[3];
-  matrixInverse(m, mCopy);
-  matrixTranspose(mCopy, mCopy);
-  multiplyMatrixWithVector(mCopy, pCopy, normal, false);
-
-  pr[3] = -dot(pr, normal);
-  pr[0] = normal[0];
-  pr[1] = normal[1];
-  pr[2] = normal[2];
-}
-
-inline void matrixFromPointAndPlane(double* point, double* plane, float* m)
+void toTangoPoseData(const tango_chromium::SensorPose& pose, TangoPoseData* tangoPoseData)
 {
-  const static double WORLD_UP[3] = {0, 1, 0}; 
-  const static double THRESHOLD = 0.5;
-
-  double normalY[3] = { 0, 1, 0 };
-  if (fabs(dot(WORLD_UP, plane)) > THRESHOLD) {
-    normalY[1] = 0; normalY[2] = 1;
-  }
-  double normalZ[3];
-  cross(plane, normalY, normalZ);
-  cross(normalZ, plane, normalY);
-  memset(m, 0, sizeof(float) * 16);
-  m[0] = m[5] = m[10] = m[15] = 1;
-  m[ 0] = normalY[0];
-  m[ 1] = normalY[1];
-  m[ 2] = normalY[2];
-  m[ 4] = plane[0];
-  m[ 5] = plane[1];
-  m[ 6] = plane[2];
-  m[ 8] = normalZ[0];
-  m[ 9] = normalZ[1];
-  m[10] = normalZ[2];
-  m[12] = point[0];
-  m[13] = point[1];
-  m[14] = point[2];
+  memset(tangoPoseData, 0, sizeof(TangoPoseData));
+  tangoPoseData->timestamp = pose.timestamp;
+  memcpy(tangoPoseData->translation, pose.translation, sizeof(pose.translation));
+  memcpy(tangoPoseData->orientation, pose.orientation, sizeof(pose.orientation));
+  tangoPoseData->status_code = pose.valid ? TANGO_POSE_VALID : TANGO_POSE_INVALID;
 }
 
-bool getADFMetadataValue(const std::string& uuid, const std::string& key, std::string& value)
+// Reads the name and the creation time of an ADF with a single metadata
+// round trip to the Tango Service.
+bool getADFMetadata(const std::string& uuid, std::string& name, unsigned long long& creationTime)
 {
-  size_t size = 0;
   TangoAreaDescriptionMetadata metadata;
 
   // Get the metadata object from the Tango Service.
   int ret = TangoService_getAreaDescriptionMetadata(uuid.c_str(), &metadata);
   if (ret != TANGO_SUCCESS)
   {
-    LOGE("getADFMetadataValue: Failed to get ADF metadata with error code: %d", ret);
+    LOGE("getADFMetadata: Failed to get ADF metadata with error code: %d", ret);
     return false;
   }
 
-  char* output;
-  // Query specific key-value from the metadata object.
-  ret = TangoAreaDescriptionMetadata_get(metadata, key.c_str(), &size, &output);
+  bool result = true;
+  size_t size = 0;
+  char* output = nullptr;
+  ret = TangoAreaDescriptionMetadata_get(metadata, "name", &size, &output);
   if (ret != TANGO_SUCCESS)
   {
-    LOGE("getADFMetadataValue: Failed to get ADF metadata value for key '%s' with error code: %d", key.c_str(), ret);
-    return false;
+    LOGE("getADFMetadata: Failed to get ADF metadata value for key 'name' with error code: %d", ret);
+    result = false;
   }
-  if (key == "date_ms_since_epoch")
+  else
   {
-    uint64_t date = *(uint64_t*)output;
-    std::stringstream converter;
-    converter << date;
-    value = converter.str();
+    name.assign(output, strnlen(output, size));
   }
-  else
+
+  // The creation date is stored as a binary 64 bit integer.
+  if (result)
   {
-    value = output;
+    ret = TangoAreaDescriptionMetadata_get(metadata, "date_ms_since_epoch", &size, &output);
+    if (ret != TANGO_SUCCESS || size < sizeof(uint64_t))
+    {
+      LOGE("getADFMetadata: Failed to get ADF metadata value for key 'date_ms_since_epoch' with error code: %d", ret);
+      result = false;
+    }
+    else
+    {
+      uint64_t date;
+      memcpy(&date, output, sizeof(date));
+      creationTime = date;
+    }
   }
 
   // We are done with the metadata, so free the used memory.
-  ret = TangoAreaDescriptionMetadata_free(metadata);
+  TangoAreaDescriptionMetadata_free(metadata);
 
-  return true;
+  return result;
 }
 
-bool addADF(const std::string& uuid, std::vector<tango_chromium::ADF>& adfs)
+bool copyDepthImage(const tango_chromium::DepthImage& source, tango_chromium::DepthImage& image)
 {
-  std::string name;
-  if (!getADFMetadataValue(uuid, "name", name))
-  {
-    return false;
-  }
-  std::string creationTimeString;
-  if (!getADFMetadataValue(uuid, "date_ms_since_epoch", creationTimeString))
-  {
-    return false;
-  }
-  unsigned long long creationTime = 0;
-  std::stringstream converter(creationTimeString);
-  if (!(converter >> creationTime))
+  if (source.depth.empty())
   {
-    LOGE("getADF: Failed to convert the creation time string '%s' to the creation time number.", creationTimeString.c_str());
     return false;
   }
-  adfs.push_back(tango_chromium::ADF(uuid, name, creationTime));
+  image.width = source.width;
+  image.height = source.height;
+  image.timestamp = source.timestamp;
+  image.depth.assign(source.depth.begin(), source.depth.end());
   return true;
 }
 
@@ -341,51 +157,124 @@ namespace tango_chromium {
 //   }
 // }
 
-TangoHandler* TangoHandler::instance = 0;
+std::atomic<TangoHandler*> TangoHandler::instance(nullptr);
+std::mutex TangoHandler::instanceMutex;
 
 TangoHandler* TangoHandler::getInstance()
 {
-  if (instance == 0)
+  TangoHandler* handler = instance;
+  if (handler == nullptr)
   {
-    instance = new TangoHandler();
+    // The VR device provider creates the instance on a worker thread, maybe
+    // while the activity is created.
+    std::lock_guard<std::mutex> lock(instanceMutex);
+    handler = instance;
+    if (handler == nullptr)
+    {
+      handler = new TangoHandler();
+      instance = handler;
+    }
   }
-  return instance;
+  return handler;
 }
 
 void TangoHandler::releaseInstance()
 {
+  std::lock_guard<std::mutex> lock(instanceMutex);
   delete instance;
-  instance = 0;
+  instance = nullptr;
 }
 
 TangoHandler::TangoHandler(): connected(false)
   , tangoConfig(nullptr)
-  , lastTangoImageBufferTimestamp(0)
-  , latestTangoPointCloud(0)
-  , latestTangoPointCloudRetrieved(false)
-  , maxNumberOfPointsInPointCloud(0)
-  , pointCloudManager(0)
-  , cameraImageWidth(0)
-  , cameraImageHeight(0)
-  , cameraImageTextureWidth(0)
-  , cameraImageTextureHeight(0)
+  , lastTextureAvailableTime(0)
+  , cameraFrameCount(0)
+  , poseCameraTimestamp(0)
   , textureIdConnected(false)
+  , activityOrientation(0)
+  , sensorOrientation(0)
+  , adfEnabled(false)
   , lastMarkerTangoImageBufferTimestamp(0)
   , imageBufferManager(nullptr)
   , poseForMarkerDetectionIsCorrect(false)
+  , markerDetector(nullptr)
+  , adfCacheWarmedUp(false)
+  , adfSwitchState(ADF_SWITCH_IDLE)
+  , switchingADF(false)
+  , adfSwitchRequested(false)
+  , stopADFSwitchThread(false)
+  , lastPoseIsValid(false)
+  , nextAnchorId(1)
+  , lastPoseIsLocalized(false)
+  , sessionRecorder(new SessionRecorder())
+  , pointCloudCallbackRate("TangoPointCloudCallbackHz")
+  , frameCallbackRate("TangoFrameCallbackHz")
+  , textureCallbackRate("TangoTextureCallbackHz")
+  , tangoSensorBackend(new TangoSensorBackend())
+  , sensorBackend(tangoSensorBackend)
+  , stopDepthImageThread(false)
+  , depthImageRequested(false)
+  , pendingDepthTimestamp(0)
+  , depthPointsPending(false)
+  , denseDepthImageRequested(false)
+  , pendingLumaWidth(0)
+  , pendingLumaHeight(0)
+  , lumaPending(false)
+  , stopSensorThread(false)
+  , pendingSensorEvents(0)
+  , publishedPointCloudTimestamp(0)
+  , publishedPointCloudGeneration(0)
+  , sensorGeneration(0)
+  , retrievedPointCloudTimestamp(0)
+  , uploadedNumberOfPoints(0)
 {
+  for (int i = 0; i < NUMBER_OF_SUBSYSTEMS; i++)
+  {
+    subsystemEnabled[i] = false;
+    subsystemLastUse[i] = 0;
+  }
 }
 
 TangoHandler::~TangoHandler()
 {
-#ifdef TANGO_USE_POINT_CLOUD
+  if (adfSwitchThread.joinable())
+  {
+    {
+      std::lock_guard<std::mutex> lock(adfSwitchMutex);
+      stopADFSwitchThread = true;
+    }
+    adfSwitchCondition.notify_one();
+    adfSwitchThread.join();
+  }
+
+  if (depthImageThread.joinable())
+  {
+    {
+      std::lock_guard<std::mutex> lock(depthImageMutex);
+      stopDepthImageThread = true;
+    }
+    depthImageCondition.notify_one();
+    depthImageThread.join();
+  }
 
-  if (pointCloudManager != 0)
+  if (sensorThread.joinable())
   {
-    TangoSupport_freePointCloudManager(pointCloudManager);
+    {
+      std::lock_guard<std::mutex> lock(sensorThreadMutex);
+      stopSensorThread = true;
+    }
+    sensorThreadCondition.notify_one();
+    sensorThread.join();
   }
 
-#endif
+  // Stops the recording, if any, and writes the index of the session log.
+  delete sessionRecorder;
+  sessionRecorder = nullptr;
+
+  delete markerDetector;
+  markerDetector = nullptr;
+
+  delete tangoSensorBackend;
 
   TangoConfig_free(tangoConfig);
   tangoConfig = nullptr;
@@ -428,12 +317,14 @@ void TangoHandler::onTangoServiceConnected(JNIEnv* env, jobject binder)
     std::exit (EXIT_SUCCESS);
   }
 
+  std::lock_guard<std::mutex> lock(connectionMutex);
   connect("");
 }
 
 
 void TangoHandler::connect(const std::string& uuid)
 {
+  ScopedTangoTrace trace("TangoHandler::connect");
   TangoErrorType result;
 
   // TANGO_CONFIG_DEFAULT is enabling Motion Tracking and disabling Depth
@@ -486,7 +377,7 @@ void TangoHandler::connect(const std::string& uuid)
 
 #ifdef TANGO_USE_POINT_CLOUD
 
-  if (pointCloudManager == 0)
+  if (tangoSensorBackend->getMaxNumberOfPointsInPointCloud() == 0)
   {
     int maxPointCloudVertexCount_temp = 0;
     result = TangoConfig_getInt32(tangoConfig, "max_point_cloud_elements", &maxPointCloudVertexCount_temp);
@@ -495,12 +386,10 @@ void TangoHandler::connect(const std::string& uuid)
       LOGE("TangoHandler::onTangoServiceConnected, Get max_point_cloud_elements failed");
       std::exit(EXIT_SUCCESS);
     }
-    maxNumberOfPointsInPointCloud = static_cast<uint32_t>(maxPointCloudVertexCount_temp);
 
-    result = TangoSupport_createPointCloudManager(maxNumberOfPointsInPointCloud, &pointCloudManager);
-    if (result != TANGO_SUCCESS)
+    if (!tangoSensorBackend->initializePointClouds(static_cast<uint32_t>(maxPointCloudVertexCount_temp)))
     {
-      LOGE("TangoHandler::onTangoServiceConnected, TangoSupport_createPointCloudManager failed");
+      LOGE("TangoHandler::onTangoServiceConnected, initializing the point clouds failed");
       std::exit(EXIT_SUCCESS);
     }
 
@@ -547,7 +436,13 @@ void TangoHandler::connect(const std::string& uuid)
       LOGE("TangoHandler::connect: setup the UUID(%s) failed with error code: %d", uuid.c_str(), result);
     }
   }
-  lastEnabledADFUUID = uuid;
+  {
+    // Written with adfSwitchMutex locked too, so requestADFSwitch can read it
+    // without waiting for a connection.
+    std::lock_guard<std::mutex> lock(adfSwitchMutex);
+    lastEnabledADFUUID = uuid;
+  }
+  adfEnabled = uuid != "";
 
   // Connect the tango service.
   if (TangoService_connect(this, tangoConfig) != TANGO_SUCCESS)
@@ -559,63 +454,89 @@ void TangoHandler::connect(const std::string& uuid)
   // Get the intrinsics for the color camera and pass them on to the depth
   // image. We need these to know how to project the point cloud into the color
   // camera frame.
-  result = TangoService_getCameraIntrinsics(TANGO_CAMERA_COLOR, &tangoCameraIntrinsics);
+  TangoCameraIntrinsics colorCameraIntrinsics;
+  result = TangoService_getCameraIntrinsics(TANGO_CAMERA_COLOR, &colorCameraIntrinsics);
   if (result != TANGO_SUCCESS) {
     LOGE("TangoHandler::connect: Failed to get the intrinsics for the color camera.");
     std::exit(EXIT_SUCCESS);
   }
 
-#ifdef TANGO_USE_MARKERS
-
-  // Register for color frame callback as we'll need color images for
-  // marker detection.
-  if (imageBufferManager == nullptr)
-  {
-    result = TangoSupport_createImageBufferManager(
-        TANGO_HAL_PIXEL_FORMAT_YCrCb_420_SP, tangoCameraIntrinsics.width,
-        tangoCameraIntrinsics.height, &imageBufferManager);
-    if (result != TANGO_SUCCESS) {
-      LOGE("TangoHandler::connect, failed to create image buffer manager with error code: %d", result);
-      std::exit(EXIT_SUCCESS);
-    }
-  }
-
-  result = TangoService_connectOnFrameAvailable(TANGO_CAMERA_COLOR, this, ::onFrameAvailable);
-  if (result != TANGO_SUCCESS)
+  // By default, use the camera width and height retrieved from the tango camera intrinsics.
   {
-    LOGE("TangoHandler::connect, failed to connect frame callback with error code: %d", result);
-    std::exit(EXIT_SUCCESS);
+    std::lock_guard<std::mutex> lock(cameraIntrinsicsMutex);
+    updateCameraIntrinsicsSnapshot([&colorCameraIntrinsics](CameraIntrinsicsSnapshot& snapshot)
+    {
+      snapshot.colorCameraIntrinsics = colorCameraIntrinsics;
+      snapshot.imageWidth = colorCameraIntrinsics.width;
+      snapshot.imageHeight = colorCameraIntrinsics.height;
+    });
   }
 
-#endif
-
-  // By default, use the camera width and height retrieved from the tango camera intrinsics.
-  cameraImageWidth = cameraImageTextureWidth = tangoCameraIntrinsics.width;
-  cameraImageHeight = cameraImageTextureHeight = tangoCameraIntrinsics.height;
-
   // Initialize TangoSupport context.
   TangoSupport_initialize(TangoService_getPoseAtTime,
                           TangoService_getCameraIntrinsics);
 
+  // The point clouds retrieved before are in the frames of the previous
+  // connection.
+  sensorGeneration++;
+
   connected = true;
 
   updateCameraIntrinsics();
+
+  restoreSubsystems();
+
+  // Warm up the ADF cache so the first getADFs call does not have to fetch the
+  // metadata of every ADF.
+  if (!adfCacheWarmedUp)
+  {
+    adfCacheWarmedUp = true;
+    std::thread t([this]()
+    {
+      std::vector<ADF> adfs;
+      getADFs(adfs);
+    });
+    t.detach();
+  }
+
+  notifyStateChanged();
 }
 
 void TangoHandler::disconnect()
 {
+  ScopedTangoTrace trace("TangoHandler::disconnect");
   TangoService_disconnect();
 
-  cameraImageWidth = cameraImageHeight = 
-    cameraImageTextureWidth = cameraImageTextureHeight = 0;
+  // The point clouds the sensor thread retrieves meanwhile are dropped.
+  sensorGeneration++;
+
+  {
+    std::lock_guard<std::mutex> lock(cameraIntrinsicsMutex);
+    updateCameraIntrinsicsSnapshot([](CameraIntrinsicsSnapshot& snapshot)
+    {
+      snapshot.imageWidth = snapshot.imageHeight = 0;
+    });
+  }
 
   textureIdConnected = false;
 
   connected = false;
+
+  notifyStateChanged();
+}
+
+void TangoHandler::notifyStateChanged()
+{
+  std::lock_guard<std::mutex> lock(stateChangedCallbackMutex);
+  if (stateChangedCallback)
+  {
+    stateChangedCallback();
+  }
 }
 
 void TangoHandler::onPause()
 {
+  std::lock_guard<std::mutex> lock(connectionMutex);
   disconnect();
 }
 
@@ -624,11 +545,24 @@ void TangoHandler::onDeviceRotationChanged(int activityOrientation, int sensorOr
   this->activityOrientation = activityOrientation;
   this->sensorOrientation = sensorOrientation;
   updateCameraIntrinsics();
+  notifyStateChanged();
 }
 
 void TangoHandler::resetPose()
 {
-  TangoService_resetMotionTracking();
+  sensorBackend->resetPose();
+}
+
+void TangoHandler::setStateChangedCallback(const StateChangedCallback& callback)
+{
+  std::lock_guard<std::mutex> lock(stateChangedCallbackMutex);
+  stateChangedCallback = callback;
+}
+
+void TangoHandler::setFrameAvailableCallback(const FrameAvailableCallback& callback)
+{
+  std::lock_guard<std::mutex> lock(frameAvailableCallbackMutex);
+  frameAvailableCallback = callback;
 }
 
 bool TangoHandler::updateCameraIntrinsics()
@@ -638,36 +572,66 @@ bool TangoHandler::updateCameraIntrinsics()
     return false;
   }
 
-  int result = TangoSupport_getCameraIntrinsicsBasedOnDisplayRotation(
-      TANGO_CAMERA_COLOR, static_cast<TangoSupportRotation>(activityOrientation),
-      &tangoCameraIntrinsics);
-
-  if (result != TANGO_SUCCESS) {
-    LOGE(
-        "TangoHandler::updateCameraIntrinsics, failed to get camera intrinsics "
-        "with error code: %d",
-        result);
+  // The rotation and the intrinsics it is applied to are read under the lock,
+  // so a concurrent rotation change is never overwritten with older ones.
+  std::lock_guard<std::mutex> lock(cameraIntrinsicsMutex);
+  SensorCameraIntrinsics cameraIntrinsics;
+  if (!sensorBackend->getColorCameraIntrinsics(activityOrientation, &cameraIntrinsics))
+  {
+    LOGE("TangoHandler::updateCameraIntrinsics, failed to get camera intrinsics.");
     return false;
   }
 
-  /*
-  LOGE("TangoHandler::updateCameraIntrinsics, success. fx: %f, fy: %f, width: %d, height: %d, cx: %f, cy: %f",
-    tangoCameraIntrinsics.fx,
-    tangoCameraIntrinsics.fy,
-    tangoCameraIntrinsics.width,
-    tangoCameraIntrinsics.height,
-    tangoCameraIntrinsics.cx,
-    tangoCameraIntrinsics.cy);
-  */
-
   // Always subtract the height of the address bar since we cannot
   // get rid of it
-  tangoCameraIntrinsics.height -= ANDROID_WEBVIEW_ADDRESS_BAR_HEIGHT;
+  cameraIntrinsics.height -= ANDROID_WEBVIEW_ADDRESS_BAR_HEIGHT;
+
+  SensorCameraIntrinsics previousCameraIntrinsics = getCameraIntrinsicsSnapshot().intrinsics;
 
   // Update the stored values for width and height
-  cameraImageWidth = cameraImageTextureWidth = tangoCameraIntrinsics.width;
-  cameraImageHeight = cameraImageTextureHeight = tangoCameraIntrinsics.height;
+  if (!updateCameraIntrinsicsSnapshot([&cameraIntrinsics](CameraIntrinsicsSnapshot& snapshot)
+      {
+        snapshot.intrinsics = cameraIntrinsics;
+        snapshot.imageWidth = cameraIntrinsics.width;
+        snapshot.imageHeight = cameraIntrinsics.height;
+      }))
+  {
+    return false;
+  }
+
+  if (sessionRecorder->isRecording() &&
+      memcmp(&previousCameraIntrinsics, &cameraIntrinsics, sizeof(SensorCameraIntrinsics)) != 0)
+  {
+    recordCameraIntrinsics();
+  }
+
+  return true;
+}
+
+TangoHandler::CameraIntrinsicsSnapshot TangoHandler::getCameraIntrinsicsSnapshot() const
+{
+  TripleBuffer<CameraIntrinsicsSnapshot, 6>::Snapshot snapshot = cameraIntrinsicsSnapshots.read();
+  if (snapshot)
+  {
+    return *snapshot;
+  }
+  CameraIntrinsicsSnapshot empty;
+  memset(&empty, 0, sizeof(empty));
+  return empty;
+}
 
+bool TangoHandler::updateCameraIntrinsicsSnapshot(const std::function<void(CameraIntrinsicsSnapshot&)>& update)
+{
+  CameraIntrinsicsSnapshot latest = getCameraIntrinsicsSnapshot();
+  CameraIntrinsicsSnapshot* snapshot = cameraIntrinsicsSnapshots.beginWrite();
+  if (snapshot == nullptr)
+  {
+    LOGE("TangoHandler::updateCameraIntrinsicsSnapshot, all the camera intrinsics snapshots are in use.");
+    return false;
+  }
+  *snapshot = latest;
+  update(*snapshot);
+  cameraIntrinsicsSnapshots.publish();
   return true;
 }
 
@@ -678,48 +642,56 @@ bool TangoHandler::isConnected() const
 
 bool TangoHandler::getPose(TangoPoseData* tangoPoseData, bool* localized)
 {
-  bool result = connected;
+  ScopedTangoTrace trace("TangoHandler::getPose");
   *localized = false;
+
+  // connectionMutex is not taken, so an ADF switch never blocks the caller:
+  // the poses are queried whenever the Tango Service is connected, the
+  // START_OF_SERVICE one until the ADF is localized.
+  bool result = false;
   if (connected)
   {
-    latestTangoPointCloudRetrieved = false;
+    // Frames are recorded even if no marker is requested.
+    if (sessionRecorder->isRecordingFrames())
+    {
+      useSubsystem(SUBSYSTEM_COLOR_FRAMES);
+    }
 
-    double timestamp = hasLastTangoImageBufferTimestampChangedLately() ? lastTangoImageBufferTimestamp : 0;
+    double timestamp = getRecentCameraImageTimestamp();
 
-    if (lastEnabledADFUUID != "")
+    // Read once, an ADF switch may change it meanwhile.
+    const bool areaDescriptionEnabled = adfEnabled;
+    SensorPose pose;
+    pose.valid = false;
+    if (areaDescriptionEnabled)
     {
-      result = TangoSupport_getPoseAtTime(
-        timestamp, TANGO_COORDINATE_FRAME_AREA_DESCRIPTION,
-        TANGO_COORDINATE_FRAME_CAMERA_COLOR, TANGO_SUPPORT_ENGINE_OPENGL,
-        TANGO_SUPPORT_ENGINE_OPENGL, 
-        static_cast<TangoSupportRotation>(activityOrientation), tangoPoseData) == TANGO_SUCCESS;
+      result = sensorBackend->getPose(
+        timestamp, SENSOR_FRAME_AREA_DESCRIPTION, SENSOR_FRAME_CAMERA_COLOR,
+        SENSOR_CONVENTION_OPENGL, activityOrientation, &pose);
       if (!result)
       {
         LOGE("TangoHandler::getPose: Failed to get the pose for area description.");
       }
-      else if (tangoPoseData->status_code != TANGO_POSE_VALID)
+      else if (!pose.valid)
       {
         LOGE("TangoHandler::getPose: Getting the Area Description pose did not work. Falling back to device pose estimation.");
       }
       else 
       {
         poseForMarkerDetectionMutex.lock();
-        poseForMarkerDetectionIsCorrect = TangoSupport_getPoseAtTime(
-          timestamp, TANGO_COORDINATE_FRAME_AREA_DESCRIPTION,
-          TANGO_COORDINATE_FRAME_CAMERA_COLOR, TANGO_SUPPORT_ENGINE_OPENGL, 
-          TANGO_SUPPORT_ENGINE_TANGO, ROTATION_IGNORED,
-          &poseForMarkerDetection) == TANGO_SUCCESS;
+        poseForMarkerDetectionIsCorrect = sensorBackend->getPose(
+          timestamp, SENSOR_FRAME_AREA_DESCRIPTION, SENSOR_FRAME_CAMERA_COLOR,
+          SENSOR_CONVENTION_TANGO, SENSOR_ROTATION_IGNORED, &poseForMarkerDetection);
         poseForMarkerDetectionMutex.unlock();
         *localized = true;
       }
     }
 
-    if (lastEnabledADFUUID == "" || tangoPoseData->status_code != TANGO_POSE_VALID)
+    if (!areaDescriptionEnabled || !pose.valid)
     {
-      result = TangoSupport_getPoseAtTime(
-        timestamp, TANGO_COORDINATE_FRAME_START_OF_SERVICE,
-        TANGO_COORDINATE_FRAME_CAMERA_COLOR, TANGO_SUPPORT_ENGINE_OPENGL, 
-        TANGO_SUPPORT_ENGINE_OPENGL, static_cast<TangoSupportRotation>(activityOrientation), tangoPoseData) == TANGO_SUCCESS;
+      result = sensorBackend->getPose(
+        timestamp, SENSOR_FRAME_START_OF_SERVICE, SENSOR_FRAME_CAMERA_COLOR,
+        SENSOR_CONVENTION_OPENGL, activityOrientation, &pose);
       if (!result)
       {
         LOGE("TangoHandler::getPose: Failed to get the pose.");
@@ -727,35 +699,65 @@ bool TangoHandler::getPose(TangoPoseData* tangoPoseData, bool* localized)
       else
       {
         poseForMarkerDetectionMutex.lock();
-        poseForMarkerDetectionIsCorrect = TangoSupport_getPoseAtTime(
-          timestamp, TANGO_COORDINATE_FRAME_START_OF_SERVICE,
-          TANGO_COORDINATE_FRAME_CAMERA_COLOR, TANGO_SUPPORT_ENGINE_OPENGL, 
-          TANGO_SUPPORT_ENGINE_TANGO, ROTATION_IGNORED, 
-          &poseForMarkerDetection) == TANGO_SUCCESS;
+        poseForMarkerDetectionIsCorrect = sensorBackend->getPose(
+          timestamp, SENSOR_FRAME_START_OF_SERVICE, SENSOR_FRAME_CAMERA_COLOR,
+          SENSOR_CONVENTION_TANGO, SENSOR_ROTATION_IGNORED, &poseForMarkerDetection);
         poseForMarkerDetectionMutex.unlock();
       }
     }
+
+    if (result)
+    {
+      toTangoPoseData(pose, tangoPoseData);
+      poseCameraTimestamp = timestamp;
+    }
+  }
+
+  // Nothing is tracked while the ADF switch has the Tango Service
+  // disconnected: the last pose is served until it is connected again.
+  if (!result && switchingADF)
+  {
+    std::lock_guard<std::mutex> lock(lastPoseMutex);
+    if (lastPoseIsValid)
+    {
+      *tangoPoseData = lastPose;
+    }
+    return lastPoseIsValid;
+  }
+
+  if (result)
+  {
+    std::lock_guard<std::mutex> lock(lastPoseMutex);
+    lastPose = *tangoPoseData;
+    lastPoseIsValid = true;
+    lastPoseIsLocalized = *localized;
   }
 
+  if (result && sessionRecorder->isRecording())
+  {
+    sessionRecorder->recordPose(tangoPoseData->timestamp, tangoPoseData->translation,
+        tangoPoseData->orientation, tangoPoseData->status_code, *localized);
+  }
   return result;
 }
 
+double TangoHandler::getPoseTimestamp() const
+{
+  return getRecentCameraImageTimestamp();
+}
+
 bool TangoHandler::getPoseMatrix(float* matrix)
 {
   bool result = false;
 
-  double timestamp = hasLastTangoImageBufferTimestampChangedLately() ? lastTangoImageBufferTimestamp : 0.0;
+  double timestamp = getRecentCameraImageTimestamp();
 
-  TangoMatrixTransformData tangoMatrixTransformData;
-  TangoSupport_getMatrixTransformAtTime(
-    timestamp, TANGO_COORDINATE_FRAME_START_OF_SERVICE,
-    TANGO_COORDINATE_FRAME_CAMERA_COLOR, TANGO_SUPPORT_ENGINE_OPENGL,
-    TANGO_SUPPORT_ENGINE_OPENGL, static_cast<TangoSupportRotation>(activityOrientation), &tangoMatrixTransformData);
-  if (tangoMatrixTransformData.status_code != TANGO_POSE_VALID) {
+  if (!sensorBackend->getMatrixTransform(
+    timestamp, SENSOR_FRAME_START_OF_SERVICE, SENSOR_FRAME_CAMERA_COLOR,
+    SENSOR_CONVENTION_OPENGL, activityOrientation, matrix)) {
     LOGE("TangoHandler::getPoseMatrix: Could not find a valid matrix transform at time %lf for the color camera.", timestamp);
     return result;
   }
-  memcpy(matrix, tangoMatrixTransformData.matrix, 16 * sizeof(float));
   result = true;
   return result;
 }
@@ -764,186 +766,124 @@ bool TangoHandler::getProjectionMatrix(float near, float far, float* projectionM
 {
   if (!connected) return false;
 
-  bool result = this->updateCameraIntrinsics();
-
-  if (!result) {
-    LOGE(
-      "TangoHandler::getProjectionMatrix, failed to get camera intrinsics");
-    return false;
+  // The intrinsics are updated when the Tango Service connects and when the
+  // display rotates, they are only retrieved here if that failed.
+  CameraIntrinsicsSnapshot snapshot = getCameraIntrinsicsSnapshot();
+  if (snapshot.intrinsics.width == 0)
+  {
+    if (!this->updateCameraIntrinsics()) {
+      LOGE(
+        "TangoHandler::getProjectionMatrix, failed to get camera intrinsics");
+      return false;
+    }
+    snapshot = getCameraIntrinsicsSnapshot();
   }
 
-  float image_width = static_cast<float>(tangoCameraIntrinsics.width);
-  float image_height = static_cast<float>(tangoCameraIntrinsics.height);
-  float fx = static_cast<float>(tangoCameraIntrinsics.fx);
-  float fy = static_cast<float>(tangoCameraIntrinsics.fy);
-  float cx = static_cast<float>(tangoCameraIntrinsics.cx);
-  float cy = static_cast<float>(tangoCameraIntrinsics.cy);
-
-  matrixProjection(
-    image_width, image_height, fx, fy, cx, cy, near,
-    far, projectionMatrix);
+  projectionMatrixFromIntrinsics(snapshot.intrinsics, near, far, projectionMatrix);
 
   return true;
 }
 
 unsigned TangoHandler::getMaxNumberOfPointsInPointCloud() const
 {
-  return maxNumberOfPointsInPointCloud;
+  return sensorBackend->getMaxNumberOfPointsInPointCloud();
 }
 
 bool TangoHandler::getPointCloud(uint32_t* numberOfPoints, float* points, bool justUpdatePointCloud, unsigned pointsToSkip, bool transformPoints, float* pointsTransformMatrix)
 {
+  ScopedTangoTrace trace("TangoHandler::getPointCloud justUpdate=%d skip=%u transform=%d", justUpdatePointCloud, pointsToSkip, transformPoints);
   // In case the point cloud retrieval fails, 0 points should be returned.
   *numberOfPoints = 0;
 
-  pointsToSkip += 1;
+  // No point cloud while the ADF switch thread reconnects the Tango Service.
+  if (switchingADF)
+  {
+    return false;
+  }
 
   if (connected)
   {
-    TangoErrorType result = TangoSupport_getLatestPointCloud(pointCloudManager, &latestTangoPointCloud);
-    if (result == TANGO_SUCCESS)
-    {
-      latestTangoPointCloudRetrieved = true;
+    // The sensor thread retrieves the point clouds: the latest one it
+    // published is returned without waiting for it.
+    postSensorEvent(SENSOR_EVENT_POINT_CLOUD_REQUESTED);
 
-      if (lastEnabledADFUUID != "")
-      {
-        TangoSupport_getMatrixTransformAtTime(
-          latestTangoPointCloud->timestamp,
-          TANGO_COORDINATE_FRAME_AREA_DESCRIPTION,
-          TANGO_COORDINATE_FRAME_CAMERA_DEPTH, TANGO_SUPPORT_ENGINE_OPENGL,
-          TANGO_SUPPORT_ENGINE_TANGO, static_cast<TangoSupportRotation>(activityOrientation), &depthCameraMatrixTransform);
-      }
+    TripleBuffer<PointCloudSnapshot>::Snapshot snapshot = getPointCloudSnapshot();
+    if (snapshot)
+    {
+      retrievedPointCloudTimestamp = snapshot->pointCloud.timestamp;
 
-      if (lastEnabledADFUUID == "" || depthCameraMatrixTransform.status_code != TANGO_POSE_VALID)
+      // If only the update was requested, return with 0 points.
+      if (justUpdatePointCloud)
       {
-        TangoSupport_getMatrixTransformAtTime(
-          latestTangoPointCloud->timestamp,
-          TANGO_COORDINATE_FRAME_START_OF_SERVICE,
-          TANGO_COORDINATE_FRAME_CAMERA_DEPTH, TANGO_SUPPORT_ENGINE_OPENGL,
-          TANGO_SUPPORT_ENGINE_TANGO, static_cast<TangoSupportRotation>(activityOrientation), &depthCameraMatrixTransform);
+        return true;
       }
 
-      if (depthCameraMatrixTransform.status_code == TANGO_POSE_VALID)
+      if (transformPoints)
       {
-        // If only the update was requested, return with 0 points.
-        if (justUpdatePointCloud)
-        {
-          return true;
-        }
-
-        // It is possible that the transform matrix retrieval fails but the count is already there/correct.
-        // TODO: Soon, the transformation of the points should be done in a shader in the application side, so the matrix retrieval could inside this method will be avoided.
-        *numberOfPoints = std::ceil(latestTangoPointCloud->num_points / pointsToSkip);
-
-        TangoPointCloud tangoPointCloud;
-        tangoPointCloud.version = latestTangoPointCloud->version;
-        tangoPointCloud.timestamp = latestTangoPointCloud->timestamp;
-        tangoPointCloud.num_points = latestTangoPointCloud->num_points;
-
-        if (transformPoints)
-        {
-          memcpy(pointsTransformMatrix, depthCameraMatrixTransform.matrix, 16 * sizeof(float));
-          tangoPointCloud.points = new float[latestTangoPointCloud->num_points][4];
-          result = TangoSupport_transformPointCloud(depthCameraMatrixTransform.matrix, latestTangoPointCloud, &tangoPointCloud);
-        }
-        else
-        {
-          // Set the transform matrix to identity
-          memset(pointsTransformMatrix, 0, 16 * sizeof(float));
-          pointsTransformMatrix[0] = pointsTransformMatrix[5] = pointsTransformMatrix[10] = pointsTransformMatrix[15] = 1; 
-          tangoPointCloud.points = latestTangoPointCloud->points;
-          // result is already TANGO_SUCCESS
-        }
-        if (result == TANGO_SUCCESS)
-        {
-          uint32_t offset;
-          float* ptrToPoints = tangoPointCloud.points[0];
-          // float* ptrToPoints = latestTangoPointCloud->points[0];
-          for (uint32_t i = 0, j = 0; i < tangoPointCloud.num_points; i += pointsToSkip, j += 3)
-          {
-            offset = i * 4;
-            points[j    ] = ptrToPoints[offset    ];
-            points[j + 1] = ptrToPoints[offset + 1];
-            points[j + 2] = ptrToPoints[offset + 2];
-          }
-          // Cannot make this call anymore as the structure is a 4 value array per point (the fourth being the confidence factor).
-          // memcpy(points, latestTangoPointCloud->points[0], sizeof(float) * latestTangoPointCloud->num_points * 3);
-        }
-        else
-        {
-          LOGE("TangoHandler::getPointCloud, transforming the point cloud with the depth camera transform matrix failed.");
-        }
-        if (transformPoints)
-        {
-          delete [] tangoPointCloud.points;
-        }
+        memcpy(pointsTransformMatrix, snapshot->depthCameraMatrix, 16 * sizeof(float));
       }
       else
       {
-        LOGE("TangoHandler::getPointCloud, retrieving the depth camera transform matrix failed.");
+        // Set the transform matrix to identity
+        memset(pointsTransformMatrix, 0, 16 * sizeof(float));
+        pointsTransformMatrix[0] = pointsTransformMatrix[5] = pointsTransformMatrix[10] = pointsTransformMatrix[15] = 1; 
       }
-    }
-    else
-    {
-      LOGE("TangoHandler::getPointCloud, retrieving the latest point cloud failed.");
+      // The points are transformed while they are copied, without an
+      // intermediate point cloud.
+      *numberOfPoints = copyPointCloud(snapshot->pointCloud, pointsToSkip, transformPoints ? snapshot->depthCameraMatrix : nullptr, points);
+      TangoTrace::setCounter("TangoPointCloudPoints", *numberOfPoints);
     }
   }
   return connected;
 }
 
+double TangoHandler::getLatestPointCloudTimestamp()
+{
+  if (!connected || switchingADF)
+  {
+    return 0;
+  }
+
+  postSensorEvent(SENSOR_EVENT_POINT_CLOUD_REQUESTED);
+  TripleBuffer<PointCloudSnapshot>::Snapshot snapshot = getPointCloudSnapshot();
+  return snapshot ? snapshot->pointCloud.timestamp : 0;
+}
+
+void TangoHandler::setUploadedNumberOfPoints(uint32_t numberOfPoints)
+{
+  uploadedNumberOfPoints = numberOfPoints;
+}
+
+uint32_t TangoHandler::getUploadedNumberOfPoints() const
+{
+  return uploadedNumberOfPoints;
+}
+
 bool TangoHandler::hitTest(float x, float y, std::vector<Hit>& hits)
 {
   bool result = false;
 
   if (connected)
   {
-    double timestamp = hasLastTangoImageBufferTimestampChangedLately() ? lastTangoImageBufferTimestamp : 0.0;
+    // The latest point cloud published by the sensor thread is used.
+    postSensorEvent(SENSOR_EVENT_POINT_CLOUD_REQUESTED);
+    TripleBuffer<PointCloudSnapshot>::Snapshot snapshot = getPointCloudSnapshot();
+    ScopedTangoTrace trace("TangoHandler::hitTest points=%u", snapshot ? snapshot->pointCloud.numberOfPoints : 0);
+    double timestamp = getRecentCameraImageTimestamp();
 
-    if (!latestTangoPointCloud || !latestTangoPointCloudRetrieved)
+    if (!snapshot)
     {
-     uint32_t numberOfPoints;
-     if (!getPointCloud(&numberOfPoints, nullptr, true, 0, false, nullptr))
-     {
-       LOGE("%s: could not get point cloud", __func__);
-     }
-     latestTangoPointCloudRetrieved = true;
-    }
-
-    TangoPoseData tangoPose;
-    if (TangoSupport_calculateRelativePose(
-      latestTangoPointCloud->timestamp, TANGO_COORDINATE_FRAME_CAMERA_DEPTH,
-      timestamp, TANGO_COORDINATE_FRAME_CAMERA_COLOR, &tangoPose) != TANGO_SUCCESS)
-    {
-      LOGE("%s: could not calculate color camera pose at time '%lf'", __func__, timestamp);
+      LOGE("TangoHandler::hitTest: Could not find a point cloud with a valid depth camera transform.");
       return result;
     }
-    float uv[] = {x, y};
-    double identity_translation[3] = {0.0, 0.0, 0.0};
-    double identity_orientation[4] = {0.0, 0.0, 0.0, 1.0};
-    double point[3];
-    double plane[4];
-    if (TangoSupport_fitPlaneModelNearPoint(
-      latestTangoPointCloud, identity_translation, identity_orientation,
-      uv, static_cast<TangoSupportRotation>(activityOrientation),
-      tangoPose.translation,
-      tangoPose.orientation,
-      point, plane) != TANGO_SUCCESS)
+
+    Hit hit;
+    if (!hitTestPointCloud(*sensorBackend, snapshot->pointCloud, snapshot->depthCameraMatrix,
+      timestamp, x, y, activityOrientation, hit.modelMatrix))
     {
       LOGE("%s: could not calculate picking point and plane", __func__);
       return result;
     }
-    if (depthCameraMatrixTransform.status_code != TANGO_POSE_VALID) {
-      LOGE("TangoHandler::getPickingPointAndPlaneInPointCloud: Could not find a valid matrix transform at "
-      "time %lf for the depth camera.", latestTangoPointCloud->timestamp);
-      return result;
-    }
-
-    multiplyMatrixWithVector(depthCameraMatrixTransform.matrix, point, point);
-
-    transformPlane(plane, depthCameraMatrixTransform.matrix, plane);
-
-    Hit hit;
-    matrixFromPointAndPlane(point, plane, hit.modelMatrix);
     hits.push_back(hit);
 
     result = true;
@@ -952,45 +892,382 @@ bool TangoHandler::hitTest(float x, float y, std::vector<Hit>& hits)
   return result;
 }
 
-bool TangoHandler::getCameraImageSize(uint32_t* width, uint32_t* height)
+bool TangoHandler::getDepthImage(DepthImage& image)
 {
-  bool result = true;
-
-  *width = cameraImageWidth;
-  *height = cameraImageHeight;
+  if (!connected)
+  {
+    return false;
+  }
 
-  return result;
+  requestDepthImages(false);
+  std::lock_guard<std::mutex> lock(depthImageMutex);
+  return copyDepthImage(depthImage, image);
 }
 
-bool TangoHandler::getCameraImageTextureSize(uint32_t* width, uint32_t* height)
+bool TangoHandler::getDenseDepthImage(DepthImage& image)
 {
-  bool result = true;
-
-  *width = cameraImageTextureWidth;
-  *height = cameraImageTextureHeight;
+  if (!connected)
+  {
+    return false;
+  }
 
-  return result;
+  requestDepthImages(true);
+  std::lock_guard<std::mutex> lock(depthImageMutex);
+  return copyDepthImage(denseDepthImage, image);
 }
 
-bool TangoHandler::getCameraFocalLength(double* focalLengthX, double* focalLengthY)
+void TangoHandler::requestDepthImages(bool dense)
 {
-  bool result = true;
-  *focalLengthX = tangoCameraIntrinsics.fx;
-  *focalLengthY = tangoCameraIntrinsics.fy;
-  return result;
-}
+  // The point clouds are only delivered while depth is in use, and the color
+  // camera frames while they are.
+  useSubsystem(SUBSYSTEM_DEPTH);
+  if (dense)
+  {
+    useSubsystem(SUBSYSTEM_COLOR_FRAMES);
+  }
 
-bool TangoHandler::getCameraPoint(double* x, double* y)
+  std::lock_guard<std::mutex> lock(depthImageMutex);
+  depthImageRequested = true;
+  if (dense)
+  {
+    denseDepthImageRequested = true;
+  }
+  if (!depthImageThread.joinable())
+  {
+    depthImageThread = std::thread(&TangoHandler::depthImageLoop, this);
+  }
+}
+
+void TangoHandler::getDepthImageSize(uint32_t* width, uint32_t* height)
+{
+  std::lock_guard<std::mutex> lock(depthImageMutex);
+  *width = depthImage.width;
+  *height = depthImage.height;
+}
+
+void TangoHandler::depthImageLoop()
+{
+  DepthImageProjector projector;
+  DepthDensifier densifier;
+  std::vector<float> points;
+  std::vector<uint8_t> lumaData;
+  // The latest projected image is kept to densify it with the next frames.
+  DepthImage projectedImage;
+  DepthImage densifiedImage;
+  std::unique_lock<std::mutex> lock(depthImageMutex);
+  while (true)
+  {
+    depthImageCondition.wait(lock, [this]() { return stopDepthImageThread || depthPointsPending || lumaPending; });
+    if (stopDepthImageThread)
+    {
+      return;
+    }
+
+    const bool project = depthPointsPending;
+    SensorPointCloud pointCloud;
+    if (project)
+    {
+      points.swap(pendingDepthPoints);
+      pointCloud.timestamp = pendingDepthTimestamp;
+      pointCloud.numberOfPoints = points.size() / 4;
+      pointCloud.points = reinterpret_cast<const float (*)[4]>(points.data());
+      depthPointsPending = false;
+    }
+    const bool densify = lumaPending;
+    LumaImage luma;
+    if (densify)
+    {
+      lumaData.swap(pendingLuma);
+      luma.data = lumaData.data();
+      luma.width = pendingLumaWidth;
+      luma.height = pendingLumaHeight;
+      luma.stride = pendingLumaWidth;
+      lumaPending = false;
+    }
+    lock.unlock();
+
+    // The intrinsics and the pose of the depth camera come from the sensor
+    // backend, like the ones of the poses and the point clouds. The image is
+    // the one the color camera would have seen when the point cloud was
+    // captured.
+    bool projected = false;
+    if (project)
+    {
+      ScopedTangoTrace trace("TangoHandler::projectDepthImage points=%u", pointCloud.numberOfPoints);
+      SensorCameraIntrinsics intrinsics;
+      float depthToColor[16];
+      if (sensorBackend->getColorCameraIntrinsics(SENSOR_ROTATION_IGNORED, &intrinsics) &&
+        sensorBackend->getDepthToColorTransform(pointCloud.timestamp, pointCloud.timestamp, depthToColor))
+      {
+        projector.project(pointCloud, depthToColor, intrinsics,
+            intrinsics.width / kDepthImageDownsampling, intrinsics.height / kDepthImageDownsampling,
+            projectedImage);
+        projected = true;
+      }
+      else
+      {
+        LOGE("TangoHandler::depthImageLoop, could not get the color camera intrinsics or the depth camera pose.");
+      }
+    }
+
+    // The frames arrive faster than the point clouds, so the same projected
+    // image is densified with every frame until the next point cloud.
+    bool densified = false;
+    if (densify && !projectedImage.depth.empty())
+    {
+      ScopedTangoTrace trace("TangoHandler::densifyDepthImage %ux%u", projectedImage.width, projectedImage.height);
+      densified = densifier.densify(projectedImage, luma, densifiedImage);
+      if (!densified)
+      {
+        LOGE("TangoHandler::depthImageLoop, the %ux%u color camera frame does not match the %ux%u depth image.",
+            luma.width, luma.height, projectedImage.width, projectedImage.height);
+      }
+    }
+
+    lock.lock();
+    if (projected)
+    {
+      depthImage = projectedImage;
+    }
+    if (densified)
+    {
+      // The previous image becomes the one the next densification writes to.
+      std::swap(denseDepthImage, densifiedImage);
+    }
+  }
+}
+
+void TangoHandler::postSensorEvent(SensorEvent event)
+{
+  // The events are handed over without locking: only the first one posted
+  // since the sensor thread last took them has to wake it up.
+  if (pendingSensorEvents.fetch_or(event) != 0)
+  {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(sensorThreadMutex);
+    if (!sensorThread.joinable())
+    {
+      sensorThread = std::thread(&TangoHandler::sensorLoop, this);
+    }
+  }
+  sensorThreadCondition.notify_one();
+}
+
+void TangoHandler::sensorLoop()
+{
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(sensorThreadMutex);
+      // While a subsystem is enabled, the thread also wakes up regularly to
+      // disable it once it is idle, even if nothing uses the sensors anymore.
+      bool subsystemsEnabled = false;
+      for (int i = 0; i < NUMBER_OF_SUBSYSTEMS; i++)
+      {
+        subsystemsEnabled = subsystemsEnabled || subsystemEnabled[i];
+      }
+      auto hasWork = [this]() { return stopSensorThread || pendingSensorEvents != 0; };
+      if (subsystemsEnabled)
+      {
+        sensorThreadCondition.wait_for(lock, kSubsystemIdleCheckInterval, hasWork);
+      }
+      else
+      {
+        sensorThreadCondition.wait(lock, hasWork);
+      }
+      if (stopSensorThread)
+      {
+        return;
+      }
+    }
+    unsigned events = pendingSensorEvents.exchange(0);
+
+    if (events & SENSOR_EVENT_POINT_CLOUD_REQUESTED)
+    {
+      subsystemLastUse[SUBSYSTEM_DEPTH] = SensorClock::now();
+    }
+    updateSubsystems();
+
+    // connectionMutex is not taken: the copy of a point cloud would make the
+    // readers that only try to lock it fail. updateSubsystems took it to
+    // toggle the subsystems. Nothing is retrieved while the ADF switch thread
+    // reconnects the Tango Service, and a point cloud retrieved while a
+    // connection or a disconnection races with this is published with the
+    // previous sensorGeneration, so it is never read.
+    if (!connected || switchingADF)
+    {
+      continue;
+    }
+    if ((events & (SENSOR_EVENT_POINT_CLOUD_DELIVERED | SENSOR_EVENT_POINT_CLOUD_REQUESTED)) &&
+        subsystemEnabled[SUBSYSTEM_DEPTH])
+    {
+      updatePointCloudSnapshot();
+    }
+  }
+}
+
+void TangoHandler::updatePointCloudSnapshot()
+{
+  // The generation is read first: connect changes it after the state the
+  // point clouds are retrieved with, disconnect before.
+  uint32_t generation = sensorGeneration;
+  SensorPointCloud pointCloud;
+  if (!sensorBackend->getLatestPointCloud(&pointCloud))
+  {
+    return;
+  }
+  if (pointCloud.timestamp == publishedPointCloudTimestamp && generation == publishedPointCloudGeneration)
+  {
+    return;
+  }
+
+  ScopedTangoTrace trace("TangoHandler::updatePointCloudSnapshot points=%u", pointCloud.numberOfPoints);
+  // Only the device thread reads the point clouds, one at a time, so a slot
+  // is always free.
+  PointCloudSnapshot* snapshot = pointCloudSnapshots.beginWrite();
+  if (snapshot == nullptr)
+  {
+    LOGE("TangoHandler::updatePointCloudSnapshot, all the point cloud snapshots are in use.");
+    return;
+  }
+
+  // The points are in the frame of the poses: the AREA_DESCRIPTION one once
+  // localized.
+  bool depthCameraMatrixIsValid = false;
+  if (lastPoseIsLocalized)
+  {
+    depthCameraMatrixIsValid = sensorBackend->getMatrixTransform(
+      pointCloud.timestamp, SENSOR_FRAME_AREA_DESCRIPTION,
+      SENSOR_FRAME_CAMERA_DEPTH, SENSOR_CONVENTION_TANGO, activityOrientation,
+      snapshot->depthCameraMatrix);
+  }
+
+  if (!depthCameraMatrixIsValid)
+  {
+    depthCameraMatrixIsValid = sensorBackend->getMatrixTransform(
+      pointCloud.timestamp, SENSOR_FRAME_START_OF_SERVICE,
+      SENSOR_FRAME_CAMERA_DEPTH, SENSOR_CONVENTION_TANGO, activityOrientation,
+      snapshot->depthCameraMatrix);
+  }
+
+  // The point cloud is retried with the next event, the readers keep the
+  // previous one meanwhile.
+  if (!depthCameraMatrixIsValid)
+  {
+    LOGE("TangoHandler::updatePointCloudSnapshot, retrieving the depth camera transform matrix failed.");
+    return;
+  }
+
+  // The storage of the points of the snapshot this slot held is reused.
+  const float* points = reinterpret_cast<const float*>(pointCloud.points);
+  snapshot->points.assign(points, points + pointCloud.numberOfPoints * 4);
+  snapshot->pointCloud = pointCloud;
+  snapshot->pointCloud.points = reinterpret_cast<const float (*)[4]>(snapshot->points.data());
+  snapshot->generation = generation;
+  pointCloudSnapshots.publish();
+
+  publishedPointCloudTimestamp = pointCloud.timestamp;
+  publishedPointCloudGeneration = generation;
+}
+
+TripleBuffer<TangoHandler::PointCloudSnapshot>::Snapshot TangoHandler::getPointCloudSnapshot() const
+{
+  TripleBuffer<PointCloudSnapshot>::Snapshot snapshot = pointCloudSnapshots.read();
+  if (snapshot && snapshot->generation != sensorGeneration)
+  {
+    return TripleBuffer<PointCloudSnapshot>::Snapshot();
+  }
+  return snapshot;
+}
+
+bool TangoHandler::getCameraImageSize(uint32_t* width, uint32_t* height)
 {
   bool result = true;
-  *x = tangoCameraIntrinsics.cx;
-  *y = tangoCameraIntrinsics.cy;
+
+  CameraIntrinsicsSnapshot snapshot = getCameraIntrinsicsSnapshot();
+  *width = snapshot.imageWidth;
+  *height = snapshot.imageHeight;
+
+  return result;
+}
+
+bool TangoHandler::getCameraImageTextureSize(uint32_t* width, uint32_t* height)
+{
+  bool result = true;
+
+  CameraIntrinsicsSnapshot snapshot = getCameraIntrinsicsSnapshot();
+  *width = snapshot.imageWidth;
+  *height = snapshot.imageHeight;
+
+  return result;
+}
+
+bool TangoHandler::getCameraFocalLength(double* focalLengthX, double* focalLengthY)
+{
+  bool result = true;
+  CameraIntrinsicsSnapshot snapshot = getCameraIntrinsicsSnapshot();
+  *focalLengthX = snapshot.intrinsics.fx;
+  *focalLengthY = snapshot.intrinsics.fy;
+  return result;
+}
+
+bool TangoHandler::getCameraPoint(double* x, double* y)
+{
+  bool result = true;
+  CameraIntrinsicsSnapshot snapshot = getCameraIntrinsicsSnapshot();
+  *x = snapshot.intrinsics.cx;
+  *y = snapshot.intrinsics.cy;
   return result;
 }
 
 void TangoHandler::onFrameAvailable(const TangoImageBuffer* imageBuffer)
 {
+  // Frames can still arrive for a short while after the callback has been
+  // disconnected.
+  if (!subsystemEnabled[SUBSYSTEM_COLOR_FRAMES])
+  {
+    return;
+  }
+  ScopedTangoTrace trace("TangoHandler::onFrameAvailable");
+  frameCallbackRate.tick();
   TangoSupport_updateImageBuffer(imageBufferManager, imageBuffer);
+  sensorClock.onSampleDelivered(imageBuffer->timestamp);
+
+  // The luma plane is copied for the depth image thread, the same way as the
+  // points of the point clouds. A frame that was not used yet is replaced.
+  if (denseDepthImageRequested)
+  {
+    {
+      std::lock_guard<std::mutex> lock(depthImageMutex);
+      pendingLuma.resize(imageBuffer->width * imageBuffer->height);
+      for (uint32_t y = 0; y < imageBuffer->height; y++)
+      {
+        memcpy(&pendingLuma[y * imageBuffer->width], imageBuffer->data + y * imageBuffer->stride, imageBuffer->width);
+      }
+      pendingLumaWidth = imageBuffer->width;
+      pendingLumaHeight = imageBuffer->height;
+      lumaPending = true;
+    }
+    depthImageCondition.notify_one();
+  }
+
+  if (sessionRecorder->isRecordingFrames())
+  {
+    sessionRecorder->recordFrame(imageBuffer->timestamp, imageBuffer->frame_number,
+        imageBuffer->data, imageBuffer->width, imageBuffer->height, imageBuffer->stride);
+  }
+}
+
+void TangoHandler::getCameraImageUVTransform(float* matrix) const
+{
+  // The height of the address bar is subtracted from the intrinsics without
+  // moving the principal point, so the rows are cut at the bottom of the image.
+  float height = static_cast<float>(getCameraIntrinsicsSnapshot().intrinsics.height);
+  float visibleHeight = height > 0 ? height / (height + ANDROID_WEBVIEW_ADDRESS_BAR_HEIGHT) : 1.0f;
+  cameraImageUVTransform(activityOrientation, sensorOrientation, visibleHeight, matrix);
 }
 
 bool TangoHandler::updateCameraImageIntoTexture(uint32_t textureId)
@@ -1008,11 +1285,38 @@ bool TangoHandler::updateCameraImageIntoTexture(uint32_t textureId)
   //   textureIdConnected = true;
   // }
 
-  TangoErrorType result = TangoService_updateTextureExternalOes(TANGO_CAMERA_COLOR, textureId, &lastTangoImageBufferTimestamp);
+  double previousTimestamp = getCameraImageTimestamp();
+  double timestamp = previousTimestamp;
+  TangoErrorType result;
+  {
+    ScopedTangoTrace trace("TangoService_updateTextureExternalOes");
+    result = TangoService_updateTextureExternalOes(TANGO_CAMERA_COLOR, textureId, &timestamp);
+  }
 
-  std::time(&lastTangoImagebufferTimestampTime);
+  if (result == TANGO_SUCCESS && timestamp != previousTimestamp)
+  {
+    // This is the only thread that publishes camera image snapshots.
+    CameraImageSnapshot* snapshot = cameraImageSnapshots.beginWrite();
+    if (snapshot != nullptr)
+    {
+      snapshot->timestamp = timestamp;
+      snapshot->changeTime = std::chrono::steady_clock::now();
+      cameraImageSnapshots.publish();
+    }
+    else
+    {
+      LOGE("TangoHandler::updateCameraImageIntoTexture, all the camera image snapshots are in use.");
+    }
+    sensorClock.onSampleDelivered(timestamp);
+    double textureAvailableTime = lastTextureAvailableTime;
+    double captureTime = sensorClock.toSteadyTime(timestamp);
+    if (textureAvailableTime > 0 && captureTime > 0)
+    {
+      recordAge(LATENCY_SAMPLE_CAMERA_FRAME, LATENCY_HOP_CALLBACK, (textureAvailableTime - captureTime) * 1000);
+    }
+  }
 
-  // LOGI("JUDAX: TangoHandler::updateCameraImageIntoTexture lastTangoImageBufferTimestamp = %lf, result = %d, textureId = %d", lastTangoImageBufferTimestamp, result, textureId);
+  // LOGI("JUDAX: TangoHandler::updateCameraImageIntoTexture timestamp = %lf, result = %d, textureId = %d", timestamp, result, textureId);
 
   return result == TANGO_SUCCESS;
 }
@@ -1021,7 +1325,38 @@ bool TangoHandler::updateCameraImageIntoTexture(uint32_t textureId)
 
 void TangoHandler::onPointCloudAvailable(const TangoPointCloud* pointCloud)
 {
-  TangoSupport_updatePointCloud(pointCloudManager, pointCloud);
+  ScopedTangoTrace trace("TangoHandler::onPointCloudAvailable");
+  pointCloudCallbackRate.tick();
+  tangoSensorBackend->onPointCloudAvailable(pointCloud);
+  postSensorEvent(SENSOR_EVENT_POINT_CLOUD_DELIVERED);
+
+  sensorClock.onSampleDelivered(pointCloud->timestamp);
+  recordLatency(LATENCY_SAMPLE_POINT_CLOUD, LATENCY_HOP_CALLBACK, sensorClock.toSteadyTime(pointCloud->timestamp));
+
+  // The callback only copies the points: they are projected on the depth
+  // image thread. A point cloud that was not projected yet is replaced.
+  if (depthImageRequested)
+  {
+    {
+      std::lock_guard<std::mutex> lock(depthImageMutex);
+      const float* points = &pointCloud->points[0][0];
+      pendingDepthPoints.assign(points, points + pointCloud->num_points * 4);
+      pendingDepthTimestamp = pointCloud->timestamp;
+      depthPointsPending = true;
+    }
+    depthImageCondition.notify_one();
+  }
+
+  if (sessionRecorder->isRecording())
+  {
+    float depthTransform[16];
+    bool depthTransformIsValid = tangoSensorBackend->getMatrixTransform(
+        pointCloud->timestamp, SENSOR_FRAME_START_OF_SERVICE,
+        SENSOR_FRAME_CAMERA_DEPTH, SENSOR_CONVENTION_TANGO,
+        SENSOR_ROTATION_IGNORED, depthTransform);
+    sessionRecorder->recordPointCloud(pointCloud->timestamp, &pointCloud->points[0][0], pointCloud->num_points,
+        depthTransformIsValid ? depthTransform : nullptr);
+  }
 }
 
 #endif
@@ -1040,77 +1375,212 @@ bool TangoHandler::getADFs(std::vector<ADF>& adfs) const
 {
   // jniEnv->CallVoidMethod(mainActivityJObject, requestADFPermissionJMethodID);
 
-  TangoConfig tango_config_ = TangoService_getConfig(TANGO_CONFIG_DEFAULT);
-  if (tango_config_ == nullptr) {
-    LOGE("TangoHandler::getADFs failed to get default config form");
-    return false;
-  }
-
   char* uuids = nullptr;
   int ret = TangoService_getAreaDescriptionUUIDList(&uuids);
   if (ret != TANGO_SUCCESS) {
     LOGE("TangoHandler::getADFs failed to get the area description with error code: %d", ret);
     return false;
   }
+  std::string uuidList = uuids != nullptr ? uuids : "";
 
-  adfs.clear();
-  std::string uuid;
-  bool thereIsADF = false; // This flag allows us to know if there is an ADF to be added (the uuid has been filled up).
-  for (unsigned int i = 0; uuids[i] != 0; i++)
+  std::lock_guard<std::mutex> lock(adfCacheMutex);
+  if (uuidList != adfCacheUUIDList)
   {
-    if (uuids[i] == ',')
+    updateADFCache(uuidList);
+  }
+  adfs = cachedADFs;
+  return true;
+}
+
+void TangoHandler::updateADFCache(const std::string& uuidList) const
+{
+  // Only the metadata of the ADFs that are not in the cache yet is requested.
+  // ADFs that are not in the list anymore are dropped.
+  std::map<std::string, ADF> previousADFCache;
+  previousADFCache.swap(adfCache);
+  cachedADFs.clear();
+  bool complete = true;
+  size_t begin = 0;
+  while (begin < uuidList.size())
+  {
+    size_t end = uuidList.find(',', begin);
+    if (end == std::string::npos)
     {
-      if (thereIsADF && !addADF(uuid, adfs))
-      {
-        LOGE("TangoHandler::getADFs failed to create the ADF for uuid '%s'", uuid.c_str());
-        // For now, if one ADF fails, continue retrieving the others.
-      }
-      uuid = "";
-      thereIsADF = false;
+      end = uuidList.size();
     }
-    else 
+    std::string uuid = uuidList.substr(begin, end - begin);
+    begin = end + 1;
+    if (uuid.empty())
     {
-      thereIsADF = true;
-      uuid += uuids[i];
+      continue;
     }
+
+    std::map<std::string, ADF>::iterator it = previousADFCache.find(uuid);
+    if (it != previousADFCache.end())
+    {
+      adfCache.insert(*it);
+      cachedADFs.push_back(it->second);
+      continue;
+    }
+
+    std::string name;
+    unsigned long long creationTime = 0;
+    if (!getADFMetadata(uuid, name, creationTime))
+    {
+      LOGE("TangoHandler::getADFs failed to create the ADF for uuid '%s'", uuid.c_str());
+      // For now, if one ADF fails, continue retrieving the others. It will be
+      // retried on the next call.
+      complete = false;
+      continue;
+    }
+    ADF adf(uuid, name, creationTime);
+    adfCache.insert(std::make_pair(uuid, adf));
+    cachedADFs.push_back(adf);
   }
-  // Add the last ADF
-  if (thereIsADF && !addADF(uuid, adfs))
-  {
-    LOGE("TangoHandler::getADFs failed to create the ADF for uuid '%s'", uuid.c_str());
-    // For now, if one ADF fails, continue retrieving the others.
-  }
-  return true;
+  adfCacheUUIDList = complete ? uuidList : "";
+}
+
+void TangoHandler::enableADF(const std::string& uuid, const ADFSwitchCallback& callback)
+{
+  requestADFSwitch(uuid, callback);
+}
+
+void TangoHandler::disableADF(const ADFSwitchCallback& callback)
+{
+  requestADFSwitch("", callback);
+}
+
+bool TangoHandler::isSwitchingADF() const
+{
+  return switchingADF;
 }
 
-void TangoHandler::enableADF(const std::string& uuid)
+void TangoHandler::requestADFSwitch(const std::string& uuid, const ADFSwitchCallback& callback)
 {
-  if (lastEnabledADFUUID != uuid)
+  // The callbacks are called outside of the lock as they may post tasks or
+  // request another switch.
+  std::vector<ADFSwitchCallback> supersededCallbacks;
+  bool alreadyEnabled;
   {
-    if (connected)
+    std::lock_guard<std::mutex> lock(adfSwitchMutex);
+    // lastEnabledADFUUID is also written with adfSwitchMutex locked.
+    alreadyEnabled = adfSwitchState == ADF_SWITCH_IDLE && uuid == lastEnabledADFUUID;
+    if (!alreadyEnabled)
     {
-      disconnect();
+      // Only the last request is applied.
+      std::vector<std::pair<std::string, ADFSwitchCallback>> pendingCallbacks;
+      for (size_t i = 0; i < adfSwitchCallbacks.size(); i++)
+      {
+        if (adfSwitchCallbacks[i].first == uuid)
+        {
+          pendingCallbacks.push_back(adfSwitchCallbacks[i]);
+        }
+        else
+        {
+          supersededCallbacks.push_back(adfSwitchCallbacks[i].second);
+        }
+      }
+      if (callback)
+      {
+        pendingCallbacks.push_back(std::make_pair(uuid, callback));
+      }
+      adfSwitchCallbacks.swap(pendingCallbacks);
+      requestedADFUUID = uuid;
+      adfSwitchRequested = true;
+      if (adfSwitchState == ADF_SWITCH_IDLE)
+      {
+        adfSwitchState = ADF_SWITCH_REQUESTED;
+      }
+      switchingADF = true;
+
+      if (!adfSwitchThread.joinable())
+      {
+        adfSwitchThread = std::thread(&TangoHandler::adfSwitchLoop, this);
+      }
     }
-    connect(uuid);
+  }
+
+  if (alreadyEnabled)
+  {
+    if (callback)
+    {
+      callback(connected);
+    }
+    return;
+  }
+
+  adfSwitchCondition.notify_one();
+  for (size_t i = 0; i < supersededCallbacks.size(); i++)
+  {
+    supersededCallbacks[i](false);
   }
 }
 
-void TangoHandler::disableADF()
+void TangoHandler::adfSwitchLoop()
 {
-  if (lastEnabledADFUUID != "")
+  std::unique_lock<std::mutex> lock(adfSwitchMutex);
+  while (true)
   {
-    if (connected)
+    adfSwitchCondition.wait(lock, [this]() { return stopADFSwitchThread || adfSwitchRequested; });
+    if (stopADFSwitchThread)
+    {
+      return;
+    }
+
+    std::string uuid = requestedADFUUID;
+    std::vector<std::pair<std::string, ADFSwitchCallback>> callbacks;
+    callbacks.swap(adfSwitchCallbacks);
+    adfSwitchRequested = false;
+    adfSwitchState = ADF_SWITCH_RECONNECTING;
+    lock.unlock();
+
+    bool success;
     {
-      disconnect();
+      ScopedTangoTrace trace("TangoHandler::switchADF");
+      std::lock_guard<std::mutex> connectionLock(connectionMutex);
+      if (lastEnabledADFUUID != uuid)
+      {
+        if (connected)
+        {
+          disconnect();
+        }
+        connect(uuid);
+      }
+      success = connected && lastEnabledADFUUID == uuid;
+    }
+
+    for (size_t i = 0; i < callbacks.size(); i++)
+    {
+      callbacks[i].second(success);
+    }
+
+    lock.lock();
+    if (!adfSwitchRequested)
+    {
+      adfSwitchState = ADF_SWITCH_IDLE;
+      switchingADF = false;
     }
-    connect("");
   }
 }
 
-bool TangoHandler::getMarkers(TangoSupportMarkerType markerType, float markerSize, std::vector<Marker>& markers)
+bool TangoHandler::getMarkers(MarkerType markerType, float markerSize, std::vector<Marker>& markers)
 {
+  // No markers while the ADF switch thread reconnects the Tango Service.
+  if (switchingADF)
+  {
+    return false;
+  }
+
   if (connected)
   {
+    // The color camera frames are only delivered while markers are requested.
+    // The sensor thread enables them, there is nothing to detect until then.
+    useSubsystem(SUBSYSTEM_COLOR_FRAMES);
+    if (!subsystemEnabled[SUBSYSTEM_COLOR_FRAMES])
+    {
+      return true;
+    }
+
     // Copy the currently detected markers to the passed container.
     // Once copied, clear the detected markers.
     markerDetectionMutex.lock();
@@ -1120,14 +1590,16 @@ bool TangoHandler::getMarkers(TangoSupportMarkerType markerType, float markerSiz
 
     // Marker detection is a time-consuming process. This is to make sure marker
     // detection process runs at a frequency no higher than a pre-defined FPS.
-    if (lastTangoImageBufferTimestamp < lastMarkerTangoImageBufferTimestamp + 1.0 / kMarkerDetectionFPS)
+    double cameraImageTimestamp = getCameraImageTimestamp();
+    if (cameraImageTimestamp < lastMarkerTangoImageBufferTimestamp + 1.0 / kMarkerDetectionFPS)
       return true;
 
-    lastMarkerTangoImageBufferTimestamp = lastTangoImageBufferTimestamp;
+    lastMarkerTangoImageBufferTimestamp = cameraImageTimestamp;
 
     // Start a new detection query in a different thread
     std::thread t([this, markerType, markerSize]()
     {
+      ScopedTangoTrace trace("TangoHandler::detectMarkers type=%d", markerType);
       // Get latest image buffer.
       TangoImageBuffer* imageBuffer = nullptr;
       TangoErrorType status = TangoSupport_getLatestImageBuffer(
@@ -1136,8 +1608,13 @@ bool TangoHandler::getMarkers(TangoSupportMarkerType markerType, float markerSiz
       {
         if (status == TANGO_SUCCESS)
         {
+          if (markerType == MARKER_TYPE_FIDUCIAL)
+          {
+            detectMarkersNatively(imageBuffer, markerSize);
+            return;
+          }
           TangoSupportMarkerParam param;
-          param.type = markerType;
+          param.type = static_cast<TangoSupportMarkerType>(markerType);
           param.marker_size = markerSize;
           TangoSupportMarkerList markerList;
           
@@ -1153,6 +1630,7 @@ bool TangoHandler::getMarkers(TangoSupportMarkerType markerType, float markerSiz
 
           if (TangoSupport_detectMarkers(imageBuffer, TANGO_CAMERA_COLOR, translation, orientation, &param, &markerList) == TANGO_SUCCESS)
           {
+            TangoTrace::setCounter("TangoDetectedMarkers", markerList.marker_count);
             markerDetectionMutex.lock();
             detectedMarkers.clear();
             for (int i = 0; i < markerList.marker_count; ++i)
@@ -1161,17 +1639,23 @@ bool TangoHandler::getMarkers(TangoSupportMarkerType markerType, float markerSiz
               std::string content;
               switch(markerType)
               {
-                case TANGO_MARKER_ARTAG:
+                case MARKER_TYPE_ARTAG:
                   id = atoi(markerList.markers[i].content);
                   break;
-                case TANGO_MARKER_QRCODE:
+                case MARKER_TYPE_QRCODE:
                   content = std::string(markerList.markers[i].content, markerList.markers[i].content_size);
                   break;
+                default:
+                  break;
               }
               detectedMarkers.push_back(Marker(markerType, id, 
                 content, markerList.markers[i].translation, 
                 markerList.markers[i].orientation));
             }
+            if (sessionRecorder->isRecording())
+            {
+              recordMarkers(imageBuffer->timestamp, detectedMarkers);
+            }
             markerDetectionMutex.unlock();
             TangoSupport_freeMarkerList(&markerList);
           }
@@ -1186,11 +1670,440 @@ bool TangoHandler::getMarkers(TangoSupportMarkerType markerType, float markerSiz
   return connected;
 }
 
-bool TangoHandler::hasLastTangoImageBufferTimestampChangedLately()
+uint32_t TangoHandler::createAnchor(const float* modelMatrix)
+{
+  if (!connected)
+  {
+    return 0;
+  }
+
+  Anchor anchor;
+  memcpy(anchor.modelMatrix, modelMatrix, sizeof(anchor.modelMatrix));
+  anchor.inAreaDescriptionFrame = lastPoseIsLocalized;
+
+  std::lock_guard<std::mutex> lock(anchorsMutex);
+  uint32_t anchorId = nextAnchorId++;
+  if (nextAnchorId == 0)
+  {
+    nextAnchorId = 1;
+  }
+  anchors.insert(std::make_pair(anchorId, anchor));
+  return anchorId;
+}
+
+bool TangoHandler::removeAnchor(uint32_t anchorId)
+{
+  std::lock_guard<std::mutex> lock(anchorsMutex);
+  return anchors.erase(anchorId) > 0;
+}
+
+bool TangoHandler::getAreaDescriptionFromStartOfService(float* matrix)
+{
+  if (!adfEnabled)
+  {
+    return false;
+  }
+  return sensorBackend->getMatrixTransform(
+    0.0, SENSOR_FRAME_AREA_DESCRIPTION, SENSOR_FRAME_START_OF_SERVICE,
+    SENSOR_CONVENTION_OPENGL, SENSOR_ROTATION_IGNORED, matrix);
+}
+
+bool TangoHandler::getAnchorModelMatrices(const std::vector<uint32_t>& anchorIds, std::vector<uint32_t>& expressedAnchorIds, std::vector<float>& modelMatrices)
+{
+  expressedAnchorIds.clear();
+  modelMatrices.clear();
+
+  // Nothing changes while the ADF switch thread reconnects the Tango Service.
+  if (!connected || switchingADF)
+  {
+    return false;
+  }
+
+  bool localized = lastPoseIsLocalized;
+  float correction[16];
+  bool correctionIsValid = getAreaDescriptionFromStartOfService(correction);
+  float inverseCorrection[16];
+  if (correctionIsValid)
+  {
+    matrixInverse(correction, inverseCorrection);
+  }
+
+  std::lock_guard<std::mutex> lock(anchorsMutex);
+  float modelMatrix[16];
+  for (size_t i = 0; i < anchorIds.size(); i++)
+  {
+    std::map<uint32_t, Anchor>::const_iterator it = anchors.find(anchorIds[i]);
+    if (it == anchors.end())
+    {
+      continue;
+    }
+    const Anchor& anchor = it->second;
+    if (anchor.inAreaDescriptionFrame == localized)
+    {
+      memcpy(modelMatrix, anchor.modelMatrix, sizeof(modelMatrix));
+    }
+    else if (!correctionIsValid)
+    {
+      // The anchor cannot be expressed in the current frame.
+      continue;
+    }
+    else if (localized)
+    {
+      matrixMultiply(correction, anchor.modelMatrix, modelMatrix);
+    }
+    else
+    {
+      matrixMultiply(inverseCorrection, anchor.modelMatrix, modelMatrix);
+    }
+    expressedAnchorIds.push_back(it->first);
+    modelMatrices.insert(modelMatrices.end(), modelMatrix, modelMatrix + 16);
+  }
+  return true;
+}
+
+void TangoHandler::detectMarkersNatively(const TangoImageBuffer* imageBuffer, float markerSize)
+{
+  // Detection requests come from detached threads. If a previous detection is
+  // still running, just skip this frame.
+  std::unique_lock<std::mutex> lock(markerDetectorMutex, std::try_to_lock);
+  if (!lock.owns_lock())
+  {
+    return;
+  }
+
+  if (markerDetector == nullptr)
+  {
+    markerDetector = new MarkerDetector();
+  }
+
+  // The luma plane of the NV21 buffer is used as is.
+  GrayImage image;
+  image.data = imageBuffer->data;
+  image.width = imageBuffer->width;
+  image.height = imageBuffer->height;
+  image.stride = imageBuffer->stride;
+
+  const TangoCameraIntrinsics colorCameraIntrinsics = getCameraIntrinsicsSnapshot().colorCameraIntrinsics;
+  CameraModel camera;
+  camera.fx = colorCameraIntrinsics.fx;
+  camera.fy = colorCameraIntrinsics.fy;
+  camera.cx = colorCameraIntrinsics.cx;
+  camera.cy = colorCameraIntrinsics.cy;
+
+  std::vector<DetectedMarker> markers;
+  {
+    ScopedTangoTrace trace("MarkerDetector::detect %ux%u", image.width, image.height);
+    markerDetector->detect(image, camera, markerSize, markers);
+  }
+  TangoTrace::setCounter("TangoDetectedMarkers", markers.size());
+
+  double cameraTranslation[3];
+  double cameraOrientation[4];
+  poseForMarkerDetectionMutex.lock();
+  memcpy(cameraTranslation, poseForMarkerDetection.translation, sizeof(double) * 3);
+  memcpy(cameraOrientation, poseForMarkerDetection.orientation, sizeof(double) * 4);
+  poseForMarkerDetectionMutex.unlock();
+
+  markerDetectionMutex.lock();
+  detectedMarkers.clear();
+  for (const DetectedMarker& marker : markers)
+  {
+    double translation[3];
+    double orientation[4];
+    MarkerDetector::transformMarkerPose(marker, cameraTranslation, cameraOrientation, translation, orientation);
+    detectedMarkers.push_back(Marker(MARKER_TYPE_FIDUCIAL, marker.id, "", translation, orientation));
+  }
+  if (sessionRecorder->isRecording())
+  {
+    recordMarkers(imageBuffer->timestamp, detectedMarkers);
+  }
+  markerDetectionMutex.unlock();
+}
+
+bool TangoHandler::startRecording(const std::string& path, unsigned frameSubsample)
+{
+  if (!sessionRecorder->start(path, frameSubsample))
+  {
+    LOGE("TangoHandler::startRecording, could not open %s.", path.c_str());
+    return false;
+  }
+  LOGI("TangoHandler::startRecording, recording the session to %s.", path.c_str());
+  if (connected)
+  {
+    recordCameraIntrinsics();
+  }
+  return true;
+}
+
+void TangoHandler::stopRecording()
+{
+  if (!sessionRecorder->isRecording())
+  {
+    return;
+  }
+  sessionRecorder->stop();
+  if (sessionRecorder->hasFailed())
+  {
+    LOGE("TangoHandler::stopRecording, writing the session log failed.");
+  }
+  if (sessionRecorder->getDroppedRecords() > 0)
+  {
+    LOGE("TangoHandler::stopRecording, %llu records were dropped.",
+        static_cast<unsigned long long>(sessionRecorder->getDroppedRecords()));
+  }
+}
+
+bool TangoHandler::isRecording() const
+{
+  return sessionRecorder->isRecording();
+}
+
+void TangoHandler::recordCameraIntrinsics()
+{
+  const SensorCameraIntrinsics cameraIntrinsics = getCameraIntrinsicsSnapshot().intrinsics;
+  SessionLogCameraIntrinsics intrinsics;
+  intrinsics.width = cameraIntrinsics.width;
+  intrinsics.height = cameraIntrinsics.height;
+  intrinsics.fx = cameraIntrinsics.fx;
+  intrinsics.fy = cameraIntrinsics.fy;
+  intrinsics.cx = cameraIntrinsics.cx;
+  intrinsics.cy = cameraIntrinsics.cy;
+  memcpy(intrinsics.distortion, cameraIntrinsics.distortion, sizeof(intrinsics.distortion));
+  intrinsics.calibrationType = cameraIntrinsics.calibrationType;
+  intrinsics.displayRotation = activityOrientation;
+  intrinsics.sensorOrientation = sensorOrientation;
+  intrinsics.reserved = 0;
+  sessionRecorder->recordCameraIntrinsics(getCameraImageTimestamp(), intrinsics);
+}
+
+void TangoHandler::recordMarkers(double timestamp, const std::vector<Marker>& markers)
+{
+  std::vector<SessionLogMarker> sessionLogMarkers(markers.size());
+  std::vector<std::string> contents(markers.size());
+  for (size_t i = 0; i < markers.size(); i++)
+  {
+    sessionLogMarkers[i].type = markers[i].getType();
+    sessionLogMarkers[i].id = markers[i].getId();
+    memcpy(sessionLogMarkers[i].translation, markers[i].getPosition(), sizeof(sessionLogMarkers[i].translation));
+    memcpy(sessionLogMarkers[i].orientation, markers[i].getOrientation(), sizeof(sessionLogMarkers[i].orientation));
+    contents[i] = markers[i].getContent();
+  }
+  sessionRecorder->recordMarkers(timestamp, sessionLogMarkers, contents);
+}
+
+void TangoHandler::useSubsystem(Subsystem subsystem)
+{
+  // The sensor thread enables the subsystem, so a use is never lost to a
+  // caller that holds connectionMutex.
+  subsystemLastUse[subsystem] = SensorClock::now();
+  if (!subsystemEnabled[subsystem])
+  {
+    postSensorEvent(SENSOR_EVENT_SUBSYSTEM_USED);
+  }
+}
+
+void TangoHandler::updateSubsystems()
+{
+  const double now = SensorClock::now();
+  const double idleTimeout = std::chrono::duration<double>(kSubsystemIdleTimeout).count();
+  bool used[NUMBER_OF_SUBSYSTEMS];
+  bool changed = false;
+  for (int i = 0; i < NUMBER_OF_SUBSYSTEMS; i++)
+  {
+    double lastUse = subsystemLastUse[i];
+    used[i] = lastUse > 0 && now - lastUse < idleTimeout;
+    changed = changed || used[i] != subsystemEnabled[i];
+  }
+  if (!changed)
+  {
+    return;
+  }
+
+  // A subsystem that fails to toggle is retried on the next wake up.
+  std::lock_guard<std::mutex> connectionLock(connectionMutex);
+  if (!connected)
+  {
+    return;
+  }
+  for (int i = 0; i < NUMBER_OF_SUBSYSTEMS; i++)
+  {
+    if (used[i] != subsystemEnabled[i] && setSubsystemEnabled(static_cast<Subsystem>(i), used[i]))
+    {
+      subsystemEnabled[i] = used[i];
+    }
+  }
+}
+
+void TangoHandler::restoreSubsystems()
+{
+  // After a reconnection (resume or ADF switch) only the subsystems that were
+  // in use are enabled again. Depth is always running right after connecting,
+  // so it has to be paused explicitly.
+  for (int i = 0; i < NUMBER_OF_SUBSYSTEMS; i++)
+  {
+    Subsystem subsystem = static_cast<Subsystem>(i);
+    if (subsystemEnabled[i])
+    {
+      subsystemEnabled[i] = setSubsystemEnabled(subsystem, true);
+    }
+    if (!subsystemEnabled[i] && subsystem == SUBSYSTEM_DEPTH)
+    {
+      setSubsystemEnabled(subsystem, false);
+    }
+  }
+}
+
+bool TangoHandler::setSubsystemEnabled(Subsystem subsystem, bool enabled)
+{
+  ScopedTangoTrace trace("TangoHandler::setSubsystemEnabled subsystem=%d enabled=%d", subsystem, enabled);
+  TangoErrorType result = TANGO_SUCCESS;
+  switch (subsystem)
+  {
+    case SUBSYSTEM_DEPTH:
+    {
+#ifdef TANGO_USE_POINT_CLOUD
+      // Depth can only be enabled when connecting, but the depth camera can be
+      // paused at runtime by setting its framerate to 0.
+      TangoConfig runtimeConfig = TangoService_getConfig(TANGO_CONFIG_RUNTIME);
+      if (runtimeConfig == nullptr)
+      {
+        LOGE("TangoHandler::setSubsystemEnabled, TangoService_getConfig(TANGO_CONFIG_RUNTIME) error.");
+        return false;
+      }
+      result = TangoConfig_setInt32(runtimeConfig, "config_runtime_depth_framerate", enabled ? kDepthFramerate : 0);
+      if (result == TANGO_SUCCESS)
+      {
+        result = TangoService_setRuntimeConfig(runtimeConfig);
+      }
+      TangoConfig_free(runtimeConfig);
+#endif
+      // The depth images are requested again when depth is used again.
+      if (!enabled)
+      {
+        depthImageRequested = false;
+        denseDepthImageRequested = false;
+      }
+      break;
+    }
+    case SUBSYSTEM_COLOR_FRAMES:
+    {
+      if (!enabled)
+      {
+        denseDepthImageRequested = false;
+      }
+#ifdef TANGO_USE_MARKERS
+      if (enabled && imageBufferManager == nullptr)
+      {
+        const TangoCameraIntrinsics colorCameraIntrinsics = getCameraIntrinsicsSnapshot().colorCameraIntrinsics;
+        result = TangoSupport_createImageBufferManager(
+            TANGO_HAL_PIXEL_FORMAT_YCrCb_420_SP, colorCameraIntrinsics.width,
+            colorCameraIntrinsics.height, &imageBufferManager);
+        if (result != TANGO_SUCCESS)
+        {
+          LOGE("TangoHandler::setSubsystemEnabled, failed to create image buffer manager with error code: %d", result);
+          return false;
+        }
+      }
+
+      // Copying every NV21 frame to the image buffer manager is what makes
+      // this subsystem expensive, so the callback is disconnected when idle.
+      result = TangoService_connectOnFrameAvailable(TANGO_CAMERA_COLOR, this, enabled ? ::onFrameAvailable : nullptr);
+
+      if (!enabled)
+      {
+        std::lock_guard<std::mutex> lock(markerDetectorMutex);
+        delete markerDetector;
+        markerDetector = nullptr;
+      }
+
+#endif
+      break;
+    }
+    default:
+      break;
+  }
+
+  if (result != TANGO_SUCCESS)
+  {
+    LOGE("TangoHandler::setSubsystemEnabled, %s subsystem %d failed with error code: %d", enabled ? "enabling" : "disabling", subsystem, result);
+  }
+  return result == TANGO_SUCCESS;
+}
+
+double TangoHandler::getRecentCameraImageTimestamp() const
+{
+  TripleBuffer<CameraImageSnapshot, 6>::Snapshot snapshot = cameraImageSnapshots.read();
+  if (!snapshot || std::chrono::steady_clock::now() - snapshot->changeTime >= kImageBufferTimestampTimeout)
+  {
+    return 0;
+  }
+  return snapshot->timestamp;
+}
+
+void TangoHandler::onTextureAvailable()
+{
+  textureCallbackRate.tick();
+  lastTextureAvailableTime = SensorClock::now();
+  cameraFrameCount++;
+
+  std::lock_guard<std::mutex> lock(frameAvailableCallbackMutex);
+  if (frameAvailableCallback)
+  {
+    frameAvailableCallback();
+  }
+}
+
+uint32_t TangoHandler::getCameraFrameCount() const
+{
+  return cameraFrameCount;
+}
+
+double TangoHandler::getPoseCameraTimestamp() const
+{
+  return poseCameraTimestamp;
+}
+
+double TangoHandler::getSampleCaptureTime(double sensorTimestamp) const
+{
+  return sensorClock.toSteadyTime(sensorTimestamp);
+}
+
+void TangoHandler::recordLatency(LatencySample sample, LatencyHop hop, double captureTime)
+{
+  if (captureTime > 0)
+  {
+    recordAge(sample, hop, (SensorClock::now() - captureTime) * 1000);
+  }
+}
+
+void TangoHandler::recordAge(LatencySample sample, LatencyHop hop, double milliseconds)
+{
+  std::lock_guard<std::mutex> lock(latencyMutex);
+  latencyHistograms[sample][hop].record(milliseconds);
+}
+
+void TangoHandler::getLatencyStatistics(LatencySample sample, LatencyHop hop, LatencyStatistics* statistics) const
+{
+  std::lock_guard<std::mutex> lock(latencyMutex);
+  latencyHistograms[sample][hop].getStatistics(statistics);
+}
+
+double TangoHandler::getPointCloudTimestamp() const
+{
+  return retrievedPointCloudTimestamp;
+}
+
+double TangoHandler::getCameraImageTimestamp() const
+{
+  TripleBuffer<CameraImageSnapshot, 6>::Snapshot snapshot = cameraImageSnapshots.read();
+  return snapshot ? snapshot->timestamp : 0;
+}
+
+void TangoHandler::getCallbackRates(double* pointCloudRate, double* frameRate, double* textureRate) const
 {
-  std::time_t currentTime;
-  std::time(&currentTime);
-  return std::difftime(currentTime, lastTangoImagebufferTimestampTime) < 1.0;
+  *pointCloudRate = pointCloudCallbackRate.getRate();
+  *frameRate = frameCallbackRate.getRate();
+  *textureRate = textureCallbackRate.getRate();
 }
 
 }  // namespace tango_chromium
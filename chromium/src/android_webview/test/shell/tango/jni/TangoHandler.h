@@ -20,7 +20,10 @@
 #include "tango_client_api.h"   // NOLINT
 #include "tango_support_api.h"  // NOLINT
 
-#include <ctime>
+#include "DepthImageProjector.h"
+#include "SensorBackend.h"
+#include "SensorTiming.h"
+#include "TripleBuffer.h"
 
 #include <jni.h>
 #include <android/log.h>
@@ -28,8 +31,14 @@
 #include <string>
 #include <vector>
 #include <queue>
+#include <map>
 
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <thread>
 
 #define LOG_TAG "Tango Chromium"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
@@ -45,6 +54,10 @@
 
 namespace tango_chromium {
 
+class MarkerDetector;
+class SessionRecorder;
+class TangoSensorBackend;
+
 class Hit
 {
 public:
@@ -78,16 +91,30 @@ private:
 	unsigned long long creationTime;
 };
 
+// The types of the markers getMarkers detects. ARTag markers and QR codes are
+// detected by TangoSupport, fiducials by the native MarkerDetector.
+enum MarkerType
+{
+	MARKER_TYPE_ARTAG = TANGO_MARKER_ARTAG,
+	MARKER_TYPE_QRCODE = TANGO_MARKER_QRCODE,
+	// Square fiducials with a code of the MarkerDetector dictionary (see
+	// MarkerDetector::getCode), not an ARTag code.
+	MARKER_TYPE_FIDUCIAL = 0x04
+};
+
+// A detected marker. ARTag markers have the id of the ARTag code they show and
+// fiducials the index of their code in the MarkerDetector dictionary. QR codes
+// have no id but a content.
 class Marker
 {
 public:
-	Marker(TangoSupportMarkerType type, int id, const std::string& content, const double* position, const double* orientation): type(type), id(id), content(content)
+	Marker(MarkerType type, int id, const std::string& content, const double* position, const double* orientation): type(type), id(id), content(content)
 	{
 		memcpy(this->position, position, sizeof(this->position));
 		memcpy(this->orientation, orientation, sizeof(this->orientation));
 	}
 
-	TangoSupportMarkerType getType() const
+	MarkerType getType() const
 	{
 		return type;
 	}
@@ -112,7 +139,7 @@ public:
 		return orientation;
 	}
 private:
-	TangoSupportMarkerType type;
+	MarkerType type;
 	int id;
 	std::string content;
 	double position[3];
@@ -122,6 +149,19 @@ private:
 // TangoHandler provides functionality to communicate with the Tango Service.
 class TangoHandler {
 public:
+	// Called from the ADF switch thread once the Tango Service has been
+	// reconnected with the requested ADF, with whether the switch succeeded.
+	typedef std::function<void(bool)> ADFSwitchCallback;
+	// Called when the Tango Service connects or disconnects and when the
+	// rotation of the device changes, from the thread that made the change.
+	// It must not call back into TangoHandler: post a task instead.
+	typedef std::function<void()> StateChangedCallback;
+	// Called from the Tango Service thread when a new color camera frame can be
+	// updated into a texture. Same restrictions as StateChangedCallback, and it
+	// must return quickly.
+	typedef std::function<void()> FrameAvailableCallback;
+
+	// getInstance can be called from any thread.
 	static TangoHandler* getInstance();
 	static void releaseInstance();
 
@@ -138,69 +178,253 @@ public:
 	void onDeviceRotationChanged(int activityOrientation, int sensorOrientation);
 	void resetPose();
 
+	// Only one callback is kept. An empty callback removes it.
+	void setStateChangedCallback(const StateChangedCallback& callback);
+	// Same for the callback of the new camera frames.
+	void setFrameAvailableCallback(const FrameAvailableCallback& callback);
+
 	bool updateCameraIntrinsics();
 
 	bool isConnected() const;
 
 	bool getPose(TangoPoseData* tangoPoseData, bool* isLocalized);
+	// The timestamp of the sensor frame getPose returns the pose of, or 0 if it
+	// returns the latest pose. Poses with the same timestamp are the same.
+	double getPoseTimestamp() const;
 	bool getPoseMatrix(float* matrix);
 	bool getProjectionMatrix(float near, float far, float* porjectionMatrix);
 
 	unsigned getMaxNumberOfPointsInPointCloud() const;
 	bool getPointCloud(uint32_t* numberOfPoints, float* points, bool justUpdatePointCloud, unsigned pointsToSkip, bool transformPoints, float* pointsTransformMatrix);
+	// The timestamp of the point cloud getPointCloud would return, without
+	// copying it, or 0 if there is none. Marks the depth camera as used.
+	double getLatestPointCloudTimestamp();
+	// The number of points the GPU process last uploaded into a WebGL buffer.
+	// The renderer gets it from the VR device later instead of waiting for the
+	// upload.
+	void setUploadedNumberOfPoints(uint32_t numberOfPoints);
+	uint32_t getUploadedNumberOfPoints() const;
 	bool hitTest(float x, float y, std::vector<Hit>& hits);
+	// The latest point cloud projected into the color camera image, without
+	// display rotation and at 1/8 of its resolution (see DepthImageProjector).
+	// The point clouds are projected on a worker thread as they are delivered,
+	// starting with the first call. Returns false until an image is available.
+	bool getDepthImage(DepthImage& image);
+	// The latest depth image with its holes filled (see DepthDensifier),
+	// guided by the latest color camera frame. It has the size of the images
+	// of getDepthImage and is densified on the depth image thread for every
+	// color camera frame, starting with the first call. Returns false until an
+	// image is available.
+	bool getDenseDepthImage(DepthImage& image);
+	// The size of the image getDepthImage would return, 0 x 0 if there is none.
+	void getDepthImageSize(uint32_t* width, uint32_t* height);
 
 	bool getCameraImageSize(uint32_t* width, uint32_t* height);
 	bool getCameraImageTextureSize(uint32_t* width, uint32_t* height);
 	bool getCameraFocalLength(double* focalLengthX, double* focalLengthY);
 	bool getCameraPoint(double* x, double* y);
+	// The column major texture coordinate transform that shows the camera
+	// image in the orientation of the display, without the part hidden by the
+	// address bar, on a quad covering the page (see cameraImageUVTransform).
+	void getCameraImageUVTransform(float* matrix) const;
+	// Always called from the same thread, the one of the GL context of the
+	// texture.
 	bool updateCameraImageIntoTexture(uint32_t textureId);
+	// The number of color camera images signaled by the Tango Service so far:
+	// when it changes, there is a new image to update into a texture.
+	uint32_t getCameraFrameCount() const;
+	// The timestamp of the camera image the last pose of getPose was computed
+	// for, or 0 for the latest pose: the image to display along with that
+	// pose (see CameraFrameRing).
+	double getPoseCameraTimestamp() const;
 
 #ifdef TANGO_USE_POINT_CLOUD_CALLBACK
 	void onPointCloudAvailable(const TangoPointCloud* pointCloud);
 #endif
 	
 	void onFrameAvailable(const TangoImageBuffer* imageBuffer);
+	void onTextureAvailable();
 
 	int getActivityOrientation() const;
 	int getSensorOrientation() const;
 
 	bool getADFs(std::vector<ADF>& adfs) const;
-	void enableADF(const std::string& uuid);
-	void disableADF();
-
-	bool getMarkers(TangoSupportMarkerType markerType, float markerSize, std::vector<Marker>& markers);
+	// ADF switches are asynchronous: the Tango Service is reconnected on a
+	// background thread. Meanwhile, getPose keeps returning the live poses
+	// while the Tango Service is connected (START_OF_SERVICE ones until the new
+	// ADF is localized) and the last pose while it is disconnected, as nothing
+	// is tracked then. Requests made during a switch are coalesced: only the
+	// last one is applied and the callbacks of the others are called with
+	// false.
+	void enableADF(const std::string& uuid, const ADFSwitchCallback& callback = ADFSwitchCallback());
+	void disableADF(const ADFSwitchCallback& callback = ADFSwitchCallback());
+	bool isSwitchingADF() const;
+
+	bool getMarkers(MarkerType markerType, float markerSize, std::vector<Marker>& markers);
+
+	// Anchors keep a model matrix (column major, in the same frame as the
+	// poses returned by getPose) in sync with the corrections between the
+	// AREA_DESCRIPTION and START_OF_SERVICE frames. createAnchor returns 0 if
+	// the anchor could not be created. The anchors are shared by all the
+	// callers: which anchors a caller owns and which matrices it was last given
+	// is up to the caller.
+	uint32_t createAnchor(const float* modelMatrix);
+	bool removeAnchor(uint32_t anchorId);
+	// Returns the ids and the packed model matrices (16 floats each) of the
+	// given anchors that can be expressed in the frame of the current pose.
+	bool getAnchorModelMatrices(const std::vector<uint32_t>& anchorIds, std::vector<uint32_t>& expressedAnchorIds, std::vector<float>& modelMatrices);
+
+	// The time a sample with the given Tango timestamp was captured, in seconds
+	// on the steady clock (see SensorClock), or 0 if it is not known yet.
+	double getSampleCaptureTime(double sensorTimestamp) const;
+	// Records the age of a sample captured at captureTime when it reaches hop.
+	void recordLatency(LatencySample sample, LatencyHop hop, double captureTime);
+	void getLatencyStatistics(LatencySample sample, LatencyHop hop, LatencyStatistics* statistics) const;
+	// The Tango timestamps of the point cloud last retrieved by getPointCloud
+	// and of the camera image last updated into the texture.
+	double getPointCloudTimestamp() const;
+	double getCameraImageTimestamp() const;
+	// The rates of the point cloud, color camera frame and texture callbacks
+	// of the Tango Service, in calls per second.
+	void getCallbackRates(double* pointCloudRate, double* frameRate, double* textureRate) const;
+
+	// Records poses, point clouds, camera intrinsics, color camera frames
+	// (downsampled by frameSubsample, 0 to skip them) and marker results to a
+	// session log file (see SessionLogFormat.h).
+	bool startRecording(const std::string& path, unsigned frameSubsample);
+	void stopRecording();
+	bool isRecording() const;
 
 private:
 	void connect(const std::string& uuid);
 	void disconnect();
-	bool hasLastTangoImageBufferTimestampChangedLately();
-
-	static TangoHandler* instance;
-
-	bool connected;
+	void notifyStateChanged();
+	// The timestamp of the camera image last updated into the texture if it
+	// changed lately, which the poses are computed for, 0 otherwise.
+	double getRecentCameraImageTimestamp() const;
+	void updateADFCache(const std::string& uuidList) const;
+	void requestADFSwitch(const std::string& uuid, const ADFSwitchCallback& callback);
+	void adfSwitchLoop();
+	// Marks the depth images (and the dense ones) as used and starts the depth
+	// image thread if needed.
+	void requestDepthImages(bool dense);
+	void depthImageLoop();
+
+	enum SensorEvent
+	{
+		// A point cloud was delivered by the Tango Service.
+		SENSOR_EVENT_POINT_CLOUD_DELIVERED = 1 << 0,
+		// A point cloud is needed: depth is marked as used.
+		SENSOR_EVENT_POINT_CLOUD_REQUESTED = 1 << 1,
+		// A subsystem that is not enabled was used.
+		SENSOR_EVENT_SUBSYSTEM_USED = 1 << 2
+	};
+
+	// Can be called from any thread. Starts the sensor thread if needed.
+	void postSensorEvent(SensorEvent event);
+	void sensorLoop();
+	// Called on the sensor thread without connectionMutex: a point cloud
+	// retrieved while the Tango Service disconnects or connects is published
+	// with the previous sensorGeneration, so it is never read.
+	void updatePointCloudSnapshot();
+
+	// A point cloud with its own copy of the points, so it stays valid when the
+	// backend retrieves the next one, and the transform from its depth camera
+	// frame to the frame of the poses.
+	struct PointCloudSnapshot
+	{
+		SensorPointCloud pointCloud;
+		std::vector<float> points;
+		float depthCameraMatrix[16];
+		// The sensorGeneration the point cloud was retrieved in.
+		uint32_t generation;
+	};
+
+	// The latest point cloud snapshot, or an empty one if it was retrieved
+	// before the Tango Service reconnected or the sensor backend changed.
+	TripleBuffer<PointCloudSnapshot>::Snapshot getPointCloudSnapshot() const;
+
+	// The timestamp of the color camera image last updated into the texture and
+	// when it changed.
+	struct CameraImageSnapshot
+	{
+		double timestamp;
+		std::chrono::steady_clock::time_point changeTime;
+	};
+
+	// The intrinsics of the color camera and the size of its image, replaced as
+	// a whole when the Tango Service connects or disconnects and when the
+	// display rotates.
+	struct CameraIntrinsicsSnapshot
+	{
+		// Adjusted to the display rotation, without the address bar.
+		SensorCameraIntrinsics intrinsics;
+		// As returned by the Tango Service, not adjusted to the display rotation.
+		TangoCameraIntrinsics colorCameraIntrinsics;
+		// 0 while the Tango Service is disconnected.
+		uint32_t imageWidth;
+		uint32_t imageHeight;
+	};
+
+	// The latest camera intrinsics snapshot, zeroed before the first connection.
+	CameraIntrinsicsSnapshot getCameraIntrinsicsSnapshot() const;
+	// Publishes a copy of the latest camera intrinsics snapshot changed by
+	// update. Must be called with cameraIntrinsicsMutex locked.
+	bool updateCameraIntrinsicsSnapshot(const std::function<void(CameraIntrinsicsSnapshot&)>& update);
+
+	// Depth and the color camera frames (only needed for marker detection and
+	// the dense depth images) are only running while they are used: the sensor
+	// thread enables them after the first use and disables them again after
+	// some time without use. Both can be toggled while the Tango Service is
+	// connected.
+	enum Subsystem
+	{
+		SUBSYSTEM_DEPTH = 0,
+		SUBSYSTEM_COLOR_FRAMES,
+		NUMBER_OF_SUBSYSTEMS
+	};
+
+	// Records the use without locking, so it can be called from any thread.
+	void useSubsystem(Subsystem subsystem);
+	// Called on the sensor thread. Locks connectionMutex only if a subsystem
+	// has to be toggled.
+	void updateSubsystems();
+	// These must be called with connectionMutex locked and the Tango Service
+	// connected.
+	void restoreSubsystems();
+	bool setSubsystemEnabled(Subsystem subsystem, bool enabled);
+
+	void recordAge(LatencySample sample, LatencyHop hop, double milliseconds);
+
+	void recordCameraIntrinsics();
+	void recordMarkers(double timestamp, const std::vector<Marker>& markers);
+	void detectMarkersNatively(const TangoImageBuffer* imageBuffer, float markerSize);
+
+	static std::atomic<TangoHandler*> instance;
+	static std::mutex instanceMutex;
+
+	std::atomic<bool> connected;
+	// Serializes connect and disconnect between the JNI thread and the ADF
+	// switch thread.
+	std::mutex connectionMutex;
 	TangoConfig tangoConfig;
-	TangoCameraIntrinsics tangoCameraIntrinsics;
-	double lastTangoImageBufferTimestamp;
-	std::time_t lastTangoImagebufferTimestampTime;
-
-	unsigned maxNumberOfPointsInPointCloud;
-	TangoSupportPointCloudManager* pointCloudManager;
-	TangoPointCloud* latestTangoPointCloud;
-	bool latestTangoPointCloudRetrieved;
-	TangoMatrixTransformData depthCameraMatrixTransform;
-
-	uint32_t cameraImageWidth;
-	uint32_t cameraImageHeight;
-	uint32_t cameraImageTextureWidth;
-	uint32_t cameraImageTextureHeight;
+	// When the Tango Service last signaled a new color camera image, in
+	// seconds on the steady clock.
+	std::atomic<double> lastTextureAvailableTime;
+	std::atomic<uint32_t> cameraFrameCount;
+	std::atomic<double> poseCameraTimestamp;
 
 	bool textureIdConnected;
 
-	int activityOrientation;
-	int sensorOrientation;
+	// Written on the JNI thread, read on the device, GPU and sensor threads.
+	std::atomic<int> activityOrientation;
+	std::atomic<int> sensorOrientation;
 
+	// Written with both connectionMutex and adfSwitchMutex locked, so either
+	// one is enough to read it. adfEnabled tells whether it is empty without
+	// locking.
 	std::string lastEnabledADFUUID;
+	std::atomic<bool> adfEnabled;
 
 	JNIEnv* jniEnv;
 	JavaVM* javaVM;
@@ -213,9 +437,140 @@ private:
 	std::vector<Marker> detectedMarkers;
 	TangoSupportImageBufferManager* imageBufferManager;
 
-	TangoPoseData poseForMarkerDetection;
+	SensorPose poseForMarkerDetection;
 	std::mutex poseForMarkerDetectionMutex;
 	bool poseForMarkerDetectionIsCorrect;
+
+	MarkerDetector* markerDetector;
+	std::mutex markerDetectorMutex;
+
+	// ADFs by uuid, refreshed only when the uuid list reported by the Tango
+	// Service changes.
+	mutable std::map<std::string, ADF> adfCache;
+	mutable std::vector<ADF> cachedADFs;
+	mutable std::string adfCacheUUIDList;
+	mutable std::mutex adfCacheMutex;
+	bool adfCacheWarmedUp;
+
+	enum ADFSwitchState
+	{
+		ADF_SWITCH_IDLE,
+		// A switch has been requested but the thread has not picked it up yet.
+		ADF_SWITCH_REQUESTED,
+		ADF_SWITCH_RECONNECTING
+	};
+
+	std::thread adfSwitchThread;
+	std::mutex adfSwitchMutex;
+	std::condition_variable adfSwitchCondition;
+	ADFSwitchState adfSwitchState;
+	std::atomic<bool> switchingADF;
+	bool adfSwitchRequested;
+	bool stopADFSwitchThread;
+	std::string requestedADFUUID;
+	std::vector<std::pair<std::string, ADFSwitchCallback>> adfSwitchCallbacks;
+
+	// The last pose returned by getPose, served while the ADF switch has the
+	// Tango Service disconnected.
+	TangoPoseData lastPose;
+	bool lastPoseIsValid;
+	std::mutex lastPoseMutex;
+
+	struct Anchor
+	{
+		// The model matrix in the frame the anchor was created in.
+		float modelMatrix[16];
+		bool inAreaDescriptionFrame;
+	};
+
+	bool getAreaDescriptionFromStartOfService(float* matrix);
+
+	std::map<uint32_t, Anchor> anchors;
+	std::mutex anchorsMutex;
+	uint32_t nextAnchorId;
+	// Whether the last pose returned by getPose was localized, that is, in the
+	// AREA_DESCRIPTION frame.
+	std::atomic<bool> lastPoseIsLocalized;
+
+	// Only changed with connectionMutex locked.
+	std::atomic<bool> subsystemEnabled[NUMBER_OF_SUBSYSTEMS];
+	// When each subsystem was last used, in seconds on the steady clock.
+	std::atomic<double> subsystemLastUse[NUMBER_OF_SUBSYSTEMS];
+
+	SessionRecorder* sessionRecorder;
+
+	SensorClock sensorClock;
+	LatencyHistogram latencyHistograms[NUMBER_OF_LATENCY_SAMPLES][NUMBER_OF_LATENCY_HOPS];
+	mutable std::mutex latencyMutex;
+
+	RateCounter pointCloudCallbackRate;
+	RateCounter frameCallbackRate;
+	RateCounter textureCallbackRate;
+
+	// The backend connected to the Tango Service, owned, and the interface the
+	// poses, intrinsics and point clouds are retrieved through. Both are set
+	// once when constructed, so any thread can use them.
+	TangoSensorBackend* const tangoSensorBackend;
+	SensorBackend* const sensorBackend;
+
+	StateChangedCallback stateChangedCallback;
+	std::mutex stateChangedCallbackMutex;
+	FrameAvailableCallback frameAvailableCallback;
+	std::mutex frameAvailableCallbackMutex;
+
+	// The points of the last point cloud delivered while depth images are
+	// requested wait in pendingDepthPoints (x, y, z, confidence) for the depth
+	// image thread, which publishes the image it projects in depthImage. The
+	// luma plane of the last color camera frame delivered while dense depth
+	// images are requested waits in pendingLuma, tightly packed, and the
+	// thread publishes the latest depth image densified with it in
+	// denseDepthImage.
+	std::thread depthImageThread;
+	std::mutex depthImageMutex;
+	std::condition_variable depthImageCondition;
+	bool stopDepthImageThread;
+	std::atomic<bool> depthImageRequested;
+	std::vector<float> pendingDepthPoints;
+	double pendingDepthTimestamp;
+	bool depthPointsPending;
+	DepthImage depthImage;
+	std::atomic<bool> denseDepthImageRequested;
+	std::vector<uint8_t> pendingLuma;
+	uint32_t pendingLumaWidth;
+	uint32_t pendingLumaHeight;
+	bool lumaPending;
+	DepthImage denseDepthImage;
+
+	// The point clouds and the camera image timestamps are read from several
+	// threads, so they are handed over through triple buffers instead of being
+	// shared. The sensor thread owns the point clouds: it retrieves one from the
+	// sensor backend when it is delivered or requested, as posted to
+	// pendingSensorEvents, and publishes it in pointCloudSnapshots. It also
+	// toggles the subsystems (see updateSubsystems). The thread of
+	// updateCameraImageIntoTexture, which has the GL context the Tango Service
+	// updates the texture in, publishes cameraImageSnapshots.
+	std::thread sensorThread;
+	std::mutex sensorThreadMutex;
+	std::condition_variable sensorThreadCondition;
+	bool stopSensorThread;
+	std::atomic<unsigned> pendingSensorEvents;
+	TripleBuffer<PointCloudSnapshot> pointCloudSnapshots;
+	// Only used on the sensor thread.
+	double publishedPointCloudTimestamp;
+	uint32_t publishedPointCloudGeneration;
+	// Incremented when the point clouds retrieved before become invalid: when
+	// the Tango Service connects or disconnects.
+	std::atomic<uint32_t> sensorGeneration;
+	// The timestamp of the point cloud last returned by getPointCloud.
+	std::atomic<double> retrievedPointCloudTimestamp;
+	// Written on the GPU thread, read on the device thread.
+	std::atomic<uint32_t> uploadedNumberOfPoints;
+	// Read from the device, GPU, JNI and ADF switch threads.
+	TripleBuffer<CameraImageSnapshot, 6> cameraImageSnapshots;
+	// Written on the JNI, ADF switch and device threads, one at a time as they
+	// lock cameraIntrinsicsMutex, and read from any thread.
+	TripleBuffer<CameraIntrinsicsSnapshot, 6> cameraIntrinsicsSnapshots;
+	std::mutex cameraIntrinsicsMutex;
 };
 }  // namespace tango_4_chromium
 
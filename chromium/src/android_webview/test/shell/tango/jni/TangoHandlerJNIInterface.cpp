@@ -54,6 +54,21 @@ Java_org_chromium_android_1webview_shell_TangoJniNative_onConfigurationChanged(J
 	TangoHandler::getInstance()->onDeviceRotationChanged(activityOrientation, sensorOrientation);
 }
 
+JNIEXPORT jboolean JNICALL
+Java_org_chromium_android_1webview_shell_TangoJniNative_startRecording(JNIEnv* env, jobject, jstring path, jint frameSubsample)
+{
+  const char* pathChars = env->GetStringUTFChars(path, nullptr);
+  bool result = TangoHandler::getInstance()->startRecording(pathChars, frameSubsample);
+  env->ReleaseStringUTFChars(path, pathChars);
+  return result;
+}
+
+JNIEXPORT void JNICALL
+Java_org_chromium_android_1webview_shell_TangoJniNative_stopRecording(JNIEnv*, jobject)
+{
+  TangoHandler::getInstance()->stopRecording();
+}
+
 JNIEXPORT void JNICALL
 Java_org_chromium_android_1webview_shell_TangoJniNative_resetPose(JNIEnv*, jobject, int activityOrientation, int sensorOrientation) 
 {
@@ -0,0 +1,225 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TangoSensorBackend.h"
+
+#include "SensorMath.h"
+#include "TangoTrace.h"
+
+#include <android/log.h>
+
+#include <cstring>
+
+#define LOG_TAG "Tango Chromium"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+TangoCoordinateFrameType toTangoFrame(tango_chromium::SensorFrame frame)
+{
+  switch (frame)
+  {
+    case tango_chromium::SENSOR_FRAME_AREA_DESCRIPTION:
+      return TANGO_COORDINATE_FRAME_AREA_DESCRIPTION;
+    case tango_chromium::SENSOR_FRAME_CAMERA_COLOR:
+      return TANGO_COORDINATE_FRAME_CAMERA_COLOR;
+    case tango_chromium::SENSOR_FRAME_CAMERA_DEPTH:
+      return TANGO_COORDINATE_FRAME_CAMERA_DEPTH;
+    case tango_chromium::SENSOR_FRAME_START_OF_SERVICE:
+    default:
+      return TANGO_COORDINATE_FRAME_START_OF_SERVICE;
+  }
+}
+
+TangoSupportEngineType toTangoEngine(tango_chromium::SensorConvention convention)
+{
+  return convention == tango_chromium::SENSOR_CONVENTION_TANGO ? TANGO_SUPPORT_ENGINE_TANGO : TANGO_SUPPORT_ENGINE_OPENGL;
+}
+
+} // End anonymous namespace
+
+namespace tango_chromium {
+
+TangoSensorBackend::TangoSensorBackend(): maxNumberOfPoints(0)
+  , pointCloudManager(nullptr)
+  , latestPointCloud(nullptr)
+{
+}
+
+TangoSensorBackend::~TangoSensorBackend()
+{
+  if (pointCloudManager != nullptr)
+  {
+    TangoSupport_freePointCloudManager(pointCloudManager);
+  }
+}
+
+bool TangoSensorBackend::initializePointClouds(uint32_t maxNumberOfPoints)
+{
+  if (pointCloudManager != nullptr)
+  {
+    return true;
+  }
+  TangoErrorType result = TangoSupport_createPointCloudManager(maxNumberOfPoints, &pointCloudManager);
+  if (result != TANGO_SUCCESS)
+  {
+    LOGE("TangoSensorBackend::initializePointClouds, TangoSupport_createPointCloudManager failed with error code: %d", result);
+    pointCloudManager = nullptr;
+    return false;
+  }
+  this->maxNumberOfPoints = maxNumberOfPoints;
+  return true;
+}
+
+void TangoSensorBackend::onPointCloudAvailable(const TangoPointCloud* pointCloud)
+{
+  if (pointCloudManager != nullptr)
+  {
+    ScopedTangoTrace trace("TangoSupport_updatePointCloud points=%u", pointCloud->num_points);
+    TangoSupport_updatePointCloud(pointCloudManager, pointCloud);
+  }
+}
+
+bool TangoSensorBackend::getPose(double timestamp, SensorFrame base, SensorFrame target, SensorConvention targetConvention, int displayRotation, SensorPose* pose)
+{
+  ScopedTangoTrace trace("TangoSupport_getPoseAtTime");
+  TangoPoseData tangoPose;
+  if (TangoSupport_getPoseAtTime(
+    timestamp, toTangoFrame(base), toTangoFrame(target), TANGO_SUPPORT_ENGINE_OPENGL,
+    toTangoEngine(targetConvention), static_cast<TangoSupportRotation>(displayRotation),
+    &tangoPose) != TANGO_SUCCESS)
+  {
+    return false;
+  }
+  pose->timestamp = tangoPose.timestamp;
+  memcpy(pose->translation, tangoPose.translation, sizeof(pose->translation));
+  memcpy(pose->orientation, tangoPose.orientation, sizeof(pose->orientation));
+  pose->valid = tangoPose.status_code == TANGO_POSE_VALID;
+  return true;
+}
+
+bool TangoSensorBackend::getMatrixTransform(double timestamp, SensorFrame base, SensorFrame target, SensorConvention targetConvention, int displayRotation, float* matrix)
+{
+  ScopedTangoTrace trace("TangoSupport_getMatrixTransformAtTime");
+  TangoMatrixTransformData transform;
+  if (TangoSupport_getMatrixTransformAtTime(
+    timestamp, toTangoFrame(base), toTangoFrame(target), TANGO_SUPPORT_ENGINE_OPENGL,
+    toTangoEngine(targetConvention), static_cast<TangoSupportRotation>(displayRotation),
+    &transform) != TANGO_SUCCESS || transform.status_code != TANGO_POSE_VALID)
+  {
+    return false;
+  }
+  memcpy(matrix, transform.matrix, sizeof(transform.matrix));
+  return true;
+}
+
+bool TangoSensorBackend::getDepthToColorTransform(double depthTimestamp, double colorTimestamp, float* matrix)
+{
+  ScopedTangoTrace trace("TangoSupport_calculateRelativePose");
+  TangoPoseData depthCameraPose;
+  if (TangoSupport_calculateRelativePose(
+    colorTimestamp, TANGO_COORDINATE_FRAME_CAMERA_COLOR,
+    depthTimestamp, TANGO_COORDINATE_FRAME_CAMERA_DEPTH, &depthCameraPose) != TANGO_SUCCESS)
+  {
+    LOGE("TangoSensorBackend::getDepthToColorTransform, could not calculate depth camera pose at time '%lf'", depthTimestamp);
+    return false;
+  }
+  matrixFromPose(depthCameraPose.translation, depthCameraPose.orientation, matrix);
+  return true;
+}
+
+bool TangoSensorBackend::getColorCameraIntrinsics(int displayRotation, SensorCameraIntrinsics* intrinsics)
+{
+  ScopedTangoTrace trace("TangoSupport_getCameraIntrinsicsBasedOnDisplayRotation");
+  TangoCameraIntrinsics tangoIntrinsics;
+  int result = TangoSupport_getCameraIntrinsicsBasedOnDisplayRotation(
+      TANGO_CAMERA_COLOR, static_cast<TangoSupportRotation>(displayRotation),
+      &tangoIntrinsics);
+  if (result != TANGO_SUCCESS)
+  {
+    LOGE("TangoSensorBackend::getColorCameraIntrinsics, failed to get camera intrinsics with error code: %d", result);
+    return false;
+  }
+  intrinsics->width = tangoIntrinsics.width;
+  intrinsics->height = tangoIntrinsics.height;
+  intrinsics->fx = tangoIntrinsics.fx;
+  intrinsics->fy = tangoIntrinsics.fy;
+  intrinsics->cx = tangoIntrinsics.cx;
+  intrinsics->cy = tangoIntrinsics.cy;
+  memcpy(intrinsics->distortion, tangoIntrinsics.distortion, sizeof(intrinsics->distortion));
+  intrinsics->calibrationType = tangoIntrinsics.calibration_type;
+  return true;
+}
+
+uint32_t TangoSensorBackend::getMaxNumberOfPointsInPointCloud() const
+{
+  return maxNumberOfPoints;
+}
+
+bool TangoSensorBackend::getLatestPointCloud(SensorPointCloud* pointCloud)
+{
+  ScopedTangoTrace trace("TangoSupport_getLatestPointCloud");
+  if (pointCloudManager == nullptr ||
+    TangoSupport_getLatestPointCloud(pointCloudManager, &latestPointCloud) != TANGO_SUCCESS ||
+    latestPointCloud == nullptr)
+  {
+    return false;
+  }
+  pointCloud->timestamp = latestPointCloud->timestamp;
+  pointCloud->numberOfPoints = latestPointCloud->num_points;
+  pointCloud->points = latestPointCloud->points;
+  return true;
+}
+
+bool TangoSensorBackend::fitPlaneNearPoint(const SensorPointCloud& pointCloud, double colorTimestamp, float u, float v, int displayRotation, double* point, double* plane)
+{
+  ScopedTangoTrace trace("TangoSensorBackend::fitPlaneNearPoint points=%u", pointCloud.numberOfPoints);
+  TangoPoseData colorCameraPose;
+  if (TangoSupport_calculateRelativePose(
+    pointCloud.timestamp, TANGO_COORDINATE_FRAME_CAMERA_DEPTH,
+    colorTimestamp, TANGO_COORDINATE_FRAME_CAMERA_COLOR, &colorCameraPose) != TANGO_SUCCESS)
+  {
+    LOGE("TangoSensorBackend::fitPlaneNearPoint, could not calculate color camera pose at time '%lf'", colorTimestamp);
+    return false;
+  }
+
+  TangoPointCloud tangoPointCloud;
+  memset(&tangoPointCloud, 0, sizeof(tangoPointCloud));
+  tangoPointCloud.timestamp = pointCloud.timestamp;
+  tangoPointCloud.num_points = pointCloud.numberOfPoints;
+  tangoPointCloud.points = const_cast<float (*)[4]>(pointCloud.points);
+
+  float uv[] = {u, v};
+  double identityTranslation[3] = {0.0, 0.0, 0.0};
+  double identityOrientation[4] = {0.0, 0.0, 0.0, 1.0};
+  if (TangoSupport_fitPlaneModelNearPoint(
+    &tangoPointCloud, identityTranslation, identityOrientation,
+    uv, static_cast<TangoSupportRotation>(displayRotation),
+    colorCameraPose.translation, colorCameraPose.orientation,
+    point, plane) != TANGO_SUCCESS)
+  {
+    LOGE("TangoSensorBackend::fitPlaneNearPoint, could not calculate picking point and plane");
+    return false;
+  }
+  return true;
+}
+
+void TangoSensorBackend::resetPose()
+{
+  TangoService_resetMotionTracking();
+}
+
+}  // namespace tango_chromium
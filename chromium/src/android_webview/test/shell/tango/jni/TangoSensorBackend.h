@@ -0,0 +1,61 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TANGO_SENSOR_BACKEND_H_
+#define _TANGO_SENSOR_BACKEND_H_
+
+#include "tango_client_api.h"   // NOLINT
+#include "tango_support_api.h"  // NOLINT
+
+#include "SensorBackend.h"
+
+namespace tango_chromium {
+
+// Gets the sensor data from the Tango Service and the Tango support library.
+// TangoHandler owns the connection to the Tango Service and forwards the point
+// clouds it receives.
+class TangoSensorBackend: public SensorBackend
+{
+public:
+	TangoSensorBackend();
+	~TangoSensorBackend() override;
+
+	TangoSensorBackend(const TangoSensorBackend& other) = delete;
+	TangoSensorBackend& operator=(const TangoSensorBackend& other) = delete;
+
+	// Creates the point cloud manager the first time it is called.
+	bool initializePointClouds(uint32_t maxNumberOfPoints);
+	void onPointCloudAvailable(const TangoPointCloud* pointCloud);
+
+	bool getPose(double timestamp, SensorFrame base, SensorFrame target, SensorConvention targetConvention, int displayRotation, SensorPose* pose) override;
+	bool getMatrixTransform(double timestamp, SensorFrame base, SensorFrame target, SensorConvention targetConvention, int displayRotation, float* matrix) override;
+	bool getDepthToColorTransform(double depthTimestamp, double colorTimestamp, float* matrix) override;
+	bool getColorCameraIntrinsics(int displayRotation, SensorCameraIntrinsics* intrinsics) override;
+	uint32_t getMaxNumberOfPointsInPointCloud() const override;
+	bool getLatestPointCloud(SensorPointCloud* pointCloud) override;
+	bool fitPlaneNearPoint(const SensorPointCloud& pointCloud, double colorTimestamp, float u, float v, int displayRotation, double* point, double* plane) override;
+	void resetPose() override;
+
+private:
+	uint32_t maxNumberOfPoints;
+	TangoSupportPointCloudManager* pointCloudManager;
+	// The point cloud returned by the last getLatestPointCloud call.
+	TangoPointCloud* latestPointCloud;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _TANGO_SENSOR_BACKEND_H_
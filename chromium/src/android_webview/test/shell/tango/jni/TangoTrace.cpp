@@ -0,0 +1,129 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TangoTrace.h"
+
+#include <cstdarg>
+#include <cstdio>
+
+#ifdef __ANDROID__
+#include <dlfcn.h>
+#endif
+
+namespace tango_chromium {
+
+namespace {
+
+#ifdef __ANDROID__
+
+// ATrace_beginSection, ATrace_endSection and ATrace_isEnabled are available
+// from API 23, ATrace_setCounter from API 29.
+struct ATraceFunctions
+{
+  ATraceFunctions()
+  {
+    void* library = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+    if (library == nullptr)
+    {
+      return;
+    }
+    isEnabled = reinterpret_cast<bool (*)()>(dlsym(library, "ATrace_isEnabled"));
+    beginSection = reinterpret_cast<void (*)(const char*)>(dlsym(library, "ATrace_beginSection"));
+    endSection = reinterpret_cast<void (*)()>(dlsym(library, "ATrace_endSection"));
+    setCounter = reinterpret_cast<void (*)(const char*, int64_t)>(dlsym(library, "ATrace_setCounter"));
+    if (isEnabled == nullptr || beginSection == nullptr || endSection == nullptr)
+    {
+      isEnabled = nullptr;
+    }
+  }
+
+  bool (*isEnabled)() = nullptr;
+  void (*beginSection)(const char*) = nullptr;
+  void (*endSection)() = nullptr;
+  void (*setCounter)(const char*, int64_t) = nullptr;
+};
+
+const ATraceFunctions& atrace()
+{
+  static const ATraceFunctions functions;
+  return functions;
+}
+
+#endif
+
+}  // namespace
+
+bool TangoTrace::isEnabled()
+{
+#ifdef __ANDROID__
+  return atrace().isEnabled != nullptr && atrace().isEnabled();
+#else
+  return false;
+#endif
+}
+
+void TangoTrace::beginSection(const char* name)
+{
+#ifdef __ANDROID__
+  if (atrace().isEnabled != nullptr)
+  {
+    atrace().beginSection(name);
+  }
+#endif
+}
+
+void TangoTrace::endSection()
+{
+#ifdef __ANDROID__
+  if (atrace().isEnabled != nullptr)
+  {
+    atrace().endSection();
+  }
+#endif
+}
+
+void TangoTrace::setCounter(const char* name, int64_t value)
+{
+#ifdef __ANDROID__
+  if (atrace().setCounter != nullptr && atrace().isEnabled())
+  {
+    atrace().setCounter(name, value);
+  }
+#endif
+}
+
+ScopedTangoTrace::ScopedTangoTrace(const char* format, ...): enabled(TangoTrace::isEnabled())
+{
+  if (enabled)
+  {
+    char name[128];
+    va_list arguments;
+    va_start(arguments, format);
+    vsnprintf(name, sizeof(name), format, arguments);
+    va_end(arguments);
+    TangoTrace::beginSection(name);
+  }
+}
+
+ScopedTangoTrace::~ScopedTangoTrace()
+{
+  if (enabled)
+  {
+    TangoTrace::endSection();
+  }
+}
+
+}  // namespace tango_chromium
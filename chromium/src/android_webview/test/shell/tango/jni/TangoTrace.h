@@ -0,0 +1,55 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TANGO_TRACE_H_
+#define _TANGO_TRACE_H_
+
+#include <cstdint>
+
+namespace tango_chromium {
+
+// Trace sections and counters of libtango_chromium, so the Tango calls, the
+// callbacks and the worker threads show up in systrace and Perfetto next to
+// the Chromium trace events. On Android they use the ATrace functions of
+// libandroid, which are looked up at runtime as they are not available on
+// every API level the library supports. Elsewhere they do nothing.
+class TangoTrace
+{
+public:
+	static bool isEnabled();
+	static void beginSection(const char* name);
+	static void endSection();
+	static void setCounter(const char* name, int64_t value);
+};
+
+// Traces a section for the lifetime of the object. The name is formatted
+// like printf, only while tracing is enabled.
+class ScopedTangoTrace
+{
+public:
+	explicit ScopedTangoTrace(const char* format, ...) __attribute__((format(printf, 2, 3)));
+	~ScopedTangoTrace();
+
+	ScopedTangoTrace(const ScopedTangoTrace& other) = delete;
+	ScopedTangoTrace& operator=(const ScopedTangoTrace& other) = delete;
+
+private:
+	bool enabled;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _TANGO_TRACE_H_
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ThreadPool.h"
+
+namespace tango_chromium {
+
+ThreadPool::ThreadPool(unsigned numberOfThreads): task(nullptr)
+  , taskCount(0)
+  , nextTaskIndex(0)
+  , busyWorkers(0)
+  , generation(0)
+  , stopping(false)
+{
+  if (numberOfThreads == 0)
+  {
+    numberOfThreads = std::thread::hardware_concurrency();
+  }
+  for (unsigned i = 1; i < numberOfThreads; i++)
+  {
+    workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  workAvailable.notify_all();
+  for (std::thread& worker : workers)
+  {
+    worker.join();
+  }
+}
+
+void ThreadPool::parallelFor(unsigned count, const std::function<void(unsigned)>& task)
+{
+  if (count == 0)
+  {
+    return;
+  }
+  if (workers.empty() || count == 1)
+  {
+    for (unsigned i = 0; i < count; i++)
+    {
+      task(i);
+    }
+    return;
+  }
+
+  std::lock_guard<std::mutex> parallelForLock(parallelForMutex);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->task = &task;
+    taskCount = count;
+    nextTaskIndex = 0;
+    busyWorkers = workers.size();
+    generation++;
+  }
+  workAvailable.notify_all();
+
+  runTasks();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  workDone.wait(lock, [this]() { return busyWorkers == 0; });
+  this->task = nullptr;
+}
+
+void ThreadPool::workerLoop()
+{
+  unsigned long long lastGeneration = 0;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      workAvailable.wait(lock, [this, lastGeneration]() { return stopping || generation != lastGeneration; });
+      if (stopping)
+      {
+        return;
+      }
+      lastGeneration = generation;
+    }
+
+    runTasks();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      busyWorkers--;
+    }
+    workDone.notify_one();
+  }
+}
+
+void ThreadPool::runTasks()
+{
+  unsigned i;
+  while ((i = nextTaskIndex.fetch_add(1)) < taskCount)
+  {
+    (*task)(i);
+  }
+}
+
+}  // namespace tango_chromium
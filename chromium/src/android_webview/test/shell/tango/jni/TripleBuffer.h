@@ -0,0 +1,181 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TRIPLE_BUFFER_H_
+#define _TRIPLE_BUFFER_H_
+
+#include <atomic>
+#include <utility>
+
+namespace tango_chromium {
+
+// Hands the latest value of a single writer thread over to any number of
+// reader threads without locks. The writer fills a slot that is neither the
+// latest one nor held by a reader, reusing the storage of the value it held,
+// and publishes it. Readers hold the latest slot through a reference counted
+// Snapshot and the writer never reuses a held slot, so a snapshot is immutable
+// and consistent for as long as it is held.
+// With kSize slots, the writer always finds a free one if at most kSize - 2
+// snapshots of different slots are held at once: the default suits a single
+// reader thread, more slots are needed for more readers.
+template <typename T, unsigned kSize = 3>
+class TripleBuffer
+{
+	struct Slot;
+
+public:
+	static_assert(kSize >= 3, "A triple buffer needs at least 3 slots");
+
+	class Snapshot
+	{
+	public:
+		Snapshot(): slot(nullptr)
+		{
+		}
+
+		Snapshot(const Snapshot& other): slot(other.slot)
+		{
+			if (slot != nullptr)
+			{
+				slot->references++;
+			}
+		}
+
+		Snapshot& operator=(const Snapshot& other)
+		{
+			Snapshot copy(other);
+			std::swap(slot, copy.slot);
+			return *this;
+		}
+
+		~Snapshot()
+		{
+			if (slot != nullptr)
+			{
+				slot->references--;
+			}
+		}
+
+		// False if nothing was published.
+		explicit operator bool() const
+		{
+			return slot != nullptr;
+		}
+
+		const T& operator*() const
+		{
+			return slot->value;
+		}
+
+		const T* operator->() const
+		{
+			return &slot->value;
+		}
+
+	private:
+		friend class TripleBuffer;
+
+		Slot* slot;
+	};
+
+	TripleBuffer(): latestSlot(-1), writeSlot(-1)
+	{
+		for (unsigned i = 0; i < kSize; i++)
+		{
+			slots[i].references = 0;
+		}
+	}
+
+	TripleBuffer(const TripleBuffer& other) = delete;
+	TripleBuffer& operator=(const TripleBuffer& other) = delete;
+
+	// The latest published value, or an empty snapshot if there is none. Can be
+	// called from any thread.
+	Snapshot read() const
+	{
+		Snapshot snapshot;
+		for (;;)
+		{
+			int slot = latestSlot;
+			if (slot < 0)
+			{
+				return snapshot;
+			}
+			// The writer may have picked the slot again before the reference was
+			// taken: it is only safe to read if it is still the latest one.
+			slots[slot].references++;
+			if (latestSlot == slot)
+			{
+				snapshot.slot = &slots[slot];
+				return snapshot;
+			}
+			slots[slot].references--;
+		}
+	}
+
+	// The value to fill for the next publish, which holds an older value, or
+	// nullptr if the readers hold every slot. Only called from the writer thread,
+	// like publish and clear.
+	T* beginWrite()
+	{
+		int latest = latestSlot;
+		for (unsigned i = 0; i < kSize; i++)
+		{
+			if (static_cast<int>(i) != latest && slots[i].references == 0)
+			{
+				writeSlot = i;
+				return &slots[i].value;
+			}
+		}
+		writeSlot = -1;
+		return nullptr;
+	}
+
+	// Publishes the value returned by the last beginWrite.
+	void publish()
+	{
+		if (writeSlot >= 0)
+		{
+			latestSlot = writeSlot;
+			writeSlot = -1;
+		}
+	}
+
+	// The next reads return an empty snapshot until the next publish. Snapshots
+	// that are held stay valid.
+	void clear()
+	{
+		latestSlot = -1;
+	}
+
+private:
+	struct Slot
+	{
+		T value;
+		std::atomic<int> references;
+	};
+
+	// The reference counts and the latest slot use sequentially consistent
+	// operations: a reader that sees its slot is still the latest after taking
+	// a reference is seen by a writer that checks the slot afterwards.
+	mutable Slot slots[kSize];
+	std::atomic<int> latestSlot;
+	int writeSlot;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _TRIPLE_BUFFER_H_
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TripleBuffer.h"
+
+#include <thread>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace tango_chromium {
+
+namespace {
+
+void write(TripleBuffer<int>& buffer, int value)
+{
+  int* slot = buffer.beginWrite();
+  ASSERT_NE(nullptr, slot);
+  *slot = value;
+  buffer.publish();
+}
+
+}  // namespace
+
+TEST(TripleBufferTest, StartsEmpty)
+{
+  TripleBuffer<int> buffer;
+  EXPECT_FALSE(buffer.read());
+}
+
+TEST(TripleBufferTest, ReadsTheLatestValue)
+{
+  TripleBuffer<int> buffer;
+  write(buffer, 1);
+  EXPECT_EQ(1, *buffer.read());
+  write(buffer, 2);
+  write(buffer, 3);
+  EXPECT_EQ(3, *buffer.read());
+  // Nothing is published until publish is called.
+  *buffer.beginWrite() = 4;
+  EXPECT_EQ(3, *buffer.read());
+}
+
+TEST(TripleBufferTest, SnapshotsAreNotOverwritten)
+{
+  TripleBuffer<int> buffer;
+  write(buffer, 1);
+  TripleBuffer<int>::Snapshot held = buffer.read();
+  for (int i = 2; i < 10; i++)
+  {
+    write(buffer, i);
+    EXPECT_EQ(1, *held) << i;
+    EXPECT_EQ(i, *buffer.read()) << i;
+  }
+
+  // A copy keeps the slot held after the original is released.
+  TripleBuffer<int>::Snapshot copy = held;
+  held = TripleBuffer<int>::Snapshot();
+  write(buffer, 10);
+  write(buffer, 11);
+  EXPECT_EQ(1, *copy);
+}
+
+TEST(TripleBufferTest, RunsOutOfSlotsWhenEveryOneIsHeld)
+{
+  TripleBuffer<int> buffer;
+  write(buffer, 1);
+  TripleBuffer<int>::Snapshot first = buffer.read();
+  write(buffer, 2);
+  TripleBuffer<int>::Snapshot second = buffer.read();
+  write(buffer, 3);
+  EXPECT_EQ(nullptr, buffer.beginWrite());
+  // publish without a slot keeps the latest value.
+  buffer.publish();
+  EXPECT_EQ(3, *buffer.read());
+
+  first = TripleBuffer<int>::Snapshot();
+  write(buffer, 4);
+  EXPECT_EQ(2, *second);
+  EXPECT_EQ(4, *buffer.read());
+}
+
+TEST(TripleBufferTest, Clear)
+{
+  TripleBuffer<int> buffer;
+  write(buffer, 1);
+  TripleBuffer<int>::Snapshot held = buffer.read();
+  buffer.clear();
+  EXPECT_FALSE(buffer.read());
+  EXPECT_EQ(1, *held);
+  write(buffer, 2);
+  EXPECT_EQ(2, *buffer.read());
+}
+
+TEST(TripleBufferTest, ConcurrentReadersSeeConsistentValues)
+{
+  // Each value is a sequence number repeated over the whole vector, so a
+  // slot written while it is read shows different numbers.
+  const int kReaders = 4;
+  const int kValues = 20000;
+  TripleBuffer<std::vector<int>, kReaders + 2> buffer;
+  std::vector<std::thread> readers;
+  for (int t = 0; t < kReaders; t++)
+  {
+    readers.push_back(std::thread([&buffer, kValues]()
+    {
+      int last = -1;
+      while (last < kValues - 1)
+      {
+        TripleBuffer<std::vector<int>, kReaders + 2>::Snapshot snapshot = buffer.read();
+        if (!snapshot)
+          continue;
+        int value = snapshot->front();
+        for (int element : *snapshot)
+          ASSERT_EQ(value, element);
+        // Values are published in order.
+        ASSERT_GE(value, last);
+        last = value;
+      }
+    }));
+  }
+  for (int i = 0; i < kValues; i++)
+  {
+    std::vector<int>* slot = buffer.beginWrite();
+    ASSERT_NE(nullptr, slot);
+    slot->assign(64, i);
+    buffer.publish();
+  }
+  for (std::thread& reader : readers)
+    reader.join();
+}
+
+}  // namespace tango_chromium
@@ -42,5 +42,40 @@ EXIT_CODE=$?
 if [ $EXIT_CODE -ne 0 ]; then 
 	exit $EXIT_CODE
 fi
+cp SessionLogFormat.h ../../../../../third_party/tango/libtango_chromium
+EXIT_CODE=$?
+if [ $EXIT_CODE -ne 0 ]; then 
+	exit $EXIT_CODE
+fi
+cp SensorBackend.h ../../../../../third_party/tango/libtango_chromium
+EXIT_CODE=$?
+if [ $EXIT_CODE -ne 0 ]; then 
+	exit $EXIT_CODE
+fi
+cp SensorTiming.h ../../../../../third_party/tango/libtango_chromium
+EXIT_CODE=$?
+if [ $EXIT_CODE -ne 0 ]; then 
+	exit $EXIT_CODE
+fi
+cp DepthImageProjector.h ../../../../../third_party/tango/libtango_chromium
+EXIT_CODE=$?
+if [ $EXIT_CODE -ne 0 ]; then 
+	exit $EXIT_CODE
+fi
+cp ThreadPool.h ../../../../../third_party/tango/libtango_chromium
+EXIT_CODE=$?
+if [ $EXIT_CODE -ne 0 ]; then 
+	exit $EXIT_CODE
+fi
+cp CameraFrameRing.h ../../../../../third_party/tango/libtango_chromium
+EXIT_CODE=$?
+if [ $EXIT_CODE -ne 0 ]; then 
+	exit $EXIT_CODE
+fi
+cp TripleBuffer.h ../../../../../third_party/tango/libtango_chromium
+EXIT_CODE=$?
+if [ $EXIT_CODE -ne 0 ]; then 
+	exit $EXIT_CODE
+fi
 echo "Rebuilt!"
 
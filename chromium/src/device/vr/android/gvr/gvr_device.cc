@@ -248,12 +248,14 @@ std::vector<mojom::VRADFPtr> GvrDevice::GetADFs()
   return adfs;
 }
 
-void GvrDevice::EnableADF(const std::string& uuid)
+void GvrDevice::EnableADF(const std::string& uuid, const base::Callback<void(bool)>& callback)
 {
+  callback.Run(false);
 }
 
-void GvrDevice::DisableADF()
+void GvrDevice::DisableADF(const base::Callback<void(bool)>& callback)
 {
+  callback.Run(false);
 }
 
 std::vector<mojom::VRMarkerPtr> GvrDevice::GetMarkers(unsigned markerType, float markerSize)
@@ -262,6 +264,20 @@ std::vector<mojom::VRMarkerPtr> GvrDevice::GetMarkers(unsigned markerType, float
   return markers;
 }
 
+unsigned GvrDevice::CreateAnchor(VRDisplayImpl* display, const std::vector<float>& modelMatrix)
+{
+  return 0;
+}
+
+void GvrDevice::RemoveAnchor(VRDisplayImpl* display, unsigned anchorId)
+{
+}
+
+mojom::VRAnchorUpdatesPtr GvrDevice::GetAnchorUpdates(VRDisplayImpl* display)
+{
+  return mojom::VRAnchorUpdates::New();
+}
+
 void GvrDevice::RequestPresent(const base::Callback<void(bool)>& callback) {
   gvr_provider_->RequestPresent(callback);
 }
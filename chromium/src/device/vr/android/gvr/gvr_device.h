@@ -31,9 +31,12 @@ class GvrDevice : public VRDevice {
   mojom::VRPassThroughCameraPtr GetPassThroughCamera() override;
   std::vector<mojom::VRHitPtr> HitTest(float x, float y) override;
   std::vector<mojom::VRADFPtr> GetADFs() override;
-  void EnableADF(const std::string& uuid) override;
-  void DisableADF() override;
+  void EnableADF(const std::string& uuid, const base::Callback<void(bool)>& callback) override;
+  void DisableADF(const base::Callback<void(bool)>& callback) override;
   std::vector<mojom::VRMarkerPtr> GetMarkers(unsigned markerType, float markerSize) override;
+  unsigned CreateAnchor(VRDisplayImpl* display, const std::vector<float>& modelMatrix) override;
+  void RemoveAnchor(VRDisplayImpl* display, unsigned anchorId) override;
+  mojom::VRAnchorUpdatesPtr GetAnchorUpdates(VRDisplayImpl* display) override;
 
   void RequestPresent(const base::Callback<void(bool)>& callback) override;
   void SetSecureOrigin(bool secure_origin) override;
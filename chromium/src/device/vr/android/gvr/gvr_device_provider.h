@@ -23,6 +23,8 @@ class DEVICE_VR_EXPORT GvrDeviceProvider : public VRDeviceProvider {
   ~GvrDeviceProvider() override;
 
   void GetDevices(std::vector<VRDevice*>* devices) override;
+  // The GVR API is loaded by the delegate provider, on the UI thread that owns
+  // its Java objects, so there is nothing to do on the worker thread.
   void Initialize() override;
 
   void SetListeningForActivate(bool listening) override;
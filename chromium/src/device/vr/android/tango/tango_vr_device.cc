@@ -4,31 +4,75 @@
 
 #include "device/vr/android/tango/tango_vr_device.h"
 
+#include <cmath>
+
 #include "tango_support_api.h"
 
+#include "base/bind.h"
+#include "base/single_thread_task_runner.h"
+#include "base/threading/thread_task_runner_handle.h"
 #include "base/trace_event/trace_event.h"
+#include "mojo/public/cpp/system/buffer.h"
 
 #include "TangoHandler.h"
 
 #define THIS_VALUE_NEEDS_TO_BE_OBTAINED_FROM_THE_TANGO_API -1
 
 const float RAD_2_DEG = 180.0 / M_PI;
+// Anchor matrices that change less than this are not reported again.
+const float kAnchorUpdateEpsilon = 1e-5f;
 
 using base::android::AttachCurrentThread;
 using tango_chromium::TangoHandler;
 using tango_chromium::ADF;
 using tango_chromium::Marker;
 using tango_chromium::Hit;
+using tango_chromium::LatencySample;
+using tango_chromium::LatencyStatistics;
+using tango_chromium::SensorClock;
 
 namespace device {
 
+static mojom::VRSampleTimingPtr CreateSampleTiming(double sensorTimestamp)
+{
+  mojom::VRSampleTimingPtr timing = mojom::VRSampleTiming::New();
+  timing->sensorTimestamp = sensorTimestamp;
+  return timing;
+}
+
+// Records the age of a sample when it is handed over to the renderer and
+// completes its timing, which is dropped if the clock of the Tango Service
+// has not been found yet. Returns the age in microseconds.
+static double StampSampleTiming(LatencySample sample, mojom::VRSampleTimingPtr* timing)
+{
+  if (!*timing)
+  {
+    return 0;
+  }
+  TangoHandler* tangoHandler = TangoHandler::getInstance();
+  double captureTime = tangoHandler->getSampleCaptureTime((*timing)->sensorTimestamp);
+  if (captureTime <= 0)
+  {
+    *timing = nullptr;
+    return 0;
+  }
+  (*timing)->captureTime = captureTime;
+  (*timing)->deviceTime = SensorClock::now();
+  tangoHandler->recordLatency(sample, tango_chromium::LATENCY_HOP_DEVICE, captureTime);
+  return ((*timing)->deviceTime - captureTime) * 1e6;
+}
+
 TangoVRDevice::TangoVRDevice(TangoVRDeviceProvider* provider)
-    : tangoVRDeviceProvider(provider) {
+    : tangoVRDeviceProvider(provider),
+      nextADFSwitchId(0),
+      weakPtrFactory(this) {
   tangoCoordinateFramePair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
   tangoCoordinateFramePair.target = TANGO_COORDINATE_FRAME_DEVICE;
 }
 
 TangoVRDevice::~TangoVRDevice() {
+  for (const auto& display : displayAnchors)
+    RemoveAnchors(display.second);
 }
 
 mojom::VRDisplayInfoPtr TangoVRDevice::GetVRDevice() {
@@ -46,6 +90,7 @@ mojom::VRDisplayInfoPtr TangoVRDevice::GetVRDevice() {
   device->capabilities->hasPassThroughCamera = true;
   device->capabilities->hasADFSupport = true;
   device->capabilities->hasMarkerSupport = true;
+  device->capabilities->hasFrameAvailableEvents = true;
 
   device->leftEye = mojom::VREyeParameters::New();
   device->rightEye = mojom::VREyeParameters::New();
@@ -125,34 +170,43 @@ mojom::VRDisplayInfoPtr TangoVRDevice::GetVRDevice() {
   right_eye->renderWidth = iw;
   right_eye->renderHeight = ih;
 
-  // Store the orientation values so we can check in future GetPose()
-  // calls if we need to update camera intrinsics and regenerate the
-  // VRDeviceInfoPtr
-  lastSensorOrientation = tangoHandler->getSensorOrientation();
-  lastActivityOrientation = tangoHandler->getActivityOrientation();
-
   return device;
 }
 
 mojom::VRPosePtr TangoVRDevice::GetPose() {
+  TRACE_EVENT0("input", "TangoVRDevice::GetPose");
 
-  // Check to see if orientation has changed, and if so, fire
-  // an OnChanged() so that the VRFieldOfView can be updated,
-  // with the up-to-date VRDeviceInfoPtr sent to WebKit for correct
-  // projection matrix calculations.
   TangoHandler* tangoHandler = TangoHandler::getInstance();
-  if (tangoHandler->isConnected() &&
-      (lastSensorOrientation  != tangoHandler->getSensorOrientation() ||
-      lastActivityOrientation != tangoHandler->getActivityOrientation())) {
-    VRDevice::OnChanged();
+
+  // GetPose is called once per frame, which samples the callback rates often
+  // enough for the counters.
+  double pointCloudRate, frameRate, textureRate;
+  tangoHandler->getCallbackRates(&pointCloudRate, &frameRate, &textureRate);
+  TRACE_COUNTER1("input", "TangoPointCloudCallbackHz", pointCloudRate);
+  TRACE_COUNTER2("input", "TangoCameraCallbackHz", "frameHz", frameRate,
+      "textureHz", textureRate);
+
+  mojom::VRPosePtr pose = sampleCache.GetPose(tangoHandler->getPoseTimestamp(),
+      base::Bind(&TangoVRDevice::AcquirePose, base::Unretained(this)));
+  if (pose)
+  {
+    double ageUs = StampSampleTiming(tango_chromium::LATENCY_SAMPLE_POSE, &pose->timing);
+    TRACE_COUNTER1("input", "TangoPoseAgeUs", ageUs);
   }
+  TRACE_COUNTER2("input", "TangoSampleCache", "hits", sampleCache.hits(),
+      "misses", sampleCache.misses());
+  return pose;
+}
 
+mojom::VRPosePtr TangoVRDevice::AcquirePose() {
   TangoPoseData tangoPoseData;
 
   mojom::VRPosePtr pose = nullptr;
   bool isLocalized = false;
 
-  if (TangoHandler::getInstance()->isConnected() && TangoHandler::getInstance()->getPose(&tangoPoseData, &isLocalized))
+  // getPose does not wait for ADF switches: it only returns the last known
+  // pose while a switch has the Tango Service disconnected.
+  if (TangoHandler::getInstance()->getPose(&tangoPoseData, &isLocalized))
   {
     pose = mojom::VRPose::New();
 
@@ -170,44 +224,97 @@ mojom::VRPosePtr TangoVRDevice::GetPose() {
     pose->position.value()[0] = tangoPoseData.translation[0]/*decomposed_transform.translate[0]*/;
     pose->position.value()[1] = tangoPoseData.translation[1]/*decomposed_transform.translate[1]*/;
     pose->position.value()[2] = tangoPoseData.translation[2]/*decomposed_transform.translate[2]*/;
+
+    pose->timing = CreateSampleTiming(tangoPoseData.timestamp);
   }
 
   return pose;
 }
 
 void TangoVRDevice::ResetPose() {
+  sampleCache.Clear();
   TangoHandler::getInstance()->resetPose();
 }
 
 mojom::VRPointCloudPtr TangoVRDevice::GetPointCloud(bool justUpdatePointCloud, unsigned pointsToSkip, bool transformPoints)
 {
+  TRACE_EVENT_BEGIN2("input", "TangoVRDevice::GetPointCloud",
+      "pointsToSkip", pointsToSkip, "transformPoints", transformPoints);
   TangoHandler* tangoHandler = TangoHandler::getInstance();
   mojom::VRPointCloudPtr pointCloudPtr = nullptr;
   if (tangoHandler->isConnected())
   {
     if (!justUpdatePointCloud)
     {
-      pointCloudPtr = mojom::VRPointCloud::New();
-      pointCloudPtr->points.resize(tangoHandler->getMaxNumberOfPointsInPointCloud() * 3);
-      pointCloudPtr->pointsTransformMatrix.resize(16);
-      if (!tangoHandler->getPointCloud(&(pointCloudPtr->numberOfPoints), &(pointCloudPtr->points[0]), justUpdatePointCloud, pointsToSkip, transformPoints, &(pointCloudPtr->pointsTransformMatrix[0])))
+      pointCloudPtr = sampleCache.GetPointCloud(tangoHandler->getLatestPointCloudTimestamp(), pointsToSkip, transformPoints,
+          base::Bind(&TangoVRDevice::AcquirePointCloud, base::Unretained(this), pointsToSkip, transformPoints));
+      if (pointCloudPtr)
       {
-        pointCloudPtr = nullptr;
+        double ageUs = StampSampleTiming(tango_chromium::LATENCY_SAMPLE_POINT_CLOUD, &pointCloudPtr->timing);
+        TRACE_COUNTER1("input", "TangoPointCloudAgeUs", ageUs);
       }
-      pointCloudPtr->pointsAlreadyTransformed = transformPoints;
     }
     else 
     {
       // If the point cloud should only be updated, why create a whole array?
+      // The points are uploaded into WebGL buffers by the GPU process, which
+      // does not wait for the renderer: only their number is returned, the
+      // one of the point cloud it uploaded last.
       uint32_t numberOfPoints;
       tangoHandler->getPointCloud(&numberOfPoints, 0, justUpdatePointCloud, pointsToSkip, transformPoints, 0);
+      pointCloudPtr = mojom::VRPointCloud::New();
+      pointCloudPtr->numberOfPoints = tangoHandler->getUploadedNumberOfPoints();
+      pointCloudPtr->maxNumberOfPoints = tangoHandler->getMaxNumberOfPointsInPointCloud();
+      pointCloudPtr->pointsTransformMatrix.assign(16, 0);
+      pointCloudPtr->pointsTransformMatrix[0] = pointCloudPtr->pointsTransformMatrix[5] = pointCloudPtr->pointsTransformMatrix[10] = pointCloudPtr->pointsTransformMatrix[15] = 1;
+      pointCloudPtr->pointsAlreadyTransformed = true;
     }
   }
+  uint32_t numberOfPoints = pointCloudPtr ? pointCloudPtr->numberOfPoints : 0;
+  TRACE_EVENT_END2("input", "TangoVRDevice::GetPointCloud",
+      "numberOfPoints", numberOfPoints,
+      "bytesCopied", justUpdatePointCloud ? 0 : numberOfPoints * 3 * sizeof(float));
+  TRACE_COUNTER2("input", "TangoSampleCache", "hits", sampleCache.hits(),
+      "misses", sampleCache.misses());
+  return pointCloudPtr;
+}
+
+mojom::VRPointCloudPtr TangoVRDevice::AcquirePointCloud(unsigned pointsToSkip, bool transformPoints)
+{
+  TangoHandler* tangoHandler = TangoHandler::getInstance();
+  // The points are written straight into the buffer the displays map.
+  uint32_t maxNumberOfPoints = tangoHandler->getMaxNumberOfPointsInPointCloud();
+  uint64_t size = maxNumberOfPoints * 3 * sizeof(float);
+  if (size == 0)
+  {
+    return nullptr;
+  }
+  mojo::ScopedSharedBufferHandle buffer = mojo::SharedBufferHandle::Create(size);
+  if (!buffer.is_valid())
+  {
+    return nullptr;
+  }
+  mojo::ScopedSharedBufferMapping mapping = buffer->Map(size);
+  if (!mapping)
+  {
+    return nullptr;
+  }
+  mojom::VRPointCloudPtr pointCloudPtr = mojom::VRPointCloud::New();
+  pointCloudPtr->maxNumberOfPoints = maxNumberOfPoints;
+  pointCloudPtr->pointsTransformMatrix.resize(16);
+  if (!tangoHandler->getPointCloud(&(pointCloudPtr->numberOfPoints), static_cast<float*>(mapping.get()), false, pointsToSkip, transformPoints, &(pointCloudPtr->pointsTransformMatrix[0])))
+  {
+    return nullptr;
+  }
+  pointCloudPtr->points = std::move(buffer);
+  pointCloudPtr->pointsAlreadyTransformed = transformPoints;
+  pointCloudPtr->timing = CreateSampleTiming(tangoHandler->getPointCloudTimestamp());
   return pointCloudPtr;
 }
 
 mojom::VRPassThroughCameraPtr TangoVRDevice::GetPassThroughCamera()
 {
+  TRACE_EVENT0("input", "TangoVRDevice::GetPassThroughCamera");
   TangoHandler* tangoHandler = TangoHandler::getInstance();
   mojom::VRPassThroughCameraPtr passThroughCameraPtr = nullptr;
   if (tangoHandler->isConnected())
@@ -218,12 +325,18 @@ mojom::VRPassThroughCameraPtr TangoVRDevice::GetPassThroughCamera()
     tangoHandler->getCameraFocalLength(&(passThroughCameraPtr->focalLengthX), &(passThroughCameraPtr->focalLengthY));
     tangoHandler->getCameraPoint(&(passThroughCameraPtr->pointX), &(passThroughCameraPtr->pointY));
     passThroughCameraPtr->orientation = tangoHandler->getSensorOrientation();
+    tangoHandler->getDepthImageSize(&(passThroughCameraPtr->depthImageWidth), &(passThroughCameraPtr->depthImageHeight));
+    // The age of the camera image that was last updated into the texture.
+    passThroughCameraPtr->timing = CreateSampleTiming(tangoHandler->getCameraImageTimestamp());
+    double ageUs = StampSampleTiming(tango_chromium::LATENCY_SAMPLE_CAMERA_FRAME, &passThroughCameraPtr->timing);
+    TRACE_COUNTER1("input", "TangoCameraFrameAgeUs", ageUs);
   }
   return passThroughCameraPtr;
 }
 
 std::vector<mojom::VRHitPtr> TangoVRDevice::HitTest(float x, float y)
 {
+  TRACE_EVENT_BEGIN2("input", "TangoVRDevice::HitTest", "x", x, "y", y);
   std::vector<mojom::VRHitPtr> mojomHits;
   if (TangoHandler::getInstance()->isConnected())
   {
@@ -243,11 +356,13 @@ std::vector<mojom::VRHitPtr> TangoVRDevice::HitTest(float x, float y)
       }
     }
   }
+  TRACE_EVENT_END1("input", "TangoVRDevice::HitTest", "numberOfHits", mojomHits.size());
   return mojomHits;
 }
 
 std::vector<mojom::VRADFPtr> TangoVRDevice::GetADFs()
 {
+  TRACE_EVENT0("input", "TangoVRDevice::GetADFs");
   std::vector<mojom::VRADFPtr> mojomADFs;
   if (TangoHandler::getInstance()->isConnected())
   {
@@ -268,32 +383,68 @@ std::vector<mojom::VRADFPtr> TangoVRDevice::GetADFs()
   return mojomADFs;
 }
 
-void TangoVRDevice::EnableADF(const std::string& uuid)
+// TangoHandler completes ADF switches on its own thread, post the result back
+// to the thread that requested the switch. The callback itself stays on this
+// thread: the mojo responders must not be released on another one. The switch
+// is traced as an async event from the request to its completion.
+TangoHandler::ADFSwitchCallback TangoVRDevice::BindADFSwitchCallback(const std::string& uuid, const base::Callback<void(bool)>& callback)
+{
+  int adfSwitchId = ++nextADFSwitchId;
+  TRACE_EVENT_ASYNC_BEGIN1("input", "TangoVRDevice::SwitchADF", adfSwitchId, "uuid", uuid);
+  adfSwitchCallbacks[adfSwitchId] = callback;
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner = base::ThreadTaskRunnerHandle::Get();
+  base::WeakPtr<TangoVRDevice> device = weakPtrFactory.GetWeakPtr();
+  return [task_runner, device, adfSwitchId](bool success) {
+    TRACE_EVENT_ASYNC_END1("input", "TangoVRDevice::SwitchADF", adfSwitchId, "success", success);
+    task_runner->PostTask(FROM_HERE, base::Bind(&TangoVRDevice::OnADFSwitched, device, adfSwitchId, success));
+  };
+}
+
+void TangoVRDevice::OnADFSwitched(int adfSwitchId, bool success)
+{
+  auto it = adfSwitchCallbacks.find(adfSwitchId);
+  if (it == adfSwitchCallbacks.end())
+  {
+    return;
+  }
+  base::Callback<void(bool)> callback = it->second;
+  adfSwitchCallbacks.erase(it);
+  callback.Run(success);
+}
+
+void TangoVRDevice::EnableADF(const std::string& uuid, const base::Callback<void(bool)>& callback)
 {
-  TangoHandler::getInstance()->enableADF(uuid);
+  // The poses change of reference frame.
+  sampleCache.Clear();
+  TangoHandler::getInstance()->enableADF(uuid, BindADFSwitchCallback(uuid, callback));
 }
 
-void TangoVRDevice::DisableADF()
+void TangoVRDevice::DisableADF(const base::Callback<void(bool)>& callback)
 {
-  TangoHandler::getInstance()->disableADF();
+  sampleCache.Clear();
+  TangoHandler::getInstance()->disableADF(BindADFSwitchCallback("", callback));
 }
 
 std::vector<mojom::VRMarkerPtr> TangoVRDevice::GetMarkers(unsigned markerType, float markerSize)
 {
+  TRACE_EVENT1("input", "TangoVRDevice::GetMarkers", "markerType", markerType);
   std::vector<mojom::VRMarkerPtr> mojomMarkers;
   if (TangoHandler::getInstance()->isConnected())
   {
-    TangoSupportMarkerType mt;
+    tango_chromium::MarkerType mt;
     switch(markerType)
     {
       case 0x1:
-        mt = TANGO_MARKER_ARTAG;
+        mt = tango_chromium::MARKER_TYPE_ARTAG;
         break;
       case 0x2:
-        mt = TANGO_MARKER_QRCODE;
+        mt = tango_chromium::MARKER_TYPE_QRCODE;
+        break;
+      case 0x4:
+        mt = tango_chromium::MARKER_TYPE_FIDUCIAL;
         break;
       default:
-        VLOG(0) << "ERROR: Incorrect marker type value. Currently supported values are VRDipslay.MARKER_TYPE_AR and VRDisplay.MARKER_TYPE_QRCODE.";
+        VLOG(0) << "ERROR: Incorrect marker type value. Currently supported values are VRDipslay.MARKER_TYPE_AR, VRDisplay.MARKER_TYPE_QRCODE and VRDisplay.MARKER_TYPE_FIDUCIAL.";
         return mojomMarkers;
     }
     std::vector<Marker> markers;
@@ -320,10 +471,126 @@ std::vector<mojom::VRMarkerPtr> TangoVRDevice::GetMarkers(unsigned markerType, f
         mojomMarkers[i]->orientation[3] = markerOrientation[3];
       }
     }
+    TRACE_COUNTER1("input", "TangoMarkers", mojomMarkers.size());
   }
   return mojomMarkers;
 }
 
+unsigned TangoVRDevice::CreateAnchor(VRDisplayImpl* display, const std::vector<float>& modelMatrix)
+{
+  TRACE_EVENT0("input", "TangoVRDevice::CreateAnchor");
+  if (modelMatrix.size() != 16)
+  {
+    VLOG(0) << "ERROR: The anchor model matrix must have 16 elements.";
+    return 0;
+  }
+  unsigned anchorId = TangoHandler::getInstance()->createAnchor(modelMatrix.data());
+  if (anchorId != 0)
+  {
+    displayAnchors[display][anchorId] = modelMatrix;
+  }
+  return anchorId;
+}
+
+void TangoVRDevice::RemoveAnchor(VRDisplayImpl* display, unsigned anchorId)
+{
+  std::map<VRDisplayImpl*, AnchorMatrices>::iterator it = displayAnchors.find(display);
+  if (it == displayAnchors.end() || it->second.erase(anchorId) == 0)
+  {
+    return;
+  }
+  TangoHandler::getInstance()->removeAnchor(anchorId);
+}
+
+void TangoVRDevice::RemoveAnchors(const AnchorMatrices& anchors)
+{
+  TangoHandler* tangoHandler = TangoHandler::getInstance();
+  for (const auto& anchor : anchors)
+    tangoHandler->removeAnchor(anchor.first);
+}
+
+mojom::VRAnchorUpdatesPtr TangoVRDevice::GetAnchorUpdates(VRDisplayImpl* display)
+{
+  mojom::VRAnchorUpdatesPtr anchorUpdates = mojom::VRAnchorUpdates::New();
+  TRACE_EVENT0("input", "TangoVRDevice::GetAnchorUpdates");
+  std::map<VRDisplayImpl*, AnchorMatrices>::iterator it = displayAnchors.find(display);
+  if (it == displayAnchors.end())
+  {
+    return anchorUpdates;
+  }
+  AnchorMatrices& reportedMatrices = it->second;
+
+  std::vector<uint32_t> anchorIds;
+  anchorIds.reserve(reportedMatrices.size());
+  for (const auto& anchor : reportedMatrices)
+    anchorIds.push_back(anchor.first);
+  std::vector<uint32_t> expressedAnchorIds;
+  std::vector<float> modelMatrices;
+  // All the anchors of the display are copied in a single batch.
+  TangoHandler::getInstance()->getAnchorModelMatrices(anchorIds, expressedAnchorIds, modelMatrices);
+
+  // Only the anchors that changed since they were last reported to this
+  // display are reported.
+  for (size_t i = 0; i < expressedAnchorIds.size(); i++)
+  {
+    const float* modelMatrix = &modelMatrices[i * 16];
+    std::vector<float>& reportedMatrix = reportedMatrices[expressedAnchorIds[i]];
+    bool changed = false;
+    for (size_t j = 0; j < 16 && !changed; j++)
+    {
+      changed = std::fabs(modelMatrix[j] - reportedMatrix[j]) > kAnchorUpdateEpsilon;
+    }
+    if (changed)
+    {
+      reportedMatrix.assign(modelMatrix, modelMatrix + 16);
+      anchorUpdates->anchorIds.push_back(expressedAnchorIds[i]);
+      anchorUpdates->modelMatrices.insert(anchorUpdates->modelMatrices.end(), modelMatrix, modelMatrix + 16);
+    }
+  }
+  TRACE_COUNTER1("input", "TangoAnchorUpdates", anchorUpdates->anchorIds.size());
+  return anchorUpdates;
+}
+
+std::vector<mojom::VRLatencyStatsPtr> TangoVRDevice::GetPerformanceStats()
+{
+  static const mojom::VRSampleType sampleTypes[tango_chromium::NUMBER_OF_LATENCY_SAMPLES] = {
+    mojom::VRSampleType::POSE,
+    mojom::VRSampleType::POINT_CLOUD,
+    mojom::VRSampleType::CAMERA_FRAME
+  };
+  static const mojom::VRLatencyHop hops[tango_chromium::NUMBER_OF_LATENCY_HOPS] = {
+    mojom::VRLatencyHop::CALLBACK,
+    mojom::VRLatencyHop::DEVICE
+  };
+
+  std::vector<mojom::VRLatencyStatsPtr> mojomStats;
+  TangoHandler* tangoHandler = TangoHandler::getInstance();
+  for (int sample = 0; sample < tango_chromium::NUMBER_OF_LATENCY_SAMPLES; sample++)
+  {
+    for (int hop = 0; hop < tango_chromium::NUMBER_OF_LATENCY_HOPS; hop++)
+    {
+      LatencyStatistics statistics;
+      tangoHandler->getLatencyStatistics(static_cast<LatencySample>(sample), static_cast<tango_chromium::LatencyHop>(hop), &statistics);
+      if (statistics.count == 0)
+      {
+        continue;
+      }
+      mojom::VRLatencyStatsPtr stats = mojom::VRLatencyStats::New();
+      stats->sample = sampleTypes[sample];
+      stats->hop = hops[hop];
+      stats->count = statistics.count;
+      stats->mean = statistics.mean;
+      stats->min = statistics.min;
+      stats->max = statistics.max;
+      stats->p50 = statistics.p50;
+      stats->p90 = statistics.p90;
+      stats->p99 = statistics.p99;
+      mojomStats.push_back(std::move(stats));
+    }
+  }
+  return mojomStats;
+}
+
 void TangoVRDevice::RequestPresent(const base::Callback<void(bool)>& callback) {
   // gvr_provider_->RequestPresent(callback);
 }
@@ -364,4 +631,15 @@ void TangoVRDevice::UpdateLayerBounds(mojom::VRLayerBoundsPtr left_bounds,
   // delegate_->UpdateWebVRTextureBounds(left_gvr_bounds, right_gvr_bounds);
 }
 
+void TangoVRDevice::RemoveDisplay(VRDisplayImpl* display) {
+  // The anchors of a display go away with it.
+  std::map<VRDisplayImpl*, AnchorMatrices>::iterator it = displayAnchors.find(display);
+  if (it != displayAnchors.end())
+  {
+    RemoveAnchors(it->second);
+    displayAnchors.erase(it);
+  }
+  VRDevice::RemoveDisplay(display);
+}
+
 }  // namespace device
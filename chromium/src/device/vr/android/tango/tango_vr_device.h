@@ -7,12 +7,20 @@
 
 #include <jni.h>
 
+#include <map>
+#include <string>
+#include <vector>
+
 #include "base/android/jni_android.h"
 #include "base/macros.h"
+#include "base/memory/weak_ptr.h"
 #include "device/vr/vr_device.h"
+#include "device/vr/vr_sample_cache.h"
 
 #include "tango_client_api.h"
 
+#include "TangoHandler.h"
+
 namespace device {
 
 class TangoVRDeviceProvider;
@@ -29,9 +37,13 @@ class TangoVRDevice : public VRDevice {
   mojom::VRPassThroughCameraPtr GetPassThroughCamera() override;
   std::vector<mojom::VRHitPtr> HitTest(float x, float y) override;
   std::vector<mojom::VRADFPtr> GetADFs() override;
-  void EnableADF(const std::string& uuid) override;
-  void DisableADF() override;
+  void EnableADF(const std::string& uuid, const base::Callback<void(bool)>& callback) override;
+  void DisableADF(const base::Callback<void(bool)>& callback) override;
   std::vector<mojom::VRMarkerPtr> GetMarkers(unsigned markerType, float markerSize) override;
+  unsigned CreateAnchor(VRDisplayImpl* display, const std::vector<float>& modelMatrix) override;
+  void RemoveAnchor(VRDisplayImpl* display, unsigned anchorId) override;
+  mojom::VRAnchorUpdatesPtr GetAnchorUpdates(VRDisplayImpl* display) override;
+  std::vector<mojom::VRLatencyStatsPtr> GetPerformanceStats() override;
 
   void RequestPresent(const base::Callback<void(bool)>& callback) override;
   void SetSecureOrigin(bool secure_origin) override;
@@ -40,13 +52,37 @@ class TangoVRDevice : public VRDevice {
   void UpdateLayerBounds(mojom::VRLayerBoundsPtr left_bounds,
                          mojom::VRLayerBoundsPtr right_bounds) override;
 
+  void RemoveDisplay(VRDisplayImpl* display) override;
+
  private:
+  // The model matrices last reported for the anchors of a display, by id.
+  typedef std::map<unsigned, std::vector<float>> AnchorMatrices;
+
+  mojom::VRPosePtr AcquirePose();
+  mojom::VRPointCloudPtr AcquirePointCloud(unsigned pointsToSkip, bool transformPoints);
+  tango_chromium::TangoHandler::ADFSwitchCallback BindADFSwitchCallback(const std::string& uuid, const base::Callback<void(bool)>& callback);
+  void OnADFSwitched(int adfSwitchId, bool success);
+  void RemoveAnchors(const AnchorMatrices& anchors);
+
+  // The poses and point clouds are shared between the displays.
+  VRSampleCache sampleCache;
+
   TangoCoordinateFramePair tangoCoordinateFramePair;  
   TangoVRDeviceProvider* tangoVRDeviceProvider;
 
-  int lastSensorOrientation;
-  int lastActivityOrientation;
-  
+  // The callbacks of the pending ADF switches, by id. They are only run and
+  // released on the thread of the device: the ADF switch thread of
+  // TangoHandler only posts the id back.
+  std::map<int, base::Callback<void(bool)>> adfSwitchCallbacks;
+  int nextADFSwitchId;
+
+  // TangoHandler keeps the anchors of all the displays, each display only
+  // sees the anchors it created, and is reported the changes since the last
+  // matrices it got.
+  std::map<VRDisplayImpl*, AnchorMatrices> displayAnchors;
+
+  base::WeakPtrFactory<TangoVRDevice> weakPtrFactory;
+
   DISALLOW_COPY_AND_ASSIGN(TangoVRDevice);
 };
 
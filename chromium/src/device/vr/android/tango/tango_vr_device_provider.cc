@@ -4,13 +4,30 @@
 
 #include "device/vr/android/tango/tango_vr_device_provider.h"
 
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/location.h"
+#include "base/single_thread_task_runner.h"
+#include "base/threading/thread_task_runner_handle.h"
 #include "device/vr/android/tango/tango_vr_device.h"
 
+#include "TangoHandler.h"
+
+using tango_chromium::TangoHandler;
+
 namespace device {
 
-TangoVRDeviceProvider::TangoVRDeviceProvider() : VRDeviceProvider() {}
+TangoVRDeviceProvider::TangoVRDeviceProvider()
+    : VRDeviceProvider(), frame_available_posted_(0), weak_ptr_factory_(this) {}
 
-TangoVRDeviceProvider::~TangoVRDeviceProvider() {}
+TangoVRDeviceProvider::~TangoVRDeviceProvider() {
+  if (task_runner_) {
+    TangoHandler::getInstance()->setStateChangedCallback(
+        TangoHandler::StateChangedCallback());
+    TangoHandler::getInstance()->setFrameAvailableCallback(
+        TangoHandler::FrameAvailableCallback());
+  }
+}
 
 void TangoVRDeviceProvider::GetDevices(std::vector<VRDevice*>* devices) {
 	Initialize();
@@ -19,10 +36,50 @@ void TangoVRDeviceProvider::GetDevices(std::vector<VRDevice*>* devices) {
 	}
 }
 
+base::Closure TangoVRDeviceProvider::GetWorkerThreadInitialization() {
+  // Creating TangoHandler allocates the buffers of the session recorder and
+  // of the sensor backend. It is a singleton, which outlives the provider.
+  return base::Bind(base::IgnoreResult(&TangoHandler::getInstance));
+}
+
 void TangoVRDeviceProvider::Initialize() {
-  if (!tango_device_) {
+  // The device is created on the thread of the VRDeviceManager, like the other
+  // devices, which creates TangoHandler if there was no worker thread.
+  if (!tango_device_)
     tango_device_.reset(new TangoVRDevice(this));
+  if (!task_runner_) {
+    // TangoHandler notifies the changes on the UI and the ADF switch threads,
+    // post them to the thread of the provider.
+    task_runner_ = base::ThreadTaskRunnerHandle::Get();
+    scoped_refptr<base::SingleThreadTaskRunner> task_runner = task_runner_;
+    base::Closure task = base::Bind(&TangoVRDeviceProvider::OnTangoStateChanged,
+                                    weak_ptr_factory_.GetWeakPtr());
+    TangoHandler::getInstance()->setStateChangedCallback(
+        [task_runner, task]() { task_runner->PostTask(FROM_HERE, task); });
+
+    // The camera frames arrive on the Tango Service thread. The callback is
+    // reset before the provider is destroyed, so the flag outlives it.
+    base::subtle::Atomic32* posted = &frame_available_posted_;
+    base::Closure frame_task =
+        base::Bind(&TangoVRDeviceProvider::OnTangoFrameAvailable,
+                   weak_ptr_factory_.GetWeakPtr());
+    TangoHandler::getInstance()->setFrameAvailableCallback(
+        [task_runner, frame_task, posted]() {
+          if (base::subtle::NoBarrier_CompareAndSwap(posted, 0, 1) == 0)
+            task_runner->PostTask(FROM_HERE, frame_task);
+        });
   }
 }
 
+void TangoVRDeviceProvider::OnTangoStateChanged() {
+  if (tango_device_ && client())
+    client()->OnDeviceChanged(tango_device_.get());
+}
+
+void TangoVRDeviceProvider::OnTangoFrameAvailable() {
+  base::subtle::NoBarrier_Store(&frame_available_posted_, 0);
+  if (tango_device_)
+    tango_device_->OnFrameAvailable();
+}
+
 }  // namespace device
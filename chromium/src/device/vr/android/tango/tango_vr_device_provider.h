@@ -8,10 +8,17 @@
 #include <map>
 #include <memory>
 
+#include "base/atomicops.h"
 #include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
 #include "device/vr/vr_device.h"
 #include "device/vr/vr_device_provider.h"
 
+namespace base {
+class SingleThreadTaskRunner;
+}
+
 namespace device {
 
 class TangoVRDeviceProvider : public VRDeviceProvider {
@@ -20,10 +27,26 @@ class TangoVRDeviceProvider : public VRDeviceProvider {
   ~TangoVRDeviceProvider() override;
 
   void GetDevices(std::vector<VRDevice*>* devices) override;
+  // Creates the device and sets the callbacks of TangoHandler, which post to
+  // the thread of the provider.
   void Initialize() override;
+  // Creates TangoHandler.
+  base::Closure GetWorkerThreadInitialization() override;
 
  private:
+  // Runs on the thread the provider was initialized on when the Tango Service
+  // connects or disconnects or the device rotates.
+  void OnTangoStateChanged();
+  // Same when a new camera frame is available, to drive the animation frames
+  // of the displays that asked for it.
+  void OnTangoFrameAvailable();
+
   std::unique_ptr<VRDevice> tango_device_;
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
+  // 1 while an OnTangoFrameAvailable task is posted: the frames delivered
+  // until it runs do not post another one.
+  base::subtle::Atomic32 frame_available_posted_;
+  base::WeakPtrFactory<TangoVRDeviceProvider> weak_ptr_factory_;
 
   DISALLOW_COPY_AND_ASSIGN(TangoVRDeviceProvider);
 };
@@ -0,0 +1,250 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "device/vr/replay/replay_session.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "base/files/file_path.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/logging.h"
+
+using tango_chromium::SESSION_LOG_CHUNK_MAGIC;
+using tango_chromium::SESSION_LOG_FILE_MAGIC;
+using tango_chromium::SESSION_LOG_FOOTER_MAGIC;
+using tango_chromium::SESSION_LOG_RECORD_CAMERA_INTRINSICS;
+using tango_chromium::SESSION_LOG_RECORD_FRAME;
+using tango_chromium::SESSION_LOG_RECORD_MARKERS;
+using tango_chromium::SESSION_LOG_RECORD_POINT_CLOUD;
+using tango_chromium::SESSION_LOG_RECORD_POSE;
+using tango_chromium::SESSION_LOG_VERSION;
+using tango_chromium::SessionLogCameraIntrinsics;
+using tango_chromium::SessionLogChunkHeader;
+using tango_chromium::SessionLogFileFooter;
+using tango_chromium::SessionLogFileHeader;
+using tango_chromium::SessionLogFrame;
+using tango_chromium::SessionLogIndexEntry;
+using tango_chromium::SessionLogMarker;
+using tango_chromium::SessionLogMarkers;
+using tango_chromium::SessionLogPointCloud;
+using tango_chromium::SessionLogPose;
+using tango_chromium::SessionLogRecordHeader;
+using tango_chromium::SessionLogRecordType;
+using tango_chromium::sessionLogPaddedSize;
+
+namespace device {
+
+namespace {
+
+template <typename T>
+T ReadStruct(const uint8_t* data) {
+  // The mapping is 8 byte aligned, but copying keeps this independent of it.
+  T value;
+  memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+// Whether a payload is big enough for what its header announces.
+bool IsValidPayload(uint32_t type, const uint8_t* payload, uint32_t size) {
+  switch (type) {
+    case SESSION_LOG_RECORD_POSE:
+      return size >= sizeof(SessionLogPose);
+    case SESSION_LOG_RECORD_POINT_CLOUD: {
+      if (size < sizeof(SessionLogPointCloud))
+        return false;
+      SessionLogPointCloud point_cloud =
+          ReadStruct<SessionLogPointCloud>(payload);
+      return point_cloud.numberOfPoints <=
+             (size - sizeof(SessionLogPointCloud)) / (4 * sizeof(float));
+    }
+    case SESSION_LOG_RECORD_CAMERA_INTRINSICS:
+      return size >= sizeof(SessionLogCameraIntrinsics);
+    case SESSION_LOG_RECORD_FRAME: {
+      if (size < sizeof(SessionLogFrame))
+        return false;
+      SessionLogFrame frame = ReadStruct<SessionLogFrame>(payload);
+      return static_cast<uint64_t>(frame.width) * frame.height * 3 / 2 <=
+             size - sizeof(SessionLogFrame);
+    }
+    case SESSION_LOG_RECORD_MARKERS: {
+      if (size < sizeof(SessionLogMarkers))
+        return false;
+      SessionLogMarkers markers = ReadStruct<SessionLogMarkers>(payload);
+      uint64_t offset = sizeof(SessionLogMarkers);
+      for (uint32_t i = 0; i < markers.numberOfMarkers; i++) {
+        if (offset + sizeof(SessionLogMarker) > size)
+          return false;
+        SessionLogMarker marker =
+            ReadStruct<SessionLogMarker>(payload + offset);
+        offset += sizeof(SessionLogMarker) +
+                  sessionLogPaddedSize(marker.contentSize);
+        if (offset > size)
+          return false;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+bool CompareRecordTimestamps(const ReplaySession::Record& a,
+                             const ReplaySession::Record& b) {
+  return a.timestamp < b.timestamp;
+}
+
+}  // namespace
+
+ReplaySession::ReplaySession()
+    : start_timestamp_(0), end_timestamp_(0), max_number_of_points_(0) {}
+
+ReplaySession::~ReplaySession() {}
+
+bool ReplaySession::Initialize(const base::FilePath& path) {
+  file_.reset(new base::MemoryMappedFile());
+  if (!file_->Initialize(path)) {
+    LOG(ERROR) << "Could not map the replay session " << path.value();
+    file_.reset();
+    return false;
+  }
+  if (!Parse(file_->data(), file_->length())) {
+    LOG(ERROR) << path.value() << " is not a valid session log.";
+    file_.reset();
+    return false;
+  }
+  return true;
+}
+
+bool ReplaySession::InitializeWithData(const uint8_t* data, size_t length) {
+  return Parse(data, length);
+}
+
+const std::vector<ReplaySession::Record>& ReplaySession::GetRecords(
+    SessionLogRecordType type) const {
+  DCHECK(type > 0 && type < kNumberOfRecordTypes);
+  return records_[type];
+}
+
+int ReplaySession::FindLatest(SessionLogRecordType type,
+                              double timestamp) const {
+  const std::vector<Record>& records = GetRecords(type);
+  Record key = {timestamp, nullptr, 0};
+  std::vector<Record>::const_iterator it = std::upper_bound(
+      records.begin(), records.end(), key, CompareRecordTimestamps);
+  return static_cast<int>(it - records.begin()) - 1;
+}
+
+bool ReplaySession::Parse(const uint8_t* data, size_t length) {
+  for (int i = 0; i < kNumberOfRecordTypes; i++)
+    records_[i].clear();
+  max_number_of_points_ = 0;
+
+  if (length < sizeof(SessionLogFileHeader))
+    return false;
+  SessionLogFileHeader header = ReadStruct<SessionLogFileHeader>(data);
+  if (header.magic != SESSION_LOG_FILE_MAGIC ||
+      header.version != SESSION_LOG_VERSION) {
+    return false;
+  }
+
+  // Use the index if the recording was stopped cleanly, walk the chunks
+  // otherwise.
+  bool indexed = false;
+  if (length >= sizeof(SessionLogFileHeader) + sizeof(SessionLogFileFooter)) {
+    SessionLogFileFooter footer = ReadStruct<SessionLogFileFooter>(
+        data + length - sizeof(SessionLogFileFooter));
+    uint64_t index_size =
+        static_cast<uint64_t>(footer.indexEntryCount) *
+        sizeof(SessionLogIndexEntry);
+    if (footer.magic == SESSION_LOG_FOOTER_MAGIC &&
+        footer.indexOffset + index_size + sizeof(SessionLogFileFooter) ==
+            length) {
+      indexed = true;
+      for (uint32_t i = 0; i < footer.indexEntryCount; i++) {
+        SessionLogIndexEntry entry = ReadStruct<SessionLogIndexEntry>(
+            data + footer.indexOffset + i * sizeof(SessionLogIndexEntry));
+        if (ParseChunk(data, footer.indexOffset, entry.offset) == 0)
+          return false;
+      }
+    }
+  }
+  if (!indexed) {
+    uint64_t offset = sizeof(SessionLogFileHeader);
+    while (offset < length) {
+      offset = ParseChunk(data, length, offset);
+      if (offset == 0)
+        break;
+    }
+  }
+
+  start_timestamp_ = std::numeric_limits<double>::max();
+  end_timestamp_ = std::numeric_limits<double>::lowest();
+  for (int i = 0; i < kNumberOfRecordTypes; i++) {
+    // Records from different threads are only roughly ordered in the file.
+    std::stable_sort(records_[i].begin(), records_[i].end(),
+                     CompareRecordTimestamps);
+    if (!records_[i].empty()) {
+      start_timestamp_ =
+          std::min(start_timestamp_, records_[i].front().timestamp);
+      end_timestamp_ = std::max(end_timestamp_, records_[i].back().timestamp);
+    }
+  }
+  if (start_timestamp_ > end_timestamp_)
+    start_timestamp_ = end_timestamp_ = 0;
+
+  return !records_[SESSION_LOG_RECORD_POSE].empty();
+}
+
+uint64_t ReplaySession::ParseChunk(const uint8_t* data,
+                                   size_t length,
+                                   uint64_t offset) {
+  if (offset + sizeof(SessionLogChunkHeader) > length)
+    return 0;
+  SessionLogChunkHeader chunk = ReadStruct<SessionLogChunkHeader>(data + offset);
+  if (chunk.magic != SESSION_LOG_CHUNK_MAGIC)
+    return 0;
+  offset += sizeof(SessionLogChunkHeader);
+
+  // A chunk that was still being written when the recording was interrupted
+  // has an empty header, its records run until the end of the data.
+  bool unfinished = chunk.recordCount == 0 && chunk.size == 0;
+  uint64_t end = unfinished ? length : offset + chunk.size;
+  if (end > length)
+    return 0;
+
+  uint32_t count = 0;
+  while (offset + sizeof(SessionLogRecordHeader) <= end &&
+         (unfinished || count < chunk.recordCount)) {
+    SessionLogRecordHeader header =
+        ReadStruct<SessionLogRecordHeader>(data + offset);
+    uint64_t payload_offset = offset + sizeof(SessionLogRecordHeader);
+    if (payload_offset + header.size > end)
+      return unfinished ? end : 0;
+    if (!AddRecord(header, data + payload_offset) && !unfinished)
+      return 0;
+    offset = payload_offset + sessionLogPaddedSize(header.size);
+    count++;
+  }
+  return unfinished ? end : offset;
+}
+
+bool ReplaySession::AddRecord(const SessionLogRecordHeader& header,
+                              const uint8_t* payload) {
+  if (header.type == 0 || header.type >= kNumberOfRecordTypes ||
+      !IsValidPayload(header.type, payload, header.size)) {
+    return false;
+  }
+  Record record = {header.timestamp, payload, header.size};
+  records_[header.type].push_back(record);
+  if (header.type == SESSION_LOG_RECORD_POINT_CLOUD) {
+    max_number_of_points_ =
+        std::max(max_number_of_points_,
+                 ReadStruct<SessionLogPointCloud>(payload).numberOfPoints);
+  }
+  return true;
+}
+
+}  // namespace device
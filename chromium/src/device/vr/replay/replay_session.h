@@ -0,0 +1,79 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef DEVICE_VR_REPLAY_REPLAY_SESSION_H
+#define DEVICE_VR_REPLAY_REPLAY_SESSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "device/vr/vr_export.h"
+
+#include "SessionLogFormat.h"
+
+namespace base {
+class FilePath;
+class MemoryMappedFile;
+}
+
+namespace device {
+
+// A session log recorded by the Tango SessionRecorder (see
+// SessionLogFormat.h). The file is memory mapped and the records of every type
+// are indexed by timestamp when it is opened, the payloads are then read in
+// place.
+class DEVICE_VR_EXPORT ReplaySession {
+ public:
+  struct Record {
+    double timestamp;
+    const uint8_t* payload;
+    uint32_t size;
+  };
+
+  ReplaySession();
+  ~ReplaySession();
+
+  bool Initialize(const base::FilePath& path);
+  // |data| must outlive the session.
+  bool InitializeWithData(const uint8_t* data, size_t length);
+
+  // Records of |type|, sorted by timestamp.
+  const std::vector<Record>& GetRecords(
+      tango_chromium::SessionLogRecordType type) const;
+  // Index of the last record of |type| with a timestamp <= |timestamp|, -1 if
+  // there is none.
+  int FindLatest(tango_chromium::SessionLogRecordType type,
+                 double timestamp) const;
+
+  double start_timestamp() const { return start_timestamp_; }
+  double end_timestamp() const { return end_timestamp_; }
+  uint32_t max_number_of_points() const { return max_number_of_points_; }
+
+ private:
+  static const int kNumberOfRecordTypes =
+      tango_chromium::SESSION_LOG_RECORD_MARKERS + 1;
+
+  bool Parse(const uint8_t* data, size_t length);
+  // Adds the records of the chunk at |offset| and returns the offset right
+  // after it, 0 if the chunk is not valid.
+  uint64_t ParseChunk(const uint8_t* data, size_t length, uint64_t offset);
+  bool AddRecord(const tango_chromium::SessionLogRecordHeader& header,
+                 const uint8_t* payload);
+
+  std::unique_ptr<base::MemoryMappedFile> file_;
+  std::vector<Record> records_[kNumberOfRecordTypes];
+  double start_timestamp_;
+  double end_timestamp_;
+  uint32_t max_number_of_points_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReplaySession);
+};
+
+}  // namespace device
+
+#endif  // DEVICE_VR_REPLAY_REPLAY_SESSION_H
@@ -0,0 +1,612 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "device/vr/replay/replay_vr_device.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/trace_event/trace_event.h"
+#include "device/vr/replay/replay_session.h"
+#include "mojo/public/cpp/system/buffer.h"
+
+using tango_chromium::SESSION_LOG_RECORD_CAMERA_INTRINSICS;
+using tango_chromium::SESSION_LOG_RECORD_MARKERS;
+using tango_chromium::SESSION_LOG_RECORD_POINT_CLOUD;
+using tango_chromium::SESSION_LOG_RECORD_POSE;
+using tango_chromium::SessionLogCameraIntrinsics;
+using tango_chromium::SessionLogMarker;
+using tango_chromium::SessionLogMarkers;
+using tango_chromium::SessionLogPointCloud;
+using tango_chromium::SessionLogPose;
+using tango_chromium::sessionLogPaddedSize;
+
+namespace device {
+
+namespace {
+
+const float kRad2Deg = 180.0 / M_PI;
+
+// The tango_chromium::MarkerType values stored in the session log.
+const int32_t kMarkerTypeARTag = 1;
+const int32_t kMarkerTypeQRCode = 2;
+const int32_t kMarkerTypeFiducial = 4;
+
+// Points whose projection is within this distance (in normalized screen
+// coordinates) of the hit test position are used to fit the plane.
+const double kHitTestRadius = 0.05;
+const size_t kHitTestMinNumberOfPoints = 10;
+
+template <typename T>
+T ReadStruct(const uint8_t* data) {
+  T value;
+  memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+double Dot(const double* a, const double* b) {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+void Cross(const double* a, const double* b, double* out) {
+  out[0] = a[1] * b[2] - a[2] * b[1];
+  out[1] = a[2] * b[0] - a[0] * b[2];
+  out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+bool Normalize(double* v) {
+  double length = sqrt(Dot(v, v));
+  if (length == 0)
+    return false;
+  v[0] /= length;
+  v[1] /= length;
+  v[2] /= length;
+  return true;
+}
+
+// Column major 3x3 rotation of the {x, y, z, w} quaternion |q|.
+void RotationFromQuaternion(const double* q, double* r) {
+  double x = q[0], y = q[1], z = q[2], w = q[3];
+  r[0] = 1 - 2 * (y * y + z * z);
+  r[1] = 2 * (x * y + z * w);
+  r[2] = 2 * (x * z - y * w);
+  r[3] = 2 * (x * y - z * w);
+  r[4] = 1 - 2 * (x * x + z * z);
+  r[5] = 2 * (y * z + x * w);
+  r[6] = 2 * (x * z + y * w);
+  r[7] = 2 * (y * z - x * w);
+  r[8] = 1 - 2 * (x * x + y * y);
+}
+
+void TransformPoint(const float* m, const float* p, double* out) {
+  for (int i = 0; i < 3; i++)
+    out[i] = m[i] * p[0] + m[4 + i] * p[1] + m[8 + i] * p[2] + m[12 + i];
+}
+
+// Fits a plane to |points| (x, y, z triplets). The normal is the direction of
+// least variance, solved along the axis with the largest determinant of the
+// covariance.
+bool FitPlane(const std::vector<double>& points, double* centroid,
+              double* normal) {
+  size_t n = points.size() / 3;
+  centroid[0] = centroid[1] = centroid[2] = 0;
+  for (size_t i = 0; i < n; i++) {
+    for (int j = 0; j < 3; j++)
+      centroid[j] += points[i * 3 + j];
+  }
+  for (int j = 0; j < 3; j++)
+    centroid[j] /= n;
+
+  double xx = 0, xy = 0, xz = 0, yy = 0, yz = 0, zz = 0;
+  for (size_t i = 0; i < n; i++) {
+    double x = points[i * 3] - centroid[0];
+    double y = points[i * 3 + 1] - centroid[1];
+    double z = points[i * 3 + 2] - centroid[2];
+    xx += x * x;
+    xy += x * y;
+    xz += x * z;
+    yy += y * y;
+    yz += y * z;
+    zz += z * z;
+  }
+
+  double det_x = yy * zz - yz * yz;
+  double det_y = xx * zz - xz * xz;
+  double det_z = xx * yy - xy * xy;
+  double det_max = std::max(det_x, std::max(det_y, det_z));
+  if (det_max <= 0)
+    return false;
+
+  if (det_max == det_x) {
+    normal[0] = det_x;
+    normal[1] = xz * yz - xy * zz;
+    normal[2] = xy * yz - xz * yy;
+  } else if (det_max == det_y) {
+    normal[0] = xz * yz - xy * zz;
+    normal[1] = det_y;
+    normal[2] = xy * xz - yz * xx;
+  } else {
+    normal[0] = xy * yz - xz * yy;
+    normal[1] = xy * xz - yz * xx;
+    normal[2] = det_z;
+  }
+  return Normalize(normal);
+}
+
+// Same convention as the hits returned by TangoHandler: the Y axis is the
+// plane normal and the translation is the hit point.
+void MatrixFromPointAndPlane(const double* point, const double* plane,
+                             float* m) {
+  const double kWorldUp[3] = {0, 1, 0};
+  const double kThreshold = 0.5;
+
+  double normal_y[3] = {0, 1, 0};
+  if (fabs(Dot(kWorldUp, plane)) > kThreshold) {
+    normal_y[1] = 0;
+    normal_y[2] = 1;
+  }
+  double normal_z[3];
+  Cross(plane, normal_y, normal_z);
+  Cross(normal_z, plane, normal_y);
+  memset(m, 0, sizeof(float) * 16);
+  m[0] = normal_y[0];
+  m[1] = normal_y[1];
+  m[2] = normal_y[2];
+  m[4] = plane[0];
+  m[5] = plane[1];
+  m[6] = plane[2];
+  m[8] = normal_z[0];
+  m[9] = normal_z[1];
+  m[10] = normal_z[2];
+  m[12] = point[0];
+  m[13] = point[1];
+  m[14] = point[2];
+  m[15] = 1;
+}
+
+}  // namespace
+
+ReplayVRDevice::ReplayVRDevice(std::unique_ptr<ReplaySession> session,
+                               Mode mode)
+    : session_(std::move(session)),
+      mode_(mode),
+      pose_index_(0),
+      current_timestamp_(0) {
+  SeekToPose(0);
+}
+
+ReplayVRDevice::~ReplayVRDevice() {}
+
+void ReplayVRDevice::Step() {
+  if (mode_ != Mode::FRAME_STEPPED || IsAtEnd())
+    return;
+  SeekToPose(pose_index_ + 1);
+}
+
+bool ReplayVRDevice::IsAtEnd() const {
+  return pose_index_ + 1 >= session_->GetRecords(SESSION_LOG_RECORD_POSE).size();
+}
+
+void ReplayVRDevice::SeekToPose(size_t pose_index) {
+  const std::vector<ReplaySession::Record>& poses =
+      session_->GetRecords(SESSION_LOG_RECORD_POSE);
+  pose_index_ = std::min(pose_index, poses.size() - 1);
+  current_timestamp_ = poses[pose_index_].timestamp;
+}
+
+bool ReplayVRDevice::GetCurrentPose(SessionLogPose* pose) const {
+  const std::vector<ReplaySession::Record>& poses =
+      session_->GetRecords(SESSION_LOG_RECORD_POSE);
+  if (poses.empty())
+    return false;
+  *pose = ReadStruct<SessionLogPose>(poses[pose_index_].payload);
+  return true;
+}
+
+bool ReplayVRDevice::GetCameraIntrinsics(
+    SessionLogCameraIntrinsics* intrinsics) const {
+  // The first intrinsics are recorded when the recording starts, before the
+  // first pose, but fall back to them in case they are not.
+  int index = session_->FindLatest(SESSION_LOG_RECORD_CAMERA_INTRINSICS,
+                                   current_timestamp_);
+  const std::vector<ReplaySession::Record>& records =
+      session_->GetRecords(SESSION_LOG_RECORD_CAMERA_INTRINSICS);
+  if (index < 0) {
+    if (records.empty())
+      return false;
+    index = 0;
+  }
+  *intrinsics = ReadStruct<SessionLogCameraIntrinsics>(records[index].payload);
+  return true;
+}
+
+mojom::VRDisplayInfoPtr ReplayVRDevice::GetVRDevice() {
+  TRACE_EVENT0("input", "ReplayVRDevice::GetVRDevice");
+  mojom::VRDisplayInfoPtr device = mojom::VRDisplayInfo::New();
+
+  device->displayName = "Replay VR Device";
+
+  device->capabilities = mojom::VRDisplayCapabilities::New();
+  device->capabilities->hasOrientation = true;
+  device->capabilities->hasPosition = true;
+  device->capabilities->hasExternalDisplay = false;
+  device->capabilities->canPresent = false;
+  device->capabilities->hasPointCloud =
+      !session_->GetRecords(SESSION_LOG_RECORD_POINT_CLOUD).empty();
+  device->capabilities->hasPassThroughCamera =
+      !session_->GetRecords(SESSION_LOG_RECORD_CAMERA_INTRINSICS).empty();
+  device->capabilities->hasADFSupport = false;
+  device->capabilities->hasMarkerSupport =
+      !session_->GetRecords(SESSION_LOG_RECORD_MARKERS).empty();
+
+  device->leftEye = mojom::VREyeParameters::New();
+  device->rightEye = mojom::VREyeParameters::New();
+  mojom::VREyeParametersPtr& left_eye = device->leftEye;
+  mojom::VREyeParametersPtr& right_eye = device->rightEye;
+  left_eye->fieldOfView = mojom::VRFieldOfView::New();
+  right_eye->fieldOfView = mojom::VRFieldOfView::New();
+
+  left_eye->offset.resize(3);
+  right_eye->offset.resize(3);
+
+  float v_degrees = 45;
+  float h_degrees = 45;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  SessionLogCameraIntrinsics intrinsics;
+  if (GetCameraIntrinsics(&intrinsics) && intrinsics.fx > 0 &&
+      intrinsics.fy > 0) {
+    width = intrinsics.width;
+    height = intrinsics.height;
+    v_degrees = atan(height / (2.0 * intrinsics.fy)) * kRad2Deg;
+    h_degrees = atan(width / (2.0 * intrinsics.fx)) * kRad2Deg;
+  }
+
+  left_eye->fieldOfView->upDegrees = v_degrees;
+  left_eye->fieldOfView->downDegrees = v_degrees;
+  left_eye->fieldOfView->leftDegrees = h_degrees;
+  left_eye->fieldOfView->rightDegrees = h_degrees;
+  right_eye->fieldOfView->upDegrees = v_degrees;
+  right_eye->fieldOfView->downDegrees = v_degrees;
+  right_eye->fieldOfView->leftDegrees = h_degrees;
+  right_eye->fieldOfView->rightDegrees = h_degrees;
+
+  left_eye->renderWidth = width;
+  left_eye->renderHeight = height;
+  right_eye->renderWidth = width;
+  right_eye->renderHeight = height;
+
+  return device;
+}
+
+mojom::VRPosePtr ReplayVRDevice::GetPose() {
+  TRACE_EVENT0("input", "ReplayVRDevice::GetPose");
+  const std::vector<ReplaySession::Record>& poses =
+      session_->GetRecords(SESSION_LOG_RECORD_POSE);
+  if (poses.empty())
+    return nullptr;
+
+  switch (mode_) {
+    case Mode::REAL_TIME: {
+      base::TimeTicks now = base::TimeTicks::Now();
+      if (start_time_.is_null())
+        start_time_ = now;
+      double timestamp =
+          session_->start_timestamp() + (now - start_time_).InSecondsF();
+      int index = session_->FindLatest(SESSION_LOG_RECORD_POSE, timestamp);
+      SeekToPose(std::max(index, 0));
+      current_timestamp_ = std::min(timestamp, session_->end_timestamp());
+      break;
+    }
+    case Mode::AS_FAST_AS_POSSIBLE:
+      // The first call returns the first pose.
+      if (!start_time_.is_null())
+        SeekToPose(pose_index_ + 1);
+      start_time_ = base::TimeTicks::Now();
+      break;
+    case Mode::FRAME_STEPPED:
+      break;
+  }
+
+  SessionLogPose log_pose;
+  GetCurrentPose(&log_pose);
+
+  mojom::VRPosePtr pose = mojom::VRPose::New();
+  // The recorded Tango timestamps, so replays are deterministic.
+  pose->timestamp = poses[pose_index_].timestamp * 1000.0;
+  pose->poseIndex = pose_index_;
+  pose->localized = log_pose.localized != 0;
+
+  pose->orientation.emplace(4);
+  pose->position.emplace(3);
+  for (int i = 0; i < 4; i++)
+    pose->orientation.value()[i] = log_pose.orientation[i];
+  for (int i = 0; i < 3; i++)
+    pose->position.value()[i] = log_pose.translation[i];
+
+  return pose;
+}
+
+void ReplayVRDevice::ResetPose() {
+  start_time_ = base::TimeTicks();
+  last_markers_index_.clear();
+  SeekToPose(0);
+}
+
+mojom::VRPointCloudPtr ReplayVRDevice::GetPointCloud(bool justUpdatePointCloud,
+                                                     unsigned pointsToSkip,
+                                                     bool transformPoints) {
+  // Point clouds are read in place, there is nothing to update.
+  if (justUpdatePointCloud)
+    return nullptr;
+
+  mojom::VRPointCloudPtr point_cloud = mojom::VRPointCloud::New();
+  point_cloud->maxNumberOfPoints = session_->max_number_of_points();
+  point_cloud->pointsTransformMatrix.resize(16);
+  point_cloud->pointsAlreadyTransformed = transformPoints;
+  float* matrix = &point_cloud->pointsTransformMatrix[0];
+  memset(matrix, 0, sizeof(float) * 16);
+  matrix[0] = matrix[5] = matrix[10] = matrix[15] = 1;
+
+  int index =
+      session_->FindLatest(SESSION_LOG_RECORD_POINT_CLOUD, current_timestamp_);
+  if (index < 0)
+    return point_cloud;
+
+  const ReplaySession::Record& record =
+      session_->GetRecords(SESSION_LOG_RECORD_POINT_CLOUD)[index];
+  SessionLogPointCloud header =
+      ReadStruct<SessionLogPointCloud>(record.payload);
+  const uint8_t* xyzc = record.payload + sizeof(SessionLogPointCloud);
+  bool transform = transformPoints && header.depthTransformIsValid;
+  if (header.depthTransformIsValid)
+    memcpy(matrix, header.depthTransform, sizeof(header.depthTransform));
+  if (header.numberOfPoints == 0)
+    return point_cloud;
+
+  // The points are written straight into the buffer the displays map.
+  uint64_t size = (header.numberOfPoints + pointsToSkip) / (pointsToSkip + 1) *
+                  3 * sizeof(float);
+  mojo::ScopedSharedBufferHandle buffer =
+      mojo::SharedBufferHandle::Create(size);
+  if (!buffer.is_valid())
+    return nullptr;
+  mojo::ScopedSharedBufferMapping mapping = buffer->Map(size);
+  if (!mapping)
+    return nullptr;
+  float* points = static_cast<float*>(mapping.get());
+
+  uint32_t number_of_points = 0;
+  for (uint32_t i = 0; i < header.numberOfPoints; i += pointsToSkip + 1) {
+    float point[4];
+    memcpy(point, xyzc + i * sizeof(point), sizeof(point));
+    float* out = &points[number_of_points * 3];
+    if (transform) {
+      double transformed[3];
+      TransformPoint(header.depthTransform, point, transformed);
+      out[0] = transformed[0];
+      out[1] = transformed[1];
+      out[2] = transformed[2];
+    } else {
+      out[0] = point[0];
+      out[1] = point[1];
+      out[2] = point[2];
+    }
+    number_of_points++;
+  }
+  point_cloud->numberOfPoints = number_of_points;
+  point_cloud->points = std::move(buffer);
+  return point_cloud;
+}
+
+mojom::VRPassThroughCameraPtr ReplayVRDevice::GetPassThroughCamera() {
+  SessionLogCameraIntrinsics intrinsics;
+  if (!GetCameraIntrinsics(&intrinsics))
+    return nullptr;
+
+  mojom::VRPassThroughCameraPtr camera = mojom::VRPassThroughCamera::New();
+  camera->width = intrinsics.width;
+  camera->height = intrinsics.height;
+  camera->textureWidth = intrinsics.width;
+  camera->textureHeight = intrinsics.height;
+  camera->focalLengthX = intrinsics.fx;
+  camera->focalLengthY = intrinsics.fy;
+  camera->pointX = intrinsics.cx;
+  camera->pointY = intrinsics.cy;
+  camera->orientation = intrinsics.sensorOrientation;
+  return camera;
+}
+
+std::vector<mojom::VRHitPtr> ReplayVRDevice::HitTest(float x, float y) {
+  TRACE_EVENT0("input", "ReplayVRDevice::HitTest");
+  std::vector<mojom::VRHitPtr> hits;
+
+  SessionLogPose pose;
+  SessionLogCameraIntrinsics intrinsics;
+  int index =
+      session_->FindLatest(SESSION_LOG_RECORD_POINT_CLOUD, current_timestamp_);
+  if (index < 0 || !GetCurrentPose(&pose) ||
+      !GetCameraIntrinsics(&intrinsics) || intrinsics.fx <= 0 ||
+      intrinsics.fy <= 0 || intrinsics.width == 0 || intrinsics.height == 0) {
+    return hits;
+  }
+
+  const ReplaySession::Record& record =
+      session_->GetRecords(SESSION_LOG_RECORD_POINT_CLOUD)[index];
+  SessionLogPointCloud header =
+      ReadStruct<SessionLogPointCloud>(record.payload);
+  if (!header.depthTransformIsValid)
+    return hits;
+  const uint8_t* xyzc = record.payload + sizeof(SessionLogPointCloud);
+
+  // The camera looks down -Z with Y up (OpenGL), the image Y axis points
+  // down.
+  double rotation[9];
+  RotationFromQuaternion(pose.orientation, rotation);
+
+  std::vector<double> selected;
+  for (uint32_t i = 0; i < header.numberOfPoints; i++) {
+    float point[4];
+    memcpy(point, xyzc + i * sizeof(point), sizeof(point));
+    double world[3];
+    TransformPoint(header.depthTransform, point, world);
+    double d[3] = {world[0] - pose.translation[0],
+                   world[1] - pose.translation[1],
+                   world[2] - pose.translation[2]};
+    // Transposed rotation: world to camera.
+    double camera[3] = {Dot(&rotation[0], d), Dot(&rotation[3], d),
+                        Dot(&rotation[6], d)};
+    if (camera[2] >= 0)
+      continue;
+    double u = (intrinsics.cx + intrinsics.fx * camera[0] / -camera[2]) /
+               intrinsics.width;
+    double v = (intrinsics.cy - intrinsics.fy * camera[1] / -camera[2]) /
+               intrinsics.height;
+    if ((u - x) * (u - x) + (v - y) * (v - y) >
+        kHitTestRadius * kHitTestRadius) {
+      continue;
+    }
+    selected.insert(selected.end(), world, world + 3);
+  }
+  if (selected.size() / 3 < kHitTestMinNumberOfPoints)
+    return hits;
+
+  double centroid[3];
+  double normal[3];
+  if (!FitPlane(selected, centroid, normal))
+    return hits;
+
+  double camera_ray[3] = {(x * intrinsics.width - intrinsics.cx) / intrinsics.fx,
+                          -(y * intrinsics.height - intrinsics.cy) /
+                              intrinsics.fy,
+                          -1};
+  double ray[3];
+  for (int i = 0; i < 3; i++) {
+    ray[i] = rotation[i] * camera_ray[0] + rotation[3 + i] * camera_ray[1] +
+             rotation[6 + i] * camera_ray[2];
+  }
+  // The normal faces the camera.
+  if (Dot(normal, ray) > 0) {
+    normal[0] = -normal[0];
+    normal[1] = -normal[1];
+    normal[2] = -normal[2];
+  }
+  double denominator = Dot(normal, ray);
+  if (fabs(denominator) < 1e-6)
+    return hits;
+  double to_centroid[3] = {centroid[0] - pose.translation[0],
+                           centroid[1] - pose.translation[1],
+                           centroid[2] - pose.translation[2]};
+  double t = Dot(normal, to_centroid) / denominator;
+  if (t <= 0)
+    return hits;
+  double point[3] = {pose.translation[0] + ray[0] * t,
+                     pose.translation[1] + ray[1] * t,
+                     pose.translation[2] + ray[2] * t};
+
+  mojom::VRHitPtr hit = mojom::VRHit::New();
+  hit->modelMatrix.resize(16);
+  MatrixFromPointAndPlane(point, normal, &hit->modelMatrix[0]);
+  hits.push_back(std::move(hit));
+  return hits;
+}
+
+std::vector<mojom::VRADFPtr> ReplayVRDevice::GetADFs() {
+  return std::vector<mojom::VRADFPtr>();
+}
+
+void ReplayVRDevice::EnableADF(const std::string& uuid,
+                               const base::Callback<void(bool)>& callback) {
+  callback.Run(false);
+}
+
+void ReplayVRDevice::DisableADF(const base::Callback<void(bool)>& callback) {
+  callback.Run(false);
+}
+
+std::vector<mojom::VRMarkerPtr> ReplayVRDevice::GetMarkers(unsigned markerType,
+                                                           float markerSize) {
+  std::vector<mojom::VRMarkerPtr> markers;
+  int32_t type;
+  switch (markerType) {
+    case 0x1:
+      type = kMarkerTypeARTag;
+      break;
+    case 0x2:
+      type = kMarkerTypeQRCode;
+      break;
+    case 0x4:
+      type = kMarkerTypeFiducial;
+      break;
+    default:
+      VLOG(0) << "ERROR: Incorrect marker type value.";
+      return markers;
+  }
+
+  // The marker size was applied when the session was recorded.
+  int index =
+      session_->FindLatest(SESSION_LOG_RECORD_MARKERS, current_timestamp_);
+  std::map<int32_t, int>::iterator last_index =
+      last_markers_index_.find(type);
+  if (index < 0 ||
+      (last_index != last_markers_index_.end() && last_index->second == index))
+    return markers;
+  last_markers_index_[type] = index;
+
+  const ReplaySession::Record& record =
+      session_->GetRecords(SESSION_LOG_RECORD_MARKERS)[index];
+  SessionLogMarkers header = ReadStruct<SessionLogMarkers>(record.payload);
+  const uint8_t* data = record.payload + sizeof(SessionLogMarkers);
+  for (uint32_t i = 0; i < header.numberOfMarkers; i++) {
+    SessionLogMarker marker = ReadStruct<SessionLogMarker>(data);
+    const char* content =
+        reinterpret_cast<const char*>(data + sizeof(SessionLogMarker));
+    data += sizeof(SessionLogMarker) + sessionLogPaddedSize(marker.contentSize);
+    if (marker.type != type)
+      continue;
+
+    mojom::VRMarkerPtr mojom_marker = mojom::VRMarker::New();
+    mojom_marker->type = marker.type;
+    mojom_marker->id = marker.id;
+    mojom_marker->content.assign(content, marker.contentSize);
+    mojom_marker->position.resize(3);
+    for (int j = 0; j < 3; j++)
+      mojom_marker->position[j] = marker.translation[j];
+    mojom_marker->orientation.resize(4);
+    for (int j = 0; j < 4; j++)
+      mojom_marker->orientation[j] = marker.orientation[j];
+    markers.push_back(std::move(mojom_marker));
+  }
+  return markers;
+}
+
+unsigned ReplayVRDevice::CreateAnchor(VRDisplayImpl* display,
+                                      const std::vector<float>& modelMatrix) {
+  return 0;
+}
+
+void ReplayVRDevice::RemoveAnchor(VRDisplayImpl* display, unsigned anchorId) {}
+
+mojom::VRAnchorUpdatesPtr ReplayVRDevice::GetAnchorUpdates(VRDisplayImpl* display) {
+  return mojom::VRAnchorUpdates::New();
+}
+
+void ReplayVRDevice::RequestPresent(
+    const base::Callback<void(bool)>& callback) {
+  callback.Run(false);
+}
+
+void ReplayVRDevice::SetSecureOrigin(bool secure_origin) {}
+
+void ReplayVRDevice::ExitPresent() {}
+
+void ReplayVRDevice::SubmitFrame(mojom::VRPosePtr pose) {}
+
+void ReplayVRDevice::UpdateLayerBounds(mojom::VRLayerBoundsPtr left_bounds,
+                                       mojom::VRLayerBoundsPtr right_bounds) {}
+
+}  // namespace device
@@ -0,0 +1,98 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef DEVICE_VR_REPLAY_REPLAY_VR_DEVICE_H
+#define DEVICE_VR_REPLAY_REPLAY_VR_DEVICE_H
+
+#include <map>
+#include <memory>
+
+#include "base/macros.h"
+#include "base/time/time.h"
+#include "device/vr/vr_device.h"
+#include "device/vr/vr_export.h"
+
+namespace tango_chromium {
+struct SessionLogCameraIntrinsics;
+struct SessionLogPose;
+}
+
+namespace device {
+
+class ReplaySession;
+
+// A VRDevice that serves the poses, point clouds, camera intrinsics and marker
+// results of a session recorded on a Tango device, so the VR stack can be
+// exercised and benchmarked without the hardware.
+class DEVICE_VR_EXPORT ReplayVRDevice : public VRDevice {
+ public:
+  enum class Mode {
+    // The recorded timestamps are followed at the speed of the wall clock,
+    // starting with the first GetPose call.
+    REAL_TIME,
+    // Every GetPose call moves to the next recorded pose, so the session is
+    // played as fast as poses are requested.
+    AS_FAST_AS_POSSIBLE,
+    // Only Step moves to the next recorded pose.
+    FRAME_STEPPED,
+  };
+
+  ReplayVRDevice(std::unique_ptr<ReplaySession> session, Mode mode);
+  ~ReplayVRDevice() override;
+
+  // Moves to the next recorded pose in FRAME_STEPPED mode.
+  void Step();
+  // Whether the last recorded pose has been reached.
+  bool IsAtEnd() const;
+  double current_timestamp() const { return current_timestamp_; }
+
+  // VRDevice
+  mojom::VRDisplayInfoPtr GetVRDevice() override;
+  mojom::VRPosePtr GetPose() override;
+  void ResetPose() override;
+  mojom::VRPointCloudPtr GetPointCloud(bool justUpdatePointCloud,
+                                       unsigned pointsToSkip,
+                                       bool transformPoints) override;
+  mojom::VRPassThroughCameraPtr GetPassThroughCamera() override;
+  std::vector<mojom::VRHitPtr> HitTest(float x, float y) override;
+  std::vector<mojom::VRADFPtr> GetADFs() override;
+  void EnableADF(const std::string& uuid,
+                 const base::Callback<void(bool)>& callback) override;
+  void DisableADF(const base::Callback<void(bool)>& callback) override;
+  std::vector<mojom::VRMarkerPtr> GetMarkers(unsigned markerType,
+                                             float markerSize) override;
+  unsigned CreateAnchor(VRDisplayImpl* display,
+                        const std::vector<float>& modelMatrix) override;
+  void RemoveAnchor(VRDisplayImpl* display, unsigned anchorId) override;
+  mojom::VRAnchorUpdatesPtr GetAnchorUpdates(VRDisplayImpl* display) override;
+
+  void RequestPresent(const base::Callback<void(bool)>& callback) override;
+  void SetSecureOrigin(bool secure_origin) override;
+  void ExitPresent() override;
+  void SubmitFrame(mojom::VRPosePtr pose) override;
+  void UpdateLayerBounds(mojom::VRLayerBoundsPtr left_bounds,
+                         mojom::VRLayerBoundsPtr right_bounds) override;
+
+ private:
+  void SeekToPose(size_t pose_index);
+  bool GetCameraIntrinsics(
+      tango_chromium::SessionLogCameraIntrinsics* intrinsics) const;
+  bool GetCurrentPose(tango_chromium::SessionLogPose* pose) const;
+
+  std::unique_ptr<ReplaySession> session_;
+  Mode mode_;
+
+  size_t pose_index_;
+  double current_timestamp_;
+  base::TimeTicks start_time_;
+  // The markers record last returned by GetMarkers for each marker type. Like
+  // TangoHandler, every detection result is only returned once.
+  std::map<int32_t, int> last_markers_index_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReplayVRDevice);
+};
+
+}  // namespace device
+
+#endif  // DEVICE_VR_REPLAY_REPLAY_VR_DEVICE_H
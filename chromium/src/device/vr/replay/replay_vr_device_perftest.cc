@@ -0,0 +1,89 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "device/vr/replay/replay_vr_device.h"
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "device/vr/replay/replay_session.h"
+#include "device/vr/test/perf_test_util.h"
+#include "device/vr/test/session_log_builder.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace device {
+
+namespace {
+
+// A point cloud of the size of the Tango depth camera ones: a wall 2 meters in
+// front of the camera, with a fixed pattern of noise.
+const int kColumns = 224;
+const int kRows = 172;
+const float kNoise = 0.005f;
+
+class ReplayVRDevicePerfTest : public testing::Test {
+ public:
+  ReplayVRDevicePerfTest() {}
+  ~ReplayVRDevicePerfTest() override {}
+
+  void SetUp() override {
+    float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    std::vector<float> points;
+    points.reserve(kColumns * kRows * 3);
+    uint32_t seed = 1;
+    for (int row = 0; row < kRows; row++) {
+      for (int column = 0; column < kColumns; column++) {
+        seed = seed * 1664525u + 1013904223u;
+        points.push_back((column - kColumns / 2) * 0.01f);
+        points.push_back((row - kRows / 2) * 0.01f);
+        points.push_back(-2 + kNoise * ((seed >> 8) / 16777216.0f - 0.5f));
+      }
+    }
+    builder_.AddCameraIntrinsics(0.5);
+    builder_.AddPose(1.0, 0, 0, 0);
+    builder_.AddPointCloud(1.0, points, identity);
+    builder_.Finish();
+
+    std::unique_ptr<ReplaySession> session = base::MakeUnique<ReplaySession>();
+    ASSERT_TRUE(session->InitializeWithData(builder_.data().data(),
+                                            builder_.data().size()));
+    device_ = base::MakeUnique<ReplayVRDevice>(
+        std::move(session), ReplayVRDevice::Mode::FRAME_STEPPED);
+    device_->GetPose();
+  }
+
+ protected:
+  SessionLogBuilder builder_;
+  std::unique_ptr<ReplayVRDevice> device_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ReplayVRDevicePerfTest);
+};
+
+}  // namespace
+
+TEST_F(ReplayVRDevicePerfTest, GetPointCloud) {
+  const size_t point_cloud_size = kColumns * kRows * 4 * sizeof(float);
+  RunPerfTest("ReplayVRDevice.GetPointCloud", point_cloud_size, [this]() {
+    CHECK(device_->GetPointCloud(false, 0, false));
+  });
+  RunPerfTest("ReplayVRDevice.GetPointCloud.Transform", point_cloud_size,
+              [this]() { CHECK(device_->GetPointCloud(false, 0, true)); });
+  RunPerfTest("ReplayVRDevice.GetPointCloud.Skip3", point_cloud_size / 4,
+              [this]() { CHECK(device_->GetPointCloud(false, 3, false)); });
+}
+
+TEST_F(ReplayVRDevicePerfTest, HitTest) {
+  // Every point of the point cloud is projected to find the ones near the hit.
+  ASSERT_EQ(1u, device_->HitTest(0.5, 0.5).size());
+  RunPerfTest("ReplayVRDevice.HitTest", kColumns * kRows * 4 * sizeof(float),
+              [this]() { CHECK_EQ(1u, device_->HitTest(0.5, 0.5).size()); });
+}
+
+}  // namespace device
@@ -0,0 +1,103 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "device/vr/replay/replay_vr_device_provider.h"
+
+#include <string>
+
+#include "base/bind.h"
+#include "base/command_line.h"
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+#include "device/vr/replay/replay_session.h"
+
+namespace device {
+
+const char ReplayVRDeviceProvider::kSessionSwitch[] = "webvr-replay-session";
+const char ReplayVRDeviceProvider::kModeSwitch[] = "webvr-replay-mode";
+
+// Shared with the worker thread, so the read can complete after the provider
+// is destroyed.
+class ReplayVRDeviceProvider::SessionReader
+    : public base::RefCountedThreadSafe<SessionReader> {
+ public:
+  explicit SessionReader(const base::FilePath& path) : path_(path) {}
+
+  void Read() {
+    session_ = base::MakeUnique<ReplaySession>();
+    // The session logs why it could not be opened.
+    if (!session_->Initialize(path_))
+      session_.reset();
+  }
+
+  std::unique_ptr<ReplaySession> TakeSession() { return std::move(session_); }
+
+ private:
+  friend class base::RefCountedThreadSafe<SessionReader>;
+  ~SessionReader() {}
+
+  const base::FilePath path_;
+  std::unique_ptr<ReplaySession> session_;
+
+  DISALLOW_COPY_AND_ASSIGN(SessionReader);
+};
+
+ReplayVRDeviceProvider::ReplayVRDeviceProvider(const base::FilePath& path,
+                                               ReplayVRDevice::Mode mode)
+    : path_(path), mode_(mode), initialized_(false) {}
+
+ReplayVRDeviceProvider::~ReplayVRDeviceProvider() {}
+
+// static
+std::unique_ptr<ReplayVRDeviceProvider>
+ReplayVRDeviceProvider::CreateFromCommandLine(
+    const base::CommandLine& command_line) {
+  base::FilePath path = command_line.GetSwitchValuePath(kSessionSwitch);
+  if (path.empty())
+    return nullptr;
+
+  ReplayVRDevice::Mode mode = ReplayVRDevice::Mode::REAL_TIME;
+  std::string mode_name = command_line.GetSwitchValueASCII(kModeSwitch);
+  if (mode_name == "fast") {
+    mode = ReplayVRDevice::Mode::AS_FAST_AS_POSSIBLE;
+  } else if (mode_name == "step") {
+    mode = ReplayVRDevice::Mode::FRAME_STEPPED;
+  } else if (!mode_name.empty() && mode_name != "realtime") {
+    LOG(ERROR) << "Unknown --" << kModeSwitch << " value: " << mode_name;
+  }
+  return base::MakeUnique<ReplayVRDeviceProvider>(path, mode);
+}
+
+void ReplayVRDeviceProvider::GetDevices(std::vector<VRDevice*>* devices) {
+  if (replay_device_)
+    devices->push_back(replay_device_.get());
+}
+
+base::Closure ReplayVRDeviceProvider::GetWorkerThreadInitialization() {
+  if (initialized_ || session_reader_)
+    return base::Closure();
+  session_reader_ = new SessionReader(path_);
+  return base::Bind(&SessionReader::Read, session_reader_);
+}
+
+void ReplayVRDeviceProvider::Initialize() {
+  if (initialized_)
+    return;
+  initialized_ = true;
+
+  // Without the worker thread, the session log is read here.
+  if (!session_reader_) {
+    session_reader_ = new SessionReader(path_);
+    session_reader_->Read();
+  }
+
+  std::unique_ptr<ReplaySession> session = session_reader_->TakeSession();
+  session_reader_ = nullptr;
+  if (session) {
+    replay_device_ =
+        base::MakeUnique<ReplayVRDevice>(std::move(session), mode_);
+  }
+}
+
+}  // namespace device
@@ -0,0 +1,60 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef DEVICE_VR_REPLAY_REPLAY_VR_DEVICE_PROVIDER_H
+#define DEVICE_VR_REPLAY_REPLAY_VR_DEVICE_PROVIDER_H
+
+#include <memory>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "device/vr/replay/replay_vr_device.h"
+#include "device/vr/vr_device_provider.h"
+#include "device/vr/vr_export.h"
+
+namespace base {
+class CommandLine;
+}
+
+namespace device {
+
+// Provides a ReplayVRDevice playing the session log passed with
+// --webvr-replay-session=<path>. --webvr-replay-mode selects how it is played:
+// "realtime" (default), "fast" or "step".
+class DEVICE_VR_EXPORT ReplayVRDeviceProvider : public VRDeviceProvider {
+ public:
+  static const char kSessionSwitch[];
+  static const char kModeSwitch[];
+
+  ReplayVRDeviceProvider(const base::FilePath& path,
+                         ReplayVRDevice::Mode mode);
+  ~ReplayVRDeviceProvider() override;
+
+  // Returns nullptr if the command line does not ask for a replay.
+  static std::unique_ptr<ReplayVRDeviceProvider> CreateFromCommandLine(
+      const base::CommandLine& command_line);
+
+  void GetDevices(std::vector<VRDevice*>* devices) override;
+  void Initialize() override;
+  // Reads the session log.
+  base::Closure GetWorkerThreadInitialization() override;
+
+ private:
+  class SessionReader;
+
+  base::FilePath path_;
+  ReplayVRDevice::Mode mode_;
+  bool initialized_;
+  // Reads the session log on the worker thread, until the device takes it
+  // over.
+  scoped_refptr<SessionReader> session_reader_;
+  std::unique_ptr<ReplayVRDevice> replay_device_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReplayVRDeviceProvider);
+};
+
+}  // namespace device
+
+#endif  // DEVICE_VR_REPLAY_REPLAY_VR_DEVICE_PROVIDER_H
@@ -0,0 +1,203 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "device/vr/replay/replay_vr_device.h"
+
+#include <string>
+#include <vector>
+
+#include "base/memory/ptr_util.h"
+#include "device/vr/replay/replay_session.h"
+#include "device/vr/test/session_log_builder.h"
+#include "mojo/public/cpp/system/buffer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace device {
+
+class ReplayVRDeviceTest : public testing::Test {
+ public:
+  ReplayVRDeviceTest() {}
+  ~ReplayVRDeviceTest() override {}
+
+ protected:
+  std::unique_ptr<ReplayVRDevice> CreateDevice(ReplayVRDevice::Mode mode) {
+    std::unique_ptr<ReplaySession> session = base::MakeUnique<ReplaySession>();
+    if (!session->InitializeWithData(builder_.data().data(),
+                                     builder_.data().size())) {
+      return nullptr;
+    }
+    return base::MakeUnique<ReplayVRDevice>(std::move(session), mode);
+  }
+
+  // The points of point_cloud, read from its shared buffer.
+  std::vector<float> MapPoints(const mojom::VRPointCloudPtr& point_cloud) {
+    size_t size = point_cloud->numberOfPoints * 3;
+    if (!point_cloud->points.is_valid())
+      return std::vector<float>();
+    mojo::ScopedSharedBufferMapping mapping =
+        point_cloud->points->Map(size * sizeof(float));
+    const float* points = static_cast<const float*>(mapping.get());
+    return std::vector<float>(points, points + size);
+  }
+
+  SessionLogBuilder builder_;
+};
+
+TEST_F(ReplayVRDeviceTest, RejectsInvalidSessions) {
+  std::vector<uint8_t> data(builder_.data());
+  data[0] = 0;
+  ReplaySession session;
+  EXPECT_FALSE(session.InitializeWithData(data.data(), data.size()));
+
+  // A session without poses cannot be replayed.
+  builder_.AddCameraIntrinsics(1.0);
+  builder_.Finish();
+  EXPECT_FALSE(CreateDevice(ReplayVRDevice::Mode::AS_FAST_AS_POSSIBLE));
+}
+
+TEST_F(ReplayVRDeviceTest, PlaysAsFastAsPossible) {
+  builder_.AddPose(1.0, 1, 0, 0);
+  builder_.AddPose(2.0, 2, 0, 0);
+  builder_.AddPose(3.0, 3, 0, 0);
+  builder_.Finish();
+  std::unique_ptr<ReplayVRDevice> device =
+      CreateDevice(ReplayVRDevice::Mode::AS_FAST_AS_POSSIBLE);
+  ASSERT_TRUE(device);
+
+  for (int i = 1; i <= 3; i++) {
+    mojom::VRPosePtr pose = device->GetPose();
+    ASSERT_TRUE(pose);
+    EXPECT_EQ(i, pose->position.value()[0]);
+    EXPECT_DOUBLE_EQ(i * 1000.0, pose->timestamp);
+  }
+  EXPECT_TRUE(device->IsAtEnd());
+  // The last pose is kept once the end is reached.
+  EXPECT_EQ(3, device->GetPose()->position.value()[0]);
+}
+
+TEST_F(ReplayVRDeviceTest, StepsFrames) {
+  builder_.AddPose(1.0, 1, 0, 0);
+  builder_.AddPose(2.0, 2, 0, 0);
+  // No footer: the chunks are found by walking the file.
+  std::unique_ptr<ReplayVRDevice> device =
+      CreateDevice(ReplayVRDevice::Mode::FRAME_STEPPED);
+  ASSERT_TRUE(device);
+
+  EXPECT_EQ(1, device->GetPose()->position.value()[0]);
+  EXPECT_EQ(1, device->GetPose()->position.value()[0]);
+  device->Step();
+  EXPECT_EQ(2, device->GetPose()->position.value()[0]);
+  EXPECT_TRUE(device->IsAtEnd());
+  device->ResetPose();
+  EXPECT_EQ(1, device->GetPose()->position.value()[0]);
+}
+
+TEST_F(ReplayVRDeviceTest, GetPointCloud) {
+  float depth_transform[16] = {1, 0, 0, 0, 0, 1, 0, 0,
+                               0, 0, 1, 0, 10, 0, 0, 1};
+  builder_.AddPose(1.0, 0, 0, 0);
+  builder_.AddPointCloud(1.0, {1, 2, 3, 4, 5, 6, 7, 8, 9}, depth_transform);
+  builder_.Finish();
+  std::unique_ptr<ReplayVRDevice> device =
+      CreateDevice(ReplayVRDevice::Mode::FRAME_STEPPED);
+  ASSERT_TRUE(device);
+  device->GetPose();
+
+  mojom::VRPointCloudPtr point_cloud = device->GetPointCloud(false, 0, false);
+  ASSERT_TRUE(point_cloud);
+  EXPECT_EQ(3u, point_cloud->numberOfPoints);
+  EXPECT_EQ(3u, point_cloud->maxNumberOfPoints);
+  std::vector<float> points = MapPoints(point_cloud);
+  ASSERT_EQ(9u, points.size());
+  EXPECT_EQ(4, points[3]);
+  EXPECT_EQ(10, point_cloud->pointsTransformMatrix[12]);
+
+  point_cloud = device->GetPointCloud(false, 1, true);
+  ASSERT_TRUE(point_cloud);
+  EXPECT_EQ(2u, point_cloud->numberOfPoints);
+  EXPECT_TRUE(point_cloud->pointsAlreadyTransformed);
+  points = MapPoints(point_cloud);
+  ASSERT_EQ(6u, points.size());
+  EXPECT_EQ(11, points[0]);
+  EXPECT_EQ(17, points[3]);
+
+  EXPECT_FALSE(device->GetPointCloud(true, 0, false));
+}
+
+TEST_F(ReplayVRDeviceTest, HitTestFitsPlane) {
+  float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+  // A wall 2 meters in front of the camera.
+  std::vector<float> points;
+  for (int i = -10; i <= 10; i++) {
+    for (int j = -10; j <= 10; j++) {
+      points.push_back(i * 0.01f);
+      points.push_back(j * 0.01f);
+      points.push_back(-2);
+    }
+  }
+  builder_.AddCameraIntrinsics(0.5);
+  builder_.AddPose(1.0, 0, 0, 0);
+  builder_.AddPointCloud(1.0, points, identity);
+  builder_.Finish();
+  std::unique_ptr<ReplayVRDevice> device =
+      CreateDevice(ReplayVRDevice::Mode::FRAME_STEPPED);
+  ASSERT_TRUE(device);
+  device->GetPose();
+
+  std::vector<mojom::VRHitPtr> hits = device->HitTest(0.5, 0.5);
+  ASSERT_EQ(1u, hits.size());
+  const std::vector<float>& m = hits[0]->modelMatrix;
+  // The Y axis is the normal, facing the camera.
+  EXPECT_NEAR(1, m[6], 1e-4);
+  EXPECT_NEAR(0, m[12], 1e-4);
+  EXPECT_NEAR(0, m[13], 1e-4);
+  EXPECT_NEAR(-2, m[14], 1e-4);
+
+  // Nothing to hit in the corner of the screen.
+  EXPECT_TRUE(device->HitTest(0.05, 0.05).empty());
+}
+
+TEST_F(ReplayVRDeviceTest, GetMarkersAndCamera) {
+  builder_.AddCameraIntrinsics(0.5);
+  builder_.AddPose(1.0, 0, 0, 0);
+  builder_.AddMarker(1.0, 2, "hello");
+  builder_.Finish();
+  std::unique_ptr<ReplayVRDevice> device =
+      CreateDevice(ReplayVRDevice::Mode::FRAME_STEPPED);
+  ASSERT_TRUE(device);
+  device->GetPose();
+
+  mojom::VRPassThroughCameraPtr camera = device->GetPassThroughCamera();
+  ASSERT_TRUE(camera);
+  EXPECT_EQ(640u, camera->width);
+  EXPECT_EQ(90, camera->orientation);
+  EXPECT_TRUE(device->GetVRDevice()->capabilities->hasMarkerSupport);
+
+  EXPECT_TRUE(device->GetMarkers(0x1, 0.1f).empty());
+  std::vector<mojom::VRMarkerPtr> markers = device->GetMarkers(0x2, 0.1f);
+  ASSERT_EQ(1u, markers.size());
+  EXPECT_EQ("hello", markers[0]->content);
+  EXPECT_EQ(7u, markers[0]->id);
+  // Detection results are only returned once.
+  EXPECT_TRUE(device->GetMarkers(0x2, 0.1f).empty());
+}
+
+TEST_F(ReplayVRDeviceTest, GetFiducialMarkers) {
+  builder_.AddPose(1.0, 0, 0, 0);
+  builder_.AddMarker(1.0, 4, "");
+  builder_.Finish();
+  std::unique_ptr<ReplayVRDevice> device =
+      CreateDevice(ReplayVRDevice::Mode::FRAME_STEPPED);
+  ASSERT_TRUE(device);
+  device->GetPose();
+
+  // The fiducials of the native detector are not ARTag markers.
+  EXPECT_TRUE(device->GetMarkers(0x1, 0.1f).empty());
+  std::vector<mojom::VRMarkerPtr> markers = device->GetMarkers(0x4, 0.1f);
+  ASSERT_EQ(1u, markers.size());
+  EXPECT_EQ(4u, markers[0]->type);
+  EXPECT_EQ(7u, markers[0]->id);
+}
+
+}  // namespace device
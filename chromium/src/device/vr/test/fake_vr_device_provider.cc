@@ -27,6 +27,11 @@ void FakeVRDeviceProvider::RemoveDevice(std::unique_ptr<VRDevice> device) {
   }
 }
 
+void FakeVRDeviceProvider::NotifyDeviceChanged(VRDevice* device) {
+  if (client())
+    client()->OnDeviceChanged(device);
+}
+
 void FakeVRDeviceProvider::GetDevices(std::vector<VRDevice*>* devices) {
   for (const auto& device : devices_) {
     devices->push_back(device.get());
@@ -21,6 +21,8 @@ class FakeVRDeviceProvider : public VRDeviceProvider {
   void AddDevice(std::unique_ptr<VRDevice> device);
   void RemoveDevice(std::unique_ptr<VRDevice> device);
   bool IsInitialized() { return initialized_; }
+  // Pushes a device event to the client, as the platform providers do.
+  void NotifyDeviceChanged(VRDevice* device);
 
   void GetDevices(std::vector<VRDevice*>* devices) override;
   void Initialize() override;
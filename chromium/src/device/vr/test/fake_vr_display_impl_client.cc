@@ -9,7 +9,7 @@ namespace device {
 
 FakeVRDisplayImplClient::FakeVRDisplayImplClient(
     mojom::VRDisplayClientRequest request)
-    : m_binding_(this, std::move(request)) {}
+    : frames_available_(0), m_binding_(this, std::move(request)) {}
 
 FakeVRDisplayImplClient::~FakeVRDisplayImplClient() {}
 
@@ -22,4 +22,8 @@ void FakeVRDisplayImplClient::OnChanged(mojom::VRDisplayInfoPtr display) {
   service_client_->SetLastDeviceId(display->index);
 }
 
+void FakeVRDisplayImplClient::OnFrameAvailable() {
+  frames_available_++;
+}
+
 }  // namespace device
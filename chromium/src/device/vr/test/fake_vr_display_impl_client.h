@@ -25,9 +25,13 @@ class FakeVRDisplayImplClient : public mojom::VRDisplayClient {
   void OnFocus() override {}
   void OnActivate(mojom::VRDisplayEventReason reason) override {}
   void OnDeactivate(mojom::VRDisplayEventReason reason) override {}
+  void OnFrameAvailable() override;
+
+  unsigned int frames_available() const { return frames_available_; }
 
  private:
   FakeVRServiceClient* service_client_;
+  unsigned int frames_available_;
   mojom::VRDisplayInfoPtr last_display_;
   mojo::Binding<mojom::VRDisplayClient> m_binding_;
 
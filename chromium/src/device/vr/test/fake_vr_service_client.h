@@ -23,6 +23,9 @@ class FakeVRServiceClient : public mojom::VRServiceClient {
                           mojom::VRDisplayInfoPtr displayInfo) override;
   void SetLastDeviceId(unsigned int id);
   bool CheckDeviceId(unsigned int id);
+  FakeVRDisplayImplClient* display_client(size_t index) {
+    return display_clients_[index];
+  }
 
  private:
   std::vector<mojom::VRDisplayInfoPtr> displays_;
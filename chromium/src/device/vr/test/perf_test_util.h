@@ -0,0 +1,50 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef DEVICE_VR_TEST_PERF_TEST_UTIL_H_
+#define DEVICE_VR_TEST_PERF_TEST_UTIL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "base/time/time.h"
+#include "testing/perf/perf_test.h"
+
+namespace device {
+
+// Runs |operation| in batches of growing size until a batch takes at least
+// |min_time| and prints its time per operation and |bytes_per_operation| as
+// perf results, named |name|.
+template <typename Operation>
+void RunPerfTest(const std::string& name,
+                 size_t bytes_per_operation,
+                 const Operation& operation,
+                 base::TimeDelta min_time = base::TimeDelta::FromSeconds(1)) {
+  // Warm up the caches.
+  operation();
+
+  uint64_t iterations = 1;
+  base::TimeDelta elapsed;
+  while (true) {
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (uint64_t i = 0; i < iterations; i++)
+      operation();
+    elapsed = base::TimeTicks::Now() - start;
+    if (elapsed >= min_time)
+      break;
+    iterations *= elapsed < min_time / 10 ? 10 : 2;
+  }
+
+  perf_test::PrintResult(name, "", "time", elapsed.InSecondsF() * 1e9 / iterations,
+                         "ns/op", true);
+  perf_test::PrintResult(name, "", "size",
+                         static_cast<double>(bytes_per_operation), "bytes/op",
+                         false);
+}
+
+}  // namespace device
+
+#endif  // DEVICE_VR_TEST_PERF_TEST_UTIL_H_
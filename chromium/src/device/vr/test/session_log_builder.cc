@@ -0,0 +1,146 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "device/vr/test/session_log_builder.h"
+
+#include <string.h>
+
+using tango_chromium::SESSION_LOG_CHUNK_MAGIC;
+using tango_chromium::SESSION_LOG_FILE_MAGIC;
+using tango_chromium::SESSION_LOG_FOOTER_MAGIC;
+using tango_chromium::SESSION_LOG_RECORD_CAMERA_INTRINSICS;
+using tango_chromium::SESSION_LOG_RECORD_MARKERS;
+using tango_chromium::SESSION_LOG_RECORD_POINT_CLOUD;
+using tango_chromium::SESSION_LOG_RECORD_POSE;
+using tango_chromium::SESSION_LOG_VERSION;
+using tango_chromium::SessionLogCameraIntrinsics;
+using tango_chromium::SessionLogChunkHeader;
+using tango_chromium::SessionLogFileFooter;
+using tango_chromium::SessionLogFileHeader;
+using tango_chromium::SessionLogIndexEntry;
+using tango_chromium::SessionLogMarker;
+using tango_chromium::SessionLogMarkers;
+using tango_chromium::SessionLogPointCloud;
+using tango_chromium::SessionLogPose;
+using tango_chromium::SessionLogRecordHeader;
+using tango_chromium::sessionLogPaddedSize;
+
+namespace device {
+
+namespace {
+
+template <typename T>
+std::string ToString(const T& value) {
+  return std::string(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+}  // namespace
+
+SessionLogBuilder::SessionLogBuilder() {
+  SessionLogFileHeader header = {SESSION_LOG_FILE_MAGIC, SESSION_LOG_VERSION};
+  Append(&header, sizeof(header));
+}
+
+SessionLogBuilder::~SessionLogBuilder() {}
+
+void SessionLogBuilder::AddRecord(uint32_t type,
+                                  double timestamp,
+                                  const std::string& payload) {
+  SessionLogChunkHeader chunk;
+  memset(&chunk, 0, sizeof(chunk));
+  chunk.magic = SESSION_LOG_CHUNK_MAGIC;
+  chunk.recordCount = 1;
+  chunk.size =
+      sizeof(SessionLogRecordHeader) + sessionLogPaddedSize(payload.size());
+  chunk.firstTimestamp = chunk.lastTimestamp = timestamp;
+
+  SessionLogIndexEntry entry;
+  memset(&entry, 0, sizeof(entry));
+  entry.offset = data_.size();
+  entry.firstTimestamp = entry.lastTimestamp = timestamp;
+  entry.recordCount = 1;
+  entry.recordTypes = 1 << type;
+  index_.push_back(entry);
+
+  SessionLogRecordHeader record = {type, static_cast<uint32_t>(payload.size()),
+                                   timestamp};
+  Append(&chunk, sizeof(chunk));
+  Append(&record, sizeof(record));
+  Append(payload.data(), payload.size());
+  data_.resize(sessionLogPaddedSize(data_.size()));
+}
+
+void SessionLogBuilder::AddPose(double timestamp, double x, double y, double z) {
+  SessionLogPose pose;
+  memset(&pose, 0, sizeof(pose));
+  pose.translation[0] = x;
+  pose.translation[1] = y;
+  pose.translation[2] = z;
+  pose.orientation[3] = 1;
+  AddRecord(SESSION_LOG_RECORD_POSE, timestamp, ToString(pose));
+}
+
+void SessionLogBuilder::AddCameraIntrinsics(double timestamp) {
+  SessionLogCameraIntrinsics intrinsics;
+  memset(&intrinsics, 0, sizeof(intrinsics));
+  intrinsics.width = 640;
+  intrinsics.height = 480;
+  intrinsics.fx = intrinsics.fy = 500;
+  intrinsics.cx = 320;
+  intrinsics.cy = 240;
+  intrinsics.sensorOrientation = 90;
+  AddRecord(SESSION_LOG_RECORD_CAMERA_INTRINSICS, timestamp,
+            ToString(intrinsics));
+}
+
+void SessionLogBuilder::AddPointCloud(double timestamp,
+                                      const std::vector<float>& points,
+                                      const float* depth_transform) {
+  SessionLogPointCloud point_cloud;
+  memset(&point_cloud, 0, sizeof(point_cloud));
+  point_cloud.numberOfPoints = points.size() / 3;
+  if (depth_transform) {
+    memcpy(point_cloud.depthTransform, depth_transform,
+           sizeof(point_cloud.depthTransform));
+    point_cloud.depthTransformIsValid = 1;
+  }
+  std::string payload = ToString(point_cloud);
+  for (size_t i = 0; i < points.size(); i += 3) {
+    float xyzc[4] = {points[i], points[i + 1], points[i + 2], 1};
+    payload.append(reinterpret_cast<const char*>(xyzc), sizeof(xyzc));
+  }
+  AddRecord(SESSION_LOG_RECORD_POINT_CLOUD, timestamp, payload);
+}
+
+void SessionLogBuilder::AddMarker(double timestamp,
+                                  int32_t type,
+                                  const std::string& content) {
+  SessionLogMarkers markers = {1, 0};
+  SessionLogMarker marker;
+  memset(&marker, 0, sizeof(marker));
+  marker.type = type;
+  marker.id = 7;
+  marker.orientation[3] = 1;
+  marker.contentSize = content.size();
+  std::string payload = ToString(markers) + ToString(marker) + content;
+  payload.resize(sizeof(markers) + sizeof(marker) +
+                 sessionLogPaddedSize(content.size()));
+  AddRecord(SESSION_LOG_RECORD_MARKERS, timestamp, payload);
+}
+
+void SessionLogBuilder::Finish() {
+  SessionLogFileFooter footer;
+  footer.indexOffset = data_.size();
+  footer.indexEntryCount = index_.size();
+  footer.magic = SESSION_LOG_FOOTER_MAGIC;
+  Append(index_.data(), index_.size() * sizeof(SessionLogIndexEntry));
+  Append(&footer, sizeof(footer));
+}
+
+void SessionLogBuilder::Append(const void* data, size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  data_.insert(data_.end(), bytes, bytes + size);
+}
+
+}  // namespace device
@@ -0,0 +1,49 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef DEVICE_VR_TEST_SESSION_LOG_BUILDER_H_
+#define DEVICE_VR_TEST_SESSION_LOG_BUILDER_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "SessionLogFormat.h"
+#include "base/macros.h"
+
+namespace device {
+
+// Writes a session log in memory, one chunk per record, for the tests and the
+// benchmarks of the ReplayVRDevice.
+class SessionLogBuilder {
+ public:
+  SessionLogBuilder();
+  ~SessionLogBuilder();
+
+  void AddRecord(uint32_t type, double timestamp, const std::string& payload);
+  void AddPose(double timestamp, double x, double y, double z);
+  void AddCameraIntrinsics(double timestamp);
+  // |points| are x, y, z triplets, |depth_transform| may be null.
+  void AddPointCloud(double timestamp,
+                     const std::vector<float>& points,
+                     const float* depth_transform);
+  void AddMarker(double timestamp, int32_t type, const std::string& content);
+  // Writes the index and the footer, like a recording stopped cleanly.
+  void Finish();
+
+  const std::vector<uint8_t>& data() const { return data_; }
+
+ private:
+  void Append(const void* data, size_t size);
+
+  std::vector<uint8_t> data_;
+  std::vector<tango_chromium::SessionLogIndexEntry> index_;
+
+  DISALLOW_COPY_AND_ASSIGN(SessionLogBuilder);
+};
+
+}  // namespace device
+
+#endif  // DEVICE_VR_TEST_SESSION_LOG_BUILDER_H_
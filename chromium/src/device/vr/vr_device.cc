@@ -24,6 +24,14 @@ void VRDevice::RequestPresent(const base::Callback<void(bool)>& callback) {
 
 void VRDevice::SetSecureOrigin(bool secure_origin) {}
 
+std::vector<mojom::VRLatencyStatsPtr> VRDevice::GetPerformanceStats() {
+  return std::vector<mojom::VRLatencyStatsPtr>();
+}
+
+void VRDevice::RequestFrameAvailable(VRDisplayImpl* display) {
+  frame_available_displays_.insert(display);
+}
+
 void VRDevice::AddDisplay(VRDisplayImpl* display) {
   displays_.insert(display);
 }
@@ -32,6 +40,7 @@ void VRDevice::RemoveDisplay(VRDisplayImpl* display) {
   if (CheckPresentingDisplay(display))
     ExitPresent();
   displays_.erase(display);
+  frame_available_displays_.erase(display);
 }
 
 bool VRDevice::IsAccessAllowed(VRDisplayImpl* display) {
@@ -79,6 +88,13 @@ void VRDevice::OnDeactivate(mojom::VRDisplayEventReason reason) {
     display->client()->OnDeactivate(reason);
 }
 
+void VRDevice::OnFrameAvailable() {
+  std::set<VRDisplayImpl*> displays;
+  displays.swap(frame_available_displays_);
+  for (const auto& display : displays)
+    display->client()->OnFrameAvailable();
+}
+
 void VRDevice::SetPresentingDisplay(VRDisplayImpl* display) {
   presenting_display_ = display;
 }
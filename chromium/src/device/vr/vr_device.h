@@ -30,9 +30,22 @@ class DEVICE_VR_EXPORT VRDevice {
   virtual mojom::VRPassThroughCameraPtr GetPassThroughCamera() = 0;
   virtual std::vector<mojom::VRHitPtr> HitTest(float x, float y) = 0;
   virtual std::vector<mojom::VRADFPtr> GetADFs() = 0;
-  virtual void EnableADF(const std::string& uuid) = 0;
-  virtual void DisableADF() = 0;
+  virtual void EnableADF(const std::string& uuid,
+                         const base::Callback<void(bool)>& callback) = 0;
+  virtual void DisableADF(const base::Callback<void(bool)>& callback) = 0;
   virtual std::vector<mojom::VRMarkerPtr> GetMarkers(unsigned markerType, float markerSize) = 0;
+  // Anchors belong to the display that created them: the other displays can
+  // not remove them or get their updates.
+  virtual unsigned CreateAnchor(VRDisplayImpl* display,
+                                const std::vector<float>& modelMatrix) = 0;
+  virtual void RemoveAnchor(VRDisplayImpl* display, unsigned anchorId) = 0;
+  virtual mojom::VRAnchorUpdatesPtr GetAnchorUpdates(VRDisplayImpl* display) = 0;
+  // The latencies measured by the device, none by default.
+  virtual std::vector<mojom::VRLatencyStatsPtr> GetPerformanceStats();
+  // The display gets a single OnFrameAvailable on the next call to
+  // OnFrameAvailable, which the devices make when they have new sensor data,
+  // e.g. a camera frame. Only devices with hasFrameAvailableEvents do.
+  virtual void RequestFrameAvailable(VRDisplayImpl* display);
 
   virtual void RequestPresent(const base::Callback<void(bool)>& callback) = 0;
   virtual void SetSecureOrigin(bool secure_origin) = 0;
@@ -53,6 +66,7 @@ class DEVICE_VR_EXPORT VRDevice {
   virtual void OnFocus();
   virtual void OnActivate(mojom::VRDisplayEventReason reason);
   virtual void OnDeactivate(mojom::VRDisplayEventReason reason);
+  virtual void OnFrameAvailable();
 
  protected:
   friend class VRDisplayImpl;
@@ -62,6 +76,8 @@ class DEVICE_VR_EXPORT VRDevice {
 
  private:
   std::set<VRDisplayImpl*> displays_;
+  // The displays waiting for OnFrameAvailable.
+  std::set<VRDisplayImpl*> frame_available_displays_;
 
   VRDisplayImpl* presenting_display_;
 
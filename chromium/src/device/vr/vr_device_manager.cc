@@ -7,8 +7,12 @@
 #include <utility>
 
 #include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/location.h"
 #include "base/memory/ptr_util.h"
 #include "base/memory/singleton.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/threading/worker_pool.h"
 #include "build/build_config.h"
 
 #if defined(OS_ANDROID)
@@ -16,6 +20,11 @@
 #include "device/vr/android/tango/tango_vr_device_provider.h"
 #endif
 
+#if defined(ENABLE_VR_REPLAY)
+#include "base/command_line.h"
+#include "device/vr/replay/replay_vr_device_provider.h"
+#endif
+
 namespace device {
 
 namespace {
@@ -25,17 +34,31 @@ VRDeviceManager* g_vr_device_manager = nullptr;
 VRDeviceManager::VRDeviceManager()
     : vr_initialized_(false),
       keep_alive_(false),
-      has_scheduled_poll_(false),
-      has_activate_listeners_(false) {
+      has_activate_listeners_(false),
+      worker_task_runner_(base::WorkerPool::GetTaskRunner(true)),
+      weak_ptr_factory_(this) {
 // Register VRDeviceProviders for the current platform
 #if defined(OS_ANDROID)
   RegisterProvider(base::MakeUnique<GvrDeviceProvider>());
   RegisterProvider(base::MakeUnique<TangoVRDeviceProvider>());
 #endif
+#if defined(ENABLE_VR_REPLAY)
+  std::unique_ptr<ReplayVRDeviceProvider> replay_provider =
+      ReplayVRDeviceProvider::CreateFromCommandLine(
+          *base::CommandLine::ForCurrentProcess());
+  if (replay_provider)
+    RegisterProvider(std::move(replay_provider));
+#endif
 }
 
 VRDeviceManager::VRDeviceManager(std::unique_ptr<VRDeviceProvider> provider)
-    : vr_initialized_(false), keep_alive_(true), has_scheduled_poll_(false) {
+    : vr_initialized_(false),
+      keep_alive_(true),
+      has_activate_listeners_(false),
+      // The providers are initialized on the thread of the test, so
+      // RunUntilIdle completes their initialization.
+      worker_task_runner_(base::ThreadTaskRunnerHandle::Get()),
+      weak_ptr_factory_(this) {
   thread_checker_.DetachFromThread();
   RegisterProvider(std::move(provider));
   SetInstance(this);
@@ -43,7 +66,6 @@ VRDeviceManager::VRDeviceManager(std::unique_ptr<VRDeviceProvider> provider)
 
 VRDeviceManager::~VRDeviceManager() {
   DCHECK(thread_checker_.CalledOnValidThread());
-  StopSchedulingPollEvents();
   g_vr_device_manager = nullptr;
 }
 
@@ -69,10 +91,13 @@ bool VRDeviceManager::HasInstance() {
 void VRDeviceManager::AddService(VRServiceImpl* service) {
   // Loop through any currently active devices and send Connected messages to
   // the service. Future devices that come online will send a Connected message
-  // when they are created.
+  // when their provider is initialized or notifies them.
   GetVRDevices(service);
 
   services_.insert(service);
+
+  if (AreDevicesReady())
+    service->OnDevicesReady(GetNumberOfConnectedDevices());
 }
 
 void VRDeviceManager::RemoveService(VRServiceImpl* service) {
@@ -83,8 +108,9 @@ void VRDeviceManager::RemoveService(VRServiceImpl* service) {
 
   services_.erase(service);
 
-  if (services_.empty() && !keep_alive_) {
-    // Delete the device manager when it has no active connections.
+  if (services_.empty() && !keep_alive_ && initializing_providers_.empty()) {
+    // Delete the device manager when it has no active connections. The
+    // providers still initializing use it until they complete.
     delete g_vr_device_manager;
   }
 }
@@ -95,8 +121,10 @@ bool VRDeviceManager::GetVRDevices(VRServiceImpl* service) {
   InitializeProviders();
 
   std::vector<VRDevice*> devices;
-  for (const auto& provider : providers_)
-    provider->GetDevices(&devices);
+  for (const auto& provider : providers_) {
+    if (!initializing_providers_.count(provider.get()))
+      provider->GetDevices(&devices);
+  }
 
   if (devices.empty())
     return false;
@@ -144,6 +172,36 @@ void VRDeviceManager::ListeningForActivateChanged(bool listening) {
   }
 }
 
+void VRDeviceManager::OnDeviceChanged(VRDevice* device) {
+  DCHECK(thread_checker_.CalledOnValidThread());
+
+  if (device->id() == VR_DEVICE_LAST_ID)
+    return;
+
+  AddDevice(device);
+  device->OnChanged();
+}
+
+void VRDeviceManager::AddDevice(VRDevice* device) {
+  if (device->id() == VR_DEVICE_LAST_ID ||
+      devices_.find(device->id()) != devices_.end()) {
+    return;
+  }
+
+  // A device that comes online after the services got the list of devices is
+  // attached to all of them, which sends them a Connected message.
+  devices_[device->id()] = device;
+  for (auto* service : services_)
+    device->AddDisplay(service->GetVRDisplayImpl(device));
+}
+
+bool VRDeviceManager::AreDevicesReady() const {
+  // Waiting for the slower providers would delay navigator.getVRDisplays(),
+  // their devices are announced when they are ready.
+  return vr_initialized_ &&
+         (!devices_.empty() || initializing_providers_.empty());
+}
+
 VRDevice* VRDeviceManager::GetDevice(unsigned int index) {
   DCHECK(thread_checker_.CalledOnValidThread());
 
@@ -163,36 +221,48 @@ void VRDeviceManager::InitializeProviders() {
     return;
   }
 
+  vr_initialized_ = true;
+
+  // The worker thread initializations do not use the providers. The providers
+  // are owned by the manager, so they are alive when the reply runs.
   for (const auto& provider : providers_) {
-    provider->Initialize();
+    base::Closure initialization = provider->GetWorkerThreadInitialization();
+    if (initialization.is_null())
+      initialization = base::Bind(&base::DoNothing);
+    initializing_providers_.insert(provider.get());
+    worker_task_runner_->PostTaskAndReply(
+        FROM_HERE, initialization,
+        base::Bind(&VRDeviceManager::OnProviderInitialized,
+                   weak_ptr_factory_.GetWeakPtr(), provider.get()));
   }
-
-  vr_initialized_ = true;
 }
 
-void VRDeviceManager::RegisterProvider(
-    std::unique_ptr<VRDeviceProvider> provider) {
-  providers_.push_back(std::move(provider));
-}
+void VRDeviceManager::OnProviderInitialized(VRDeviceProvider* provider) {
+  DCHECK(thread_checker_.CalledOnValidThread());
 
-void VRDeviceManager::SchedulePollEvents() {
-  if (has_scheduled_poll_)
-    return;
+  provider->Initialize();
+  initializing_providers_.erase(provider);
 
-  has_scheduled_poll_ = true;
+  std::vector<VRDevice*> devices;
+  provider->GetDevices(&devices);
+  for (auto* device : devices)
+    AddDevice(device);
 
-  timer_.Start(FROM_HERE, base::TimeDelta::FromMilliseconds(500), this,
-               &VRDeviceManager::PollEvents);
-}
+  if (AreDevicesReady()) {
+    for (auto* service : services_)
+      service->OnDevicesReady(GetNumberOfConnectedDevices());
+  }
 
-void VRDeviceManager::PollEvents() {
-  for (const auto& provider : providers_)
-    provider->PollEvents();
+  if (services_.empty() && !keep_alive_ && initializing_providers_.empty()) {
+    // The last services went away during the initialization.
+    delete g_vr_device_manager;
+  }
 }
 
-void VRDeviceManager::StopSchedulingPollEvents() {
-  if (has_scheduled_poll_)
-    timer_.Stop();
+void VRDeviceManager::RegisterProvider(
+    std::unique_ptr<VRDeviceProvider> provider) {
+  provider->set_client(this);
+  providers_.push_back(std::move(provider));
 }
 
 }  // namespace device
@@ -9,12 +9,13 @@
 
 #include <map>
 #include <memory>
+#include <set>
 #include <vector>
 
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
 #include "base/threading/thread_checker.h"
-#include "base/timer/timer.h"
 #include "device/vr/vr_device.h"
 #include "device/vr/vr_device_provider.h"
 #include "device/vr/vr_export.h"
@@ -22,17 +23,23 @@
 #include "device/vr/vr_service_impl.h"
 #include "mojo/public/cpp/bindings/binding_set.h"
 
+namespace base {
+class TaskRunner;
+}
+
 namespace device {
 
-class VRDeviceManager {
+class VRDeviceManager : public VRDeviceProvider::Client {
  public:
-  DEVICE_VR_EXPORT virtual ~VRDeviceManager();
+  DEVICE_VR_EXPORT ~VRDeviceManager() override;
 
   // Returns the VRDeviceManager singleton.
   static VRDeviceManager* GetInstance();
 
   // Adds a listener for device manager events. VRDeviceManager does not own
-  // this object.
+  // this object. The service is told how many devices are connected once the
+  // first device is ready, or once all the providers are initialized if there
+  // is none.
   void AddService(VRServiceImpl* service);
   void RemoveService(VRServiceImpl* service);
 
@@ -41,6 +48,9 @@ class VRDeviceManager {
 
   void ListeningForActivateChanged(bool listening);
 
+  // VRDeviceProvider::Client
+  DEVICE_VR_EXPORT void OnDeviceChanged(VRDevice* device) override;
+
  private:
   friend class VRDeviceManagerTest;
   friend class VRDisplayImplTest;
@@ -56,12 +66,16 @@ class VRDeviceManager {
   static void SetInstance(VRDeviceManager* service);
   static bool HasInstance();
 
+  // Starts the initialization of the providers, concurrently on
+  // |worker_task_runner_|. Their devices are announced to the services as each
+  // of them completes.
   void InitializeProviders();
+  void OnProviderInitialized(VRDeviceProvider* provider);
   void RegisterProvider(std::unique_ptr<VRDeviceProvider> provider);
 
-  void SchedulePollEvents();
-  void PollEvents();
-  void StopSchedulingPollEvents();
+  // Attaches a new device to all the services.
+  void AddDevice(VRDevice* device);
+  bool AreDevicesReady() const;
 
   using ProviderList = std::vector<std::unique_ptr<VRDeviceProvider>>;
   ProviderList providers_;
@@ -77,13 +91,17 @@ class VRDeviceManager {
   // For testing. If true will not delete self when consumer count reaches 0.
   bool keep_alive_;
 
-  bool has_scheduled_poll_;
-
   bool has_activate_listeners_;
 
   base::ThreadChecker thread_checker_;
 
-  base::RepeatingTimer timer_;
+  scoped_refptr<base::TaskRunner> worker_task_runner_;
+
+  // The providers whose initialization has not completed yet. Their devices
+  // are not used and the manager is not deleted until they complete.
+  std::set<VRDeviceProvider*> initializing_providers_;
+
+  base::WeakPtrFactory<VRDeviceManager> weak_ptr_factory_;
 
   DISALLOW_COPY_AND_ASSIGN(VRDeviceManager);
 };
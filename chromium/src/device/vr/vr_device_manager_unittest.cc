@@ -24,7 +24,9 @@ namespace device {
 
 class VRDeviceManagerTest : public testing::Test {
  public:
-  void onDisplaySynced(unsigned int number_of_devices) {}
+  void onDisplaySynced(unsigned int number_of_devices) {
+    number_of_synced_devices_ = number_of_devices;
+  }
 
  protected:
   VRDeviceManagerTest();
@@ -40,10 +42,15 @@ class VRDeviceManagerTest : public testing::Test {
     return device_manager_->GetDevice(index);
   }
 
+  bool HasDisplay(VRServiceImpl* service, VRDevice* device) {
+    return service->displays_.find(device) != service->displays_.end();
+  }
+
  protected:
   base::MessageLoop message_loop_;
   FakeVRDeviceProvider* provider_ = nullptr;
   std::unique_ptr<VRDeviceManager> device_manager_;
+  int number_of_synced_devices_ = -1;
 
   DISALLOW_COPY_AND_ASSIGN(VRDeviceManagerTest);
 };
@@ -74,17 +81,40 @@ TEST_F(VRDeviceManagerTest, InitializationTest) {
   // initialized yet or the providesr have been released.
   // The mojom::VRService should initialize each of it's providers upon it's own
   // initialization. And SetClient method in VRService class will invoke
-  // GetVRDevices too.
+  // GetVRDevices too. The providers are initialized asynchronously.
   auto service = BindService();
   device_manager_->GetVRDevices(service.get());
+  EXPECT_FALSE(provider_->IsInitialized());
+  base::RunLoop().RunUntilIdle();
   EXPECT_TRUE(provider_->IsInitialized());
 }
 
+TEST_F(VRDeviceManagerTest, DevicesReadyTest) {
+  FakeVRDevice* device = new FakeVRDevice();
+  provider_->AddDevice(base::WrapUnique(device));
+
+  // SetClient completes once the provider is initialized, after the device
+  // has been attached to the service.
+  auto service = BindService();
+  EXPECT_EQ(-1, number_of_synced_devices_);
+  EXPECT_FALSE(HasDisplay(service.get(), device));
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(1, number_of_synced_devices_);
+  EXPECT_TRUE(HasDisplay(service.get(), device));
+
+  // Once the devices are ready, it completes right away.
+  number_of_synced_devices_ = -1;
+  auto service_2 = BindService();
+  EXPECT_EQ(1, number_of_synced_devices_);
+  EXPECT_TRUE(HasDisplay(service_2.get(), device));
+}
+
 TEST_F(VRDeviceManagerTest, GetDevicesBasicTest) {
   auto service = BindService();
 
   bool success = device_manager_->GetVRDevices(service.get());
   // Calling GetVRDevices should initialize the providers.
+  base::RunLoop().RunUntilIdle();
   EXPECT_TRUE(provider_->IsInitialized());
   EXPECT_FALSE(success);
 
@@ -109,4 +139,24 @@ TEST_F(VRDeviceManagerTest, GetDevicesBasicTest) {
   EXPECT_EQ(device2, GetDevice(device2->id()));
 }
 
+TEST_F(VRDeviceManagerTest, DeviceChangedTest) {
+  auto service = BindService();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(0u, device_manager_->GetNumberOfConnectedDevices());
+
+  // A device the provider notifies after the service got the list of devices
+  // is attached to the service right away, without polling.
+  FakeVRDevice* device = new FakeVRDevice();
+  provider_->AddDevice(base::WrapUnique(device));
+  EXPECT_EQ(nullptr, GetDevice(device->id()));
+  provider_->NotifyDeviceChanged(device);
+  EXPECT_EQ(device, GetDevice(device->id()));
+  EXPECT_TRUE(HasDisplay(service.get(), device));
+
+  // Later notifications do not attach it again.
+  provider_->NotifyDeviceChanged(device);
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(1u, device_manager_->GetNumberOfConnectedDevices());
+}
+
 }  // namespace device
@@ -7,23 +7,53 @@
 
 #include <vector>
 
+#include "base/callback.h"
+
 namespace device {
 
 class VRDevice;
 
 class VRDeviceProvider {
  public:
-  VRDeviceProvider() {}
+  // Receives the events of the devices of a provider as they happen, on the
+  // thread the provider was initialized on.
+  class Client {
+   public:
+    virtual ~Client() {}
+
+    // The device was added, or its connection or its display info (for
+    // example after a rotation) changed.
+    virtual void OnDeviceChanged(VRDevice* device) = 0;
+  };
+
+  VRDeviceProvider() : client_(nullptr) {}
   virtual ~VRDeviceProvider() {}
 
+  // The client is not owned and must outlive the provider.
+  void set_client(Client* client) { client_ = client; }
+
   virtual void GetDevices(std::vector<VRDevice*>* devices) = 0;
 
-  // If the VR API requires initialization that should happen here.
+  // If the VR API requires initialization that should happen here. It runs on
+  // the thread of the VRDeviceManager, as do the constructors of the devices.
   virtual void Initialize() = 0;
 
-  virtual void PollEvents() {}
+  // Initialization that blocks, such as reading files, should be done by the
+  // returned closure instead, if not null. It runs on a worker thread,
+  // concurrently with the other providers, before Initialize. The provider may
+  // be destroyed while it runs, so it must own or share (e.g. with a
+  // refcounted object) the state it uses rather than use the provider.
+  virtual base::Closure GetWorkerThreadInitialization() {
+    return base::Closure();
+  }
 
   virtual void SetListeningForActivate(bool listening) {}
+
+ protected:
+  Client* client() const { return client_; }
+
+ private:
+  Client* client_;
 };
 
 }  // namespace device
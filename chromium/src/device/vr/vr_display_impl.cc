@@ -80,12 +80,23 @@ void VRDisplayImpl::GetADFs(const GetADFsCallback& callback) {
   callback.Run(device_->GetADFs());
 }
 
-void VRDisplayImpl::EnableADF(const std::string& uuid) {
-  device_->EnableADF(uuid);
+void VRDisplayImpl::EnableADF(const std::string& uuid,
+                              const EnableADFCallback& callback) {
+  if (!device_->IsAccessAllowed(this)) {
+    callback.Run(false);
+    return;
+  }
+
+  device_->EnableADF(uuid, callback);
 }
 
-void VRDisplayImpl::DisableADF() {
-  device_->DisableADF();
+void VRDisplayImpl::DisableADF(const DisableADFCallback& callback) {
+  if (!device_->IsAccessAllowed(this)) {
+    callback.Run(false);
+    return;
+  }
+
+  device_->DisableADF(callback);
 }
 
 void VRDisplayImpl::GetMarkers(unsigned markerType, float markerSize, const GetMarkersCallback& callback) {
@@ -97,6 +108,43 @@ void VRDisplayImpl::GetMarkers(unsigned markerType, float markerSize, const GetM
   callback.Run(device_->GetMarkers(markerType, markerSize));
 }
 
+void VRDisplayImpl::CreateAnchor(const std::vector<float>& modelMatrix, const CreateAnchorCallback& callback) {
+  if (!device_->IsAccessAllowed(this)) {
+    callback.Run(0);
+    return;
+  }
+
+  callback.Run(device_->CreateAnchor(this, modelMatrix));
+}
+
+void VRDisplayImpl::RemoveAnchor(unsigned anchorId) {
+  if (!device_->IsAccessAllowed(this))
+    return;
+
+  device_->RemoveAnchor(this, anchorId);
+}
+
+void VRDisplayImpl::GetAnchorUpdates(const GetAnchorUpdatesCallback& callback) {
+  if (!device_->IsAccessAllowed(this)) {
+    callback.Run(mojom::VRAnchorUpdates::New());
+    return;
+  }
+
+  callback.Run(device_->GetAnchorUpdates(this));
+}
+
+void VRDisplayImpl::GetPerformanceStats(
+    const GetPerformanceStatsCallback& callback) {
+  callback.Run(device_->GetPerformanceStats());
+}
+
+void VRDisplayImpl::RequestFrameAvailable() {
+  if (!device_->IsAccessAllowed(this))
+    return;
+
+  device_->RequestFrameAvailable(this);
+}
+
 void VRDisplayImpl::RequestPresent(bool secure_origin,
                                    const RequestPresentCallback& callback) {
   if (!device_->IsAccessAllowed(this)) {
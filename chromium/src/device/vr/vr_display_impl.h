@@ -36,9 +36,15 @@ class VRDisplayImpl : public mojom::VRDisplay {
   void HitTest(float x, float y, const HitTestCallback& callback) override;
   void GetPassThroughCamera(const GetPassThroughCameraCallback& callback) override;
   void GetADFs(const GetADFsCallback& callback) override;
-  void EnableADF(const std::string& uuid) override;
-  void DisableADF() override;
+  void EnableADF(const std::string& uuid,
+                 const EnableADFCallback& callback) override;
+  void DisableADF(const DisableADFCallback& callback) override;
   void GetMarkers(unsigned markerType, float markerSize, const GetMarkersCallback& callback) override;
+  void CreateAnchor(const std::vector<float>& modelMatrix, const CreateAnchorCallback& callback) override;
+  void RemoveAnchor(unsigned anchorId) override;
+  void GetAnchorUpdates(const GetAnchorUpdatesCallback& callback) override;
+  void GetPerformanceStats(const GetPerformanceStatsCallback& callback) override;
+  void RequestFrameAvailable() override;
 
   void RequestPresent(bool secure_origin,
                       const RequestPresentCallback& callback) override;
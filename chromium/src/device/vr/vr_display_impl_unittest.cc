@@ -114,6 +114,8 @@ TEST_F(VRDisplayImplTest, DevicePresentationIsolation) {
 TEST_F(VRDisplayImplTest, DeviceChangedDispatched) {
   auto service_1 = BindService();
   auto service_2 = BindService();
+  // Attaches the device to the services once the provider is initialized.
+  base::RunLoop().RunUntilIdle();
 
   device()->OnChanged();
 
@@ -122,4 +124,29 @@ TEST_F(VRDisplayImplTest, DeviceChangedDispatched) {
   for (auto client : clients_)
     EXPECT_TRUE(client->CheckDeviceId(device()->id()));
 }
+
+// Only the displays that requested a frame get OnFrameAvailable, once however
+// many times they requested it and the device had new data.
+TEST_F(VRDisplayImplTest, FrameAvailableIsCoalesced) {
+  auto service_1 = BindService();
+  auto service_2 = BindService();
+  base::RunLoop().RunUntilIdle();
+
+  VRDisplayImpl* display_1 = service_1->GetVRDisplayImpl(device());
+  display_1->RequestFrameAvailable();
+  display_1->RequestFrameAvailable();
+  device()->OnFrameAvailable();
+  device()->OnFrameAvailable();
+  base::RunLoop().RunUntilIdle();
+
+  FakeVRDisplayImplClient* client_1 = clients_[0]->display_client(0);
+  FakeVRDisplayImplClient* client_2 = clients_[1]->display_client(0);
+  EXPECT_EQ(1u, client_1->frames_available());
+  EXPECT_EQ(0u, client_2->frames_available());
+
+  display_1->RequestFrameAvailable();
+  device()->OnFrameAvailable();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(2u, client_1->frames_available());
+}
 }
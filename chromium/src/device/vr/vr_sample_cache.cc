@@ -0,0 +1,101 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "device/vr/vr_sample_cache.h"
+
+#include "mojo/public/cpp/system/buffer.h"
+
+namespace device {
+
+namespace {
+
+// The sensor timestamp the sample was acquired for, which is sensor_timestamp
+// for the samples without timing.
+double GetCacheKey(double sensor_timestamp,
+                   const mojom::VRSampleTimingPtr& timing) {
+  if (sensor_timestamp == 0 || !timing)
+    return sensor_timestamp;
+  return timing->sensorTimestamp;
+}
+
+// Structs with handles cannot be cloned. The points are shared by duplicating
+// the handle of their buffer, only the other fields are copied.
+mojom::VRPointCloudPtr SharePointCloud(
+    const mojom::VRPointCloudPtr& point_cloud) {
+  mojom::VRPointCloudPtr shared = mojom::VRPointCloud::New();
+  shared->numberOfPoints = point_cloud->numberOfPoints;
+  shared->maxNumberOfPoints = point_cloud->maxNumberOfPoints;
+  if (point_cloud->points.is_valid())
+    shared->points = point_cloud->points->Clone();
+  shared->pointsTransformMatrix = point_cloud->pointsTransformMatrix;
+  shared->pointsAlreadyTransformed = point_cloud->pointsAlreadyTransformed;
+  shared->timing = point_cloud->timing.Clone();
+  return shared;
+}
+
+}  // namespace
+
+VRSampleCache::VRSampleCache()
+    : pose_timestamp_(0),
+      point_cloud_timestamp_(0),
+      point_cloud_points_to_skip_(0),
+      point_cloud_transform_points_(false),
+      hits_(0),
+      misses_(0) {}
+
+VRSampleCache::~VRSampleCache() {}
+
+mojom::VRPosePtr VRSampleCache::GetPose(double sensor_timestamp,
+                                        const AcquirePoseCallback& acquire) {
+  if (sensor_timestamp != 0 && pose_ && sensor_timestamp == pose_timestamp_) {
+    hits_++;
+    return pose_.Clone();
+  }
+
+  misses_++;
+  mojom::VRPosePtr pose = acquire.Run();
+  double key = pose ? GetCacheKey(sensor_timestamp, pose->timing) : 0;
+  if (key != 0) {
+    pose_ = pose.Clone();
+    pose_timestamp_ = key;
+  } else {
+    pose_ = nullptr;
+  }
+  return pose;
+}
+
+mojom::VRPointCloudPtr VRSampleCache::GetPointCloud(
+    double sensor_timestamp,
+    unsigned points_to_skip,
+    bool transform_points,
+    const AcquirePointCloudCallback& acquire) {
+  if (sensor_timestamp != 0 && point_cloud_ &&
+      sensor_timestamp == point_cloud_timestamp_ &&
+      points_to_skip == point_cloud_points_to_skip_ &&
+      transform_points == point_cloud_transform_points_) {
+    hits_++;
+    return SharePointCloud(point_cloud_);
+  }
+
+  misses_++;
+  mojom::VRPointCloudPtr point_cloud = acquire.Run();
+  double key =
+      point_cloud ? GetCacheKey(sensor_timestamp, point_cloud->timing) : 0;
+  if (key != 0) {
+    point_cloud_ = SharePointCloud(point_cloud);
+    point_cloud_timestamp_ = key;
+    point_cloud_points_to_skip_ = points_to_skip;
+    point_cloud_transform_points_ = transform_points;
+  } else {
+    point_cloud_ = nullptr;
+  }
+  return point_cloud;
+}
+
+void VRSampleCache::Clear() {
+  pose_ = nullptr;
+  point_cloud_ = nullptr;
+}
+
+}  // namespace device
@@ -0,0 +1,69 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef DEVICE_VR_VR_SAMPLE_CACHE_H
+#define DEVICE_VR_VR_SAMPLE_CACHE_H
+
+#include "base/callback.h"
+#include "base/macros.h"
+#include "device/vr/vr_export.h"
+#include "device/vr/vr_service.mojom.h"
+
+namespace device {
+
+// Shares the samples of a VRDevice between the VRDisplayImpls connected to it
+// (one per renderer). The samples are keyed on the timestamp of the sensor
+// data they are computed from, so the displays that ask for the same sensor
+// frame share a single acquisition. The poses are small and each display gets
+// a copy, the points of a point cloud are in a shared buffer that is mapped by
+// every display instead of being copied and serialized for each of them. A
+// timestamp of 0 means the sample cannot be shared and is always acquired.
+class DEVICE_VR_EXPORT VRSampleCache {
+ public:
+  using AcquirePoseCallback = base::Callback<mojom::VRPosePtr()>;
+  using AcquirePointCloudCallback = base::Callback<mojom::VRPointCloudPtr()>;
+
+  VRSampleCache();
+  ~VRSampleCache();
+
+  // Returns a copy of the cached pose if it was acquired for sensor_timestamp,
+  // otherwise the pose returned by acquire, which is cached if not null. The
+  // sensor data may change between the lookup and the acquisition, so the
+  // acquired samples are cached under the sensor timestamp of their timing
+  // when they have one.
+  mojom::VRPosePtr GetPose(double sensor_timestamp,
+                           const AcquirePoseCallback& acquire);
+  // Same for the point clouds, which are also keyed on the way they are
+  // copied. A hit shares the points buffer of the cached point cloud.
+  mojom::VRPointCloudPtr GetPointCloud(
+      double sensor_timestamp,
+      unsigned points_to_skip,
+      bool transform_points,
+      const AcquirePointCloudCallback& acquire);
+
+  // Drops the cached samples, e.g. when the reference frame of the poses
+  // changes.
+  void Clear();
+
+  unsigned hits() const { return hits_; }
+  unsigned misses() const { return misses_; }
+
+ private:
+  double pose_timestamp_;
+  mojom::VRPosePtr pose_;
+
+  double point_cloud_timestamp_;
+  unsigned point_cloud_points_to_skip_;
+  bool point_cloud_transform_points_;
+  mojom::VRPointCloudPtr point_cloud_;
+
+  unsigned hits_;
+  unsigned misses_;
+
+  DISALLOW_COPY_AND_ASSIGN(VRSampleCache);
+};
+
+}  // namespace device
+
+#endif  // DEVICE_VR_VR_SAMPLE_CACHE_H
@@ -0,0 +1,158 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "device/vr/vr_sample_cache.h"
+
+#include "base/bind.h"
+#include "mojo/public/cpp/system/buffer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace device {
+
+namespace {
+
+mojom::VRPosePtr AcquirePose(int* acquisitions, float x) {
+  (*acquisitions)++;
+  mojom::VRPosePtr pose = mojom::VRPose::New();
+  pose->position.emplace(3);
+  pose->position.value()[0] = x;
+  return pose;
+}
+
+mojom::VRPosePtr AcquireNoPose(int* acquisitions) {
+  (*acquisitions)++;
+  return nullptr;
+}
+
+mojom::VRPointCloudPtr AcquirePointCloud(int* acquisitions,
+                                         uint32_t number_of_points) {
+  (*acquisitions)++;
+  mojom::VRPointCloudPtr point_cloud = mojom::VRPointCloud::New();
+  point_cloud->numberOfPoints = number_of_points;
+  point_cloud->points =
+      mojo::SharedBufferHandle::Create(number_of_points * 3 * sizeof(float));
+  return point_cloud;
+}
+
+// A point cloud whose timing says it was computed from the depth frame at
+// sensor_timestamp.
+mojom::VRPointCloudPtr AcquireTimedPointCloud(int* acquisitions,
+                                              double sensor_timestamp) {
+  mojom::VRPointCloudPtr point_cloud = AcquirePointCloud(acquisitions, 10);
+  point_cloud->timing = mojom::VRSampleTiming::New();
+  point_cloud->timing->sensorTimestamp = sensor_timestamp;
+  return point_cloud;
+}
+
+}  // namespace
+
+TEST(VRSampleCacheTest, SharesThePoseOfASensorFrame) {
+  VRSampleCache cache;
+  int acquisitions = 0;
+
+  // Three displays asking for the pose of the same camera frame.
+  for (int i = 0; i < 3; i++) {
+    mojom::VRPosePtr pose =
+        cache.GetPose(1.5, base::Bind(&AcquirePose, &acquisitions, 1.0f));
+    ASSERT_TRUE(pose);
+    EXPECT_EQ(1.0f, pose->position.value()[0]);
+  }
+  EXPECT_EQ(1, acquisitions);
+  EXPECT_EQ(2u, cache.hits());
+  EXPECT_EQ(1u, cache.misses());
+
+  // A new frame is acquired again.
+  mojom::VRPosePtr pose =
+      cache.GetPose(1.6, base::Bind(&AcquirePose, &acquisitions, 2.0f));
+  EXPECT_EQ(2.0f, pose->position.value()[0]);
+  EXPECT_EQ(2, acquisitions);
+
+  // The cache is dropped when the reference frame changes.
+  cache.Clear();
+  cache.GetPose(1.6, base::Bind(&AcquirePose, &acquisitions, 3.0f));
+  EXPECT_EQ(3, acquisitions);
+}
+
+TEST(VRSampleCacheTest, DoesNotShareUnknownOrMissingSamples) {
+  VRSampleCache cache;
+  int acquisitions = 0;
+
+  // Without a sensor timestamp, every request is acquired.
+  cache.GetPose(0, base::Bind(&AcquirePose, &acquisitions, 1.0f));
+  cache.GetPose(0, base::Bind(&AcquirePose, &acquisitions, 1.0f));
+  EXPECT_EQ(2, acquisitions);
+
+  // Failed acquisitions are retried.
+  EXPECT_FALSE(cache.GetPose(2.0, base::Bind(&AcquireNoPose, &acquisitions)));
+  EXPECT_FALSE(cache.GetPose(2.0, base::Bind(&AcquireNoPose, &acquisitions)));
+  EXPECT_EQ(4, acquisitions);
+}
+
+TEST(VRSampleCacheTest, KeysPointCloudsOnTheirCopyParameters) {
+  VRSampleCache cache;
+  int acquisitions = 0;
+
+  mojom::VRPointCloudPtr point_cloud = cache.GetPointCloud(
+      3.0, 0, true, base::Bind(&AcquirePointCloud, &acquisitions, 100));
+  point_cloud = cache.GetPointCloud(
+      3.0, 0, true, base::Bind(&AcquirePointCloud, &acquisitions, 100));
+  EXPECT_EQ(1, acquisitions);
+  EXPECT_EQ(100u, point_cloud->numberOfPoints);
+  EXPECT_TRUE(point_cloud->points.is_valid());
+
+  // Different skip factors or transforms are different payloads.
+  cache.GetPointCloud(3.0, 3, true,
+                      base::Bind(&AcquirePointCloud, &acquisitions, 25));
+  cache.GetPointCloud(3.0, 3, false,
+                      base::Bind(&AcquirePointCloud, &acquisitions, 25));
+  EXPECT_EQ(3, acquisitions);
+
+  // The last one is cached.
+  point_cloud = cache.GetPointCloud(
+      3.0, 3, false, base::Bind(&AcquirePointCloud, &acquisitions, 25));
+  EXPECT_EQ(3, acquisitions);
+  EXPECT_EQ(25u, point_cloud->numberOfPoints);
+}
+
+TEST(VRSampleCacheTest, SharesThePointsBuffer) {
+  VRSampleCache cache;
+  int acquisitions = 0;
+
+  mojom::VRPointCloudPtr first = cache.GetPointCloud(
+      3.0, 0, false, base::Bind(&AcquirePointCloud, &acquisitions, 4));
+  mojom::VRPointCloudPtr second = cache.GetPointCloud(
+      3.0, 0, false, base::Bind(&AcquirePointCloud, &acquisitions, 4));
+  EXPECT_EQ(1, acquisitions);
+  ASSERT_TRUE(first->points.is_valid());
+  ASSERT_TRUE(second->points.is_valid());
+
+  // Both displays map the same points, none of them is copied.
+  const size_t size = 4 * 3 * sizeof(float);
+  mojo::ScopedSharedBufferMapping first_mapping = first->points->Map(size);
+  mojo::ScopedSharedBufferMapping second_mapping = second->points->Map(size);
+  ASSERT_TRUE(first_mapping);
+  ASSERT_TRUE(second_mapping);
+  static_cast<float*>(first_mapping.get())[5] = 42;
+  EXPECT_EQ(42, static_cast<float*>(second_mapping.get())[5]);
+}
+
+TEST(VRSampleCacheTest, KeysOnTheAcquiredSensorFrame) {
+  VRSampleCache cache;
+  int acquisitions = 0;
+
+  // The depth camera delivered a new frame between the lookup and the
+  // acquisition: the point cloud is cached for the frame it was computed from.
+  cache.GetPointCloud(3.0, 0, false,
+                      base::Bind(&AcquireTimedPointCloud, &acquisitions, 3.5));
+  cache.GetPointCloud(3.5, 0, false,
+                      base::Bind(&AcquireTimedPointCloud, &acquisitions, 3.5));
+  EXPECT_EQ(1, acquisitions);
+
+  // So it is not served for the frame that was looked up.
+  cache.GetPointCloud(3.0, 0, false,
+                      base::Bind(&AcquireTimedPointCloud, &acquisitions, 3.0));
+  EXPECT_EQ(2, acquisitions);
+}
+
+}  // namespace device
@@ -49,13 +49,21 @@ void VRServiceImpl::SetClient(mojom::VRServiceClientPtr service_client,
                               const SetClientCallback& callback) {
   DCHECK(!client_.get());
   client_ = std::move(service_client);
+  set_client_callback_ = callback;
   VRDeviceManager* device_manager = VRDeviceManager::GetInstance();
   // Once a client has been connected AddService will force any VRDisplays to
   // send OnConnected to it so that it's populated with the currently active
   // displays. Thereafer it will stay up to date by virtue of listening for new
-  // connected events.
+  // connected events. The callback runs once the first displays are ready.
   device_manager->AddService(this);
-  callback.Run(device_manager->GetNumberOfConnectedDevices());
+}
+
+void VRServiceImpl::OnDevicesReady(unsigned int number_of_devices) {
+  if (set_client_callback_.is_null())
+    return;
+  SetClientCallback callback = set_client_callback_;
+  set_client_callback_.Reset();
+  callback.Run(number_of_devices);
 }
 
 void VRServiceImpl::SetListeningForActivate(bool listening) {
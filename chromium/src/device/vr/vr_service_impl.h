@@ -35,6 +35,10 @@ class VRServiceImpl : public mojom::VRService {
 
   bool listening_for_activate() { return listening_for_activate_; }
 
+  // Called by the VRDeviceManager once the devices that are ready have been
+  // announced to the client. Only the first call completes SetClient.
+  void OnDevicesReady(unsigned int number_of_devices);
+
  private:
   friend class FakeVRServiceClient;
   friend class VRDeviceManagerTest;
@@ -49,6 +53,7 @@ class VRServiceImpl : public mojom::VRService {
   std::map<VRDevice*, std::unique_ptr<VRDisplayImpl>> displays_;
 
   mojom::VRServiceClientPtr client_;
+  SetClientCallback set_client_callback_;
 
   bool listening_for_activate_;
 
@@ -0,0 +1,115 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/logging.h"
+#include "device/vr/test/perf_test_util.h"
+#include "device/vr/vr_sample_cache.h"
+#include "device/vr/vr_service.mojom.h"
+#include "mojo/public/cpp/system/buffer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace device {
+
+namespace {
+
+// The number of points of a full point cloud of the Tango depth camera.
+const uint32_t kNumberOfPoints = 224 * 172;
+
+mojom::VRPointCloudPtr CreatePointCloud() {
+  mojom::VRPointCloudPtr point_cloud = mojom::VRPointCloud::New();
+  point_cloud->numberOfPoints = kNumberOfPoints;
+  const size_t size = kNumberOfPoints * 3 * sizeof(float);
+  point_cloud->points = mojo::SharedBufferHandle::Create(size);
+  CHECK(point_cloud->points.is_valid());
+  mojo::ScopedSharedBufferMapping mapping = point_cloud->points->Map(size);
+  CHECK(mapping);
+  float* points = static_cast<float*>(mapping.get());
+  for (size_t i = 0; i < kNumberOfPoints * 3; i++)
+    points[i] = static_cast<float>(i % 1000) * 0.001f;
+  point_cloud->pointsTransformMatrix.resize(16);
+  for (size_t i = 0; i < 16; i++)
+    point_cloud->pointsTransformMatrix[i] = i % 5 == 0 ? 1 : 0;
+  point_cloud->pointsAlreadyTransformed = false;
+  return point_cloud;
+}
+
+mojom::VRPosePtr CreatePose() {
+  mojom::VRPosePtr pose = mojom::VRPose::New();
+  pose->timestamp = 1234.5;
+  pose->orientation.emplace(4, 0.5f);
+  pose->position.emplace(3, 1.0f);
+  pose->angularVelocity.emplace(3, 0.1f);
+  pose->linearVelocity.emplace(3, 0.2f);
+  pose->angularAcceleration.emplace(3, 0.3f);
+  pose->linearAcceleration.emplace(3, 0.4f);
+  pose->poseIndex = 42;
+  pose->localized = true;
+  return pose;
+}
+
+mojom::VRMarkerPtr CreateMarker() {
+  mojom::VRMarkerPtr marker = mojom::VRMarker::New();
+  marker->type = 2;
+  marker->id = 7;
+  marker->content = "https://github.com/google-ar/WebARonTango";
+  marker->position.assign(3, 0.5f);
+  marker->orientation.assign(4, 0.5f);
+  return marker;
+}
+
+// Measures the serialization and the deserialization of |value|, which is
+// what sending it from the browser process to the renderer costs besides the
+// IPC itself.
+template <typename StructPtr>
+void RunSerializationPerfTests(const std::string& name,
+                               const StructPtr& value) {
+  using Struct = typename StructPtr::element_type;
+
+  std::vector<uint8_t> data = Struct::Serialize(&value);
+  ASSERT_FALSE(data.empty());
+  StructPtr output;
+  ASSERT_TRUE(Struct::Deserialize(data, &output));
+  ASSERT_TRUE(output.Equals(value));
+
+  RunPerfTest(name + ".Serialize", data.size(), [&value]() {
+    std::vector<uint8_t> serialized = Struct::Serialize(&value);
+    CHECK(!serialized.empty());
+  });
+  RunPerfTest(name + ".Deserialize", data.size(), [&data]() {
+    StructPtr deserialized;
+    CHECK(Struct::Deserialize(data, &deserialized));
+  });
+}
+
+}  // namespace
+
+// The points are in a shared buffer, so a point cloud is not serialized with
+// them. What each display costs is sharing the cached point cloud: duplicating
+// the handle of the buffer and copying the other fields.
+TEST(VRServicePerfTest, VRPointCloud) {
+  VRSampleCache cache;
+  cache.GetPointCloud(1.0, 0, false, base::Bind(&CreatePointCloud));
+  RunPerfTest("VRPointCloud.Share", 0, [&cache]() {
+    mojom::VRPointCloudPtr point_cloud =
+        cache.GetPointCloud(1.0, 0, false, base::Bind(&CreatePointCloud));
+    CHECK(point_cloud->points.is_valid());
+  });
+  CHECK_EQ(1u, cache.misses());
+}
+
+TEST(VRServicePerfTest, VRPose) {
+  RunSerializationPerfTests("VRPose", CreatePose());
+}
+
+TEST(VRServicePerfTest, VRMarker) {
+  RunSerializationPerfTests("VRMarker", CreateMarker());
+}
+
+}  // namespace device
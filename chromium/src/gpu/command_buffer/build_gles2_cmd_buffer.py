@@ -2470,6 +2470,29 @@ _FUNCTION_INFO = {
     'unit_test': False,
     'client_test': False,
   },
+  # Fills the buffer bound to the target with the latest point cloud of the
+  # Tango device. The client does not wait for its number of points, which the
+  # VR device reports later.
+  'UpdatePointCloudBuffer': {
+    'decoder_func': 'DoUpdatePointCloudBuffer',
+    'unit_test': False,
+    'client_test': False,
+  },
+  # Uploads the latest depth image of the Tango device into the 2D texture,
+  # the sparse one or the densified one.
+  'UpdateDepthImageTexture': {
+    'decoder_func': 'DoUpdateDepthImageTexture',
+    'unit_test': False,
+    'client_test': False,
+  },
+  # Draws the camera image of the Tango device over the bound framebuffer, and
+  # into the 2D texture copy_texture if it is not 0. Only the validating
+  # decoder supports it, the passthrough one raises GL_INVALID_OPERATION.
+  'DrawCameraBackground': {
+    'decoder_func': 'DoDrawCameraBackground',
+    'unit_test': False,
+    'client_test': False,
+  },
 #  'UpdateTextureExternalOes': {
 #    'type': 'Bind',
 #    'decoder_func': 'DoUpdateTextureExternalOes',
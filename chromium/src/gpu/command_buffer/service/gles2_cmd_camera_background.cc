@@ -0,0 +1,204 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gpu/command_buffer/service/gles2_cmd_camera_background.h"
+
+#include "base/logging.h"
+#include "gpu/command_buffer/service/gles2_cmd_decoder.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace {
+
+const GLuint kVertexPositionAttrib = 0;
+
+const char* kVertexShaderSource =
+    "attribute vec2 a_position;\n"
+    "uniform mat4 u_uv_transform;\n"
+    "varying vec2 v_uv;\n"
+    "void main(void) {\n"
+    "  gl_Position = vec4(a_position, 0.0, 1.0);\n"
+    "  vec4 uv = vec4(a_position * 0.5 + 0.5, 0.0, 1.0);\n"
+    "  v_uv = (u_uv_transform * uv).xy;\n"
+    "}\n";
+
+const char* kFragmentShaderSource =
+    "#extension GL_OES_EGL_image_external : require\n"
+    "precision mediump float;\n"
+    "uniform samplerExternalOES u_camera_image;\n"
+    "varying vec2 v_uv;\n"
+    "void main(void) {\n"
+    "  gl_FragColor = texture2D(u_camera_image, v_uv);\n"
+    "}\n";
+
+void CompileShader(GLuint shader, const char* shader_source) {
+  glShaderSource(shader, 1, &shader_source, 0);
+  glCompileShader(shader);
+#if DCHECK_IS_ON()
+  GLint compile_status = GL_FALSE;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &compile_status);
+  if (GL_TRUE != compile_status)
+    DLOG(ERROR) << "CameraBackgroundResourceManager: shader compilation "
+                   "failure.";
+#endif
+}
+
+}  // namespace
+
+namespace gpu {
+namespace gles2 {
+
+CameraBackgroundResourceManager::CameraBackgroundResourceManager(
+    const GLES2Decoder* decoder)
+    : initialized_(false),
+      program_(0u),
+      vertex_shader_(0u),
+      fragment_shader_(0u),
+      uv_transform_handle_(-1),
+      sampler_handle_(-1),
+      buffer_id_(0u),
+      framebuffer_(0u) {
+  Initialize(decoder);
+}
+
+CameraBackgroundResourceManager::~CameraBackgroundResourceManager() {}
+
+void CameraBackgroundResourceManager::Initialize(const GLES2Decoder* decoder) {
+  static_assert(
+      kVertexPositionAttrib == 0u,
+      "kVertexPositionAttrib must be 0 to be compatible with the client");
+
+  glGenBuffersARB(1, &buffer_id_);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer_id_);
+  const GLfloat kQuadVertices[] = {-1.0f, -1.0f, 1.0f,  -1.0f,
+                                   1.0f,  1.0f,  -1.0f, 1.0f};
+  glBufferData(GL_ARRAY_BUFFER, sizeof(kQuadVertices), kQuadVertices,
+               GL_STATIC_DRAW);
+  decoder->RestoreBufferBindings();
+  initialized_ = true;
+}
+
+void CameraBackgroundResourceManager::Destroy() {
+  if (!initialized_)
+    return;
+
+  glDeleteProgram(program_);
+  glDeleteShader(vertex_shader_);
+  glDeleteShader(fragment_shader_);
+  glDeleteBuffersARB(1, &buffer_id_);
+  if (framebuffer_)
+    glDeleteFramebuffersEXT(1, &framebuffer_);
+  program_ = vertex_shader_ = fragment_shader_ = buffer_id_ = framebuffer_ = 0;
+  initialized_ = false;
+}
+
+void CameraBackgroundResourceManager::InitializeProgram() {
+  program_ = glCreateProgram();
+
+  vertex_shader_ = glCreateShader(GL_VERTEX_SHADER);
+  CompileShader(vertex_shader_, kVertexShaderSource);
+  glAttachShader(program_, vertex_shader_);
+
+  fragment_shader_ = glCreateShader(GL_FRAGMENT_SHADER);
+  CompileShader(fragment_shader_, kFragmentShaderSource);
+  glAttachShader(program_, fragment_shader_);
+
+  glBindAttribLocation(program_, kVertexPositionAttrib, "a_position");
+  glLinkProgram(program_);
+#if DCHECK_IS_ON()
+  GLint linked = GL_FALSE;
+  glGetProgramiv(program_, GL_LINK_STATUS, &linked);
+  if (GL_TRUE != linked)
+    DLOG(ERROR) << "CameraBackgroundResourceManager: program link failure.";
+#endif
+  uv_transform_handle_ = glGetUniformLocation(program_, "u_uv_transform");
+  sampler_handle_ = glGetUniformLocation(program_, "u_camera_image");
+}
+
+void CameraBackgroundResourceManager::DrawIntoFramebuffer(
+    const GLES2Decoder* decoder,
+    GLuint source_id,
+    const GLfloat uv_transform[16],
+    const gfx::Size& framebuffer_size) {
+  if (!initialized_) {
+    DLOG(ERROR) << "Uninitialized manager.";
+    return;
+  }
+
+  glViewport(0, 0, framebuffer_size.width(), framebuffer_size.height());
+  Draw(source_id, uv_transform);
+  RestoreState(decoder);
+}
+
+void CameraBackgroundResourceManager::DrawIntoTexture(
+    const GLES2Decoder* decoder,
+    GLuint source_id,
+    const GLfloat uv_transform[16],
+    GLuint dest_id,
+    const gfx::Size& dest_size) {
+  if (!initialized_) {
+    DLOG(ERROR) << "Uninitialized manager.";
+    return;
+  }
+
+  if (!framebuffer_)
+    glGenFramebuffersEXT(1, &framebuffer_);
+  glBindFramebufferEXT(GL_FRAMEBUFFER, framebuffer_);
+  glFramebufferTexture2DEXT(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                            dest_id, 0);
+#if DCHECK_IS_ON()
+  GLenum status = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER);
+  if (status != GL_FRAMEBUFFER_COMPLETE)
+    DLOG(ERROR) << "CameraBackgroundResourceManager: incomplete framebuffer.";
+#endif
+  glViewport(0, 0, dest_size.width(), dest_size.height());
+  Draw(source_id, uv_transform);
+  // The texture is not kept attached, so it can be deleted by the client.
+  glFramebufferTexture2DEXT(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                            0, 0);
+  RestoreState(decoder);
+  decoder->RestoreFramebufferBindings();
+}
+
+void CameraBackgroundResourceManager::Draw(GLuint source_id,
+                                           const GLfloat uv_transform[16]) {
+  if (!program_)
+    InitializeProgram();
+  glUseProgram(program_);
+  glUniformMatrix4fv(uv_transform_handle_, 1, GL_FALSE, uv_transform);
+  glUniform1i(sampler_handle_, 0);
+
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_EXTERNAL_OES, source_id);
+
+  glBindBuffer(GL_ARRAY_BUFFER, buffer_id_);
+  glEnableVertexAttribArray(kVertexPositionAttrib);
+  glVertexAttribPointer(kVertexPositionAttrib, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+  // The background covers everything: none of the state of the client
+  // applies.
+  glDisable(GL_BLEND);
+  glDisable(GL_CULL_FACE);
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_SCISSOR_TEST);
+  glDisable(GL_STENCIL_TEST);
+  glDisable(GL_POLYGON_OFFSET_FILL);
+  glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+  glDisable(GL_SAMPLE_COVERAGE);
+  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+  glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+}
+
+void CameraBackgroundResourceManager::RestoreState(
+    const GLES2Decoder* decoder) {
+  decoder->RestoreAllAttributes();
+  decoder->RestoreTextureUnitBindings(0);
+  decoder->RestoreActiveTexture();
+  decoder->RestoreProgramBindings();
+  decoder->RestoreBufferBindings();
+  decoder->RestoreGlobalState();
+}
+
+}  // namespace gles2
+}  // namespace gpu
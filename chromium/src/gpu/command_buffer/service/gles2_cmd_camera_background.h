@@ -0,0 +1,72 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GPU_COMMAND_BUFFER_SERVICE_GLES2_CMD_CAMERA_BACKGROUND_H_
+#define GPU_COMMAND_BUFFER_SERVICE_GLES2_CMD_CAMERA_BACKGROUND_H_
+
+#include "base/macros.h"
+#include "gpu/command_buffer/service/gl_utils.h"
+#include "gpu/gpu_export.h"
+
+namespace gfx {
+class Size;
+}
+
+namespace gpu {
+namespace gles2 {
+class GLES2Decoder;
+
+// Draws the camera frames of the Tango device, external textures, on a quad
+// covering the bound framebuffer or a 2D texture, for glDrawCameraBackground.
+// The state of the decoder is restored after each draw.
+class GPU_EXPORT CameraBackgroundResourceManager {
+ public:
+  explicit CameraBackgroundResourceManager(const GLES2Decoder* decoder);
+  ~CameraBackgroundResourceManager();
+
+  // Deletes the GL objects. Must be called with the context current before
+  // the manager is destroyed, unless the context is lost.
+  void Destroy();
+
+  // Draws the external texture source_id over the whole framebuffer bound to
+  // GL_DRAW_FRAMEBUFFER, of framebuffer_size. uv_transform is the column
+  // major transform from the texture coordinates of the quad, with the origin
+  // at the bottom left, to those of the source texture.
+  void DrawIntoFramebuffer(const GLES2Decoder* decoder,
+                           GLuint source_id,
+                           const GLfloat uv_transform[16],
+                           const gfx::Size& framebuffer_size);
+
+  // Same, into level 0 of the 2D texture dest_id of dest_size, which must have
+  // RGBA storage.
+  void DrawIntoTexture(const GLES2Decoder* decoder,
+                       GLuint source_id,
+                       const GLfloat uv_transform[16],
+                       GLuint dest_id,
+                       const gfx::Size& dest_size);
+
+ private:
+  void Initialize(const GLES2Decoder* decoder);
+  void InitializeProgram();
+  // Draws the quad with the framebuffer and the viewport already set.
+  void Draw(GLuint source_id, const GLfloat uv_transform[16]);
+  void RestoreState(const GLES2Decoder* decoder);
+
+  bool initialized_;
+  GLuint program_;
+  GLuint vertex_shader_;
+  GLuint fragment_shader_;
+  GLint uv_transform_handle_;
+  GLint sampler_handle_;
+  GLuint buffer_id_;
+  // Only created for DrawIntoTexture.
+  GLuint framebuffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(CameraBackgroundResourceManager);
+};
+
+}  // namespace gles2
+}  // namespace gpu
+
+#endif  // GPU_COMMAND_BUFFER_SERVICE_GLES2_CMD_CAMERA_BACKGROUND_H_
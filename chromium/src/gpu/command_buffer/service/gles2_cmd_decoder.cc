@@ -18,6 +18,7 @@
 
 #include "base/callback.h"
 #include "base/callback_helpers.h"
+#include "base/lazy_instance.h"
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
 #include "base/metrics/histogram_macros.h"
@@ -40,6 +41,7 @@
 #include "gpu/command_buffer/service/gl_stream_texture_image.h"
 #include "gpu/command_buffer/service/gl_utils.h"
 #include "gpu/command_buffer/service/gles2_cmd_apply_framebuffer_attachment_cmaa_intel.h"
+#include "gpu/command_buffer/service/gles2_cmd_camera_background.h"
 #include "gpu/command_buffer/service/gles2_cmd_clear_framebuffer.h"
 #include "gpu/command_buffer/service/gles2_cmd_copy_tex_image.h"
 #include "gpu/command_buffer/service/gles2_cmd_copy_texture_chromium.h"
@@ -81,12 +83,15 @@
 #include "ui/gl/gl_fence.h"
 #include "ui/gl/gl_image.h"
 #include "ui/gl/gl_implementation.h"
+#include "ui/gl/gl_share_group.h"
 #include "ui/gl/gl_surface.h"
 #include "ui/gl/gl_version_info.h"
 #include "ui/gl/gpu_timing.h"
 
 // WebAR BEGIN
+#include "CameraFrameRing.h"
 #include "TangoHandler.h"
+using tango_chromium::CameraFrameRing;
 using tango_chromium::TangoHandler;
 // WebAR END
 
@@ -106,6 +111,27 @@ const char kEXTFragDepthExtension[] = "GL_EXT_frag_depth";
 const char kEXTDrawBuffersExtension[] = "GL_EXT_draw_buffers";
 const char kEXTShaderTextureLodExtension[] = "GL_EXT_shader_texture_lod";
 
+// WebAR BEGIN
+// The camera frames latched for the decoders of a share group. Latching a
+// frame costs a copy of the camera image in the Tango Service, so it is done
+// once per frame for all the decoders (the WebGL contexts of a page, and of
+// every page of the GPU channel) instead of once per decoder, and the textures
+// are shared through the share group. Only used on the GPU main thread.
+struct SharedCameraFrames {
+  GLuint textures[CameraFrameRing::kSize] = {};
+  CameraFrameRing ring;
+  // The camera frame count of the TangoHandler when the last frame was
+  // latched.
+  uint32_t camera_frame_count = 0;
+  // The number of decoders using the frames, which are deleted with the last
+  // one.
+  int users = 0;
+};
+
+base::LazyInstance<std::map<gl::GLShareGroup*, SharedCameraFrames>>::Leaky
+    g_shared_camera_frames = LAZY_INSTANCE_INITIALIZER;
+// WebAR END
+
 const GLfloat kIdentityMatrix[16] = {1.0f, 0.0f, 0.0f, 0.0f,
                                      0.0f, 1.0f, 0.0f, 0.0f,
                                      0.0f, 0.0f, 1.0f, 0.0f,
@@ -1417,7 +1443,30 @@ class GLES2DecoderImpl : public GLES2Decoder, public ErrorStateClient {
   void DoBindTexture(GLenum target, GLuint texture);
 
 // WebAR BEGIN
+  // Points the external texture to the camera frame the last pose was
+  // computed for, after latching the newest frame into the camera frame ring.
   void DoUpdateTextureExternalOes(GLuint client_id);
+  // Latches the newest camera frame, if there is a new one that no decoder of
+  // the share group has latched yet, into a texture of the camera frame ring.
+  void LatchCameraFrame();
+  // Latches the newest camera frame and returns the service id of the texture
+  // of the frame to display, or 0 if there is none yet.
+  GLuint SelectCameraFrame();
+  // Draws the camera frame to display over the bound draw framebuffer, in the
+  // orientation of the display, and into the 2D texture if it is not 0, of
+  // copy_width x copy_height.
+  void DoDrawCameraBackground(GLuint copy_client_id,
+                              GLsizei copy_width,
+                              GLsizei copy_height);
+  // Copies the latest point cloud into the buffer bound to the target, without
+  // going through the client. The buffer is sized for the largest point cloud
+  // and its number of points is recorded in the TangoHandler, which the VR
+  // device reports to the renderer.
+  void DoUpdatePointCloudBuffer(GLenum target, GLenum usage);
+  // Uploads the latest depth image into the 2D texture as LUMINANCE_ALPHA,
+  // the low byte of the depth in millimeters in luminance and the high one in
+  // alpha.
+  void DoUpdateDepthImageTexture(GLuint client_id, GLboolean dense);
 // WebAR END
 
   // Wrapper for glBindSampler since we need to track the current targets.
@@ -2378,6 +2427,9 @@ class GLES2DecoderImpl : public GLES2Decoder, public ErrorStateClient {
   std::unique_ptr<CopyTextureCHROMIUMResourceManager> copy_texture_CHROMIUM_;
   std::unique_ptr<SRGBConverter> srgb_converter_;
   std::unique_ptr<ClearFramebufferResourceManager> clear_framebuffer_blit_;
+  // WebAR BEGIN
+  std::unique_ptr<CameraBackgroundResourceManager> camera_background_;
+  // WebAR END
 
   // Cached values of the currently assigned viewport dimensions.
   GLsizei viewport_max_width_;
@@ -2446,6 +2498,21 @@ class GLES2DecoderImpl : public GLES2Decoder, public ErrorStateClient {
 
   std::unique_ptr<CALayerSharedState> ca_layer_shared_state_;
 
+  // WebAR BEGIN
+  // Where DoUpdatePointCloudBuffer copies the point clouds to, kept across
+  // calls so it is only allocated once.
+  std::vector<float> point_cloud_upload_;
+  // Same for the depth images of DoUpdateDepthImageTexture.
+  tango_chromium::DepthImage depth_image_upload_;
+  // The camera frames are latched into textures shared by the decoders of the
+  // share group, and the external textures of the client are pointed to the
+  // one to display (see LatchCameraFrame). Null until the first frame.
+  SharedCameraFrames* shared_camera_frames_;
+  // The slot of the ring this decoder displays, which the other decoders do
+  // not latch into, or -1.
+  int displayed_camera_frame_slot_;
+  // WebAR END
+
   DISALLOW_COPY_AND_ASSIGN(GLES2DecoderImpl);
 };
 
@@ -3061,7 +3128,12 @@ GLES2DecoderImpl::GLES2DecoderImpl(ContextGroup* group)
       validation_fbo_multisample_(0),
       validation_fbo_(0),
       texture_manager_service_id_generation_(0),
-      force_shader_name_hashing_for_test(false) {
+      force_shader_name_hashing_for_test(false),
+      // WebAR BEGIN
+      shared_camera_frames_(nullptr),
+      displayed_camera_frame_slot_(-1)
+      // WebAR END
+{
   DCHECK(group);
 }
 
@@ -4721,6 +4793,13 @@ void GLES2DecoderImpl::Destroy(bool have_context) {
 
     clear_framebuffer_blit_.reset();
 
+    // WebAR BEGIN
+    if (camera_background_.get()) {
+      camera_background_->Destroy();
+      camera_background_.reset();
+    }
+    // WebAR END
+
     if (state_.current_program.get()) {
       program_manager()->UnuseProgram(shader_manager(),
                                       state_.current_program.get());
@@ -4787,6 +4866,29 @@ void GLES2DecoderImpl::Destroy(bool have_context) {
   }
   deschedule_until_finished_fences_.clear();
 
+  // WebAR BEGIN
+  if (shared_camera_frames_) {
+    shared_camera_frames_->ring.releaseFrame(displayed_camera_frame_slot_);
+    displayed_camera_frame_slot_ = -1;
+    if (--shared_camera_frames_->users == 0) {
+      // The textures are lost with the share group otherwise.
+      if (have_context) {
+        glDeleteTextures(CameraFrameRing::kSize,
+                         shared_camera_frames_->textures);
+      }
+      auto& shared_camera_frames = g_shared_camera_frames.Get();
+      for (auto it = shared_camera_frames.begin();
+           it != shared_camera_frames.end(); ++it) {
+        if (&it->second == shared_camera_frames_) {
+          shared_camera_frames.erase(it);
+          break;
+        }
+      }
+    }
+    shared_camera_frames_ = nullptr;
+  }
+  // WebAR END
+
   // Unbind everything.
   state_.vertex_attrib_manager = nullptr;
   state_.default_vertex_attrib_manager = nullptr;
@@ -4818,6 +4920,9 @@ void GLES2DecoderImpl::Destroy(bool have_context) {
   copy_texture_CHROMIUM_.reset();
   srgb_converter_.reset();
   clear_framebuffer_blit_.reset();
+  // WebAR BEGIN
+  camera_background_.reset();
+  // WebAR END
 
   if (query_manager_.get()) {
     query_manager_->Destroy(have_context);
@@ -5775,6 +5880,8 @@ void GLES2DecoderImpl::DoBindTexture(GLenum target, GLuint client_id) {
 // WebAR BEGIN
 
 void GLES2DecoderImpl::DoUpdateTextureExternalOes(GLuint client_id) {
+  TRACE_EVENT1("gpu", "GLES2DecoderImpl::DoUpdateTextureExternalOes",
+               "client_id", client_id);
   TextureRef* texture_ref = NULL;
   GLuint service_id = 0;
   if (client_id != 0) {
@@ -5802,7 +5909,238 @@ void GLES2DecoderImpl::DoUpdateTextureExternalOes(GLuint client_id) {
   if (texture_ref) {
     Texture* texture = texture_ref->texture();
     LogClientServiceForInfo(texture, client_id, "glUpdateTextureExternalOes");
-    TangoHandler::getInstance()->updateCameraImageIntoTexture(texture->service_id());
+    // The texture is pointed to the frame like a stream texture, which
+    // rebinds the external textures.
+    GLuint camera_frame_service_id = SelectCameraFrame();
+    if (camera_frame_service_id != 0) {
+      texture->SetStreamTextureServiceId(camera_frame_service_id);
+    }
+  }
+}
+
+GLuint GLES2DecoderImpl::SelectCameraFrame() {
+  LatchCameraFrame();
+  // The frame to display is chosen as late as possible, when it is about to
+  // be drawn: the one of the pose the page is rendering with, which can be
+  // older than the newest one.
+  displayed_camera_frame_slot_ = shared_camera_frames_->ring.selectFrame(
+      TangoHandler::getInstance()->getPoseCameraTimestamp(),
+      displayed_camera_frame_slot_);
+  return displayed_camera_frame_slot_ >= 0
+             ? shared_camera_frames_->textures[displayed_camera_frame_slot_]
+             : 0;
+}
+
+void GLES2DecoderImpl::DoDrawCameraBackground(GLuint copy_client_id,
+                                              GLsizei copy_width,
+                                              GLsizei copy_height) {
+  TRACE_EVENT0("gpu", "GLES2DecoderImpl::DoDrawCameraBackground");
+  const char* func_name = "glDrawCameraBackground";
+  TextureRef* copy_texture_ref = nullptr;
+  if (copy_client_id != 0) {
+    copy_texture_ref = GetTexture(copy_client_id);
+    if (!copy_texture_ref ||
+        copy_texture_ref->texture()->target() != GL_TEXTURE_2D) {
+      LOCAL_SET_GL_ERROR(GL_INVALID_OPERATION, func_name, "not a 2D texture");
+      return;
+    }
+    GLsizei max_size = texture_manager()->MaxSizeForTarget(GL_TEXTURE_2D);
+    if (copy_width <= 0 || copy_height <= 0 || copy_width > max_size ||
+        copy_height > max_size) {
+      LOCAL_SET_GL_ERROR(GL_INVALID_VALUE, func_name, "invalid copy size");
+      return;
+    }
+  }
+  if (!CheckBoundDrawFramebufferValid(func_name))
+    return;
+
+  GLuint camera_frame_service_id = SelectCameraFrame();
+  if (camera_frame_service_id == 0)
+    return;
+
+  LOCAL_COPY_REAL_GL_ERRORS_TO_WRAPPER(func_name);
+  if (!camera_background_.get()) {
+    camera_background_.reset(new CameraBackgroundResourceManager(this));
+    if (LOCAL_PEEK_GL_ERROR(func_name) != GL_NO_ERROR) {
+      camera_background_->Destroy();
+      camera_background_.reset();
+      return;
+    }
+  }
+
+  // The page is drawn over the image as the camera sees it: rotated to the
+  // orientation of the display, without the part behind the address bar.
+  GLfloat uv_transform[16];
+  TangoHandler::getInstance()->getCameraImageUVTransform(uv_transform);
+
+  gfx::Size framebuffer_size;
+  Framebuffer* framebuffer = GetBoundDrawFramebuffer();
+  if (framebuffer) {
+    const Framebuffer::Attachment* attachment =
+        framebuffer->GetAttachment(GL_COLOR_ATTACHMENT0);
+    if (attachment)
+      framebuffer_size = gfx::Size(attachment->width(), attachment->height());
+  } else if (offscreen_target_frame_buffer_.get()) {
+    framebuffer_size = offscreen_size_;
+  } else {
+    framebuffer_size = surface_->GetSize();
+  }
+  camera_background_->DrawIntoFramebuffer(this, camera_frame_service_id,
+                                          uv_transform, framebuffer_size);
+
+  if (copy_texture_ref) {
+    // The copy is a plain RGBA texture, cheaper to sample than the external
+    // texture, for example to light the scene or for computer vision.
+    Texture* copy_texture = copy_texture_ref->texture();
+    GLsizei width = 0;
+    GLsizei height = 0;
+    GLenum type = GL_NONE;
+    GLenum internal_format = GL_NONE;
+    if (!copy_texture->GetLevelSize(GL_TEXTURE_2D, 0, &width, &height,
+                                    nullptr) ||
+        !copy_texture->GetLevelType(GL_TEXTURE_2D, 0, &type,
+                                    &internal_format) ||
+        width != copy_width || height != copy_height ||
+        type != GL_UNSIGNED_BYTE || internal_format != GL_RGBA) {
+      ScopedTextureBinder binder(&state_, copy_texture_ref->service_id(),
+                                 GL_TEXTURE_2D);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, copy_width, copy_height, 0,
+                   GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+      if (LOCAL_PEEK_GL_ERROR(func_name) != GL_NO_ERROR)
+        return;
+      texture_manager()->SetLevelInfo(copy_texture_ref, GL_TEXTURE_2D, 0,
+                                      GL_RGBA, copy_width, copy_height, 1, 0,
+                                      GL_RGBA, GL_UNSIGNED_BYTE, gfx::Rect());
+    }
+    camera_background_->DrawIntoTexture(
+        this, camera_frame_service_id, uv_transform,
+        copy_texture_ref->service_id(), gfx::Size(copy_width, copy_height));
+    texture_manager()->SetLevelCleared(copy_texture_ref, GL_TEXTURE_2D, 0,
+                                       true);
+  }
+}
+
+void GLES2DecoderImpl::LatchCameraFrame() {
+  if (!shared_camera_frames_) {
+    // Every WebGL context of the GPU channel is in the same share group, so
+    // they all display the same frames.
+    shared_camera_frames_ =
+        &g_shared_camera_frames.Get()[context_->share_group()];
+    shared_camera_frames_->users++;
+  }
+  SharedCameraFrames* frames = shared_camera_frames_;
+  TangoHandler* tango_handler = TangoHandler::getInstance();
+  uint32_t camera_frame_count = tango_handler->getCameraFrameCount();
+  if (frames->textures[0] == 0) {
+    glGenTextures(CameraFrameRing::kSize, frames->textures);
+  } else if (camera_frame_count == frames->camera_frame_count) {
+    // Another decoder of the share group has latched it already.
+    return;
+  }
+
+  TRACE_EVENT1("gpu", "GLES2DecoderImpl::LatchCameraFrame",
+               "camera_frame_count", camera_frame_count);
+  // Every slot holds the newest frame or one the other decoders display: the
+  // new frame waits until one of them moves on.
+  int slot = frames->ring.getLatchSlot();
+  if (slot < 0)
+    return;
+  // The TangoHandler records the timestamp of the frame, which the next
+  // poses are computed for.
+  if (tango_handler->updateCameraImageIntoTexture(frames->textures[slot])) {
+    frames->ring.onFrameLatched(slot,
+                                tango_handler->getCameraImageTimestamp());
+    frames->camera_frame_count = camera_frame_count;
+    // The other contexts of the share group only see the new contents of the
+    // texture once the commands that wrote them are flushed.
+    glFlush();
+  }
+  // The Tango Service leaves the texture bound to the active texture unit.
+  state_.RestoreActiveTextureUnitBinding(GL_TEXTURE_EXTERNAL_OES);
+}
+
+void GLES2DecoderImpl::DoUpdatePointCloudBuffer(GLenum target,
+                                                GLenum usage) {
+  TRACE_EVENT0("gpu", "GLES2DecoderImpl::DoUpdatePointCloudBuffer");
+  Buffer* buffer = buffer_manager()->GetBufferInfoForTarget(&state_, target);
+  if (!buffer) {
+    LOCAL_SET_GL_ERROR(GL_INVALID_OPERATION, "glUpdatePointCloudBuffer",
+                       "no buffer bound to target");
+    return;
+  }
+
+  // The points are transformed by the pose of the depth camera, as the
+  // client has no other way to get the matrix of this point cloud.
+  TangoHandler* tangoHandler = TangoHandler::getInstance();
+  uint32_t number_of_points = 0;
+  float points_transform_matrix[16];
+  point_cloud_upload_.resize(tangoHandler->getMaxNumberOfPointsInPointCloud() *
+                             3);
+  if (point_cloud_upload_.empty() ||
+      !tangoHandler->getPointCloud(&number_of_points,
+                                   point_cloud_upload_.data(), false, 0, true,
+                                   points_transform_matrix)) {
+    number_of_points = 0;
+  }
+  TRACE_COUNTER1("gpu", "UploadedPointCloudPoints", number_of_points);
+
+  // The renderer gets the number of points later, so it may draw the number of
+  // the previous point cloud: the buffer keeps the size of the largest one and
+  // the stale points after number_of_points are left as they are.
+  GLsizeiptr size = point_cloud_upload_.size() * sizeof(float);
+  if (buffer->size() != size || buffer->usage() != usage) {
+    buffer_manager()->ValidateAndDoBufferData(&state_, target, size, nullptr,
+                                              usage);
+  }
+  if (number_of_points > 0) {
+    buffer_manager()->ValidateAndDoBufferSubData(
+        &state_, target, 0, number_of_points * 3 * sizeof(float),
+        point_cloud_upload_.data());
+  }
+  tangoHandler->setUploadedNumberOfPoints(number_of_points);
+}
+
+void GLES2DecoderImpl::DoUpdateDepthImageTexture(GLuint client_id,
+                                                 GLboolean dense) {
+  TRACE_EVENT2("gpu", "GLES2DecoderImpl::DoUpdateDepthImageTexture",
+               "client_id", client_id, "dense", dense);
+  TextureRef* texture_ref = GetTexture(client_id);
+  if (!texture_ref || texture_ref->texture()->target() != GL_TEXTURE_2D) {
+    LOCAL_SET_GL_ERROR(GL_INVALID_OPERATION, "glUpdateDepthImageTexture",
+                       "not a 2D texture");
+    return;
+  }
+
+  // A single pixel without depth is uploaded until the first depth image is
+  // available, so the texture is always complete.
+  TangoHandler* tango_handler = TangoHandler::getInstance();
+  bool has_depth_image =
+      dense ? tango_handler->getDenseDepthImage(depth_image_upload_)
+            : tango_handler->getDepthImage(depth_image_upload_);
+  if (!has_depth_image) {
+    depth_image_upload_.width = depth_image_upload_.height = 1;
+    depth_image_upload_.depth.assign(1, 0);
+  }
+  GLsizei width = depth_image_upload_.width;
+  GLsizei height = depth_image_upload_.height;
+
+  LOCAL_COPY_REAL_GL_ERRORS_TO_WRAPPER("glUpdateDepthImageTexture");
+  {
+    ScopedTextureBinder binder(&state_, texture_ref->service_id(),
+                               GL_TEXTURE_2D);
+    // The rows are tightly packed and the data is not in a pixel unpack
+    // buffer.
+    state_.PushTextureDecompressionUnpackState();
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, width, height, 0,
+                 GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE,
+                 depth_image_upload_.depth.data());
+    state_.RestoreUnpackState();
+  }
+  if (LOCAL_PEEK_GL_ERROR("glUpdateDepthImageTexture") == GL_NO_ERROR) {
+    texture_manager()->SetLevelInfo(texture_ref, GL_TEXTURE_2D, 0,
+                                    GL_LUMINANCE_ALPHA, width, height, 1, 0,
+                                    GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE,
+                                    gfx::Rect(width, height));
   }
 }
 // WebAR END
@@ -21,6 +21,11 @@ error::Error DoBindTexture(GLenum target, GLuint texture);
 
 // WebAR BEGIN
 error::Error DoUpdateTextureExternalOes(GLuint texture);
+error::Error DoUpdatePointCloudBuffer(GLenum target, GLenum usage);
+error::Error DoUpdateDepthImageTexture(GLuint texture, GLboolean dense);
+error::Error DoDrawCameraBackground(GLuint copy_texture,
+                                    GLsizei copy_width,
+                                    GLsizei copy_height);
 // WebAR END
 
 error::Error DoBindTransformFeedback(GLenum target, GLuint transformfeedback);
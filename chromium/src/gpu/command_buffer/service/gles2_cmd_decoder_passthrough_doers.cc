@@ -5,6 +5,12 @@
 #include "gpu/command_buffer/service/gles2_cmd_decoder_passthrough.h"
 
 #include "base/strings/string_number_conversions.h"
+#include "base/trace_event/trace_event.h"
+
+// WebAR BEGIN
+#include "TangoHandler.h"
+using tango_chromium::TangoHandler;
+// WebAR END
 
 namespace gpu {
 namespace gles2 {
@@ -305,7 +311,186 @@ error::Error GLES2DecoderPassthroughImpl::DoBindTexture(GLenum target,
 }
 
 // WebAR BEGIN
-error::Error GLES2DecoderPassthroughImpl::DoUpdateTextureExternalOes(GLuint texture) {
+error::Error GLES2DecoderPassthroughImpl::DoUpdateTextureExternalOes(
+    GLuint texture) {
+  TRACE_EVENT1("gpu", "GLES2DecoderPassthroughImpl::DoUpdateTextureExternalOes",
+               "texture", texture);
+  if (texture == 0) {
+    return error::kNoError;
+  }
+
+  GLuint service_id =
+      GetTextureServiceID(texture, resources_, bind_generates_resource_);
+  if (service_id == 0) {
+    InsertError(GL_INVALID_OPERATION, "id not generated by glGenTextures");
+    return error::kNoError;
+  }
+
+  // Track the texture like DoBindTexture does, so it can be deleted and
+  // produced into mailboxes like any other external texture.
+  auto texture_object_iter = resources_->texture_object_map.find(texture);
+  if (texture_object_iter == resources_->texture_object_map.end()) {
+    resources_->texture_object_map.insert(std::make_pair(
+        texture, new TexturePassthrough(service_id, GL_TEXTURE_EXTERNAL_OES)));
+  } else if (texture_object_iter->second->target() !=
+             GL_TEXTURE_EXTERNAL_OES) {
+    InsertError(GL_INVALID_OPERATION, "Texture target does not match.");
+    return error::kNoError;
+  }
+
+  // The errors of the client are kept apart from the ones of the GL calls
+  // the Tango Service makes, which the client did not ask for.
+  FlushErrors();
+
+  // The Tango Service latches the latest camera frame into the texture and
+  // the TangoHandler records its timestamp (see getCameraImageTimestamp), so
+  // the pose of the frame can be retrieved. Like any SurfaceTexture update,
+  // it makes this context wait for the camera to be done writing the frame.
+  bool updated =
+      TangoHandler::getInstance()->updateCameraImageIntoTexture(service_id);
+
+  // Updating the texture binds it to GL_TEXTURE_EXTERNAL_OES on the active
+  // texture unit. The state of the client is the state of the context in
+  // this decoder, so the texture the client had bound is restored.
+  GLuint bound_texture = 0;
+  auto bound_textures_iter = bound_textures_.find(GL_TEXTURE_EXTERNAL_OES);
+  if (bound_textures_iter != bound_textures_.end() &&
+      bound_textures_iter->second.size() > active_texture_unit_) {
+    bound_texture = bound_textures_iter->second[active_texture_unit_];
+  }
+  glBindTexture(GL_TEXTURE_EXTERNAL_OES,
+                GetTextureServiceID(bound_texture, resources_, false));
+
+  // Drop the errors of the Tango Service (see FlushErrors above).
+  while (glGetError() != GL_NO_ERROR) {
+  }
+  if (!updated) {
+    DLOG(ERROR) << "glUpdateTextureExternalOes: the camera frame could not be "
+                   "updated into texture "
+                << texture;
+  }
+  return error::kNoError;
+}
+
+error::Error GLES2DecoderPassthroughImpl::DoUpdatePointCloudBuffer(
+    GLenum target,
+    GLenum usage) {
+  TRACE_EVENT0("gpu", "GLES2DecoderPassthroughImpl::DoUpdatePointCloudBuffer");
+  // Same as the validating decoder, except that the driver checks a buffer is
+  // bound to the target.
+  TangoHandler* tango_handler = TangoHandler::getInstance();
+  uint32_t number_of_points = 0;
+  float points_transform_matrix[16];
+  std::vector<float> points(
+      tango_handler->getMaxNumberOfPointsInPointCloud() * 3);
+  if (points.empty() ||
+      !tango_handler->getPointCloud(&number_of_points, points.data(), false, 0,
+                                    true, points_transform_matrix)) {
+    number_of_points = 0;
+  }
+
+  FlushErrors();
+  GLint size = 0;
+  GLint current_usage = 0;
+  glGetBufferParameteriv(target, GL_BUFFER_SIZE, &size);
+  glGetBufferParameteriv(target, GL_BUFFER_USAGE, &current_usage);
+  if (static_cast<size_t>(size) != points.size() * sizeof(float) ||
+      static_cast<GLenum>(current_usage) != usage) {
+    glBufferData(target, points.size() * sizeof(float), nullptr, usage);
+  }
+  if (number_of_points > 0) {
+    glBufferSubData(target, 0, number_of_points * 3 * sizeof(float),
+                    points.data());
+  }
+  tango_handler->setUploadedNumberOfPoints(FlushErrors() ? 0
+                                                         : number_of_points);
+  return error::kNoError;
+}
+
+error::Error GLES2DecoderPassthroughImpl::DoUpdateDepthImageTexture(
+    GLuint texture,
+    GLboolean dense) {
+  TRACE_EVENT2("gpu", "GLES2DecoderPassthroughImpl::DoUpdateDepthImageTexture",
+               "texture", texture, "dense", dense);
+  auto texture_object_iter = resources_->texture_object_map.find(texture);
+  if (texture_object_iter == resources_->texture_object_map.end() ||
+      texture_object_iter->second->target() != GL_TEXTURE_2D) {
+    InsertError(GL_INVALID_OPERATION, "not a 2D texture");
+    return error::kNoError;
+  }
+
+  // Same as the validating decoder: a single pixel without depth is uploaded
+  // until the first depth image is available.
+  TangoHandler* tango_handler = TangoHandler::getInstance();
+  tango_chromium::DepthImage depth_image;
+  bool has_depth_image = dense ? tango_handler->getDenseDepthImage(depth_image)
+                               : tango_handler->getDepthImage(depth_image);
+  if (!has_depth_image) {
+    depth_image.width = depth_image.height = 1;
+    depth_image.depth.assign(1, 0);
+  }
+
+  // The rows are tightly packed and the data is not in a pixel unpack buffer.
+  // The unpack state of the client is the state of the context in this
+  // decoder, so it is restored after the upload. The pixel unpack buffer can
+  // only be queried in ES3 contexts, which also have the other parameters.
+  FlushErrors();
+  GLint unpack_alignment = 4;
+  GLint unpack_buffer = 0;
+  GLint unpack_row_length = 0;
+  GLint unpack_skip_pixels = 0;
+  GLint unpack_skip_rows = 0;
+  glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_alignment);
+  glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &unpack_buffer);
+  bool es3 = glGetError() == GL_NO_ERROR;
+  if (es3) {
+    glGetIntegerv(GL_UNPACK_ROW_LENGTH, &unpack_row_length);
+    glGetIntegerv(GL_UNPACK_SKIP_PIXELS, &unpack_skip_pixels);
+    glGetIntegerv(GL_UNPACK_SKIP_ROWS, &unpack_skip_rows);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+  glBindTexture(GL_TEXTURE_2D, texture_object_iter->second->service_id());
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, depth_image.width,
+               depth_image.height, 0, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE,
+               depth_image.depth.data());
+  // The errors of the upload are the client's.
+  FlushErrors();
+
+  GLuint bound_texture = 0;
+  auto bound_textures_iter = bound_textures_.find(GL_TEXTURE_2D);
+  if (bound_textures_iter != bound_textures_.end() &&
+      bound_textures_iter->second.size() > active_texture_unit_) {
+    bound_texture = bound_textures_iter->second[active_texture_unit_];
+  }
+  glBindTexture(GL_TEXTURE_2D,
+                GetTextureServiceID(bound_texture, resources_, false));
+  glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+  if (es3) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpack_buffer);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, unpack_row_length);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, unpack_skip_pixels);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, unpack_skip_rows);
+  }
+  return error::kNoError;
+}
+
+error::Error GLES2DecoderPassthroughImpl::DoDrawCameraBackground(
+    GLuint copy_texture,
+    GLsizei copy_width,
+    GLsizei copy_height) {
+  // Not supported: the camera frames are latched into the textures shared by
+  // the validating decoders of the share group (see
+  // GLES2DecoderImpl::LatchCameraFrame), and CameraBackgroundResourceManager
+  // restores the state the validating decoder tracks, which this decoder does
+  // not. The page gets an error instead of a missing background.
+  InsertError(GL_INVALID_OPERATION,
+              "glDrawCameraBackground is not supported by the passthrough "
+              "decoder");
   return error::kNoError;
 }
 // WebAR END
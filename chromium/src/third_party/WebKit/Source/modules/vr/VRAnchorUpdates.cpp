@@ -0,0 +1,58 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "modules/vr/VRAnchorUpdates.h"
+
+#include <string.h>
+
+namespace blink {
+
+VRAnchorUpdates::VRAnchorUpdates(): m_numberOfUpdates(0) {
+  m_anchorIds = DOMUint32Array::create(0);
+  m_modelMatrices = DOMFloat32Array::create(0);
+}
+
+unsigned VRAnchorUpdates::numberOfUpdates() const
+{
+  return m_numberOfUpdates;
+}
+
+DOMUint32Array* VRAnchorUpdates::anchorIds() const
+{
+  return m_anchorIds;
+}
+
+DOMFloat32Array* VRAnchorUpdates::modelMatrices() const
+{
+  return m_modelMatrices;
+}
+
+void VRAnchorUpdates::setAnchorUpdates(device::mojom::blink::VRAnchorUpdatesPtr& anchorUpdatesPtr) {
+  if (anchorUpdatesPtr.is_null() || anchorUpdatesPtr->modelMatrices.size() != anchorUpdatesPtr->anchorIds.size() * 16)
+  {
+    m_numberOfUpdates = 0;
+    return;
+  }
+  m_numberOfUpdates = anchorUpdatesPtr->anchorIds.size();
+  if (m_numberOfUpdates > m_anchorIds->length())
+  {
+    // Grow geometrically so a steady number of updates does not keep
+    // reallocating the arrays.
+    unsigned capacity = std::max(m_numberOfUpdates, m_anchorIds->length() * 2);
+    m_anchorIds = DOMUint32Array::create(capacity);
+    m_modelMatrices = DOMFloat32Array::create(capacity * 16);
+  }
+  if (m_numberOfUpdates > 0)
+  {
+    memcpy(m_anchorIds->data(), anchorUpdatesPtr->anchorIds.data(), m_numberOfUpdates * sizeof(uint32_t));
+    memcpy(m_modelMatrices->data(), anchorUpdatesPtr->modelMatrices.data(), m_numberOfUpdates * 16 * sizeof(float));
+  }
+}
+
+DEFINE_TRACE(VRAnchorUpdates) {
+  visitor->trace(m_anchorIds);
+  visitor->trace(m_modelMatrices);
+}
+
+} // namespace blink
@@ -0,0 +1,43 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef VRAnchorUpdates_h
+#define VRAnchorUpdates_h
+
+#include "bindings/core/v8/ScriptWrappable.h"
+#include "core/dom/DOMTypedArray.h"
+#include "device/vr/vr_service.mojom-blink.h"
+#include "platform/heap/Handle.h"
+#include "wtf/Forward.h"
+
+namespace blink {
+
+// The anchors whose model matrix changed since the previous call to
+// VRDisplay.getAnchorUpdates. Only the first numberOfUpdates ids (and
+// numberOfUpdates * 16 matrix elements) are valid. The arrays are reused
+// between updates and only reallocated when they need to grow.
+class VRAnchorUpdates final : public GarbageCollected<VRAnchorUpdates>, public ScriptWrappable {
+    DEFINE_WRAPPERTYPEINFO();
+public:
+    static VRAnchorUpdates* create() { return new VRAnchorUpdates(); }
+
+    VRAnchorUpdates();
+
+    unsigned numberOfUpdates() const;
+    DOMUint32Array* anchorIds() const;
+    DOMFloat32Array* modelMatrices() const;
+
+    void setAnchorUpdates(device::mojom::blink::VRAnchorUpdatesPtr& anchorUpdatesPtr);
+
+    DECLARE_VIRTUAL_TRACE()
+
+private:
+    unsigned m_numberOfUpdates;
+    Member<DOMUint32Array> m_anchorIds;
+    Member<DOMFloat32Array> m_modelMatrices;
+};
+
+} // namespace blink
+
+#endif // VRAnchorUpdates_h
@@ -0,0 +1,32 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "modules/vr/VRDepthImage.h"
+
+namespace blink {
+
+VRDepthImage::VRDepthImage(bool dense): m_dense(dense)
+  , m_width(0)
+  , m_height(0) {
+}
+
+unsigned long VRDepthImage::width() const
+{
+  return m_width;
+}
+
+unsigned long VRDepthImage::height() const
+{
+  return m_height;
+}
+
+void VRDepthImage::setSize(unsigned long width, unsigned long height) {
+  m_width = width;
+  m_height = height;
+}
+
+DEFINE_TRACE(VRDepthImage) {
+}
+
+} // namespace blink
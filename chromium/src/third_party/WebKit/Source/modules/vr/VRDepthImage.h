@@ -0,0 +1,37 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef VRDepthImage_h
+#define VRDepthImage_h
+
+#include "bindings/core/v8/ScriptWrappable.h"
+#include "platform/heap/Handle.h"
+
+namespace blink {
+
+// The size of the depth image of the device. The image itself never leaves
+// the GPU process.
+class VRDepthImage final : public GarbageCollected<VRDepthImage>, public ScriptWrappable {
+    DEFINE_WRAPPERTYPEINFO();
+public:
+    explicit VRDepthImage(bool dense);
+
+    unsigned long width() const;
+    unsigned long height() const;
+
+    // Whether the holes of the image are filled.
+    bool isDense() const { return m_dense; }
+
+    void setSize(unsigned long width, unsigned long height);
+
+    DECLARE_VIRTUAL_TRACE()
+private:
+    bool m_dense;
+    unsigned long m_width;
+    unsigned long m_height;
+};
+
+} // namespace blink
+
+#endif // VRDepthImage_h
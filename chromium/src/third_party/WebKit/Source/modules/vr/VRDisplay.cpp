@@ -25,14 +25,19 @@
 #include "modules/vr/VRStageParameters.h"
 #include "modules/vr/VRPointCloud.h"
 #include "modules/vr/VRHit.h"
+#include "modules/vr/VRHitResults.h"
 #include "modules/vr/VRPassThroughCamera.h"
 #include "modules/vr/VRADF.h"
 #include "modules/vr/VRMarker.h"
+#include "modules/vr/VRAnchorUpdates.h"
+#include "modules/vr/VRLatencyStats.h"
 #include "modules/webgl/WebGLRenderingContextBase.h"
 #include "platform/Histogram.h"
 #include "platform/UserGestureIndicator.h"
+#include "platform/tracing/TraceEvent.h"
 #include "public/platform/Platform.h"
 #include "wtf/AutoReset.h"
+#include "wtf/CurrentTime.h"
 
 #include <array>
 
@@ -98,9 +103,15 @@ VRDisplay::VRDisplay(NavigatorVR* navigatorVR,
       m_fullscreenCheckTimer(this, &VRDisplay::onFullscreenCheck),
       m_contextGL(nullptr),
       m_animationCallbackRequested(false),
+      m_animationFramesFollowCamera(false),
+      m_hasFrameAvailableEvents(false),
+      m_frameAvailableRequested(false),
       m_inAnimationFrame(false),
       m_display(std::move(display)),
-      m_binding(this, std::move(request)) {}
+      m_binding(this, std::move(request)) {
+  for (double& captureTime : m_frameCaptureTimes)
+    captureTime = 0;
+}
 
 VRDisplay::~VRDisplay() {}
 
@@ -123,6 +134,7 @@ void VRDisplay::update(const device::mojom::blink::VRDisplayInfoPtr& display) {
   m_capabilities->setHasPassThroughCamera(display->capabilities->hasPassThroughCamera);
   m_capabilities->setHasADFSupport(display->capabilities->hasADFSupport);
   m_capabilities->setHasMarkerSupport(display->capabilities->hasMarkerSupport);
+  m_hasFrameAvailableEvents = display->capabilities->hasFrameAvailableEvents;
 
   // Ignore non presenting delegate
   bool isValid = display->leftEye->renderWidth > 0;
@@ -170,8 +182,13 @@ bool VRDisplay::getFrameData(VRFrameData* frameData) {
   if (m_depthNear == m_depthFar)
     return false;
 
-  return frameData->update(m_framePose, m_eyeParametersLeft,
-                           m_eyeParametersRight, m_depthNear, m_depthFar);
+  if (!frameData->update(m_framePose, m_eyeParametersLeft,
+                         m_eyeParametersRight, m_depthNear, m_depthFar))
+    return false;
+
+  onSampleExposed(device::mojom::blink::VRSampleType::POSE,
+                  m_framePose->timing);
+  return true;
 }
 
 VRPose* VRDisplay::getPose() {
@@ -182,9 +199,26 @@ VRPose* VRDisplay::getPose() {
 
   VRPose* pose = VRPose::create();
   pose->setPose(m_framePose);
+  onSampleExposed(device::mojom::blink::VRSampleType::POSE,
+                  m_framePose->timing);
   return pose;
 }
 
+bool VRDisplay::getPoseInto(VRPose* pose) {
+  if (!pose)
+    return false;
+
+  updatePose();
+
+  if (!m_framePose)
+    return false;
+
+  pose->updatePose(m_framePose);
+  onSampleExposed(device::mojom::blink::VRSampleType::POSE,
+                  m_framePose->timing);
+  return true;
+}
+
 void VRDisplay::updatePose() {
   if (m_displayBlurred) {
     // WebVR spec says to return a null pose when the display is blurred.
@@ -196,6 +230,8 @@ void VRDisplay::updatePose() {
       return;
     device::mojom::blink::VRPosePtr pose;
     m_display->GetPose(&pose);
+    if (pose)
+      onSampleReceived(device::mojom::blink::VRSampleType::POSE, pose->timing);
     m_framePose = std::move(pose);
     if (m_isPresenting)
       m_canUpdateFramePose = false;
@@ -215,9 +251,17 @@ void VRDisplay::getPointCloud(VRPointCloud* pointCloud, bool justUpdatePointClou
 
   device::mojom::blink::VRPointCloudPtr mojoPointCloud;
   m_display->GetPointCloud(justUpdatePointCloud, pointsToSkip, transformPoints, &mojoPointCloud);
+  if (!mojoPointCloud)
+    return;
+  if (justUpdatePointCloud) {
+    // The points are only uploaded into WebGL buffers.
+    pointCloud->setUploadedNumberOfPoints(mojoPointCloud->numberOfPoints, mojoPointCloud->maxNumberOfPoints);
+    return;
+  }
+  onSampleReceived(device::mojom::blink::VRSampleType::POINT_CLOUD, mojoPointCloud->timing);
 
-  unsigned maxNumberOfPoints = mojoPointCloud->points.size();
-  pointCloud->setPointCloud(maxNumberOfPoints, mojoPointCloud);
+  pointCloud->setPointCloud(pointsToSkip, mojoPointCloud);
+  onSampleExposed(device::mojom::blink::VRSampleType::POINT_CLOUD, mojoPointCloud->timing);
 }
 
 HeapVector<Member<VRHit>> VRDisplay::hitTest(float x, float y) {
@@ -241,6 +285,17 @@ HeapVector<Member<VRHit>> VRDisplay::hitTest(float x, float y) {
   return hits;
 }
 
+void VRDisplay::hitTestInto(float x, float y, VRHitResults* hitResults)
+{
+  if (!hitResults)
+    return;
+
+  Vector<device::mojom::blink::VRHitPtr> hitPtrs;
+  if (m_display)
+    m_display->HitTest(x, y, &hitPtrs);
+  hitResults->setHits(hitPtrs);
+}
+
 VRPassThroughCamera* VRDisplay::getPassThroughCamera()
 {
   if (!m_display || !m_passThroughCamera)
@@ -252,7 +307,9 @@ VRPassThroughCamera* VRDisplay::getPassThroughCamera()
     return nullptr;
   }
   else {
+    onSampleReceived(device::mojom::blink::VRSampleType::CAMERA_FRAME, passThroughCamera->timing);
     m_passThroughCamera->setPassThroughCamera(passThroughCamera);
+    onSampleExposed(device::mojom::blink::VRSampleType::CAMERA_FRAME, passThroughCamera->timing);
   }
   return m_passThroughCamera;
 }
@@ -276,18 +333,43 @@ HeapVector<Member<VRADF>> VRDisplay::getADFs()
   return adfs;
 }
 
-void VRDisplay::enableADF(const String& uuid)
+ScriptPromise VRDisplay::enableADF(ScriptState* scriptState, const String& uuid)
 {
-  if (!m_display)
-    return;
-  m_display->EnableADF(uuid);
+  ScriptPromiseResolver* resolver = ScriptPromiseResolver::create(scriptState);
+  ScriptPromise promise = resolver->promise();
+  if (!m_display) {
+    DOMException* exception = DOMException::create(
+        InvalidStateError, "The service is no longer active.");
+    resolver->reject(exception);
+    return promise;
+  }
+  m_display->EnableADF(uuid, convertToBaseCallback(WTF::bind(
+                                 &VRDisplay::onADFSwitchComplete,
+                                 wrapPersistent(this),
+                                 wrapPersistent(resolver))));
+  return promise;
 }
 
-void VRDisplay::disableADF()
+ScriptPromise VRDisplay::disableADF(ScriptState* scriptState)
 {
-  if (!m_display)
-    return;
-  m_display->DisableADF();
+  ScriptPromiseResolver* resolver = ScriptPromiseResolver::create(scriptState);
+  ScriptPromise promise = resolver->promise();
+  if (!m_display) {
+    DOMException* exception = DOMException::create(
+        InvalidStateError, "The service is no longer active.");
+    resolver->reject(exception);
+    return promise;
+  }
+  m_display->DisableADF(convertToBaseCallback(WTF::bind(
+      &VRDisplay::onADFSwitchComplete,
+      wrapPersistent(this),
+      wrapPersistent(resolver))));
+  return promise;
+}
+
+void VRDisplay::onADFSwitchComplete(ScriptPromiseResolver* resolver, bool success)
+{
+  resolver->resolve(success);
 }
 
 HeapVector<Member<VRMarker>> VRDisplay::getMarkers(unsigned markerType, float markerSize)
@@ -309,6 +391,71 @@ HeapVector<Member<VRMarker>> VRDisplay::getMarkers(unsigned markerType, float ma
   return markers;
 }
 
+unsigned VRDisplay::createAnchor(DOMFloat32Array* modelMatrix)
+{
+  if (!m_display || !modelMatrix || modelMatrix->length() != 16)
+    return 0;
+  Vector<float> mojomModelMatrix;
+  mojomModelMatrix.append(modelMatrix->data(), 16);
+  unsigned anchorId = 0;
+  m_display->CreateAnchor(mojomModelMatrix, &anchorId);
+  return anchorId;
+}
+
+void VRDisplay::removeAnchor(unsigned anchorId)
+{
+  if (!m_display)
+    return;
+  m_display->RemoveAnchor(anchorId);
+}
+
+void VRDisplay::getAnchorUpdates(VRAnchorUpdates* anchorUpdates)
+{
+  if (!m_display || !anchorUpdates)
+    return;
+  device::mojom::blink::VRAnchorUpdatesPtr mojomAnchorUpdates;
+  m_display->GetAnchorUpdates(&mojomAnchorUpdates);
+  anchorUpdates->setAnchorUpdates(mojomAnchorUpdates);
+}
+
+HeapVector<Member<VRLatencyStats>> VRDisplay::getPerformanceStats()
+{
+  HeapVector<Member<VRLatencyStats>> stats;
+  // The device measures the hops up to the IPC, the renderer the others.
+  Vector<device::mojom::blink::VRLatencyStatsPtr> mojomStats;
+  if (m_display)
+    m_display->GetPerformanceStats(&mojomStats);
+  m_latencyStatistics.appendStats(&mojomStats);
+  stats.resize(mojomStats.size());
+  for (size_t i = 0; i < mojomStats.size(); i++)
+  {
+    VRLatencyStats* latencyStats = new VRLatencyStats();
+    latencyStats->setLatencyStats(mojomStats[i]);
+    stats[i] = latencyStats;
+  }
+  return stats;
+}
+
+void VRDisplay::onSampleReceived(
+    device::mojom::blink::VRSampleType sample,
+    const device::mojom::blink::VRSampleTimingPtr& timing) {
+  if (timing) {
+    m_latencyStatistics.record(sample, device::mojom::blink::VRLatencyHop::IPC,
+                               timing->captureTime);
+  }
+}
+
+void VRDisplay::onSampleExposed(
+    device::mojom::blink::VRSampleType sample,
+    const device::mojom::blink::VRSampleTimingPtr& timing) {
+  if (!timing)
+    return;
+  m_latencyStatistics.record(sample, device::mojom::blink::VRLatencyHop::BLINK,
+                             timing->captureTime);
+  if (m_inAnimationFrame)
+    m_frameCaptureTimes[static_cast<int>(sample)] = timing->captureTime;
+}
+
 VREyeParameters* VRDisplay::getEyeParameters(const String& whichEye) {
   switch (stringToVREye(whichEye)) {
     case VREyeLeft:
@@ -326,7 +473,7 @@ int VRDisplay::requestAnimationFrame(FrameRequestCallback* callback) {
     return 0;
 
   if (!m_animationCallbackRequested) {
-    doc->requestAnimationFrame(new VRDisplayFrameRequestCallback(this));
+    scheduleAnimationFrame(doc);
     m_animationCallbackRequested = true;
   }
 
@@ -340,6 +487,45 @@ void VRDisplay::cancelAnimationFrame(int id) {
   m_scriptedAnimationController->cancelCallback(id);
 }
 
+void VRDisplay::setAnimationFramesFollowCamera(bool value) {
+  if (m_animationFramesFollowCamera == value)
+    return;
+  m_animationFramesFollowCamera = value;
+
+  // The frame already requested may not come in the new mode: request one
+  // again. Whichever comes first runs the callbacks.
+  if (m_animationCallbackRequested) {
+    if (Document* doc = document())
+      scheduleAnimationFrame(doc);
+  }
+}
+
+void VRDisplay::scheduleAnimationFrame(Document* doc) {
+  if (m_animationFramesFollowCamera && m_hasFrameAvailableEvents && m_display) {
+    // The device answers once, when the next camera frame is available.
+    if (!m_frameAvailableRequested) {
+      m_display->RequestFrameAvailable();
+      m_frameAvailableRequested = true;
+    }
+    return;
+  }
+  doc->requestAnimationFrame(new VRDisplayFrameRequestCallback(this));
+}
+
+void VRDisplay::OnFrameAvailable() {
+  m_frameAvailableRequested = false;
+  if (!m_animationFramesFollowCamera || !m_animationCallbackRequested)
+    return;
+  if (!document())
+    return;
+
+  // The callbacks run right away instead of waiting for the next frame of the
+  // document, so the page starts working on the camera frame as soon as it
+  // is available.
+  TRACE_EVENT0("gpu", "VRDisplay::OnFrameAvailable");
+  serviceScriptedAnimations(monotonicallyIncreasingTime());
+}
+
 void VRDisplay::OnBlur() {
   m_displayBlurred = true;
 
@@ -358,7 +544,7 @@ void VRDisplay::OnFocus() {
     Document* doc = this->document();
     if (!doc)
       return;
-    doc->requestAnimationFrame(new VRDisplayFrameRequestCallback(this));
+    scheduleAnimationFrame(doc);
   }
   m_navigatorVR->enqueueVREvent(VRDisplayEvent::create(
       EventTypeNames::vrdisplayfocus, true, false, this, ""));
@@ -378,6 +564,30 @@ void VRDisplay::serviceScriptedAnimations(double monotonicAnimationStartTime) {
     return;
   m_scriptedAnimationController->serviceScriptedAnimations(
       monotonicAnimationStartTime);
+
+  // The frame has been rendered with the samples the callbacks used, their
+  // age now approximates the motion to photon latency up to the submission
+  // of the GL commands.
+  double now = monotonicallyIncreasingTime();
+  if (m_frameCaptureTimes[0] > 0) {
+    TRACE_COUNTER1("gpu", "WebVRPoseToSubmitUs",
+                   (now - m_frameCaptureTimes[0]) * 1e6);
+  }
+  if (m_frameCaptureTimes[1] > 0) {
+    TRACE_COUNTER1("gpu", "WebVRPointCloudToSubmitUs",
+                   (now - m_frameCaptureTimes[1]) * 1e6);
+  }
+  if (m_frameCaptureTimes[2] > 0) {
+    TRACE_COUNTER1("gpu", "WebVRCameraFrameToSubmitUs",
+                   (now - m_frameCaptureTimes[2]) * 1e6);
+  }
+  for (int sample = 0; sample < 3; sample++) {
+    m_latencyStatistics.record(
+        static_cast<device::mojom::blink::VRSampleType>(sample),
+        device::mojom::blink::VRLatencyHop::SUBMIT,
+        m_frameCaptureTimes[sample]);
+    m_frameCaptureTimes[sample] = 0;
+  }
 }
 
 void ReportPresentationResult(PresentationResult result) {
@@ -11,6 +11,7 @@
 #include "core/dom/DOMTypedArray.h"
 #include "device/vr/vr_service.mojom-blink.h"
 #include "modules/vr/VRDisplayCapabilities.h"
+#include "modules/vr/VRLatencyStatistics.h"
 #include "modules/vr/VRLayer.h"
 #include "mojo/public/cpp/bindings/binding.h"
 #include "platform/Timer.h"
@@ -37,9 +38,12 @@ class VRStageParameters;
 class VRPose;
 class VRPointCloud;
 class VRHit;
+class VRHitResults;
 class VRPassThroughCamera;
 class VRADF;
 class VRMarker;
+class VRAnchorUpdates;
+class VRLatencyStats;
 
 class WebGLRenderingContextBase;
 
@@ -67,15 +71,21 @@ class VRDisplay final : public EventTargetWithInlineData,
 
   bool getFrameData(VRFrameData*);
   VRPose* getPose();
+  bool getPoseInto(VRPose*);
   void resetPose();
 
   void getPointCloud(VRPointCloud* pointCloud, bool justUpdatePointCloud, unsigned pointsToSkip, bool transformPoints);
   HeapVector<Member<VRHit>> hitTest(float x, float y);
+  void hitTestInto(float x, float y, VRHitResults* hitResults);
   VRPassThroughCamera* getPassThroughCamera();
   HeapVector<Member<VRADF>> getADFs();
-  void enableADF(const String&);
-  void disableADF();
+  ScriptPromise enableADF(ScriptState*, const String&);
+  ScriptPromise disableADF(ScriptState*);
   HeapVector<Member<VRMarker>> getMarkers(unsigned markerType, float markerSize);
+  unsigned createAnchor(DOMFloat32Array* modelMatrix);
+  void removeAnchor(unsigned anchorId);
+  void getAnchorUpdates(VRAnchorUpdates* anchorUpdates);
+  HeapVector<Member<VRLatencyStats>> getPerformanceStats();
 
   double depthNear() const { return m_depthNear; }
   double depthFar() const { return m_depthFar; }
@@ -87,6 +97,10 @@ class VRDisplay final : public EventTargetWithInlineData,
 
   int requestAnimationFrame(FrameRequestCallback*);
   void cancelAnimationFrame(int id);
+  bool animationFramesFollowCamera() const {
+    return m_animationFramesFollowCamera;
+  }
+  void setAnimationFramesFollowCamera(bool);
   void serviceScriptedAnimations(double monotonicAnimationStartTime);
 
   ScriptPromise requestPresent(ScriptState*, const HeapVector<VRLayer>& layers);
@@ -132,6 +146,14 @@ class VRDisplay final : public EventTargetWithInlineData,
  private:
   void onFullscreenCheck(TimerBase*);
   void onPresentComplete(bool);
+  void onADFSwitchComplete(ScriptPromiseResolver*, bool);
+
+  // Record the age of the samples when they are received from the device and
+  // when they are exposed to script.
+  void onSampleReceived(device::mojom::blink::VRSampleType,
+                        const device::mojom::blink::VRSampleTimingPtr&);
+  void onSampleExposed(device::mojom::blink::VRSampleType,
+                       const device::mojom::blink::VRSampleTimingPtr&);
 
   void onConnected();
   void onDisconnected();
@@ -145,8 +167,12 @@ class VRDisplay final : public EventTargetWithInlineData,
   void OnFocus() override;
   void OnActivate(device::mojom::blink::VRDisplayEventReason) override;
   void OnDeactivate(device::mojom::blink::VRDisplayEventReason) override;
+  void OnFrameAvailable() override;
 
   ScriptedAnimationController& ensureScriptedAnimationController(Document*);
+  // Requests the next animation frame from the document, or from the device
+  // if the animation frames follow the camera.
+  void scheduleAnimationFrame(Document*);
 
   Member<NavigatorVR> m_navigatorVR;
   unsigned m_displayId;
@@ -177,6 +203,11 @@ class VRDisplay final : public EventTargetWithInlineData,
 
   Member<ScriptedAnimationController> m_scriptedAnimationController;
   bool m_animationCallbackRequested;
+  bool m_animationFramesFollowCamera;
+  // Whether the device sends OnFrameAvailable, and whether one was requested
+  // and has not been received yet.
+  bool m_hasFrameAvailableEvents;
+  bool m_frameAvailableRequested;
   bool m_inAnimationFrame;
   bool m_displayBlurred;
   bool m_reenteredFullscreen;
@@ -186,6 +217,11 @@ class VRDisplay final : public EventTargetWithInlineData,
   mojo::Binding<device::mojom::blink::VRDisplayClient> m_binding;
 
   HeapDeque<Member<ScriptPromiseResolver>> m_pendingPresentResolvers;
+
+  VRLatencyStatistics m_latencyStatistics;
+  // The capture times of the samples exposed during the current animation
+  // frame, by VRSampleType, 0 for the types that were not used.
+  double m_frameCaptureTimes[3];
 };
 
 using VRDisplayVector = HeapVector<Member<VRDisplay>>;
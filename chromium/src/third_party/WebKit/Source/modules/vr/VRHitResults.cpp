@@ -0,0 +1,48 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "modules/vr/VRHitResults.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace blink {
+
+VRHitResults::VRHitResults(): m_numberOfHits(0) {
+  m_modelMatrices = DOMFloat32Array::create(0);
+}
+
+unsigned VRHitResults::numberOfHits() const
+{
+  return m_numberOfHits;
+}
+
+DOMFloat32Array* VRHitResults::modelMatrices() const
+{
+  return m_modelMatrices;
+}
+
+void VRHitResults::setHits(const Vector<device::mojom::blink::VRHitPtr>& hitPtrs) {
+  m_numberOfHits = 0;
+  unsigned capacity = m_modelMatrices->length() / 16;
+  if (hitPtrs.size() > capacity)
+  {
+    // Grow geometrically, like VRAnchorUpdates.
+    capacity = std::max(static_cast<unsigned>(hitPtrs.size()), capacity * 2);
+    m_modelMatrices = DOMFloat32Array::create(capacity * 16);
+  }
+  for (const auto& hitPtr : hitPtrs)
+  {
+    if (hitPtr.is_null() || hitPtr->modelMatrix.size() != 16)
+      continue;
+    memcpy(m_modelMatrices->data() + m_numberOfHits * 16, hitPtr->modelMatrix.data(), 16 * sizeof(float));
+    m_numberOfHits++;
+  }
+}
+
+DEFINE_TRACE(VRHitResults) {
+  visitor->trace(m_modelMatrices);
+}
+
+} // namespace blink
@@ -0,0 +1,39 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef VRHitResults_h
+#define VRHitResults_h
+
+#include "bindings/core/v8/ScriptWrappable.h"
+#include "core/dom/DOMTypedArray.h"
+#include "device/vr/vr_service.mojom-blink.h"
+#include "platform/heap/Handle.h"
+#include "wtf/Forward.h"
+
+namespace blink {
+
+// The results of VRDisplay::hitTestInto, which reuses the same arrays from one
+// call to the next instead of allocating a VRHit per result.
+class VRHitResults final : public GarbageCollected<VRHitResults>, public ScriptWrappable {
+    DEFINE_WRAPPERTYPEINFO();
+public:
+    static VRHitResults* create() { return new VRHitResults(); }
+
+    VRHitResults();
+
+    unsigned numberOfHits() const;
+    DOMFloat32Array* modelMatrices() const;
+
+    void setHits(const Vector<device::mojom::blink::VRHitPtr>& hitPtrs);
+
+    DECLARE_VIRTUAL_TRACE()
+
+private:
+    unsigned m_numberOfHits;
+    Member<DOMFloat32Array> m_modelMatrices;
+};
+
+} // namespace blink
+
+#endif // VRHitResults_h
@@ -0,0 +1,112 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "modules/vr/VRLatencyStatistics.h"
+
+#include "wtf/CurrentTime.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+namespace blink {
+
+namespace {
+
+const double kSmallestBucket = 0.1;
+const int kBucketsPerOctave = 8;
+
+}  // namespace
+
+VRLatencyStatistics::VRLatencyStatistics() {
+  memset(m_histograms, 0, sizeof(m_histograms));
+}
+
+int VRLatencyStatistics::hopIndex(device::mojom::blink::VRLatencyHop hop) {
+  switch (hop) {
+    case device::mojom::blink::VRLatencyHop::IPC:
+      return 0;
+    case device::mojom::blink::VRLatencyHop::BLINK:
+      return 1;
+    case device::mojom::blink::VRLatencyHop::SUBMIT:
+      return 2;
+    default:
+      return -1;
+  }
+}
+
+void VRLatencyStatistics::record(device::mojom::blink::VRSampleType sample,
+                                 device::mojom::blink::VRLatencyHop hop,
+                                 double captureTime) {
+  int index = hopIndex(hop);
+  if (captureTime <= 0 || index < 0)
+    return;
+
+  double milliseconds = (monotonicallyIncreasingTime() - captureTime) * 1000;
+  Histogram& histogram = m_histograms[static_cast<int>(sample)][index];
+  int bucket = 0;
+  if (milliseconds > kSmallestBucket) {
+    bucket = std::min(kNumberOfBuckets - 1,
+                      static_cast<int>(kBucketsPerOctave *
+                                       std::log2(milliseconds / kSmallestBucket)));
+  }
+  histogram.buckets[bucket]++;
+  histogram.min = histogram.count ? std::min(histogram.min, milliseconds)
+                                  : milliseconds;
+  histogram.max = histogram.count ? std::max(histogram.max, milliseconds)
+                                  : milliseconds;
+  histogram.count++;
+  histogram.sum += milliseconds;
+}
+
+double VRLatencyStatistics::percentile(const Histogram& histogram,
+                                       double fraction) {
+  unsigned rank = std::max(
+      1u, static_cast<unsigned>(std::ceil(fraction * histogram.count)));
+  unsigned cumulative = 0;
+  for (int bucket = 0; bucket < kNumberOfBuckets; bucket++) {
+    cumulative += histogram.buckets[bucket];
+    if (cumulative < rank)
+      continue;
+    // The geometric center of the bucket, the first and the last buckets are
+    // open ended.
+    if (bucket == 0)
+      return histogram.min;
+    if (bucket == kNumberOfBuckets - 1)
+      return histogram.max;
+    double center =
+        kSmallestBucket * std::exp2((bucket + 0.5) / kBucketsPerOctave);
+    return std::max(histogram.min, std::min(histogram.max, center));
+  }
+  return histogram.max;
+}
+
+void VRLatencyStatistics::appendStats(
+    Vector<device::mojom::blink::VRLatencyStatsPtr>* stats) const {
+  const device::mojom::blink::VRLatencyHop hops[kNumberOfHops] = {
+      device::mojom::blink::VRLatencyHop::IPC,
+      device::mojom::blink::VRLatencyHop::BLINK,
+      device::mojom::blink::VRLatencyHop::SUBMIT};
+  for (int sample = 0; sample < kNumberOfSamples; sample++) {
+    for (int hop = 0; hop < kNumberOfHops; hop++) {
+      const Histogram& histogram = m_histograms[sample][hop];
+      if (!histogram.count)
+        continue;
+      device::mojom::blink::VRLatencyStatsPtr stat =
+          device::mojom::blink::VRLatencyStats::New();
+      stat->sample = static_cast<device::mojom::blink::VRSampleType>(sample);
+      stat->hop = hops[hop];
+      stat->count = histogram.count;
+      stat->mean = histogram.sum / histogram.count;
+      stat->min = histogram.min;
+      stat->max = histogram.max;
+      stat->p50 = percentile(histogram, 0.5);
+      stat->p90 = percentile(histogram, 0.9);
+      stat->p99 = percentile(histogram, 0.99);
+      stats->append(std::move(stat));
+    }
+  }
+}
+
+}  // namespace blink
@@ -0,0 +1,55 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef VRLatencyStatistics_h
+#define VRLatencyStatistics_h
+
+#include "device/vr/vr_service.mojom-blink.h"
+#include "wtf/Allocator.h"
+#include "wtf/Noncopyable.h"
+#include "wtf/Vector.h"
+
+namespace blink {
+
+// The ages of the sensor samples measured in the renderer: when they are
+// received from the device (IPC), when they are exposed to script (BLINK) and
+// at the end of the animation frame that used them (SUBMIT). The ages are kept
+// in histograms with logarithmic buckets (8 per octave, from 0.1 ms), like the
+// ones of libtango_chromium, so recording them is constant time.
+class VRLatencyStatistics {
+  DISALLOW_NEW();
+  WTF_MAKE_NONCOPYABLE(VRLatencyStatistics);
+
+ public:
+  VRLatencyStatistics();
+
+  // captureTime is in seconds on the monotonic clock, 0 if unknown.
+  void record(device::mojom::blink::VRSampleType,
+              device::mojom::blink::VRLatencyHop,
+              double captureTime);
+
+  void appendStats(Vector<device::mojom::blink::VRLatencyStatsPtr>*) const;
+
+ private:
+  static const int kNumberOfSamples = 3;
+  static const int kNumberOfHops = 3;
+  static const int kNumberOfBuckets = 136;
+
+  struct Histogram {
+    unsigned buckets[kNumberOfBuckets];
+    unsigned count;
+    double sum;
+    double min;
+    double max;
+  };
+
+  static int hopIndex(device::mojom::blink::VRLatencyHop);
+  static double percentile(const Histogram&, double);
+
+  Histogram m_histograms[kNumberOfSamples][kNumberOfHops];
+};
+
+}  // namespace blink
+
+#endif  // VRLatencyStatistics_h
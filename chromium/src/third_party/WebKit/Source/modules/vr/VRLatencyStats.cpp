@@ -0,0 +1,98 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "modules/vr/VRLatencyStats.h"
+
+namespace blink {
+
+VRLatencyStats::VRLatencyStats()
+  : m_sample(device::mojom::blink::VRSampleType::POSE)
+  , m_hop(device::mojom::blink::VRLatencyHop::CALLBACK)
+  , m_count(0), m_mean(0), m_min(0), m_max(0), m_p50(0), m_p90(0), m_p99(0)
+{
+}
+
+String VRLatencyStats::sample() const
+{
+  switch (m_sample)
+  {
+    case device::mojom::blink::VRSampleType::POINT_CLOUD:
+      return "pointcloud";
+    case device::mojom::blink::VRSampleType::CAMERA_FRAME:
+      return "cameraframe";
+    default:
+      return "pose";
+  }
+}
+
+String VRLatencyStats::hop() const
+{
+  switch (m_hop)
+  {
+    case device::mojom::blink::VRLatencyHop::DEVICE:
+      return "device";
+    case device::mojom::blink::VRLatencyHop::IPC:
+      return "ipc";
+    case device::mojom::blink::VRLatencyHop::BLINK:
+      return "blink";
+    case device::mojom::blink::VRLatencyHop::SUBMIT:
+      return "submit";
+    default:
+      return "callback";
+  }
+}
+
+unsigned VRLatencyStats::count() const
+{
+  return m_count;
+}
+
+double VRLatencyStats::mean() const
+{
+  return m_mean;
+}
+
+double VRLatencyStats::min() const
+{
+  return m_min;
+}
+
+double VRLatencyStats::max() const
+{
+  return m_max;
+}
+
+double VRLatencyStats::p50() const
+{
+  return m_p50;
+}
+
+double VRLatencyStats::p90() const
+{
+  return m_p90;
+}
+
+double VRLatencyStats::p99() const
+{
+  return m_p99;
+}
+
+void VRLatencyStats::setLatencyStats(const device::mojom::blink::VRLatencyStatsPtr& statsPtr)
+{
+  m_sample = statsPtr->sample;
+  m_hop = statsPtr->hop;
+  m_count = statsPtr->count;
+  m_mean = statsPtr->mean;
+  m_min = statsPtr->min;
+  m_max = statsPtr->max;
+  m_p50 = statsPtr->p50;
+  m_p90 = statsPtr->p90;
+  m_p99 = statsPtr->p99;
+}
+
+DEFINE_TRACE(VRLatencyStats)
+{
+}
+
+} // namespace blink
@@ -0,0 +1,47 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef VRLatencyStats_h
+#define VRLatencyStats_h
+
+#include "bindings/core/v8/ScriptWrappable.h"
+#include "device/vr/vr_service.mojom-blink.h"
+#include "platform/heap/Handle.h"
+#include "wtf/text/WTFString.h"
+
+namespace blink {
+
+class VRLatencyStats final : public GarbageCollected<VRLatencyStats>, public ScriptWrappable {
+    DEFINE_WRAPPERTYPEINFO();
+public:
+    VRLatencyStats();
+
+    String sample() const;
+    String hop() const;
+    unsigned count() const;
+    double mean() const;
+    double min() const;
+    double max() const;
+    double p50() const;
+    double p90() const;
+    double p99() const;
+
+    void setLatencyStats(const device::mojom::blink::VRLatencyStatsPtr&);
+
+    DECLARE_VIRTUAL_TRACE()
+private:
+    device::mojom::blink::VRSampleType m_sample;
+    device::mojom::blink::VRLatencyHop m_hop;
+    unsigned m_count;
+    double m_mean;
+    double m_min;
+    double m_max;
+    double m_p50;
+    double m_p90;
+    double m_p99;
+};
+
+} // namespace blink
+
+#endif // VRLatencyStats_h
@@ -14,7 +14,9 @@ VRPassThroughCamera::VRPassThroughCamera(): m_width(0)
   , m_focalLengthY(0)
   , m_pointX(0)
   , m_pointY(0)
-  , m_orientation(0) {
+  , m_orientation(0)
+  , m_depthImage(new VRDepthImage(false))
+  , m_denseDepthImage(new VRDepthImage(true)) {
 }
 
 unsigned long VRPassThroughCamera::width() const
@@ -61,6 +63,16 @@ long VRPassThroughCamera::orientation() {
   return m_orientation;
 }
 
+VRDepthImage* VRPassThroughCamera::depthImage() const
+{
+  return m_depthImage;
+}
+
+VRDepthImage* VRPassThroughCamera::denseDepthImage() const
+{
+  return m_denseDepthImage;
+}
+
 void VRPassThroughCamera::setPassThroughCamera(const device::mojom::blink::VRPassThroughCameraPtr& passThroughCameraPtr) {
   m_width = passThroughCameraPtr->width;
   m_height = passThroughCameraPtr->height;
@@ -71,9 +83,14 @@ void VRPassThroughCamera::setPassThroughCamera(const device::mojom::blink::VRPas
   m_pointX = passThroughCameraPtr->pointX;
   m_pointY = passThroughCameraPtr->pointY;
   m_orientation = passThroughCameraPtr->orientation;
+  m_depthImage->setSize(passThroughCameraPtr->depthImageWidth, passThroughCameraPtr->depthImageHeight);
+  // The dense depth images have the size of the sparse ones.
+  m_denseDepthImage->setSize(passThroughCameraPtr->depthImageWidth, passThroughCameraPtr->depthImageHeight);
 }
 
 DEFINE_TRACE(VRPassThroughCamera) {
+  visitor->trace(m_depthImage);
+  visitor->trace(m_denseDepthImage);
 }
 
 } // namespace blink
@@ -7,6 +7,7 @@
 
 #include "bindings/core/v8/ScriptWrappable.h"
 #include "device/vr/vr_service.mojom-blink.h"
+#include "modules/vr/VRDepthImage.h"
 
 namespace blink {
 
@@ -24,6 +25,8 @@ public:
     double pointX() const;
     double pointY() const;
     long orientation();
+    VRDepthImage* depthImage() const;
+    VRDepthImage* denseDepthImage() const;
 
     void setPassThroughCamera(const device::mojom::blink::VRPassThroughCameraPtr&);
 
@@ -38,6 +41,8 @@ private:
     double m_pointX;
     double m_pointY;
     long m_orientation;
+    Member<VRDepthImage> m_depthImage;
+    Member<VRDepthImage> m_denseDepthImage;
 };
 
 } // namespace blink
@@ -4,7 +4,11 @@
 
 #include "modules/vr/VRPointCloud.h"
 
-#include <float.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "mojo/public/cpp/system/buffer.h"
 
 namespace blink {
 
@@ -20,7 +24,8 @@ namespace {
 
 } // namespace
 
-VRPointCloud::VRPointCloud(): m_numberOfPoints(0), m_lastNumberOfPoints(0), m_pointsAlreadyTransformed(false) {
+VRPointCloud::VRPointCloud(): m_numberOfPoints(0), m_maxNumberOfPoints(0), m_generation(0), m_sensorTimestamp(0), m_pointsToSkip(0), m_pointsAlreadyTransformed(false) {
+	m_points = DOMFloat32Array::create(0);
 	m_pointsTransformMatrix = DOMFloat32Array::create(16);
 }
 
@@ -34,6 +39,11 @@ DOMFloat32Array* VRPointCloud::points() const
   return m_points;
 }
 
+unsigned VRPointCloud::generation() const
+{
+  return m_generation;
+}
+
 DOMFloat32Array* VRPointCloud::pointsTransformMatrix() const
 {
   return m_pointsTransformMatrix;
@@ -44,32 +54,71 @@ bool VRPointCloud::pointsAlreadyTransformed() const
 	return m_pointsAlreadyTransformed;
 }
 
-void VRPointCloud::setPointCloud(unsigned maxNumberOfPoints, device::mojom::blink::VRPointCloudPtr& pointCloudPtr) {
-	if (!m_points)
-	{
-		m_points = DOMFloat32Array::create(maxNumberOfPoints * 3);
-		std::fill_n(m_points->data(), m_numberOfPoints, std::numeric_limits<float>::max());
-	}
+void VRPointCloud::setPointCloud(unsigned pointsToSkip, device::mojom::blink::VRPointCloudPtr& pointCloudPtr) {
 	if (pointCloudPtr.is_null())
 	{
 		m_numberOfPoints = 0;
+		m_sensorTimestamp = 0;
 		std::fill_n(m_pointsTransformMatrix->data(), 16, 0);
 		m_pointsTransformMatrix->data()[0] = m_pointsTransformMatrix->data()[5] = m_pointsTransformMatrix->data()[10] = m_pointsTransformMatrix->data()[15] = 1;
+		m_generation++;
+		return;
 	}
-	else
+
+	// The device keeps returning the same point cloud until the depth camera
+	// delivers a new one. Without timing, the clouds cannot be told apart.
+	double sensorTimestamp = pointCloudPtr->timing ? pointCloudPtr->timing->sensorTimestamp : 0;
+	if (m_generation > 0 && sensorTimestamp != 0 && sensorTimestamp == m_sensorTimestamp &&
+	    pointsToSkip == m_pointsToSkip && pointCloudPtr->pointsAlreadyTransformed == m_pointsAlreadyTransformed)
 	{
-		m_numberOfPoints = pointCloudPtr->numberOfPoints;
-		if (m_numberOfPoints > 0) {
-			memcpy(m_points->data(), &(pointCloudPtr->points.front()), m_numberOfPoints * 3 * sizeof(float));
+		return;
+	}
+
+	// The points are in a buffer shared with the other renderers that retrieved
+	// the same point cloud, they are only copied out of it here.
+	unsigned length = pointCloudPtr->points.is_valid() ? pointCloudPtr->numberOfPoints * 3 : 0;
+	mojo::ScopedSharedBufferMapping mapping;
+	if (length > 0)
+	{
+		mapping = pointCloudPtr->points->Map(length * sizeof(float));
+		if (!mapping)
+		{
+			length = 0;
 		}
-		memcpy(m_pointsTransformMatrix->data(), &(pointCloudPtr->pointsTransformMatrix.front()), 16 * sizeof(float));
-		m_pointsAlreadyTransformed = pointCloudPtr->pointsAlreadyTransformed;
 	}
-	if (m_numberOfPoints < m_lastNumberOfPoints)
+
+	// The points are copied into the exposed array, which is only replaced if
+	// the point cloud does not fit. The stale points after numberOfPoints are
+	// left as they are.
+	if (m_points->length() < length)
 	{
-		std::fill_n(m_points->data() + (m_numberOfPoints * 3), (m_lastNumberOfPoints - m_numberOfPoints) * 3, std::numeric_limits<float>::max());
+		m_points = DOMFloat32Array::create(std::max(length, pointCloudPtr->maxNumberOfPoints * 3));
 	}
-	m_lastNumberOfPoints = m_numberOfPoints;
+	if (length > 0)
+	{
+		memcpy(m_points->data(), mapping.get(), length * sizeof(float));
+	}
+
+	m_numberOfPoints = length / 3;
+	m_maxNumberOfPoints = pointCloudPtr->maxNumberOfPoints;
+	memcpy(m_pointsTransformMatrix->data(), pointCloudPtr->pointsTransformMatrix.data(), 16 * sizeof(float));
+	m_pointsAlreadyTransformed = pointCloudPtr->pointsAlreadyTransformed;
+	m_sensorTimestamp = sensorTimestamp;
+	m_pointsToSkip = pointsToSkip;
+	m_generation++;
+}
+
+void VRPointCloud::setUploadedPointCloud() {
+	m_pointsAlreadyTransformed = true;
+	m_sensorTimestamp = 0;
+	std::fill_n(m_pointsTransformMatrix->data(), 16, 0);
+	m_pointsTransformMatrix->data()[0] = m_pointsTransformMatrix->data()[5] = m_pointsTransformMatrix->data()[10] = m_pointsTransformMatrix->data()[15] = 1;
+	m_generation++;
+}
+
+void VRPointCloud::setUploadedNumberOfPoints(unsigned numberOfPoints, unsigned maxNumberOfPoints) {
+	m_numberOfPoints = numberOfPoints;
+	m_maxNumberOfPoints = maxNumberOfPoints;
 }
 
 DEFINE_TRACE(VRPointCloud) {
@@ -22,16 +22,32 @@ public:
 
     unsigned int numberOfPoints() const;
     DOMFloat32Array* points() const;
+    unsigned generation() const;
     DOMFloat32Array* pointsTransformMatrix() const;
     bool pointsAlreadyTransformed() const;
 
-    void setPointCloud(unsigned maxNumberOfPoints, device::mojom::blink::VRPointCloudPtr& pointCloudPtr);
+    // The points are not copied again if the device returns the point cloud
+    // that was already retrieved with the same pointsToSkip.
+    void setPointCloud(unsigned pointsToSkip, device::mojom::blink::VRPointCloudPtr& pointCloudPtr);
+    // The points were uploaded into a WebGL buffer in the GPU process, already
+    // transformed. The arrays and numberOfPoints are left as they are.
+    void setUploadedPointCloud();
+    // The number of points the GPU process uploaded last, which it reports
+    // later than the upload.
+    void setUploadedNumberOfPoints(unsigned numberOfPoints, unsigned maxNumberOfPoints);
+    // 0 until a point cloud was retrieved.
+    unsigned maxNumberOfPoints() const { return m_maxNumberOfPoints; }
 
     DECLARE_VIRTUAL_TRACE()
 
 private:
     unsigned long m_numberOfPoints;
-    unsigned long m_lastNumberOfPoints;
+    unsigned m_maxNumberOfPoints;
+    unsigned m_generation;
+    double m_sensorTimestamp;
+    unsigned m_pointsToSkip;
+    // Allocated for the largest point cloud of the device, so the same array is
+    // exposed from one generation to the next.
     Member<DOMFloat32Array> m_points;
     Member<DOMFloat32Array> m_pointsTransformMatrix;
     bool m_pointsAlreadyTransformed;
@@ -4,6 +4,8 @@
 
 #include "modules/vr/VRPose.h"
 
+#include <algorithm>
+
 namespace blink {
 
 namespace {
@@ -16,9 +18,19 @@ DOMFloat32Array* mojoArrayToFloat32Array(
   return DOMFloat32Array::create(&(vec.value().front()), vec.value().size());
 }
 
+void updateFloat32Array(Member<DOMFloat32Array>& array,
+                        const WTF::Optional<WTF::Vector<float>>& vec) {
+  if (!vec || !array || array->length() != vec.value().size()) {
+    array = mojoArrayToFloat32Array(vec);
+    return;
+  }
+
+  std::copy(vec.value().begin(), vec.value().end(), array->data());
+}
+
 }  // namespace
 
-VRPose::VRPose() {}
+VRPose::VRPose() : m_localized(false) {}
 
 void VRPose::setPose(const device::mojom::blink::VRPosePtr& state) {
   if (state.is_null())
@@ -33,6 +45,19 @@ void VRPose::setPose(const device::mojom::blink::VRPosePtr& state) {
   m_localized = state->localized;
 }
 
+void VRPose::updatePose(const device::mojom::blink::VRPosePtr& state) {
+  if (state.is_null())
+    return;
+
+  updateFloat32Array(m_orientation, state->orientation);
+  updateFloat32Array(m_position, state->position);
+  updateFloat32Array(m_angularVelocity, state->angularVelocity);
+  updateFloat32Array(m_linearVelocity, state->linearVelocity);
+  updateFloat32Array(m_angularAcceleration, state->angularAcceleration);
+  updateFloat32Array(m_linearAcceleration, state->linearAcceleration);
+  m_localized = state->localized;
+}
+
 DEFINE_TRACE(VRPose) {
   visitor->trace(m_orientation);
   visitor->trace(m_position);
@@ -28,6 +28,9 @@ class VRPose final : public GarbageCollected<VRPose>, public ScriptWrappable {
   bool localized() const { return m_localized; }
 
   void setPose(const device::mojom::blink::VRPosePtr&);
+  // Like setPose, but copies into the existing arrays when their sizes match,
+  // so a pose kept by the page across frames is updated without allocations.
+  void updatePose(const device::mojom::blink::VRPosePtr&);
 
   DECLARE_VIRTUAL_TRACE();
 
@@ -284,6 +284,12 @@ void WebGL2RenderingContextBase::bufferData(GLenum target,
   WebGLRenderingContextBase::bufferData(target, data, usage);
 }
 
+void WebGL2RenderingContextBase::bufferData(GLenum target,
+                                            VRPointCloud* pointCloud,
+                                            GLenum usage) {
+  WebGLRenderingContextBase::bufferData(target, pointCloud, usage);
+}
+
 void WebGL2RenderingContextBase::bufferSubData(GLenum target,
                                                GLintptr dstByteOffset,
                                                DOMArrayBufferView* srcData,
@@ -1312,6 +1318,16 @@ void WebGL2RenderingContextBase::texImage2D(GLenum target,
                                         type, passThroughCamera);
 }
 
+void WebGL2RenderingContextBase::texImage2D(GLenum target,
+                                            GLint level,
+                                            GLint internalformat,
+                                            GLenum format,
+                                            GLenum type,
+                                            VRDepthImage* depthImage) {
+  WebGLRenderingContextBase::texImage2D(target, level, internalformat, format,
+                                        type, depthImage);
+}
+
 void WebGL2RenderingContextBase::texSubImage2D(GLenum target,
                                                GLint level,
                                                GLint xoffset,
@@ -39,6 +39,7 @@ class WebGL2RenderingContextBase : public WebGLRenderingContextBase {
   void bufferData(GLenum target, long long size, GLenum usage);
   void bufferData(GLenum target, DOMArrayBuffer* data, GLenum usage);
   void bufferData(GLenum target, DOMArrayBufferView* data, GLenum usage);
+  void bufferData(GLenum target, VRPointCloud* pointCloud, GLenum usage);
   void bufferSubData(GLenum target, long long offset, DOMArrayBuffer* data);
   void bufferSubData(GLenum target,
                      long long offset,
@@ -252,6 +253,12 @@ class WebGL2RenderingContextBase : public WebGLRenderingContextBase {
                   GLenum format, 
                   GLenum type, 
                   VRPassThroughCamera*);
+  void texImage2D(GLenum target,
+                  GLint level,
+                  GLint internalformat,
+                  GLenum format,
+                  GLenum type,
+                  VRDepthImage*);
   void texImage2D(GLenum,
                   GLint,
                   GLint,
@@ -103,7 +103,9 @@
 #include "wtf/typed_arrays/ArrayBufferContents.h"
 #include <memory>
 
+#include "modules/vr/VRDepthImage.h"
 #include "modules/vr/VRPassThroughCamera.h"
+#include "modules/vr/VRPointCloud.h"
 
 namespace blink {
 
@@ -1930,6 +1932,31 @@ void WebGLRenderingContextBase::bufferData(GLenum target,
   bufferDataImpl(target, data->byteLength(), data->baseAddress(), usage);
 }
 
+void WebGLRenderingContextBase::bufferData(GLenum target,
+                                           VRPointCloud* pointCloud,
+                                           GLenum usage) {
+  if (isContextLost())
+    return;
+  if (!pointCloud) {
+    synthesizeGLError(GL_INVALID_VALUE, "bufferData", "no point cloud");
+    return;
+  }
+  WebGLBuffer* buffer = validateBufferDataTarget("bufferData", target);
+  if (!buffer)
+    return;
+  if (!validateBufferDataUsage("bufferData", usage))
+    return;
+
+  // The GPU process writes the transformed points straight into the buffer,
+  // sized for the largest point cloud. It is not waited for: the number of
+  // points is returned by the next VRDisplay.getPointCloud(pointCloud, true,
+  // ...) call.
+  contextGL()->UpdatePointCloudBuffer(target, usage);
+  buffer->setSize(static_cast<long long>(pointCloud->maxNumberOfPoints()) * 3 *
+                  sizeof(GLfloat));
+  pointCloud->setUploadedPointCloud();
+}
+
 void WebGLRenderingContextBase::bufferSubDataImpl(GLenum target,
                                                   long long offset,
                                                   GLsizeiptr size,
@@ -2498,6 +2525,42 @@ void WebGLRenderingContextBase::drawElements(GLenum mode,
   markContextChanged(CanvasChanged);
 }
 
+void WebGLRenderingContextBase::drawCameraBackground(
+    VRPassThroughCamera* passThroughCamera,
+    WebGLTexture* copyTexture,
+    GLsizei copyWidth,
+    GLsizei copyHeight) {
+  if (isContextLost())
+    return;
+  if (!passThroughCamera) {
+    synthesizeGLError(GL_INVALID_VALUE, "drawCameraBackground",
+                      "no pass through camera");
+    return;
+  }
+  if (copyTexture) {
+    if (!validateWebGLObject("drawCameraBackground", copyTexture))
+      return;
+    if (copyTexture->getTarget() != GL_TEXTURE_2D) {
+      synthesizeGLError(GL_INVALID_OPERATION, "drawCameraBackground",
+                        "copyTexture is not a 2D texture");
+      return;
+    }
+    if (copyWidth <= 0 || copyHeight <= 0) {
+      synthesizeGLError(GL_INVALID_VALUE, "drawCameraBackground",
+                        "invalid copy size");
+      return;
+    }
+  }
+
+  // The quad, its shader and the texture coordinates of the camera image are
+  // all in the GPU process, which restores the state of the context after
+  // drawing.
+  clearIfComposited();
+  contextGL()->DrawCameraBackground(objectOrZero(copyTexture), copyWidth,
+                                    copyHeight);
+  markContextChanged(CanvasChanged);
+}
+
 void WebGLRenderingContextBase::drawArraysInstancedANGLE(GLenum mode,
                                                          GLint first,
                                                          GLsizei count,
@@ -4869,8 +4932,10 @@ void WebGLRenderingContextBase::texImageHelperVRPassThroughCamera(
 {
   if (m_cameraImageTextureId != 0) 
   {
+    // The GPU process latches the camera frame once for every context of the
+    // share group. No need to wait for it: the draws that sample the texture
+    // come after it in the command stream.
     contextGL()->UpdateTextureExternalOes(m_cameraImageTextureId);
-    contextGL()->Finish();
   }
 }
 
@@ -4884,6 +4949,34 @@ void WebGLRenderingContextBase::texImage2D(GLenum target,
   texImageHelperVRPassThroughCamera(TexImage2D, target, level, internalformat, 0, format, type, 1, 0, 0, 0, passThroughCamera);
 }
 
+void WebGLRenderingContextBase::texImage2D(GLenum target,
+                                           GLint level,
+                                           GLint internalformat,
+                                           GLenum format,
+                                           GLenum type,
+                                           VRDepthImage* depthImage) {
+  if (isContextLost())
+    return;
+  if (!depthImage) {
+    synthesizeGLError(GL_INVALID_VALUE, "texImage2D", "no depth image");
+    return;
+  }
+  WebGLTexture* texture = validateTexture2DBinding("texImage2D", target);
+  if (!texture)
+    return;
+  if (target != GL_TEXTURE_2D || level != 0 ||
+      internalformat != GL_LUMINANCE_ALPHA || format != GL_LUMINANCE_ALPHA ||
+      type != GL_UNSIGNED_BYTE) {
+    synthesizeGLError(GL_INVALID_OPERATION, "texImage2D",
+                      "depth images are LUMINANCE_ALPHA UNSIGNED_BYTE level 0 "
+                      "2D textures");
+    return;
+  }
+  // The depth image is copied into the texture in the GPU process.
+  contextGL()->UpdateDepthImageTexture(objectOrZero(texture),
+                                       depthImage->isDense());
+}
+
 void WebGLRenderingContextBase::texImageHelperHTMLImageElement(
     TexImageFunctionID functionID,
     GLenum target,
@@ -102,7 +102,9 @@ class WebGLVertexArrayObjectBase;
 
 class WebGLRenderingContextErrorMessageCallback;
 
+class VRDepthImage;
 class VRPassThroughCamera;
+class VRPointCloud;
 
 // This class uses the color mask to prevent drawing to the alpha channel, if
 // the DrawingBuffer requires RGB emulation.
@@ -169,6 +171,7 @@ class MODULES_EXPORT WebGLRenderingContextBase : public CanvasRenderingContext,
   void bufferData(GLenum target, long long size, GLenum usage);
   void bufferData(GLenum target, DOMArrayBuffer* data, GLenum usage);
   void bufferData(GLenum target, DOMArrayBufferView* data, GLenum usage);
+  void bufferData(GLenum target, VRPointCloud* pointCloud, GLenum usage);
   void bufferSubData(GLenum target, long long offset, DOMArrayBuffer* data);
   void bufferSubData(GLenum target,
                      long long offset,
@@ -242,6 +245,10 @@ class MODULES_EXPORT WebGLRenderingContextBase : public CanvasRenderingContext,
   void disableVertexAttribArray(GLuint index);
   void drawArrays(GLenum mode, GLint first, GLsizei count);
   void drawElements(GLenum mode, GLsizei count, GLenum type, long long offset);
+  void drawCameraBackground(VRPassThroughCamera*,
+                            WebGLTexture* copyTexture,
+                            GLsizei copyWidth,
+                            GLsizei copyHeight);
 
   void drawArraysInstancedANGLE(GLenum mode,
                                 GLint first,
@@ -388,6 +395,12 @@ class MODULES_EXPORT WebGLRenderingContextBase : public CanvasRenderingContext,
                   GLenum format, 
                   GLenum type, 
                   VRPassThroughCamera*);
+  void texImage2D(GLenum target,
+                  GLint level,
+                  GLint internalformat,
+                  GLenum format,
+                  GLenum type,
+                  VRDepthImage*);
 
   void texParameterf(GLenum target, GLenum pname, GLfloat param);
   void texParameteri(GLenum target, GLenum pname, GLint param);
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _CAMERA_FRAME_RING_H_
+#define _CAMERA_FRAME_RING_H_
+
+namespace tango_chromium {
+
+// Keeps track of the camera frames latched into a small ring of textures, so
+// the frame that is displayed can be the one the pose was computed for instead
+// of the newest one.
+//
+// The textures themselves belong to the GL share group that latches the
+// frames: the ring only knows which slot holds which frame. Every context of
+// the share group displays a frame, chosen by selectFrame at draw time, and
+// counts as a display of its slot until it selects another one or releases
+// it. New frames are latched into the slot given by getLatchSlot, which is
+// never a displayed one nor the newest one, so the frame a pose was just
+// computed for is still there when it is drawn.
+// Not thread safe: it is used on the thread of its GL share group.
+class CameraFrameRing
+{
+public:
+	static const unsigned kSize = 3;
+
+	CameraFrameRing();
+
+	// The slot the next frame must be latched into, or -1 if every slot is
+	// displayed or holds the newest frame.
+	int getLatchSlot() const;
+	// Records that the frame with timestamp was latched into slot. A frame
+	// that is not newer than the newest one does not take a slot: slot is
+	// left empty, as its previous frame was overwritten.
+	void onFrameLatched(unsigned slot, double timestamp);
+
+	// Selects the slot of the frame with timestamp, or the newest frame if
+	// that one is not in the ring (or timestamp is 0), for display by a
+	// context that displayed previousSlot (-1 for none) until now. Returns -1,
+	// and releases previousSlot, if no frame has been latched yet.
+	int selectFrame(double timestamp, int previousSlot);
+	// A context that displayed slot (-1 for none) displays no frame anymore.
+	void releaseFrame(int slot);
+
+	// The timestamp of the newest frame, 0 if there is none.
+	double getNewestTimestamp() const;
+	// The timestamp of the frame in slot, 0 if there is none.
+	double getTimestamp(unsigned slot) const;
+
+	// Forgets every frame, when the textures are lost. The slots stay
+	// displayed until they are released.
+	void clear();
+
+private:
+	// 0 for the slots without frame.
+	double timestamps[kSize];
+	// The number of contexts displaying each slot.
+	unsigned displayCounts[kSize];
+	int newestSlot;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _CAMERA_FRAME_RING_H_
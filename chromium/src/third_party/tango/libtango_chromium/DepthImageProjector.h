@@ -0,0 +1,75 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _DEPTH_IMAGE_PROJECTOR_H_
+#define _DEPTH_IMAGE_PROJECTOR_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "SensorBackend.h"
+#include "ThreadPool.h"
+
+namespace tango_chromium {
+
+// A sparse depth image aligned with the color camera image: every pixel holds
+// the depth (the distance along the optical axis of the color camera) of the
+// nearest point projected into it, in millimeters, or 0 if no point was.
+struct DepthImage
+{
+	DepthImage(): width(0), height(0), timestamp(0)
+	{
+	}
+
+	uint32_t width;
+	uint32_t height;
+	// The timestamp of the point cloud the image was projected from.
+	double timestamp;
+	// width * height values, row by row from the top left pixel.
+	std::vector<uint16_t> depth;
+};
+
+// Rasterizes point clouds into low resolution DepthImages, so occlusion
+// against the camera image does not need every point to be projected in
+// JavaScript or in a shader.
+//
+// The points are split between the threads of the pool, each one transforming
+// and projecting 4 points at a time (SIMD) into its own z-buffer. The
+// z-buffers are then merged by keeping the nearest depth of every pixel.
+class DepthImageProjector
+{
+public:
+	explicit DepthImageProjector(unsigned numberOfThreads = 0);
+
+	DepthImageProjector(const DepthImageProjector& other) = delete;
+	DepthImageProjector& operator=(const DepthImageProjector& other) = delete;
+
+	// Projects pointCloud into a width x height image of the color camera.
+	// depthToColor transforms from the depth camera frame to the color camera
+	// frame (see SensorBackend::getDepthToColorTransform) and intrinsics are
+	// the ones of the color camera without display rotation, scaled to the
+	// size of the image. Lens distortion is not modelled.
+	void project(const SensorPointCloud& pointCloud, const float* depthToColor, const SensorCameraIntrinsics& intrinsics, uint32_t width, uint32_t height, DepthImage& image);
+
+private:
+	ThreadPool threadPool;
+	// One z-buffer per task, with 0xFFFF where no point was projected.
+	std::vector<std::vector<uint16_t>> zBuffers;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _DEPTH_IMAGE_PROJECTOR_H_
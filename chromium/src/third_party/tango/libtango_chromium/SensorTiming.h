@@ -0,0 +1,144 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SENSOR_TIMING_H_
+#define _SENSOR_TIMING_H_
+
+#include <cstdint>
+#include <mutex>
+
+namespace tango_chromium {
+
+// The kinds of sensor samples whose latency is measured.
+enum LatencySample
+{
+	LATENCY_SAMPLE_POSE = 0,
+	LATENCY_SAMPLE_POINT_CLOUD,
+	LATENCY_SAMPLE_CAMERA_FRAME,
+	NUMBER_OF_LATENCY_SAMPLES
+};
+
+// The hops on the native side of the pipeline. The age of a sample is
+// measured when it is delivered by the Tango callback and when the VR device
+// hands it over to the renderer.
+enum LatencyHop
+{
+	LATENCY_HOP_CALLBACK = 0,
+	LATENCY_HOP_DEVICE,
+	NUMBER_OF_LATENCY_HOPS
+};
+
+// Summary of a LatencyHistogram. All the values are in milliseconds.
+struct LatencyStatistics
+{
+	uint32_t count;
+	double mean;
+	double min;
+	double max;
+	double p50;
+	double p90;
+	double p99;
+};
+
+// Histogram of latencies with logarithmic buckets (8 per octave, from 0.1 ms
+// to about 13 s), so the percentiles are within 5% of the exact ones while
+// recording stays constant time and allocation free. Not thread safe.
+class LatencyHistogram
+{
+public:
+	LatencyHistogram();
+
+	void record(double milliseconds);
+	void reset();
+	void getStatistics(LatencyStatistics* statistics) const;
+
+private:
+	static const int NUMBER_OF_BUCKETS = 136;
+
+	uint32_t buckets[NUMBER_OF_BUCKETS];
+	uint32_t count;
+	double sum;
+	double min;
+	double max;
+};
+
+// Maps the timestamps of the sensor samples (in seconds, in the clock of the
+// Tango Service) to the steady clock, which is the monotonic clock that
+// base::TimeTicks also uses, so the age of a sample can be measured in any
+// process. The clock of the sensor is found by comparing the timestamps to the
+// monotonic and the boot time clocks when the samples are delivered: the one
+// the samples are a little older than is used. If neither matches, the offset
+// is estimated from the fastest delivery seen, which leaves the constant part
+// of the delivery latency out of the ages. Thread safe.
+class SensorClock
+{
+public:
+	SensorClock();
+
+	// Seconds on the steady clock.
+	static double now();
+
+	void onSampleDelivered(double sensorTimestamp);
+	// For tests, with the current times of the monotonic and boot time clocks.
+	void onSampleDelivered(double sensorTimestamp, double monotonicTime, double bootTime);
+
+	// Returns 0 if no sample has been delivered yet.
+	double toSteadyTime(double sensorTimestamp) const;
+
+	enum Source
+	{
+		SOURCE_UNKNOWN,
+		SOURCE_MONOTONIC,
+		SOURCE_BOOT_TIME,
+		SOURCE_ESTIMATED
+	};
+	Source getSource() const;
+
+private:
+	mutable std::mutex mutex;
+	Source source;
+	// steady time = sensor timestamp + offset.
+	double offset;
+};
+
+// Counts events, such as the calls of a Tango callback, and computes their
+// rate once per period. The rate is also written to the trace counter of the
+// given name. Thread safe.
+class RateCounter
+{
+public:
+	// name must outlive the counter.
+	explicit RateCounter(const char* name, double period = 1.0);
+
+	void tick();
+	// For tests, with the current time in seconds on the steady clock.
+	void tick(double now);
+
+	// Events per second over the last complete period, 0 before the first one.
+	double getRate() const;
+
+private:
+	const char* name;
+	const double period;
+	mutable std::mutex mutex;
+	double periodStart;
+	uint32_t count;
+	double rate;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _SENSOR_TIMING_H_
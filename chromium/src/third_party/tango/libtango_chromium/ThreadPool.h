@@ -0,0 +1,75 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tango_chromium {
+
+// A small fixed size pool of worker threads used to split image processing
+// work (thresholding, decoding, rasterization...) into tiles.
+// parallelFor calls are serialized, so a pool can be shared by several
+// pipelines running on different threads.
+class ThreadPool
+{
+public:
+	// A numberOfThreads of 0 uses one thread per available core. The calling
+	// thread always takes part in the work, so a pool of 1 thread spawns no
+	// workers at all.
+	explicit ThreadPool(unsigned numberOfThreads = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool& other) = delete;
+	ThreadPool& operator=(const ThreadPool& other) = delete;
+
+	unsigned getNumberOfThreads() const
+	{
+		return workers.size() + 1;
+	}
+
+	// Runs task(i) for every i in [0, count) and returns once all of them
+	// have finished.
+	void parallelFor(unsigned count, const std::function<void(unsigned)>& task);
+
+private:
+	void workerLoop();
+	void runTasks();
+
+	std::vector<std::thread> workers;
+
+	std::mutex parallelForMutex;
+
+	std::mutex mutex;
+	std::condition_variable workAvailable;
+	std::condition_variable workDone;
+	const std::function<void(unsigned)>* task;
+	unsigned taskCount;
+	std::atomic<unsigned> nextTaskIndex;
+	unsigned busyWorkers;
+	unsigned long long generation;
+	bool stopping;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _THREAD_POOL_H_